@@ -0,0 +1,483 @@
+// benchmarks/benchmark.cpp
+
+/**
+ * @file  benchmarks/benchmark.cpp
+ * @brief  NIPC throughput and latency benchmark
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Forks N subscribers and M publishers for every combination of delivery mode, payload size and subscriber count requested, and prints one JSON object per run on its own line.
+ * @remark  Usage: benchmark [--transport queue|ring] [--wakeup signal|futex] [--modes broadcast,multicast,unicast] [--payloads 16,256,4096] [--subscribers 1,4,16] [--publishers 1] [--messages 20000] [--batch 1] [--ring-slots 4096] [--shards 1] [--slab 16] [--idle 1000]
+ */
+
+#include "../src/NIPC.h"	// nipc_message, nipc_options, nipc_delivery, nipc_create, nipc_get, nipc_subscribe_batch, nipc_send_batch, nipc_close, nipc_remove
+#include <cstdio>		// printf, fprintf, fflush, perror
+#include <cstdlib>		// exit, strtoul, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>		// strcmp, strchr, memcpy
+#include <cerrno>		// errno, EINTR, ENOBUFS
+#include <cstdint>		// uint64_t
+#include <atomic>		// std::atomic
+#include <vector>		// std::vector
+#include <algorithm>		// std::min, std::max
+#include <new>			// placement new
+#include <ctime>		// clock_gettime, nanosleep, CLOCK_MONOTONIC
+#include <csignal>		// signal, kill, SIGTERM
+#include <unistd.h>		// fork, pipe, read, write, close, getpid, pause, _exit
+#include <sys/mman.h>		// mmap, munmap
+#include <sys/wait.h>		// waitpid
+
+// The number of sub-buckets every power of two of the latency histogram is split into; the reported percentiles are within 1/16 of the true value.
+constexpr unsigned int BENCH_SUB_BUCKETS = 16;
+
+// The number of buckets of the latency histogram, covering every 64-bit nanosecond value.
+constexpr unsigned int BENCH_BUCKETS = 61 * BENCH_SUB_BUCKETS;
+
+// The delivery modes, in the order they are named on the command line.
+const char* const BENCH_MODES[] = { "broadcast", "multicast", "unicast" };
+
+/**
+ * @name  bench_subscriber
+ * @brief  The results of one subscriber, kept in memory shared with the benchmark process.
+ * @remark  Only the subscriber writes to it, so the histogram needs no synchronisation; the benchmark process reads it once the run is over.
+ */
+struct bench_subscriber
+{
+	/**
+	 * @name  {pid_t}  pid
+	 * @brief  The PID of the subscriber, used as the target of unicasts.
+	 */
+	pid_t pid;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  received
+	 * @brief  The number of messages the subscriber received.
+	 */
+	std::atomic<uint64_t> received;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  last
+	 * @brief  The time the subscriber received its last message at, in nanoseconds.
+	 */
+	std::atomic<uint64_t> last;
+
+	/**
+	 * @name  {uint64_t[BENCH_BUCKETS]}  latency
+	 * @brief  The histogram of the end-to-end latencies of the messages received, in nanoseconds.
+	 */
+	uint64_t latency[BENCH_BUCKETS];
+};
+
+/**
+ * @name  bench_shared
+ * @brief  The state shared between the benchmark process, its subscribers and its publishers for one run.
+ * @remark  The subscribers follow the header in the same mapping.
+ */
+struct bench_shared
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  attempted
+	 * @brief  The number of messages the publishers tried to send.
+	 */
+	std::atomic<uint64_t> attempted;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  expected
+	 * @brief  The number of deliveries the instance accepted, summed over every recipient of every message.
+	 */
+	std::atomic<uint64_t> expected;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  failed
+	 * @brief  The number of sends that failed for a reason other than a full slab.
+	 */
+	std::atomic<uint64_t> failed;
+};
+
+/**
+ * @name  bench_config
+ * @brief  The settings shared by every run of a sweep.
+ */
+struct bench_config
+{
+	nipc_transport transport; // The transport of the instances.
+	nipc_wakeup wakeup; // The wakeup mechanism of the instances.
+	unsigned int publishers; // The number of publisher processes.
+	unsigned long messages; // The number of messages every publisher sends.
+	unsigned int batch; // The number of messages every publisher sends per call.
+	unsigned int ring_slots; // The number of slots of the ring.
+	unsigned int shards; // The number of message queues of the instances.
+	unsigned long slab; // The size of the slab in MiB.
+	unsigned long idle; // The time in milliseconds without any delivery after which the messages still missing are counted as lost.
+	std::vector<unsigned long> modes; // The delivery modes to sweep, as indices into `BENCH_MODES`.
+	std::vector<unsigned long> payloads; // The payload sizes to sweep, in bytes.
+	std::vector<unsigned long> subscribers; // The subscriber counts to sweep.
+};
+
+/**
+ * @name  _bench_self
+ * @brief  The results of the calling subscriber process.
+ */
+bench_subscriber* _bench_self = nullptr;
+
+/**
+ * @name  _bench_stop
+ * @brief  Set once a subscriber process is asked to exit.
+ */
+volatile sig_atomic_t _bench_stop = 0;
+
+/**
+ * @name  bench_now()
+ * @brief  Reads the monotonic clock, which is shared by every process of the machine.
+ * @return  {const uint64_t}  The current time in nanoseconds.
+ */
+const uint64_t bench_now()
+{
+	timespec now; // The current time.
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+/**
+ * @name  bench_sleep()
+ * @brief  Sleeps for a number of microseconds.
+ * @param  microseconds  {const long}  The time to sleep for.
+ */
+void bench_sleep(const long microseconds)
+{
+	timespec duration = { microseconds / 1000000, (microseconds % 1000000) * 1000 }; // The time to sleep for.
+	while (nanosleep(&duration, &duration) == -1 && errno == EINTR);
+}
+
+/**
+ * @name  bench_bucket()
+ * @brief  Maps a latency to its bucket of the latency histogram.
+ * @param  value  {const uint64_t}  The latency in nanoseconds.
+ * @return  {const unsigned int}  The index of the bucket.
+ */
+const unsigned int bench_bucket(const uint64_t value)
+{
+	// Values below the number of sub-buckets get a bucket each; the others are split by power of two, then linearly.
+	if (value < BENCH_SUB_BUCKETS) return static_cast<unsigned int>(value);
+	const unsigned int exponent = 63 - __builtin_clzll(value); // The position of the highest bit set.
+	return (exponent - 3) * BENCH_SUB_BUCKETS + static_cast<unsigned int>((value >> (exponent - 4)) & (BENCH_SUB_BUCKETS - 1));
+}
+
+/**
+ * @name  bench_bucket_value()
+ * @brief  Finds the smallest latency of a bucket of the latency histogram.
+ * @param  bucket  {const unsigned int}  The index of the bucket.
+ * @return  {const uint64_t}  The latency in nanoseconds.
+ */
+const uint64_t bench_bucket_value(const unsigned int bucket)
+{
+	if (bucket < BENCH_SUB_BUCKETS) return bucket;
+	return static_cast<uint64_t>(BENCH_SUB_BUCKETS + bucket % BENCH_SUB_BUCKETS) << (bucket / BENCH_SUB_BUCKETS + 3 - 4);
+}
+
+/**
+ * @name  bench_percentile()
+ * @brief  Reads a percentile off a latency histogram.
+ * @param  histogram  {const std::vector<uint64_t>&}  The histogram.
+ * @param  total  {const uint64_t}  The number of latencies in the histogram.
+ * @param  fraction  {const double}  The percentile, as a fraction.
+ * @return  {const double}  The latency in microseconds, or `0` if the histogram is empty.
+ */
+const double bench_percentile(const std::vector<uint64_t>& histogram, const uint64_t total, const double fraction)
+{
+	// Walk the buckets until the rank of the percentile is reached.
+	const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - (total ? 1 : 0))) + 1; // The rank of the percentile.
+	uint64_t seen = 0; // The number of latencies in the buckets walked so far.
+	for (unsigned int bucket = 0; bucket < BENCH_BUCKETS && total; ++bucket) if ((seen += histogram[bucket]) >= rank) return static_cast<double>(bench_bucket_value(bucket)) / 1000.0;
+	return 0.0;
+}
+
+/**
+ * @name  bench_handler()
+ * @brief  The batch notification handler of the subscribers; records the latency of every message.
+ * @param  batch  {const nipc_message* const}  The messages.
+ * @param  count  {const size_t}  The number of messages.
+ * @remark  Publishers stamp every payload with the time it was sent at.
+ */
+void bench_handler(const nipc_message* const batch, const size_t count)
+{
+	const uint64_t now = bench_now(); // The time the batch was received at.
+	for (size_t index = 0; index < count; ++index)
+	{
+		uint64_t sent; // The time the message was sent at.
+		memcpy(&sent, batch[index].payload(), sizeof(sent));
+		++_bench_self->latency[bench_bucket(now > sent ? now - sent : 0)];
+	}
+	_bench_self->received.fetch_add(count, std::memory_order_relaxed);
+	_bench_self->last.store(now, std::memory_order_relaxed);
+}
+
+/**
+ * @name  bench_terminate()
+ * @brief  The signal handler for `SIGTERM` in subscriber processes.
+ * @param  signal  {const int}  The signal number.
+ */
+void bench_terminate(const int signal) { _bench_stop = 1; }
+
+/**
+ * @name  bench_subscribe()
+ * @brief  The body of a subscriber process.
+ * @param  key  {const key_t}  The key of the NIPC instance.
+ * @param  self  {bench_subscriber* const}  The results of the subscriber.
+ * @param  channel  {const long}  The multicast channel to subscribe to.
+ * @param  ready  {const int}  The pipe to signal readiness on.
+ */
+void bench_subscribe(const key_t key, bench_subscriber* const self, const long channel, const int ready)
+{
+	// Subscribe, then tell the benchmark process the subscriber is ready.
+	_bench_self = self;
+	signal(SIGTERM, bench_terminate);
+	const int id = nipc_get(key); // The ID of the NIPC instance.
+	if (id == -1 || nipc_subscribe_batch(id, channel, bench_handler) == -1) { perror("benchmark: subscribe"); _exit(EXIT_FAILURE); }
+	if (write(ready, "s", 1) != 1) _exit(EXIT_FAILURE);
+	close(ready);
+
+	// Handle messages until asked to exit.
+	while (!_bench_stop) pause();
+	nipc_close(id);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+ * @name  bench_publish()
+ * @brief  The body of a publisher process.
+ * @param  key  {const key_t}  The key of the NIPC instance.
+ * @param  config  {const bench_config&}  The settings of the sweep.
+ * @param  shared  {bench_shared* const}  The state shared by the run.
+ * @param  subscribers  {const bench_subscriber* const}  The results of the subscribers, used to address unicasts.
+ * @param  count  {const unsigned int}  The number of subscribers.
+ * @param  mode  {const unsigned long}  The delivery mode.
+ * @param  payload  {const size_t}  The size of the payloads.
+ * @param  start  {const int}  The pipe closed when the run starts.
+ */
+void bench_publish(const key_t key, const bench_config& config, bench_shared* const shared, const bench_subscriber* const subscribers, const unsigned int count, const unsigned long mode, const size_t payload, const int start)
+{
+	// Open the instance and prepare the payloads and the delivery report.
+	const int id = nipc_get(key); // The ID of the NIPC instance.
+	if (id == -1) { perror("benchmark: open"); _exit(EXIT_FAILURE); }
+	std::vector<nipc_message> batch(config.batch); // The messages of the batch being sent.
+	std::vector<std::vector<char>> payloads(config.batch, std::vector<char>(payload, 'x')); // The payloads of the batch.
+	std::vector<nipc_delivery> deliveries(count); // The outcome of the last send for every recipient.
+
+	// Wait for the run to start.
+	char signal; // The byte read from the pipe; the pipe is only ever closed.
+	while (read(start, &signal, 1) == -1 && errno == EINTR);
+
+	for (unsigned long sent = 0, round = 0; sent < config.messages; ++round)
+	{
+		// Pick the recipients: everyone, the first multicast channel or the next subscriber in turn.
+		const long type = mode == 0 ? NIPC_BROADCAST : mode == 1 ? NIPC_MULTICAST(1) : NIPC_UNICAST(subscribers[round % count].pid); // The type of the batch.
+
+		// Stamp the messages of the batch with the time they are sent at.
+		const size_t size = std::min<unsigned long>(config.batch, config.messages - sent); // The number of messages in the batch.
+		const uint64_t now = bench_now(); // The time the batch is sent at.
+		for (size_t index = 0; index < size; ++index)
+		{
+			memcpy(payloads[index].data(), &now, sizeof(now));
+			batch[index] = nipc_message::borrow(0, getpid(), payloads[index].data(), payload);
+		}
+
+		// Send the batch, retrying the messages that did not fit in the slab.
+		size_t done = 0; // The number of messages of the batch sent so far.
+		while (done < size)
+		{
+			const int recipients = nipc_send_batch(id, batch.data() + done, size - done, type, deliveries.data(), deliveries.size()); // The number of recipients, or -1.
+			const int error = errno; // The error of the send, if any.
+			size_t progress = size - done; // The number of messages this send got through to everyone.
+			uint64_t accepted = 0; // The number of deliveries this send made.
+			const size_t reported = recipients == -1 ? deliveries.size() : std::min<size_t>(recipients, deliveries.size()); // The number of outcomes reported.
+			for (size_t recipient = 0; recipient < reported && deliveries[recipient].pid; ++recipient) { accepted += deliveries[recipient].delivered; progress = std::min(progress, deliveries[recipient].delivered); }
+			shared->expected.fetch_add(accepted, std::memory_order_relaxed);
+			if (recipients == -1 && error == ENOBUFS) { done += progress; bench_sleep(50); continue; }
+			if (recipients == -1) shared->failed.fetch_add(1, std::memory_order_relaxed);
+			break;
+		}
+		shared->attempted.fetch_add(size, std::memory_order_relaxed);
+		sent += size;
+	}
+
+	// Exit the publisher.
+	nipc_close(id);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+ * @name  bench_run()
+ * @brief  Runs one combination of the sweep and prints its results as a JSON object on its own line.
+ * @param  config  {const bench_config&}  The settings of the sweep.
+ * @param  mode  {const unsigned long}  The delivery mode.
+ * @param  payload  {const size_t}  The size of the payloads; at least 8 bytes to hold the timestamp.
+ * @param  count  {const unsigned int}  The number of subscribers.
+ * @param  key  {const key_t}  The key of the NIPC instance to create for the run.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int bench_run(const bench_config& config, const unsigned long mode, const size_t payload, const unsigned int count, const key_t key)
+{
+	// Create the instance of the run.
+	nipc_options options; // The options of the NIPC instance.
+	options.transport = config.transport;
+	options.wakeup = config.wakeup;
+	options.ring_slots = config.ring_slots;
+	options.queue_shards = config.shards;
+	options.slab_size = config.slab << 20;
+	nipc_remove(key);
+	if (nipc_create(key, options) == -1) { perror("benchmark: create"); return -1; }
+
+	// Map the state shared with the subscribers and publishers.
+	const size_t size = sizeof(bench_shared) + count * sizeof(bench_subscriber); // The size of the shared state.
+	void* const mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0); // The shared state.
+	if (mapping == MAP_FAILED) { perror("benchmark: mmap"); nipc_remove(key); return -1; }
+	bench_shared* const shared = new (mapping) bench_shared(); // The state shared by the run.
+	bench_subscriber* const subscribers = reinterpret_cast<bench_subscriber*>(shared + 1); // The results of the subscribers.
+
+	// Fork the subscribers and wait for all of them to subscribe; with multicasts, only every other subscriber joins the channel the publishers send to.
+	int ready[2]; // The pipe the subscribers signal readiness on.
+	if (pipe(ready) == -1) { perror("benchmark: pipe"); munmap(mapping, size); nipc_remove(key); return -1; }
+	fflush(stdout);
+	for (unsigned int index = 0; index < count; ++index)
+	{
+		new (&subscribers[index]) bench_subscriber();
+		const pid_t pid = fork(); // The PID of the subscriber.
+		if (!pid) bench_subscribe(key, &subscribers[index], NIPC_MULTICAST(mode == 1 ? 1L + index % 2 : 1L), ready[1]);
+		subscribers[index].pid = pid;
+	}
+	close(ready[1]);
+	unsigned int subscribed = 0; // The number of subscribers ready; the pipe reaches its end early if one of them fails.
+	for (char signal; subscribed < count && read(ready[0], &signal, 1) == 1; ++subscribed);
+	close(ready[0]);
+	if (subscribed < count)
+	{
+		for (unsigned int index = 0; index < count; ++index) { kill(subscribers[index].pid, SIGTERM); waitpid(subscribers[index].pid, nullptr, 0); }
+		munmap(mapping, size);
+		nipc_remove(key);
+		return -1;
+	}
+
+	// Fork the publishers, then release them all at once.
+	int start[2]; // The pipe closed to start the run.
+	if (pipe(start) == -1) { perror("benchmark: pipe"); return -1; }
+	std::vector<pid_t> publishers(config.publishers); // The PIDs of the publishers.
+	for (unsigned int index = 0; index < config.publishers; ++index) if (!(publishers[index] = fork())) { close(start[1]); bench_publish(key, config, shared, subscribers, count, mode, payload, start[0]); }
+	close(start[0]);
+	const uint64_t begin = bench_now(); // The time the run started at.
+	close(start[1]);
+	for (const pid_t pid : publishers) waitpid(pid, nullptr, 0);
+	const uint64_t published = bench_now(); // The time the publishers were done at.
+
+	// Wait until every delivery is received, or until none arrives for a while.
+	uint64_t received = 0; // The number of messages received by all subscribers.
+	uint64_t progress = bench_now(); // The time the last progress was seen at.
+	while (true)
+	{
+		uint64_t total = 0; // The number of messages received so far.
+		for (unsigned int index = 0; index < count; ++index) total += subscribers[index].received.load(std::memory_order_relaxed);
+		if (total != received) { received = total; progress = bench_now(); }
+		if (received >= shared->expected.load(std::memory_order_relaxed) || bench_now() - progress > config.idle * 1000000ULL) break;
+		bench_sleep(1000);
+	}
+
+	// Stop the subscribers and remove the instance.
+	for (unsigned int index = 0; index < count; ++index) kill(subscribers[index].pid, SIGTERM);
+	for (unsigned int index = 0; index < count; ++index) waitpid(subscribers[index].pid, nullptr, 0);
+	nipc_remove(key);
+
+	// Merge the latency histograms and find when the last message was received.
+	std::vector<uint64_t> histogram(BENCH_BUCKETS, 0); // The latencies of all the messages received.
+	uint64_t end = published; // The time the last message was received at.
+	for (unsigned int index = 0; index < count; ++index)
+	{
+		for (unsigned int bucket = 0; bucket < BENCH_BUCKETS; ++bucket) histogram[bucket] += subscribers[index].latency[bucket];
+		end = std::max<uint64_t>(end, subscribers[index].last.load(std::memory_order_relaxed));
+	}
+
+	// Print the results.
+	const uint64_t expected = shared->expected.load(); // The number of deliveries accepted by the instance.
+	const double seconds = static_cast<double>(end - begin) / 1e9; // The duration of the run.
+	printf("{\"transport\":\"%s\",\"shards\":%u,\"wakeup\":\"%s\",\"mode\":\"%s\",\"payload\":%zu,\"subscribers\":%u,\"publishers\":%u,\"batch\":%u,", config.transport == NIPC_TRANSPORT_RING ? "ring" : "queue", config.transport == NIPC_TRANSPORT_RING ? 1U : config.shards, config.wakeup == NIPC_WAKEUP_FUTEX ? "futex" : "signal", BENCH_MODES[mode], payload, count, config.publishers, config.batch);
+	printf("\"attempted\":%llu,\"expected\":%llu,\"received\":%llu,\"lost\":%llu,\"failed\":%llu,\"seconds\":%.6f,\"msgs_per_sec\":%.1f,", static_cast<unsigned long long>(shared->attempted.load()), static_cast<unsigned long long>(expected), static_cast<unsigned long long>(received), static_cast<unsigned long long>(expected > received ? expected - received : 0), static_cast<unsigned long long>(shared->failed.load()), seconds, seconds > 0 ? static_cast<double>(received) / seconds : 0.0);
+	printf("\"p50_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f}\n", bench_percentile(histogram, received, 0.50), bench_percentile(histogram, received, 0.99), bench_percentile(histogram, received, 0.999));
+	fflush(stdout);
+
+	// Release the shared state.
+	munmap(mapping, size);
+	return 0;
+}
+
+/**
+ * @name  bench_list()
+ * @brief  Parses a comma-separated list of numbers or names.
+ * @param  text  {const char*}  The list.
+ * @param  names  {const char* const* const}  The names the list may use instead of numbers, or `nullptr`; a name is parsed as its index.
+ * @param  count  {const size_t}  The number of names.
+ * @return  {std::vector<unsigned long>}  The values of the list.
+ */
+std::vector<unsigned long> bench_list(const char* text, const char* const* const names, const size_t count)
+{
+	std::vector<unsigned long> values; // The values of the list.
+	while (*text)
+	{
+		// Find the end of the item, then parse it as a name or a number.
+		const char* const comma = strchr(text, ','); // The end of the item.
+		const size_t length = comma ? static_cast<size_t>(comma - text) : strlen(text); // The length of the item.
+		size_t name = 0; // The index of the name the item matches.
+		while (name < count && (strlen(names[name]) != length || strncmp(names[name], text, length))) ++name;
+		values.push_back(name < count ? name : strtoul(text, nullptr, 10));
+		text += length + (comma ? 1 : 0);
+	}
+	return values;
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// The default sweep.
+	bench_config config; // The settings of the sweep.
+	config.transport = NIPC_TRANSPORT_QUEUE;
+	config.wakeup = NIPC_WAKEUP_SIGNAL;
+	config.publishers = 1;
+	config.messages = 20000;
+	config.batch = 1;
+	config.ring_slots = 4096;
+	config.shards = 1;
+	config.slab = 16;
+	config.idle = 1000;
+	config.modes = { 0, 1, 2 };
+	config.payloads = { 16, 256, 4096 };
+	config.subscribers = { 1, 4, 16 };
+
+	// Parse the command line.
+	for (int index = 1; index + 1 < argc; index += 2)
+	{
+		const char* const option = argv[index]; // The name of the option.
+		const char* const value = argv[index + 1]; // The value of the option.
+		if (!strcmp(option, "--transport")) config.transport = strcmp(value, "ring") ? NIPC_TRANSPORT_QUEUE : NIPC_TRANSPORT_RING;
+		else if (!strcmp(option, "--wakeup")) config.wakeup = strcmp(value, "futex") ? NIPC_WAKEUP_SIGNAL : NIPC_WAKEUP_FUTEX;
+		else if (!strcmp(option, "--modes")) config.modes = bench_list(value, BENCH_MODES, 3);
+		else if (!strcmp(option, "--payloads")) config.payloads = bench_list(value, nullptr, 0);
+		else if (!strcmp(option, "--subscribers")) config.subscribers = bench_list(value, nullptr, 0);
+		else if (!strcmp(option, "--publishers")) config.publishers = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--messages")) config.messages = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--batch")) config.batch = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--ring-slots")) config.ring_slots = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--shards")) config.shards = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--slab")) config.slab = strtoul(value, nullptr, 10);
+		else if (!strcmp(option, "--idle")) config.idle = strtoul(value, nullptr, 10);
+		else { fprintf(stderr, "benchmark: unknown option %s\n", option); exit(EXIT_FAILURE); }
+	}
+
+	// Reject settings the runs cannot honour.
+	if (!config.publishers || !config.batch) { fprintf(stderr, "benchmark: --publishers and --batch must be positive\n"); exit(EXIT_FAILURE); }
+	for (const unsigned long mode : config.modes) if (mode > 2) { fprintf(stderr, "benchmark: unknown mode\n"); exit(EXIT_FAILURE); }
+	for (const unsigned long count : config.subscribers) if (!count || count > NIPC_MAX_SUBSCRIBERS) { fprintf(stderr, "benchmark: --subscribers must be between 1 and %u\n", NIPC_MAX_SUBSCRIBERS); exit(EXIT_FAILURE); }
+
+	// Run every combination of the sweep on an instance keyed after this process.
+	int status = EXIT_SUCCESS; // The exit status of the benchmark.
+	for (const unsigned long mode : config.modes) for (const unsigned long payload : config.payloads) for (const unsigned long count : config.subscribers)
+		if (bench_run(config, mode, std::max<size_t>(payload, sizeof(uint64_t)), static_cast<unsigned int>(count), static_cast<key_t>(0x4E420000 | (getpid() & 0xFFFF))) == -1) status = EXIT_FAILURE;
+
+	exit(status);
+}
+
+// End of benchmarks/benchmark.cpp
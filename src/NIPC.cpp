@@ -1,295 +1,5321 @@
-//TODO: mutex everything that is shared
+// src/NIPC.cpp
+
+/**
+ * @file  src/NIPC.cpp
+ * @brief  Notifier Inter-Process Communication (NIPC) source file
+ * @date  26/12/2023
+ * @version  1.0.0
+ */
+
+#include "NIPC.h"		// nipc_message, nipc_handler_t, nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+#include <unordered_map>	// std::unordered_map
+#include <atomic>		// std::atomic, std::atomic_thread_fence
+#include <cstdint>		// uint32_t, uint64_t, uintptr_t, UINT32_MAX
+#include <climits>		// LONG_MAX
+#include <cstddef>		// offsetof
+#include <cstring>		// memcpy, memchr
+#include <algorithm>		// std::min
+#include <cerrno>		// errno, Error number definitions
+#include <sys/msg.h>		// msgget, msgctl, msgsnd, msgrcv
+#include <sys/shm.h>		// shmget, shmat, shmdt, shmctl
+#include <sys/types.h>		// key_t, pid_t
+#include <sys/ipc.h>		// IPC_CREAT, IPC_RMID, IPC_EXCL
+#include <csignal>		// sigaction, sigqueue, signal, sigemptyset, sigaddset, pthread_sigmask, SA_SIGINFO, SA_RESTART, SI_QUEUE, SIG_DFL, SIG_BLOCK, SIG_SETMASK
+#include <unistd.h>		// getpid, write, unlink
+#include <cstdlib>		// NULL, strtoull
+#include <sys/stat.h>		// S_IRUSR, S_IWUSR, S_IRGRP, S_IWGRP, S_IROTH, S_IWOTH
+#include <pthread.h>		// pthread_mutex_t, pthread_mutex_init, pthread_mutex_lock, pthread_mutex_unlock, pthread_mutex_consistent
+#include <sched.h>		// sched_yield
+#include <new>			// placement new, std::nothrow
+#include <linux/futex.h>	// FUTEX_WAIT, FUTEX_WAKE
+#include <sys/syscall.h>	// SYS_futex
+#include <ctime>		// clock_gettime, CLOCK_MONOTONIC
+#include <cstdio>		// snprintf
+#include <string>		// std::string
+#include <vector>		// std::vector
+#include <sys/socket.h>		// socket, bind, sendto, recv, AF_UNIX, SOCK_DGRAM, SOCK_NONBLOCK, SOCK_CLOEXEC, MSG_DONTWAIT
+#include <sys/un.h>		// sockaddr_un
+#include <sys/mman.h>		// mmap, munmap, PROT_READ, PROT_WRITE, MAP_SHARED, MAP_FAILED
+#include <fcntl.h>		// open, posix_fallocate, O_RDONLY, O_WRONLY, O_RDWR, O_CREAT, O_TRUNC, O_CLOEXEC
+#include <dirent.h>		// opendir, readdir, closedir
+
+// The permissions for the message queue and shared memory segment.
+constexpr int RW_UGO = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+
+// The value stored in an initialised NIPC instance; segments without it are still being set up by their creator.
+constexpr uint32_t NIPC_MAGIC = 0x4E495043;
+
+// The value at the start of every log segment.
+constexpr uint64_t NIPC_LOG_MAGIC = 0x4E4950434C4F4731ULL;
+
+// The number of buckets in the registry's hash index.  Keeping it at twice the capacity bounds the load factor to one half.
+constexpr uint32_t NIPC_INDEX_CAPACITY = 2 * NIPC_MAX_SUBSCRIBERS;
+static_assert((NIPC_INDEX_CAPACITY & (NIPC_INDEX_CAPACITY - 1)) == 0, "The registry index capacity must be a power of two.");
+
+// The sentinel marking an empty bucket in the registry index and the end of the free list.
+constexpr uint32_t NIPC_NONE = UINT32_MAX;
+
+// The number of 256-bit lanes in a bitmap holding one bit per subscriber entry.
+constexpr uint32_t NIPC_MEMBER_LANES = NIPC_MAX_SUBSCRIBERS / 256;
+static_assert(NIPC_MAX_SUBSCRIBERS % 256 == 0, "The subscriber capacity must be a multiple of 256.");
+
+// Every subscriber tracks the conflation slots it has not read in a single 64-bit word.
+static_assert(NIPC_MAX_CONFLATED <= 64, "The conflation slots must fit in a 64-bit bitmap.");
+
+// 256 bits of a subscriber bitmap, combined with SIMD instructions.
+typedef uint64_t nipc_lane __attribute__((vector_size(32)));
+
+// The states of a subscriber's futex word: draining messages, notified of new messages, and parked waiting for them.
+constexpr uint32_t NIPC_RUNNING = 0;
+constexpr uint32_t NIPC_NOTIFIED = 1;
+constexpr uint32_t NIPC_PARKED = 2;
+
+// How many times ring writers yield while waiting for the message a lap behind theirs, or for their turn to claim positions, before they check whether the process they wait for died.
+constexpr uint32_t NIPC_RING_PATIENCE = 64;
+
+// The `type` of a ring slot reclaimed from a writer that died before publishing it; it matches no subscriber, so readers skip it.
+constexpr long NIPC_RING_SKIPPED = LONG_MAX;
+
+// The phases of a call slot, held in the low bits of its state: no call in flight, request written, request taken by the callee, reply being written and reply written.
+constexpr uint32_t NIPC_CALL_IDLE = 0;
+constexpr uint32_t NIPC_CALL_REQUESTED = 1;
+constexpr uint32_t NIPC_CALL_TAKEN = 2;
+constexpr uint32_t NIPC_CALL_ANSWERING = 3;
+constexpr uint32_t NIPC_CALL_REPLIED = 4;
+
+// The bits of a call slot's state holding its phase; the others count the calls made through the slot.
+constexpr uint32_t NIPC_CALL_PHASE = 7;
+
+// How long callers and callees spin before sleeping on a futex, in nanoseconds, and how long they then sleep between checks that the other side is alive.
+constexpr uint64_t NIPC_CALL_SPIN = 50000;
+constexpr uint64_t NIPC_CALL_NAP = 10000000;
+
+// How often senders look for subscribers that died without closing the instance, in nanoseconds.
+constexpr uint64_t NIPC_REAP_INTERVAL = 100000000;
+
+// The number of subscribers reaped since the last sweep whose inboxes it purges again.
+constexpr uint32_t NIPC_MAX_REAPED = 64;
+
+// Every responder tracks the slots holding requests for it in a bitmap of 64-bit words.
+static_assert(NIPC_MAX_CALLS % 64 == 0, "The call slots must fill whole 64-bit words.");
+
+// The largest message queue write; several messages are packed into each write, up to the default `MSGMAX`.
+constexpr size_t NIPC_RECORD_SIZE = 8192;
+
+// The number of messages a worker thread's queue can hold.
+constexpr uint64_t NIPC_WORKER_QUEUE_SIZE = 1024;
+static_assert((NIPC_WORKER_QUEUE_SIZE & (NIPC_WORKER_QUEUE_SIZE - 1)) == 0, "The worker queue size must be a power of two.");
+
+// The stages of a message's life recorded when tracing: the registry lookup, the writes to the transport and the notifications of a send, then the receipt and the handling of a batch.
+constexpr uint32_t NIPC_TRACE_RESOLVE = 0;
+constexpr uint32_t NIPC_TRACE_WRITE = 1;
+constexpr uint32_t NIPC_TRACE_NOTIFY = 2;
+constexpr uint32_t NIPC_TRACE_RECEIVE = 3;
+constexpr uint32_t NIPC_TRACE_HANDLER = 4;
+
+// The names of the traced stages in exported traces.
+const char* const NIPC_TRACE_STAGES[] = { "send.resolve", "send.write", "send.notify", "receive", "handler" };
+
+/**
+ * @name  nipc_wire
+ * @brief  A message as it travels between processes.
+ * @remark  Only the first `length` bytes of `data` are copied for a payload stored inline, and none of them for a payload held in the slab.
+ */
+struct nipc_wire
+{
+	/**
+	 * @name  {long}  channel
+	 * @brief  The channel of the message.
+	 */
+	long channel;
+
+	/**
+	 * @name  {pid_t}  sender
+	 * @brief  The PID of the process that sent the message.
+	 */
+	pid_t sender;
+
+	/**
+	 * @name  {uint32_t}  length
+	 * @brief  The length of the payload in bytes.
+	 */
+	uint32_t length;
+
+	/**
+	 * @name  {uint64_t}  block
+	 * @brief  The reference to the payload in the slab: the generation of its first block in the high 32 bits and the index of that block in the low 32 bits; `0` if the payload is stored inline.
+	 */
+	uint64_t block;
+
+	/**
+	 * @name  {uint64_t}  timestamp
+	 * @brief  The time the message was sent at, in nanoseconds of `CLOCK_MONOTONIC`.
+	 */
+	uint64_t timestamp;
+
+	/**
+	 * @name  {uint64_t}  sequence
+	 * @brief  The sequence number the message was logged under, or `0` if the instance does not log.
+	 */
+	uint64_t sequence;
+
+	/**
+	 * @name  {char[NIPC_INLINE_SIZE]}  data
+	 * @brief  The payload, if it is stored inline.
+	 */
+	char data[NIPC_INLINE_SIZE];
+};
+
+/**
+ * @name  msgq_buf
+ * @brief  A buffer to store a record of one or more messages in a message queue.
+ */
+struct msgq_buf
+{
+	/**
+	 * @name  receiver
+	 * @brief  The PID of the process that will receive the messages.
+	 * @remark  This corresponds to the `type` parameter of `msgsnd()`.  Here, the message queue type is abstracted an inbox for each process, with the lane of the messages in the high 32 bits; see `_nipc_lane_type()`.
+	 */
+	long receiver;
+
+	/**
+	 * @name  data
+	 * @brief  The messages, each in its `nipc_wire` form trimmed to its used part and padded to a multiple of 8 bytes.
+	 */
+	alignas(8) char data[NIPC_RECORD_SIZE];
+
+	/**
+	 * @name msgq_buf()
+	 * @brief  Constructs a new message queue buffer; the messages are left uninitialised since only their used part is ever copied.
+	 */
+	msgq_buf() : receiver(0) {}
+};
+
+/**
+ * @name  nipc_inbox
+ * @brief  The record a process is receiving messages from, and how far it got through it.
+ * @remark  A drain always empties the inbox, so the signal handler can share a single inbox between all the subscriptions it drains.
+ */
+struct nipc_inbox
+{
+	/**
+	 * @name  {size_t}  size
+	 * @brief  The number of bytes of messages in the record.
+	 */
+	size_t size;
+
+	/**
+	 * @name  {size_t}  offset
+	 * @brief  The offset of the next message to receive in the record.
+	 */
+	size_t offset;
+
+	/**
+	 * @name  {uint32_t}  lane
+	 * @brief  The lane the record was received on.
+	 */
+	uint32_t lane;
+
+	/**
+	 * @name  {msgq_buf}  record
+	 * @brief  The record.
+	 */
+	msgq_buf record;
+
+	/**
+	 * @name  nipc_inbox()
+	 * @brief  Constructs an empty inbox.
+	 */
+	nipc_inbox() : size(0), offset(0), lane(0) {}
+};
+
+/**
+ * @name  nipc_recipient
+ * @brief  A recipient of a message, as resolved from the subscriber registry.
+ */
+struct nipc_recipient
+{
+	/**
+	 * @name  {pid_t}  pid
+	 * @brief  The PID of the recipient.
+	 */
+	pid_t pid;
+
+	/**
+	 * @name  {uint32_t}  entry
+	 * @brief  The index of the recipient's entry in the registry.
+	 */
+	uint32_t entry;
+
+	/**
+	 * @name  {size_t}  delivered
+	 * @brief  The number of messages delivered to the recipient so far.
+	 */
+	size_t delivered;
+
+	/**
+	 * @name  {size_t}  notified
+	 * @brief  The number of messages delivered to the recipient when it was last notified.
+	 */
+	size_t notified;
+
+	/**
+	 * @name  {int}  error
+	 * @brief  The error that stopped delivery to the recipient, or `0`.
+	 */
+	int error;
+
+	/**
+	 * @name  {size_t}  dropped
+	 * @brief  The number of messages dropped for the recipient by the overflow policy so far.
+	 */
+	size_t dropped;
+};
+
+/**
+ * @name  nipc_subscriber
+ * @brief  An entry in the subscriber registry of a NIPC instance.
+ * @remark  An entry never moves while its process is subscribed, so its index identifies the subscriber for as long as it is registered.
+ * @remark  Fields read by senders are atomic so they can be read without the registry lock under the protection of the sequence counter.
+ */
+struct nipc_subscriber
+{
+	/**
+	 * @name  {std::atomic<pid_t>}  pid
+	 * @brief  The PID of the subscribed process, or `0` if the entry is free.
+	 */
+	std::atomic<pid_t> pid;
+
+	/**
+	 * @name  {std::atomic<long>[NIPC_MAX_CHANNELS]}  channels
+	 * @brief  The multicast channels the process follows, in the order it subscribed to them.
+	 */
+	std::atomic<long> channels[NIPC_MAX_CHANNELS];
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  channel_count
+	 * @brief  The number of multicast channels the process follows.
+	 */
+	std::atomic<uint32_t> channel_count;
+
+	/**
+	 * @name  {uint32_t}  position
+	 * @brief  The position of the entry in the registry's member list.
+	 */
+	uint32_t position;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  cursor
+	 * @brief  The position of the next message the subscriber will read from the ring of an instance using `NIPC_TRANSPORT_RING`.
+	 * @remark  Only the subscriber itself advances its cursor.
+	 */
+	std::atomic<uint64_t> cursor;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  futex
+	 * @brief  The futex word the subscriber's receiver thread parks on when the instance uses `NIPC_WAKEUP_FUTEX`; one of `NIPC_RUNNING`, `NIPC_NOTIFIED` or `NIPC_PARKED`.
+	 */
+	std::atomic<uint32_t> futex;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  signalled
+	 * @brief  Set while a `NIPC_SIGNAL` naming the instance, or a datagram on its descriptor, is queued for the subscriber and it has not started draining, so senders queue at most one at a time.
+	 */
+	std::atomic<uint32_t> signalled;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  polled
+	 * @brief  Set if the subscriber receives with `nipc_recv()`, so senders notify it through its descriptor rather than as the instance's `wakeup` says.
+	 */
+	std::atomic<uint32_t> polled;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  stale
+	 * @brief  The conflation slots holding a value the subscriber has not read yet, one bit per slot.
+	 */
+	std::atomic<uint64_t> stale;
+
+	/**
+	 * @name  {uint32_t}  next_free
+	 * @brief  The index of the next free entry when this entry is on the free list.
+	 */
+	uint32_t next_free;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  delivered
+	 * @brief  The number of messages written to the subscriber's inbox in the message queue.
+	 */
+	std::atomic<uint64_t> delivered;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  evicted
+	 * @brief  The number of messages senders removed from the subscriber's inbox to make room with `NIPC_OVERFLOW_DROP_OLDEST`.
+	 */
+	std::atomic<uint64_t> evicted;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  overflowed
+	 * @brief  The number of messages dropped for the subscriber by the overflow policy, whether evicted or never delivered.
+	 */
+	std::atomic<uint64_t> overflowed;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  received
+	 * @brief  The number of messages handed to the subscriber's notification handler.
+	 * @remark  This and the following counters are only written by the subscriber, so they sit on their own cache lines away from those written by senders.
+	 */
+	alignas(64) std::atomic<uint64_t> received;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  dropped
+	 * @brief  The number of messages the subscriber lost because its message pool had no buffer left for them.
+	 */
+	std::atomic<uint64_t> dropped;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  lapped
+	 * @brief  The number of ring positions the subscriber skipped because it was lapped.
+	 */
+	std::atomic<uint64_t> lapped;
+
+	/**
+	 * @name  {std::atomic<int32_t>[NIPC_LANES]}  queued
+	 * @brief  The number of messages waiting on each lane of the subscriber's inbox above lane `0`, which is always checked; the first entry is unused.
+	 * @remark  Senders bump it after writing a record and whoever takes the record off the queue drops it, so it may dip below zero for a moment.  It lets the subscriber skip empty lanes without a system call, and keeps urgent messages out of its quota.
+	 */
+	std::atomic<int32_t> queued[NIPC_LANES];
+
+	/**
+	 * @name  {std::atomic<uint64_t>[NIPC_LATENCY_BUCKETS]}  latency
+	 * @brief  The histogram of the time between sending the subscriber's messages and handing them to its notification handler, across every lane.
+	 */
+	std::atomic<uint64_t> latency[NIPC_LATENCY_BUCKETS];
+
+	/**
+	 * @name  {uint64_t[NIPC_MAX_CONFLATED]}  seen
+	 * @brief  The version of every conflation slot the subscriber last read, so that it never receives the same value twice.
+	 */
+	uint64_t seen[NIPC_MAX_CONFLATED];
+};
+
+/**
+ * @name  nipc_channel
+ * @brief  An entry in the channel index of a NIPC instance, holding the subscribers of one multicast channel.
+ * @remark  An entry is taken when the first subscriber joins the channel and released when the last one leaves, so an instance can have up to `NIPC_MAX_SUBSCRIBERS` channels with subscribers at once.
+ */
+struct nipc_channel
+{
+	/**
+	 * @name  {nipc_lane[NIPC_MEMBER_LANES]}  members
+	 * @brief  The bitmap of the subscribers of the channel, with bit `entry` set for every subscriber entry following it.
+	 * @remark  Only changed under the registry lock; readers go through `_nipc_read()`.
+	 */
+	nipc_lane members[NIPC_MEMBER_LANES];
+
+	/**
+	 * @name  {std::atomic<long>}  id
+	 * @brief  The ID of the multicast channel, or `0` if the entry is free.
+	 */
+	std::atomic<long> id;
+
+	/**
+	 * @name  {uint32_t}  count
+	 * @brief  The number of subscribers of the channel.
+	 */
+	uint32_t count;
+
+	/**
+	 * @name  {uint32_t}  next_free
+	 * @brief  The index of the next free entry when this entry is on the free list.
+	 */
+	uint32_t next_free;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  sent
+	 * @brief  The number of messages multicast to the channel since its entry was taken.
+	 */
+	std::atomic<uint64_t> sent;
+};
+
+/**
+ * @name  nipc_registry
+ * @brief  The fixed-capacity subscriber registry of a NIPC instance, stored entirely inside its shared memory segment.
+ * @remark  PIDs are mapped to entries through an open-addressing hash index with linear probing; removals shift the following buckets back rather than leaving tombstones, so lookups never degrade over time.
+ * @remark  Multicast channels are indexed the same way, and each channel entry holds a bitmap of its subscribers, so that the recipients of a multicast to any number of channels are found by OR-ing bitmaps rather than by comparing entries.
+ * @remark  Writers serialise on a process-shared robust mutex and bump `sequence` around every change.  Readers never lock; they retry whenever `sequence` was odd or changed while they were reading.
+ */
+struct nipc_registry
+{
+	/**
+	 * @name  {pthread_mutex_t}  lock
+	 * @brief  The process-shared mutex serialising changes to the registry.
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  sequence
+	 * @brief  The sequence counter of the registry; odd while a change is in progress.
+	 */
+	std::atomic<uint32_t> sequence;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  count
+	 * @brief  The number of subscribed processes.
+	 */
+	std::atomic<uint32_t> count;
+
+	/**
+	 * @name  {uint32_t}  free_list
+	 * @brief  The index of the first free entry.
+	 */
+	uint32_t free_list;
+
+	/**
+	 * @name  {std::atomic<uint32_t>[NIPC_INDEX_CAPACITY]}  index
+	 * @brief  The hash index mapping PIDs to entries; empty buckets hold `NIPC_NONE`.
+	 */
+	std::atomic<uint32_t> index[NIPC_INDEX_CAPACITY];
+
+	/**
+	 * @name  {uint32_t}  channel_free_list
+	 * @brief  The index of the first free channel entry.
+	 */
+	uint32_t channel_free_list;
+
+	/**
+	 * @name  {std::atomic<uint32_t>[NIPC_INDEX_CAPACITY]}  channel_index
+	 * @brief  The hash index mapping multicast channel IDs to channel entries; empty buckets hold `NIPC_NONE`.
+	 */
+	std::atomic<uint32_t> channel_index[NIPC_INDEX_CAPACITY];
+
+	/**
+	 * @name  {nipc_channel[NIPC_MAX_SUBSCRIBERS]}  channels
+	 * @brief  The channel entries.
+	 */
+	nipc_channel channels[NIPC_MAX_SUBSCRIBERS];
+
+	/**
+	 * @name  {std::atomic<uint32_t>[NIPC_MAX_SUBSCRIBERS]}  members
+	 * @brief  The densely packed indices of all occupied entries, used to enumerate subscribers without scanning free entries.
+	 */
+	std::atomic<uint32_t> members[NIPC_MAX_SUBSCRIBERS];
+
+	/**
+	 * @name  {nipc_subscriber[NIPC_MAX_SUBSCRIBERS]}  entries
+	 * @brief  The subscriber entries.
+	 */
+	nipc_subscriber entries[NIPC_MAX_SUBSCRIBERS];
+};
+
+/**
+ * @name  nipc_ring_slot
+ * @brief  A slot of the message ring of a NIPC instance using `NIPC_TRANSPORT_RING`.
+ */
+struct nipc_ring_slot
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  sequence
+	 * @brief  The state of the slot: `2 * position + 1` while the message at `position` is being written and `2 * position + 2` once it is published.
+	 * @remark  Readers copy the slot and then check that `sequence` did not change, discarding copies torn by a writer lapping them.  Writers only take the slot over from the published state of the message a lap behind theirs.
+	 */
+	std::atomic<uint64_t> sequence;
+
+	/**
+	 * @name  {std::atomic<pid_t>}  writer
+	 * @brief  The PID of the process that last took the slot over to write a message, or `0` if none has yet.
+	 * @remark  It is recorded before `sequence` is marked as being written, so a slot left being written by a process that died can be told apart and reclaimed.
+	 */
+	std::atomic<pid_t> writer;
+
+	/**
+	 * @name  {long}  target
+	 * @brief  The `type` the message was sent with, used by readers to pick the messages addressed to them.
+	 */
+	long target;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  held
+	 * @brief  The reference the slot holds to the payload of its message in the slab, or `0` if it holds none.
+	 * @remark  It is dropped when the slot is overwritten, or earlier if the slab runs out of room; whoever exchanges it for `0` drops it.
+	 */
+	std::atomic<uint64_t> held;
+
+	/**
+	 * @name  {nipc_wire}  message
+	 * @brief  The message.
+	 */
+	nipc_wire message;
+};
+
+/**
+ * @name  nipc_ring
+ * @brief  The header of the single-write, multi-read message ring of a NIPC instance using `NIPC_TRANSPORT_RING`.
+ * @remark  The slots of the ring follow the instance in its shared memory segment.
+ * @remark  Writers take short turns to claim positions and mark their slots, then fill the slots in concurrently, so any number of processes may send at once.  Writers never wait for readers; a reader that is lapped skips ahead to the oldest message still in the ring.
+ * @remark  A writer that dies before publishing the slots it claimed does not hold the ring up: the next writer to take its turn, or the next reader or writer to find one of its slots still being written, publishes them as messages nobody receives.
+ */
+struct nipc_ring
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  head
+	 * @brief  The position the next message will be written at.
+	 */
+	std::atomic<uint64_t> head;
+
+	/**
+	 * @name  {uint64_t}  mask
+	 * @brief  The number of slots minus one, used to map positions to slots.
+	 */
+	uint64_t mask;
+
+	/**
+	 * @name  {std::atomic<pid_t>}  claimant
+	 * @brief  The PID of the writer whose turn it is to claim positions, or `0` if it is nobody's.
+	 */
+	std::atomic<pid_t> claimant;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  claimed
+	 * @brief  The first position claimed by the last writer to take its turn.
+	 */
+	std::atomic<uint64_t> claimed;
+};
+
+/**
+ * @name  nipc_conflation_slot
+ * @brief  The slot holding the latest value of a conflated channel of a NIPC instance.
+ * @remark  Writers take turns through `version`; readers copy the slot and then check that `version` did not change, discarding copies torn by a writer.
+ */
+struct alignas(64) nipc_conflation_slot
+{
+	/**
+	 * @name  {std::atomic<long>}  channel
+	 * @brief  The ID of the conflated channel, or `0` if the slot is free.
+	 */
+	std::atomic<long> channel;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  version
+	 * @brief  Twice the number of values written to the slot, plus one while a value is being written; `0` until the first value is written.
+	 */
+	std::atomic<uint64_t> version;
+
+	/**
+	 * @name  {nipc_wire}  message
+	 * @brief  The latest value; it holds its own reference to a payload in the slab, dropped when it is overwritten.
+	 */
+	nipc_wire message;
+};
+
+/**
+ * @name  nipc_log_segment
+ * @brief  The header at the start of every log segment file, which its records follow.
+ */
+struct nipc_log_segment
+{
+	/**
+	 * @name  {uint64_t}  magic
+	 * @brief  Holds `NIPC_LOG_MAGIC`.
+	 */
+	uint64_t magic;
+
+	/**
+	 * @name  {uint64_t}  first
+	 * @brief  The sequence number of the first message logged in the segment; the segment ends where the next one begins.
+	 */
+	uint64_t first;
+
+	/**
+	 * @name  {uint64_t}  created
+	 * @brief  The time the segment was started at, in seconds since the epoch.
+	 */
+	uint64_t created;
+
+	/**
+	 * @name  {uint64_t}  sealed
+	 * @brief  The time the segment was filled at, in seconds since the epoch; `0` while it is being written.
+	 */
+	uint64_t sealed;
+};
+
+/**
+ * @name  nipc_log_record
+ * @brief  The header of a message in a log segment.
+ * @remark  It is followed by the `channels` additional channels the message was sent on and by the whole payload, padded to 8 bytes.
+ */
+struct nipc_log_record
+{
+	/**
+	 * @name  {std::atomic<uint32_t>}  size
+	 * @brief  The size of the record in bytes, padding included; `0` past the last record.
+	 * @remark  It is written last, so a record with a size is complete.
+	 */
+	std::atomic<uint32_t> size;
+
+	/**
+	 * @name  {uint32_t}  channels
+	 * @brief  The number of channels following the header, if the message was sent on several channels; the first of them is `target`.
+	 */
+	uint32_t channels;
+
+	/**
+	 * @name  {uint64_t}  sequence
+	 * @brief  The sequence number of the message.
+	 */
+	uint64_t sequence;
+
+	/**
+	 * @name  {long}  target
+	 * @brief  The `type` the message was sent with.
+	 */
+	long target;
+
+	/**
+	 * @name  {long}  channel
+	 * @brief  The channel of the message.
+	 */
+	long channel;
+
+	/**
+	 * @name  {pid_t}  sender
+	 * @brief  The PID of the process that sent the message.
+	 */
+	pid_t sender;
+
+	/**
+	 * @name  {uint32_t}  length
+	 * @brief  The length of the payload in bytes.
+	 */
+	uint32_t length;
+
+	/**
+	 * @name  {uint64_t}  timestamp
+	 * @brief  The time the message was sent at, in nanoseconds of `CLOCK_MONOTONIC`.
+	 */
+	uint64_t timestamp;
+};
+
+/**
+ * @name  nipc_log
+ * @brief  The state of the log of a NIPC instance, whose segments are files named after `nipc_options::log_path`.
+ * @remark  Senders append under `lock`, so sequence numbers follow the order of the records.  Every process maps the segment it writes to on its own.
+ */
+struct nipc_log
+{
+	/**
+	 * @name  {pthread_mutex_t}  lock
+	 * @brief  The process-shared robust mutex serialising appends.
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @name  {uint64_t}  first
+	 * @brief  The index of the oldest segment kept.
+	 */
+	uint64_t first;
+
+	/**
+	 * @name  {uint64_t}  segment
+	 * @brief  The index of the segment being written.
+	 */
+	uint64_t segment;
+
+	/**
+	 * @name  {uint64_t}  offset
+	 * @brief  The offset in the segment being written at which the next record goes.
+	 */
+	uint64_t offset;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  next
+	 * @brief  The sequence number of the next message to be logged; every message below it is complete.
+	 */
+	std::atomic<uint64_t> next;
+};
+
+/**
+ * @name  nipc_call_slot
+ * @brief  A slot of a NIPC instance holding a call in flight: its request, and its reply once the callee answers.
+ * @remark  `state` moves the call through its phases with compare-and-swap, and counts the calls made through the slot so that a callee answering an abandoned call cannot touch the next one.  The callee copies the request and then takes it by swapping the state it read, discarding copies torn by a caller that gave up meanwhile.
+ */
+struct alignas(64) nipc_call_slot
+{
+	/**
+	 * @name  {std::atomic<pid_t>}  owner
+	 * @brief  The PID of the process holding the slot, or `0` if it is free.
+	 */
+	std::atomic<pid_t> owner;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  state
+	 * @brief  The number of calls made through the slot times 8, plus the phase of the current one; the futex word the caller sleeps on.
+	 */
+	std::atomic<uint32_t> state;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  sleeping
+	 * @brief  Set while the caller sleeps on `state`, so that the callee only makes a system call to wake it when needed.
+	 */
+	std::atomic<uint32_t> sleeping;
+
+	/**
+	 * @name  {std::atomic<pid_t>}  callee
+	 * @brief  The PID of the process the current call is made to.
+	 */
+	std::atomic<pid_t> callee;
+
+	/**
+	 * @name  {nipc_wire}  request
+	 * @brief  The request of the current call.
+	 */
+	nipc_wire request;
+
+	/**
+	 * @name  {nipc_wire}  reply
+	 * @brief  The reply to the current call, once it reached `NIPC_CALL_REPLIED`.
+	 */
+	nipc_wire reply;
+};
+
+/**
+ * @name  nipc_responder
+ * @brief  A process answering calls on a NIPC instance.
+ */
+struct alignas(64) nipc_responder
+{
+	/**
+	 * @name  {std::atomic<pid_t>}  pid
+	 * @brief  The PID of the process, or `0` if the entry is free.
+	 */
+	std::atomic<pid_t> pid;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  doorbell
+	 * @brief  Incremented by every call made to the process; the futex word its threads sleep on.
+	 */
+	std::atomic<uint32_t> doorbell;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  sleepers
+	 * @brief  The number of threads of the process sleeping on `doorbell`.
+	 */
+	std::atomic<uint32_t> sleepers;
+
+	/**
+	 * @name  {std::atomic<uint64_t>[NIPC_MAX_CALLS / 64]}  pending
+	 * @brief  The slots that may hold a request for the process, one bit per slot.
+	 */
+	std::atomic<uint64_t> pending[NIPC_MAX_CALLS / 64];
+};
+
+/**
+ * @name  nipc_slab
+ * @brief  The header of the slab holding the payloads larger than `NIPC_INLINE_SIZE` of a NIPC instance.
+ * @remark  The slab is carved into blocks, and each payload takes a contiguous run of them.  Following the ring, the segment holds a reference count for every block, the length of the run starting at every block, a bitmap of the blocks in use and finally the blocks themselves.
+ * @remark  The reference count of the first block of a run carries the run's generation in its high 32 bits, bumped on every allocation, so a reader holding a stale reference can never pin a run that was recycled.
+ */
+struct nipc_slab
+{
+	/**
+	 * @name  {pthread_mutex_t}  lock
+	 * @brief  The process-shared robust mutex serialising allocations of runs.
+	 * @remark  Runs are freed without it, as the last reference to a run may be dropped in a signal handler that interrupted an allocation.
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @name  {uint32_t}  blocks
+	 * @brief  The number of blocks in the slab; `0` if the instance has no slab.
+	 */
+	uint32_t blocks;
+
+	/**
+	 * @name  {uint32_t}  block_size
+	 * @brief  The size of a block in bytes.
+	 */
+	uint32_t block_size;
+
+	/**
+	 * @name  {uint32_t}  hint
+	 * @brief  The block the next allocation starts searching from.
+	 */
+	uint32_t hint;
+
+	/**
+	 * @name  {uint64_t}  offset
+	 * @brief  The offset of the reference counts from the start of the instance.
+	 */
+	uint64_t offset;
+
+	/**
+	 * @name  {uint64_t}  data
+	 * @brief  The offset of the first block from the start of the instance.
+	 */
+	uint64_t data;
+};
+
+/**
+ * @name  nipc_trace_event
+ * @brief  An event of a trace buffer: one stage of a message's life, as run by one thread.
+ */
+struct nipc_trace_event
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  sequence
+	 * @brief  The position of the event in its buffer plus one once it is written, `0` while it is being written.
+	 */
+	std::atomic<uint64_t> sequence;
+
+	/**
+	 * @name  {uint64_t}  start
+	 * @brief  The time the stage started at, in nanoseconds of `CLOCK_MONOTONIC`.
+	 */
+	uint64_t start;
+
+	/**
+	 * @name  {uint64_t}  duration
+	 * @brief  The time the stage took, in nanoseconds.
+	 */
+	uint64_t duration;
+
+	/**
+	 * @name  {uint64_t}  flow
+	 * @brief  The time the send the stage belongs to started at, identifying it across processes; `0` if there is none.
+	 */
+	uint64_t flow;
+
+	/**
+	 * @name  {long}  argument
+	 * @brief  The detail of the stage: the number of recipients or messages, or the PID of the recipient.
+	 */
+	long argument;
+
+	/**
+	 * @name  {uint32_t}  stage
+	 * @brief  The stage; one of the `NIPC_TRACE_*` constants.
+	 */
+	uint32_t stage;
+
+	/**
+	 * @name  {pid_t}  thread
+	 * @brief  The thread ID of the thread that ran the stage.
+	 */
+	pid_t thread;
+};
+
+/**
+ * @name  nipc_trace_buffer
+ * @brief  The header of the trace buffer of a process, followed by its events in the instance's shared memory segment.
+ * @remark  The threads of the process claim positions with an atomic increment and publish each event through its `sequence`, so no lock is taken and readers can tell finished events from those being written.
+ */
+struct alignas(64) nipc_trace_buffer
+{
+	/**
+	 * @name  {std::atomic<pid_t>}  pid
+	 * @brief  The PID of the process owning the buffer, or `0` if it is free.
+	 */
+	std::atomic<pid_t> pid;
+
+	/**
+	 * @name  {uint32_t}  mask
+	 * @brief  The number of events in the buffer minus one, used to map positions to events.
+	 */
+	uint32_t mask;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  head
+	 * @brief  The position the next event will be written at.
+	 */
+	std::atomic<uint64_t> head;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  origin
+	 * @brief  The position of the first event of the current owner; earlier events belong to a previous owner.
+	 */
+	std::atomic<uint64_t> origin;
+};
+
+/**
+ * @name  nipc_counters
+ * @brief  The counters of a NIPC instance, kept in its shared memory segment.
+ * @remark  Senders bump the message counters once per send and `delivered` once per record; the counters of subscribers are kept in their registry entries and folded in here when they unsubscribe.
+ */
+struct nipc_counters
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  broadcasts
+	 * @brief  The number of messages broadcast.
+	 */
+	alignas(64) std::atomic<uint64_t> broadcasts;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  multicasts
+	 * @brief  The number of messages multicast.
+	 */
+	std::atomic<uint64_t> multicasts;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  unicasts
+	 * @brief  The number of messages unicast.
+	 */
+	std::atomic<uint64_t> unicasts;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  delivered
+	 * @brief  The number of copies of messages delivered to recipients.
+	 */
+	std::atomic<uint64_t> delivered;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  overflowed
+	 * @brief  The number of copies of messages dropped by the overflow policy.
+	 */
+	std::atomic<uint64_t> overflowed;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  send_failures
+	 * @brief  The number of message queue writes that failed.
+	 */
+	std::atomic<uint64_t> send_failures;
+
+	/**
+	 * @name  {std::atomic<int>}  send_error
+	 * @brief  The error of the last message queue write that failed.
+	 */
+	std::atomic<int> send_error;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  notify_failures
+	 * @brief  The number of recipients that could not be signalled.
+	 */
+	std::atomic<uint64_t> notify_failures;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  reaped
+	 * @brief  The number of subscribers reaped; it also picks the slot of `nipc_instance::reaped` the next one is recorded in.
+	 */
+	std::atomic<uint64_t> reaped;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  purged
+	 * @brief  The number of messages purged from the inboxes of processes gone from the registry.
+	 */
+	std::atomic<uint64_t> purged;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  reclaimed
+	 * @brief  The number of ring slots reclaimed from writers that died before publishing them.
+	 */
+	std::atomic<uint64_t> reclaimed;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  received
+	 * @brief  The number of messages received by subscribers that have unsubscribed.
+	 */
+	std::atomic<uint64_t> received;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  dropped
+	 * @brief  The number of messages dropped by subscribers that have unsubscribed.
+	 */
+	std::atomic<uint64_t> dropped;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  lapped
+	 * @brief  The number of ring positions skipped by subscribers that have unsubscribed.
+	 */
+	std::atomic<uint64_t> lapped;
+
+	/**
+	 * @name  {std::atomic<uint64_t>[NIPC_LATENCY_BUCKETS]}  latency
+	 * @brief  The latency histogram of subscribers that have unsubscribed.
+	 */
+	std::atomic<uint64_t> latency[NIPC_LATENCY_BUCKETS];
+
+	/**
+	 * @name  {std::atomic<uint64_t>[NIPC_LANES - 1][NIPC_LATENCY_BUCKETS]}  urgent_latency
+	 * @brief  The latency histograms of the messages received on every lane above `0`, starting with lane `1`, across every subscriber.
+	 * @remark  Urgent messages are few, so they are counted here directly rather than in a histogram per lane in every registry entry; the histogram of lane `0` is what is left of the subscribers' own.
+	 */
+	std::atomic<uint64_t> urgent_latency[NIPC_LANES - 1][NIPC_LATENCY_BUCKETS];
+};
+
+/**
+ * @name  nipc_instance
+ * @brief  The state of a NIPC instance shared by every process that opened it.
+ */
+struct nipc_instance
+{
+	/**
+	 * @name  {std::atomic<uint32_t>}  magic
+	 * @brief  Holds `NIPC_MAGIC` once the instance has been fully initialised.
+	 */
+	std::atomic<uint32_t> magic;
+
+	/**
+	 * @name  {nipc_options}  options
+	 * @brief  The options the instance was created with.
+	 */
+	nipc_options options;
+
+	/**
+	 * @name  {nipc_registry}  registry
+	 * @brief  The subscriber registry of the instance.
+	 */
+	nipc_registry registry;
+
+	/**
+	 * @name  {int[NIPC_MAX_SHARDS]}  queues
+	 * @brief  The IDs of the message queues holding the inboxes of subscribers, one per shard; the first is the queue with the instance's key.
+	 */
+	int queues[NIPC_MAX_SHARDS];
+
+	/**
+	 * @name  {nipc_ring}  ring
+	 * @brief  The message ring of the instance, if it uses `NIPC_TRANSPORT_RING`.
+	 */
+	nipc_ring ring;
+
+	/**
+	 * @name  {nipc_slab}  slab
+	 * @brief  The slab holding the large payloads of the instance.
+	 */
+	nipc_slab slab;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  conflated
+	 * @brief  The number of conflated channels, whose slots are the first of `conflation`; it only grows, under the registry lock.
+	 */
+	std::atomic<uint32_t> conflated;
+
+	/**
+	 * @name  {nipc_conflation_slot[NIPC_MAX_CONFLATED]}  conflation
+	 * @brief  The slots holding the latest values of the conflated channels.
+	 */
+	nipc_conflation_slot conflation[NIPC_MAX_CONFLATED];
+
+	/**
+	 * @name  {nipc_log}  log
+	 * @brief  The state of the instance's log, if it has one.
+	 */
+	nipc_log log;
+
+	/**
+	 * @name  {nipc_call_slot[NIPC_MAX_CALLS]}  calls
+	 * @brief  The slots of the calls in flight.
+	 */
+	nipc_call_slot calls[NIPC_MAX_CALLS];
+
+	/**
+	 * @name  {nipc_responder[NIPC_MAX_RESPONDERS]}  responders
+	 * @brief  The processes answering calls.
+	 */
+	nipc_responder responders[NIPC_MAX_RESPONDERS];
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  swept
+	 * @brief  The time of the last sweep for dead subscribers, in nanoseconds of `CLOCK_MONOTONIC`.
+	 */
+	std::atomic<uint64_t> swept;
+
+	/**
+	 * @name  {std::atomic<pid_t>[NIPC_MAX_REAPED]}  reaped
+	 * @brief  The PIDs of the subscribers reaped since the last sweep, or `0`; the next sweep purges their inboxes again, in case a send that resolved them before they were reaped wrote to them afterwards.
+	 */
+	std::atomic<pid_t> reaped[NIPC_MAX_REAPED];
+
+	/**
+	 * @name  {nipc_counters}  stats
+	 * @brief  The counters of the instance.
+	 */
+	nipc_counters stats;
+};
+
+struct nipc_receiver;
+struct nipc_handle;
+
+/**
+ * @name  nipc_worker
+ * @brief  A worker thread running the notification handler of a subscription, fed by its receiver thread.
+ * @remark  The queue is a single-producer, single-consumer ring: only the receiver thread advances `head` and only the worker advances `tail`, so neither side ever locks.
+ */
+struct nipc_worker
+{
+	/**
+	 * @name  {std::atomic<uint64_t>}  head
+	 * @brief  The position the receiver thread will queue the next message at.
+	 */
+	alignas(64) std::atomic<uint64_t> head;
+
+	/**
+	 * @name  {std::atomic<uint64_t>}  tail
+	 * @brief  The position of the next message the worker will handle.
+	 */
+	alignas(64) std::atomic<uint64_t> tail;
+
+	/**
+	 * @name  {std::atomic<uint32_t>}  futex
+	 * @brief  The futex word the worker parks on when its queue is empty; one of `NIPC_RUNNING`, `NIPC_NOTIFIED` or `NIPC_PARKED`.
+	 */
+	alignas(64) std::atomic<uint32_t> futex;
+
+	/**
+	 * @name  {nipc_receiver*}  receiver
+	 * @brief  The receiver thread feeding the worker.
+	 */
+	nipc_receiver* receiver;
+
+	/**
+	 * @name  {pthread_t}  thread
+	 * @brief  The worker thread.
+	 */
+	pthread_t thread;
+
+	/**
+	 * @name  {nipc_message[NIPC_BATCH_SIZE]}  batch
+	 * @brief  The buffer the worker moves messages into before handling them, so that their queue slots are freed early.
+	 */
+	nipc_message batch[NIPC_BATCH_SIZE];
+
+	/**
+	 * @name  {nipc_message[NIPC_WORKER_QUEUE_SIZE]}  queue
+	 * @brief  The messages queued for the worker.
+	 */
+	nipc_message queue[NIPC_WORKER_QUEUE_SIZE];
+};
+
+/**
+ * @name  nipc_receiver
+ * @brief  The receiver thread serving a subscription to a NIPC instance using `NIPC_WAKEUP_FUTEX` or worker threads.
+ */
+struct nipc_receiver
+{
+	/**
+	 * @name  {int}  id
+	 * @brief  The ID of the NIPC instance.
+	 */
+	int id;
+
+	/**
+	 * @name  {nipc_instance*}  instance
+	 * @brief  The NIPC instance.
+	 */
+	nipc_instance* instance;
+
+	/**
+	 * @name  {uint32_t}  subscriber
+	 * @brief  The index of this process's entry in the instance's registry.
+	 */
+	uint32_t subscriber;
+
+	/**
+	 * @name  {const nipc_handle*}  handle
+	 * @brief  The state this process keeps for the instance, which holds the notification handlers.
+	 */
+	const nipc_handle* handle;
+
+	/**
+	 * @name  {std::atomic<bool>}  stopping
+	 * @brief  Set when the thread must exit.
+	 */
+	std::atomic<bool> stopping;
+
+	/**
+	 * @name  {pthread_t}  thread
+	 * @brief  The receiver thread.
+	 */
+	pthread_t thread;
+
+	/**
+	 * @name  {unsigned int}  workers
+	 * @brief  The number of worker threads running the notification handler; `0` if the receiver thread runs it itself.
+	 */
+	unsigned int workers;
+
+	/**
+	 * @name  {nipc_worker*}  pool
+	 * @brief  The worker threads.
+	 */
+	nipc_worker* pool;
+
+	/**
+	 * @name  {nipc_trace_buffer*}  trace
+	 * @brief  The trace buffer of this process, or `nullptr` if it does not trace.
+	 */
+	nipc_trace_buffer* trace;
+
+	/**
+	 * @name  {nipc_message[NIPC_BATCH_SIZE]}  batch
+	 * @brief  The buffer the thread drains messages into.
+	 */
+	nipc_message batch[NIPC_BATCH_SIZE];
+
+	/**
+	 * @name  {nipc_inbox}  inbox
+	 * @brief  The record the thread receives messages from.
+	 */
+	nipc_inbox inbox;
+};
+
+/**
+ * @name  nipc_handle
+ * @brief  The state this process keeps for a NIPC instance it opened.
+ */
+struct nipc_handle
+{
+	/**
+	 * @name  {nipc_instance*}  instance
+	 * @brief  The instance's shared memory segment.
+	 */
+	nipc_instance* instance;
+
+	/**
+	 * @name  {uint32_t}  subscriber
+	 * @brief  The index of this process's entry in the instance's registry, or `NIPC_NONE` if it has not subscribed.
+	 */
+	uint32_t subscriber;
+
+	/**
+	 * @name  {nipc_receiver*}  receiver
+	 * @brief  The receiver thread serving the subscription, if the instance uses `NIPC_WAKEUP_FUTEX` or the subscription uses worker threads.
+	 */
+	nipc_receiver* receiver;
+
+	/**
+	 * @name  {nipc_trace_buffer*}  trace
+	 * @brief  The trace buffer of this process, if the instance traces and one was claimed.
+	 */
+	nipc_trace_buffer* trace;
+
+	/**
+	 * @name  {nipc_handler_t}  handler
+	 * @brief  The function handler to invoke with every message from the instance, if `batch_handler` is not set.
+	 */
+	nipc_handler_t handler;
+
+	/**
+	 * @name  {nipc_batch_handler_t}  batch_handler
+	 * @brief  The function handler to invoke with every batch of messages from the instance; takes precedence over `handler` when set.
+	 */
+	nipc_batch_handler_t batch_handler;
+
+	/**
+	 * @name  {int}  fd
+	 * @brief  The socket senders notify this process through, if it subscribed with `nipc_subscribe_poll()`; `-1` otherwise.
+	 */
+	int fd;
+
+	/**
+	 * @name  {nipc_inbox*}  inbox
+	 * @brief  The record `nipc_recv()` receives messages from, if the process subscribed with `nipc_subscribe_poll()`.
+	 */
+	nipc_inbox* inbox;
+
+	/**
+	 * @name  {std::vector<uint32_t>}  held
+	 * @brief  The slab blocks of the payloads last returned by `nipc_recv()` or `nipc_recv_many()`, released on the next call.
+	 */
+	std::vector<uint32_t> held;
+
+	/**
+	 * @name  {char*}  log_map
+	 * @brief  The log segment this process last appended to, mapped, or `nullptr`.
+	 */
+	char* log_map;
+
+	/**
+	 * @name  {uint64_t}  log_segment
+	 * @brief  The index of the log segment mapped at `log_map`.
+	 */
+	uint64_t log_segment;
+
+	/**
+	 * @name  {uint64_t}  replayed_from
+	 * @brief  The sequence number the subscription replayed the log from, if it did.
+	 */
+	uint64_t replayed_from;
+
+	/**
+	 * @name  {uint64_t}  replayed_to
+	 * @brief  The sequence number the replay stopped before; live messages from `replayed_from` up to it were already replayed and are dropped.
+	 */
+	uint64_t replayed_to;
+
+	/**
+	 * @name  {uint32_t}  responder
+	 * @brief  The index of this process's entry among the instance's responders, or `NIPC_NONE` if it does not answer calls.
+	 */
+	uint32_t responder;
+};
+
+/**
+ * @name  _subscription_list
+ * @brief  A list of all NIPC instances opened by this process.
+ * @remark  The key is the ID of the NIPC instance and the value is the state this process keeps for it.
+ */
+std::unordered_map<int, nipc_handle> _subscription_list;
+
+/**
+ * @name  _batch
+ * @brief  The buffer the signal handler drains messages into.
+ * @remark  The signal handler is never re-entered because `NIPC_SIGNAL` is blocked while it runs.
+ */
+nipc_message _batch[NIPC_BATCH_SIZE];
+
+/**
+ * @name  _inbox
+ * @brief  The record the signal handler receives messages from.
+ */
+nipc_inbox _inbox;
+
+/**
+ * @name  _pool
+ * @brief  The message buffers of the process's message pool, or `nullptr` if it has none.
+ * @remark  Published once the pool is linked, so the signal handler never sees a partially built pool.
+ */
+std::atomic<nipc_message*> _pool(nullptr);
+
+/**
+ * @name  _pool_size
+ * @brief  The number of message buffers in the process's message pool.
+ */
+uint32_t _pool_size = 0;
+
+/**
+ * @name  _pool_next
+ * @brief  The index of the next free buffer after each free buffer of the process's message pool, or `NIPC_NONE` at the end of the free list.
+ */
+std::atomic<uint32_t>* _pool_next = nullptr;
+
+/**
+ * @name  _pool_head
+ * @brief  The head of the free list of the process's message pool.
+ * @remark  The low 32 bits hold the index of the first free buffer, or `NIPC_NONE`; the high 32 bits hold a tag bumped on every change so that a stale head never passes a compare-and-swap.
+ */
+std::atomic<uint64_t> _pool_head(NIPC_NONE);
+
+/**
+ * @name  _pool_owners
+ * @brief  The NIPC instance whose slab holds the payload of each buffer of the process's message pool, or `nullptr` if the buffer holds no reference to a slab.
+ * @remark  Whoever swaps an entry back to `nullptr` drops the reference, so a buffer released while its instance is being closed is dropped once.
+ */
+std::atomic<nipc_instance*>* _pool_owners = nullptr;
+
+/**
+ * @name  _pool_blocks
+ * @brief  The first block of the run of the slab each buffer of the process's message pool holds a reference to, as recorded in `_pool_owners`.
+ */
+uint32_t* _pool_blocks = nullptr;
+
+/**
+ * @name  _pool_free
+ * @brief  The number of buffers of the process's message pool that are free and not reserved.
+ * @remark  Buffers are counted out of it before they are taken off the free list and back in once they are returned to it, so a reserved buffer is always there to take.
+ */
+std::atomic<uint32_t> _pool_free(0);
+
+/**
+ * @name  _pool_starved
+ * @brief  Set when a drain stopped for want of a buffer in the process's message pool, so that the next buffer released has the messages left pending delivered.
+ */
+std::atomic<bool> _pool_starved(false);
+
+/**
+ * @name  _notifier
+ * @brief  The unbound socket this process sends notifications to polled subscribers from, or `-1` until it first does.
+ */
+std::atomic<int> _notifier(-1);
+
+/**
+ * @name  _trace_thread
+ * @brief  The thread ID of the calling thread, looked up on its first traced event; `0` until then.
+ */
+thread_local pid_t _trace_thread = 0;
+
+/**
+ * @name  _nipc_bucket()
+ * @brief  Computes the home bucket of a key in a registry index.
+ * @param  key  {const long}  The key to hash; either a PID or a multicast channel ID.
+ * @return  {const uint32_t}  The index of the key's home bucket.
+ */
+inline const uint32_t _nipc_bucket(const long key) { return static_cast<uint32_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> 32) & (NIPC_INDEX_CAPACITY - 1); }
+
+/**
+ * @name  _nipc_index_find()
+ * @brief  Finds the entry of a key in a registry index.
+ * @param  index  {const std::atomic<uint32_t>* const}  The buckets of the index.
+ * @param  key  {const long}  The key to find.
+ * @param  key_of  {const KeyOf&}  Returns the key of an entry.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The index of the key's entry, or `NIPC_NONE` if it is not indexed.
+ */
+template <typename KeyOf> const uint32_t _nipc_index_find(const std::atomic<uint32_t>* const index, const long key, const KeyOf& key_of)
+{
+	// Probe the index from the key's home bucket until the key or an empty bucket is found.
+	// The probe is bounded by the capacity so that a torn read cannot loop forever.
+	for (uint32_t bucket = _nipc_bucket(key), probes = 0; probes < NIPC_INDEX_CAPACITY; bucket = (bucket + 1) & (NIPC_INDEX_CAPACITY - 1), ++probes)
+	{
+		const uint32_t entry = index[bucket].load(std::memory_order_relaxed); // The entry referenced by the bucket.
+		if (entry == NIPC_NONE) return NIPC_NONE;
+		if (entry < NIPC_MAX_SUBSCRIBERS && key_of(entry) == key) return entry;
+	}
+
+	// The key is not indexed.
+	return NIPC_NONE;
+}
+
+/**
+ * @name  _nipc_index_insert()
+ * @brief  Inserts an entry into a registry index under the given key.
+ * @param  index  {std::atomic<uint32_t>* const}  The buckets of the index.
+ * @param  key  {const long}  The key of the entry.
+ * @param  entry  {const uint32_t}  The entry to insert.
+ * @remark  The caller must hold the registry lock and ensure the key is not indexed yet.
+ */
+void _nipc_index_insert(std::atomic<uint32_t>* const index, const long key, const uint32_t entry)
+{
+	// Insert the entry into the first empty bucket of the key's probe sequence.
+	uint32_t bucket = _nipc_bucket(key); // The bucket to store the entry in.
+	while (index[bucket].load(std::memory_order_relaxed) != NIPC_NONE) bucket = (bucket + 1) & (NIPC_INDEX_CAPACITY - 1);
+	index[bucket].store(entry, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_index_erase()
+ * @brief  Removes a key from a registry index.
+ * @param  index  {std::atomic<uint32_t>* const}  The buckets of the index.
+ * @param  key  {const long}  The key to remove.
+ * @param  key_of  {const KeyOf&}  Returns the key of an entry.
+ * @remark  The caller must hold the registry lock.
+ * @remark  Every following bucket whose home lies at or before the vacated bucket is shifted back, so no probe sequence is broken.
+ */
+template <typename KeyOf> void _nipc_index_erase(std::atomic<uint32_t>* const index, const long key, const KeyOf& key_of)
+{
+	// Find the bucket holding the key; if the key is not indexed, there is nothing to do.
+	uint32_t bucket = _nipc_bucket(key); // The bucket holding the key's entry.
+	uint32_t entry; // The entry of the key.
+	while ((entry = index[bucket].load(std::memory_order_relaxed)) != NIPC_NONE && key_of(entry) != key) bucket = (bucket + 1) & (NIPC_INDEX_CAPACITY - 1);
+	if (entry == NIPC_NONE) return;
+
+	// Shift the following buckets back until an empty bucket is reached.
+	for (uint32_t next = (bucket + 1) & (NIPC_INDEX_CAPACITY - 1); ; next = (next + 1) & (NIPC_INDEX_CAPACITY - 1))
+	{
+		const uint32_t moved = index[next].load(std::memory_order_relaxed); // The entry that may be shifted back.
+		if (moved == NIPC_NONE) break;
+		const uint32_t home = _nipc_bucket(key_of(moved)); // The home bucket of the entry.
+		if (((next - home) & (NIPC_INDEX_CAPACITY - 1)) >= ((next - bucket) & (NIPC_INDEX_CAPACITY - 1))) { index[bucket].store(moved, std::memory_order_relaxed); bucket = next; }
+	}
+	index[bucket].store(NIPC_NONE, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_lock()
+ * @brief  Acquires the lock of a registry and marks the start of a change.
+ * @param  registry  {nipc_registry* const}  The registry to lock.
+ * @remark  If the previous owner died while holding the lock, the lock is made consistent again and the sequence counter is evened out so readers stop retrying.
+ * @throws  ENOLCK  If the lock could not be acquired.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_lock(nipc_registry* const registry)
+{
+	// Acquire the lock.
+	const int status = pthread_mutex_lock(&registry->lock); // The result of locking the mutex.
+
+	// If the previous owner died mid-change, recover the lock and close the change it left open.
+	if (status == EOWNERDEAD)
+	{
+		pthread_mutex_consistent(&registry->lock);
+		if (registry->sequence.load(std::memory_order_relaxed) & 1) registry->sequence.fetch_add(1, std::memory_order_release);
+	}
+
+	// If the lock could not be acquired, return an error.
+	else if (status) { errno = ENOLCK; return -1; }
+
+	// Mark the start of a change so that concurrent readers retry.
+	registry->sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_unlock()
+ * @brief  Marks the end of a change and releases the lock of a registry.
+ * @param  registry  {nipc_registry* const}  The registry to unlock.
+ */
+void _nipc_unlock(nipc_registry* const registry)
+{
+	// Mark the end of the change and release the lock.
+	registry->sequence.fetch_add(1, std::memory_order_release);
+	pthread_mutex_unlock(&registry->lock);
+}
+
+/**
+ * @name  _nipc_read()
+ * @brief  Runs a read-only operation against a registry without locking it, retrying until it observes a consistent state.
+ * @param  registry  {const nipc_registry* const}  The registry to read.
+ * @param  read  {const Read&}  The operation to run; it must only read the registry and may be run more than once.
+ * @return  The result of the last run of `read`.
+ */
+template <typename Read> auto _nipc_read(const nipc_registry* const registry, const Read& read)
+{
+	while (true)
+	{
+		// Wait until no change is in progress.
+		const uint32_t sequence = registry->sequence.load(std::memory_order_acquire); // The sequence counter before reading.
+		if (sequence & 1) { sched_yield(); continue; }
+
+		// Run the operation and keep its result if no change happened meanwhile.
+		const auto result = read();
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (registry->sequence.load(std::memory_order_relaxed) == sequence) return result;
+	}
+}
+
+/**
+ * @name  _nipc_find()
+ * @brief  Finds the entry of a PID in a registry.
+ * @param  registry  {const nipc_registry* const}  The registry to search.
+ * @param  pid  {const pid_t}  The PID to find.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The index of the PID's entry, or `NIPC_NONE` if it is not registered.
+ */
+const uint32_t _nipc_find(const nipc_registry* const registry, const pid_t pid) { return _nipc_index_find(registry->index, pid, [registry](const uint32_t entry) -> long { return registry->entries[entry].pid.load(std::memory_order_relaxed); }); }
+
+/**
+ * @name  _nipc_find_channel()
+ * @brief  Finds the entry of a multicast channel in a registry.
+ * @param  registry  {const nipc_registry* const}  The registry to search.
+ * @param  channel  {const long}  The ID of the multicast channel to find.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The index of the channel's entry, or `NIPC_NONE` if the channel has no subscribers.
+ */
+const uint32_t _nipc_find_channel(const nipc_registry* const registry, const long channel) { return _nipc_index_find(registry->channel_index, channel, [registry](const uint32_t entry) -> long { return registry->channels[entry].id.load(std::memory_order_relaxed); }); }
+
+/**
+ * @name  _nipc_member()
+ * @brief  Locates the bit of a subscriber entry in a subscriber bitmap.
+ * @param  members  {nipc_lane* const}  The bitmap.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry.
+ * @return  {uint64_t&}  The word holding the bit; the bit itself is `entry % 64`.
+ */
+inline uint64_t& _nipc_member(nipc_lane* const members, const uint32_t entry) { return reinterpret_cast<uint64_t*>(members)[entry / 64]; }
+
+/**
+ * @name  _nipc_join()
+ * @brief  Adds a multicast channel to those a subscriber follows, creating the channel's entry if needed.
+ * @param  registry  {nipc_registry* const}  The registry to update.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry.
+ * @param  channel  {const long}  The ID of the multicast channel to join.
+ * @remark  The caller must hold the registry lock.
+ * @remark  Joining a channel the subscriber already follows does nothing.
+ * @throws  ENOSPC  If the subscriber already follows `NIPC_MAX_CHANNELS` channels, or the registry has no channel entry left.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_join(nipc_registry* const registry, const uint32_t entry, const long channel)
+{
+	// A subscriber follows every channel at most once, and only so many of them.
+	nipc_subscriber& subscriber = registry->entries[entry]; // The subscriber joining the channel.
+	const uint32_t count = subscriber.channel_count.load(std::memory_order_relaxed); // The number of channels the subscriber follows.
+	for (uint32_t index = 0; index < count; ++index) if (subscriber.channels[index].load(std::memory_order_relaxed) == channel) return 0;
+	if (count == NIPC_MAX_CHANNELS) { errno = ENOSPC; return -1; }
+
+	// Find the channel's entry; if the channel has no subscribers yet, take an entry off the free list and index it.
+	uint32_t record = _nipc_find_channel(registry, channel); // The entry of the channel.
+	if (record == NIPC_NONE)
+	{
+		record = registry->channel_free_list;
+		if (record == NIPC_NONE) { errno = ENOSPC; return -1; }
+		registry->channel_free_list = registry->channels[record].next_free;
+		registry->channels[record].id.store(channel, std::memory_order_relaxed);
+		for (uint32_t lane = 0; lane < NIPC_MEMBER_LANES; ++lane) registry->channels[record].members[lane] = nipc_lane{};
+		registry->channels[record].count = 0;
+		registry->channels[record].sent.store(0, std::memory_order_relaxed);
+		_nipc_index_insert(registry->channel_index, channel, record);
+	}
+
+	// Add the subscriber to the channel's bitmap and the channel to the subscriber's channels.
+	nipc_channel& target = registry->channels[record]; // The channel being joined.
+	_nipc_member(target.members, entry) |= 1ULL << (entry % 64);
+	++target.count;
+	subscriber.channels[count].store(channel, std::memory_order_relaxed);
+	subscriber.channel_count.store(count + 1, std::memory_order_relaxed);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_leave()
+ * @brief  Removes a multicast channel from those a subscriber follows, releasing the channel's entry once it has no subscribers left.
+ * @param  registry  {nipc_registry* const}  The registry to update.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry.
+ * @param  channel  {const long}  The ID of the multicast channel to leave.
+ * @remark  The caller must hold the registry lock.
+ * @throws  ENOENT  If the subscriber does not follow the channel.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_leave(nipc_registry* const registry, const uint32_t entry, const long channel)
+{
+	// Find the channel among the subscriber's channels.
+	nipc_subscriber& subscriber = registry->entries[entry]; // The subscriber leaving the channel.
+	const uint32_t count = subscriber.channel_count.load(std::memory_order_relaxed); // The number of channels the subscriber follows.
+	uint32_t position = 0; // The position of the channel among the subscriber's channels.
+	while (position < count && subscriber.channels[position].load(std::memory_order_relaxed) != channel) ++position;
+	if (position == count) { errno = ENOENT; return -1; }
+
+	// Remove it, keeping the others in the order they were subscribed to.
+	for (; position + 1 < count; ++position) subscriber.channels[position].store(subscriber.channels[position + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	subscriber.channel_count.store(count - 1, std::memory_order_relaxed);
+
+	// Remove the subscriber from the channel's bitmap.
+	const uint32_t record = _nipc_find_channel(registry, channel); // The entry of the channel.
+	nipc_channel& target = registry->channels[record]; // The channel being left.
+	_nipc_member(target.members, entry) &= ~(1ULL << (entry % 64));
+
+	// If the channel has no members left, remove it from the index and release its entry.
+	if (--target.count) return 0;
+	_nipc_index_erase(registry->channel_index, channel, [registry](const uint32_t other) -> long { return registry->channels[other].id.load(std::memory_order_relaxed); });
+	target.id.store(0, std::memory_order_relaxed);
+	target.next_free = registry->channel_free_list;
+	registry->channel_free_list = record;
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_follows()
+ * @brief  Tells whether a subscriber follows a multicast channel, from the list of channels kept in its own entry.
+ * @param  subscriber  {const nipc_subscriber&}  The subscriber.
+ * @param  channel  {const long}  The ID of the multicast channel.
+ * @remark  The list is read once without the registry lock or a retry, so this is safe in a signal handler that interrupted a registry update.  `_nipc_join()` and `_nipc_leave()` keep every other channel in the list at all times, so only a channel being joined or left concurrently may be missed.
+ * @return  {const bool}  `true` if the subscriber follows the channel.
+ */
+const bool _nipc_follows(const nipc_subscriber& subscriber, const long channel)
+{
+	const uint32_t count = std::min<uint32_t>(subscriber.channel_count.load(std::memory_order_relaxed), NIPC_MAX_CHANNELS); // The number of channels the subscriber follows.
+	for (uint32_t index = 0; index < count; ++index) if (subscriber.channels[index].load(std::memory_order_relaxed) == channel) return true;
+	return false;
+}
+
+/**
+ * @name  _nipc_unregister()
+ * @brief  Removes a PID from a registry.
+ * @param  registry  {nipc_registry* const}  The registry to update.
+ * @param  pid  {const pid_t}  The PID to remove.
+ * @remark  The caller must hold the registry lock.
+ * @remark  Removing a PID that is not registered does nothing.
+ */
+void _nipc_unregister(nipc_registry* const registry, const pid_t pid)
+{
+	// Find the entry of the PID; if the PID is not registered, there is nothing to do.
+	const uint32_t entry = _nipc_find(registry, pid); // The entry of the PID.
+	if (entry == NIPC_NONE) return;
+
+	// Remove the subscriber from its channels and from the index.
+	for (uint32_t count = registry->entries[entry].channel_count.load(std::memory_order_relaxed); count; --count) _nipc_leave(registry, entry, registry->entries[entry].channels[count - 1].load(std::memory_order_relaxed));
+	_nipc_index_erase(registry->index, pid, [registry](const uint32_t other) -> long { return registry->entries[other].pid.load(std::memory_order_relaxed); });
+
+	// Remove the entry from the member list by moving the last member into its position.
+	const uint32_t last = registry->count.load(std::memory_order_relaxed) - 1; // The position of the last member.
+	const uint32_t tail = registry->members[last].load(std::memory_order_relaxed); // The entry of the last member.
+	registry->members[registry->entries[entry].position].store(tail, std::memory_order_relaxed);
+	registry->entries[tail].position = registry->entries[entry].position;
+	registry->count.store(last, std::memory_order_relaxed);
+
+	// Release the entry.
+	registry->entries[entry].pid.store(0, std::memory_order_relaxed);
+	registry->entries[entry].next_free = registry->free_list;
+	registry->free_list = entry;
+}
+
+/**
+ * @name  _nipc_register()
+ * @brief  Registers a PID in a registry under a multicast channel, or adds that channel to its channels if it is already registered.
+ * @param  registry  {nipc_registry* const}  The registry to update.
+ * @param  pid  {const pid_t}  The PID to register.
+ * @param  channel  {const long}  The multicast channel to add to the PID's channels.
+ * @param  cursor  {const uint64_t}  The ring position a newly registered PID starts reading at.
+ * @remark  The caller must hold the registry lock.
+ * @throws  ENOSPC  If the registry is full, or the channel cannot be joined.
+ * @return  {const uint32_t}  The index of the PID's entry on success, `NIPC_NONE` on failure.
+ */
+const uint32_t _nipc_register(nipc_registry* const registry, const pid_t pid, const long channel, const uint64_t cursor)
+{
+	// If the PID is already registered, add the channel to its channels.
+	const uint32_t existing = _nipc_find(registry, pid); // The entry of the PID, if any.
+	if (existing != NIPC_NONE) return _nipc_join(registry, existing, channel) == -1 ? NIPC_NONE : existing;
+
+	// Take an entry off the free list; if none is left, return an error.
+	const uint32_t entry = registry->free_list; // The entry to assign to the PID.
+	if (entry == NIPC_NONE) { errno = ENOSPC; return NIPC_NONE; }
+	registry->free_list = registry->entries[entry].next_free;
+
+	// Fill in the entry, append it to the member list and index it.
+	const uint32_t count = registry->count.load(std::memory_order_relaxed); // The number of subscribers before this one.
+	registry->entries[entry].pid.store(pid, std::memory_order_relaxed);
+	registry->entries[entry].cursor.store(cursor, std::memory_order_relaxed);
+	registry->entries[entry].futex.store(NIPC_RUNNING, std::memory_order_relaxed);
+	registry->entries[entry].signalled.store(0, std::memory_order_relaxed);
+	registry->entries[entry].polled.store(0, std::memory_order_relaxed);
+	registry->entries[entry].stale.store(0, std::memory_order_relaxed);
+	for (uint32_t slot = 0; slot < NIPC_MAX_CONFLATED; ++slot) registry->entries[entry].seen[slot] = 0;
+	registry->entries[entry].channel_count.store(0, std::memory_order_relaxed);
+	registry->entries[entry].delivered.store(0, std::memory_order_relaxed);
+	registry->entries[entry].evicted.store(0, std::memory_order_relaxed);
+	registry->entries[entry].overflowed.store(0, std::memory_order_relaxed);
+	registry->entries[entry].received.store(0, std::memory_order_relaxed);
+	registry->entries[entry].dropped.store(0, std::memory_order_relaxed);
+	registry->entries[entry].lapped.store(0, std::memory_order_relaxed);
+	for (uint32_t lane = 0; lane < NIPC_LANES; ++lane) registry->entries[entry].queued[lane].store(0, std::memory_order_relaxed);
+	for (uint32_t bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) registry->entries[entry].latency[bucket].store(0, std::memory_order_relaxed);
+	registry->entries[entry].position = count;
+	registry->members[count].store(entry, std::memory_order_relaxed);
+	registry->count.store(count + 1, std::memory_order_relaxed);
+	_nipc_index_insert(registry->index, pid, entry);
+
+	// Add the subscriber to its channel; if the channel cannot be joined, release the entry again.
+	if (_nipc_join(registry, entry, channel) == -1) { const int error = errno; _nipc_unregister(registry, pid); errno = error; return NIPC_NONE; }
+
+	// Return the entry of the PID.
+	return entry;
+}
+
+/**
+ * @name  _nipc_ring_slots()
+ * @brief  Locates the slots of the message ring of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @return  {nipc_ring_slot* const}  The first slot of the ring.
+ */
+inline nipc_ring_slot* const _nipc_ring_slots(nipc_instance* const instance) { return reinterpret_cast<nipc_ring_slot*>(instance + 1); }
+
+/**
+ * @name  _nipc_slab_blocks()
+ * @brief  Computes the number of blocks in the slab of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @return  {const size_t}  The number of blocks.
+ */
+inline const size_t _nipc_slab_blocks(const nipc_options& options) { return options.slab_block_size ? options.slab_size / options.slab_block_size : 0; }
+
+/**
+ * @name  _nipc_slab_offset()
+ * @brief  Computes the offset of the slab's reference counts from the start of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @return  {const size_t}  The offset in bytes, aligned to a cache line.
+ */
+inline const size_t _nipc_slab_offset(const nipc_options& options) { return (sizeof(nipc_instance) + (options.transport == NIPC_TRANSPORT_RING ? options.ring_slots * sizeof(nipc_ring_slot) : 0) + 63) & ~static_cast<size_t>(63); }
+
+/**
+ * @name  _nipc_slab_data_offset()
+ * @brief  Computes the offset of the slab's first block from the start of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @remark  The reference counts, the run lengths and the bitmap sit between the ring and the blocks.
+ * @return  {const size_t}  The offset in bytes, aligned to a cache line.
+ */
+inline const size_t _nipc_slab_data_offset(const nipc_options& options)
+{
+	const size_t blocks = _nipc_slab_blocks(options); // The number of blocks in the slab.
+	return (_nipc_slab_offset(options) + blocks * sizeof(uint64_t) + ((blocks * sizeof(uint32_t) + 7) & ~static_cast<size_t>(7)) + (blocks + 63) / 64 * sizeof(uint64_t) + 63) & ~static_cast<size_t>(63);
+}
+
+/**
+ * @name  _nipc_trace_offset()
+ * @brief  Computes the offset of the first trace buffer from the start of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @remark  The trace buffers follow the slab's blocks.
+ * @return  {const size_t}  The offset in bytes, aligned to a cache line.
+ */
+inline const size_t _nipc_trace_offset(const nipc_options& options) { return (_nipc_slab_data_offset(options) + _nipc_slab_blocks(options) * options.slab_block_size + 63) & ~static_cast<size_t>(63); }
+
+/**
+ * @name  _nipc_trace_stride()
+ * @brief  Computes the size of a trace buffer of a NIPC instance, header included.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @return  {const size_t}  The size in bytes, aligned to a cache line.
+ */
+inline const size_t _nipc_trace_stride(const nipc_options& options) { return (sizeof(nipc_trace_buffer) + options.trace_events * sizeof(nipc_trace_event) + 63) & ~static_cast<size_t>(63); }
+
+/**
+ * @name  _nipc_segment_size()
+ * @brief  Computes the size of the shared memory segment of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @return  {const size_t}  The size of the segment in bytes.
+ */
+const size_t _nipc_segment_size(const nipc_options& options) { return _nipc_trace_offset(options) + (options.trace_events ? options.trace_processes * _nipc_trace_stride(options) : 0); }
+
+/**
+ * @name  _nipc_slab_refs()
+ * @brief  Locates the reference counts of the slab of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @return  {std::atomic<uint64_t>* const}  The reference count of the first block.
+ */
+inline std::atomic<uint64_t>* const _nipc_slab_refs(nipc_instance* const instance) { return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(instance) + instance->slab.offset); }
+
+/**
+ * @name  _nipc_slab_runs()
+ * @brief  Locates the run lengths of the slab of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @return  {uint32_t* const}  The run length of the first block.
+ */
+inline uint32_t* const _nipc_slab_runs(nipc_instance* const instance) { return reinterpret_cast<uint32_t*>(_nipc_slab_refs(instance) + instance->slab.blocks); }
+
+/**
+ * @name  _nipc_slab_bitmap()
+ * @brief  Locates the bitmap of the blocks in use in the slab of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @remark  Bits are set under the slab's lock but cleared without it, so every word is updated atomically.
+ * @return  {std::atomic<uint64_t>* const}  The first word of the bitmap.
+ */
+inline std::atomic<uint64_t>* const _nipc_slab_bitmap(nipc_instance* const instance) { return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(_nipc_slab_runs(instance)) + ((instance->slab.blocks * sizeof(uint32_t) + 7) & ~static_cast<size_t>(7))); }
+
+/**
+ * @name  _nipc_slab_data()
+ * @brief  Locates the first block of the slab of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @return  {char* const}  The first byte of the first block.
+ */
+inline char* const _nipc_slab_data(nipc_instance* const instance) { return reinterpret_cast<char*>(instance) + instance->slab.data; }
+
+/**
+ * @name  _nipc_slab_lock()
+ * @brief  Acquires the lock of the slab of a NIPC instance.
+ * @param  slab  {nipc_slab* const}  The slab to lock.
+ * @remark  If the previous owner died while holding the lock, the lock is made consistent again; at worst, the run it was allocating is leaked.
+ * @throws  ENOLCK  If the lock could not be acquired.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_slab_lock(nipc_slab* const slab)
+{
+	// Acquire the lock, recovering it if its previous owner died.
+	const int status = pthread_mutex_lock(&slab->lock); // The result of locking the mutex.
+	if (status == EOWNERDEAD) pthread_mutex_consistent(&slab->lock);
+	else if (status) { errno = ENOLCK; return -1; }
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_slab_alloc()
+ * @brief  Allocates a run of blocks large enough for a payload from the slab of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  length  {const size_t}  The length of the payload in bytes.
+ * @remark  The run is found first-fit, starting where the previous allocation ended.  It is returned holding a single reference, owned by the caller.
+ * @throws  EMSGSIZE  If the payload is larger than the slab.
+ * @throws  ENOBUFS  If no run of free blocks is large enough for the payload.
+ * @throws  ENOLCK  If the slab could not be locked.
+ * @return  {const uint64_t}  The reference to the run on success, `0` on failure.
+ */
+const uint64_t _nipc_slab_alloc(nipc_instance* const instance, const size_t length)
+{
+	// Ensure the payload can fit in the slab at all.
+	nipc_slab* const slab = &instance->slab; // The slab of the instance.
+	const size_t count = (length + slab->block_size - 1) / (slab->block_size ? slab->block_size : 1); // The number of blocks the payload needs.
+	if (!slab->blocks || count > slab->blocks) { errno = EMSGSIZE; return 0; }
+	if (_nipc_slab_lock(slab) == -1) return 0;
+
+	// Look for a run of free blocks, wrapping around once; runs never span the end of the slab.
+	std::atomic<uint64_t>* const bitmap = _nipc_slab_bitmap(instance); // The bitmap of the blocks in use.
+	uint32_t found = NIPC_NONE; // The first block of the run found.
+	for (uint32_t step = 0, run = 0; step < slab->blocks + count && found == NIPC_NONE; ++step)
+	{
+		const uint32_t block = (slab->hint + step) % slab->blocks; // The block being looked at.
+		if (!block) run = 0;
+		if ((bitmap[block / 64].load(std::memory_order_acquire) >> (block % 64)) & 1) run = 0;
+		else if (++run == count) found = block + 1 - count;
+	}
+
+	// If no run is large enough, return an error.
+	if (found == NIPC_NONE) { pthread_mutex_unlock(&slab->lock); errno = ENOBUFS; return 0; }
+
+	// Mark the run as in use and start its next generation with the caller's reference.
+	for (uint32_t block = found; block < found + count; ++block) bitmap[block / 64].fetch_or(1ULL << (block % 64), std::memory_order_relaxed);
+	_nipc_slab_runs(instance)[found] = count;
+	std::atomic<uint64_t>& refs = _nipc_slab_refs(instance)[found]; // The reference count of the run.
+	uint64_t generation = (refs.load(std::memory_order_relaxed) >> 32) + 1; // The generation of the run.
+	if (generation > UINT32_MAX) generation = 1;
+	refs.store((generation << 32) | 1, std::memory_order_release);
+	slab->hint = (found + count) % slab->blocks;
+	pthread_mutex_unlock(&slab->lock);
+
+	// Return the reference to the run.
+	return (generation << 32) | found;
+}
+
+/**
+ * @name  _nipc_slab_pin()
+ * @brief  Takes a reference to a run of the slab of a NIPC instance, unless it was recycled.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  reference  {const uint64_t}  The reference to the run, as found in a message.
+ * @remark  The reference count is only incremented if it is not zero and still carries the generation of the reference.
+ * @return  {const bool}  `true` if a reference was taken, `false` if the run was freed or recycled.
+ */
+const bool _nipc_slab_pin(nipc_instance* const instance, const uint64_t reference)
+{
+	// Ignore references to blocks outside the slab.
+	const uint32_t block = static_cast<uint32_t>(reference); // The first block of the run.
+	if (block >= instance->slab.blocks) return false;
+
+	// Increment the reference count while the run is alive and of the same generation.
+	std::atomic<uint64_t>& refs = _nipc_slab_refs(instance)[block]; // The reference count of the run.
+	uint64_t word = refs.load(std::memory_order_relaxed); // The generation and reference count of the run.
+	while ((word >> 32) == (reference >> 32) && (word & UINT32_MAX)) if (refs.compare_exchange_weak(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+	return false;
+}
+
+/**
+ * @name  _nipc_slab_release()
+ * @brief  Drops a reference to a run of the slab of a NIPC instance, freeing the run once the last reference is dropped.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  block  {const uint32_t}  The first block of the run.
+ * @remark  The run is freed by clearing its bits in the bitmap atomically, without taking the slab's lock, so this is safe in a signal handler.
+ */
+void _nipc_slab_release(nipc_instance* const instance, const uint32_t block)
+{
+	// Ignore blocks outside the slab and keep the run while references to it remain.
+	if (block >= instance->slab.blocks) return;
+	if ((_nipc_slab_refs(instance)[block].fetch_sub(1, std::memory_order_acq_rel) & UINT32_MAX) != 1) return;
+
+	// Mark the run as free; no reference is left to it, so nothing else touches its bits until it is allocated again.
+	std::atomic<uint64_t>* const bitmap = _nipc_slab_bitmap(instance); // The bitmap of the blocks in use.
+	const uint32_t end = std::min(block + _nipc_slab_runs(instance)[block], instance->slab.blocks); // The block after the run.
+	for (uint32_t index = block; index < end; ++index) bitmap[index / 64].fetch_and(~(1ULL << (index % 64)), std::memory_order_release);
+}
+
+/**
+ * @name  _nipc_slab_block()
+ * @brief  Finds the first block of the run holding a received payload.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  blob  {const void* const}  The payload.
+ * @return  {const uint32_t}  The index of the block.
+ */
+inline const uint32_t _nipc_slab_block(nipc_instance* const instance, const void* const blob) { return static_cast<uint32_t>((static_cast<const char*>(blob) - _nipc_slab_data(instance)) / instance->slab.block_size); }
+
+/**
+ * @name  _nipc_wire_size()
+ * @brief  Computes the number of bytes of a message that cross the transport.
+ * @param  wire  {const nipc_wire&}  The message.
+ * @return  {const size_t}  The size of the message's header, plus its payload if it is stored inline.
+ */
+inline const size_t _nipc_wire_size(const nipc_wire& wire) { return offsetof(nipc_wire, data) + (wire.block ? 0 : std::min<size_t>(wire.length, NIPC_INLINE_SIZE)); }
+
+/**
+ * @name  _nipc_wire_size()
+ * @brief  Computes the number of bytes a message to be sent will take on the transport.
+ * @param  message  {const nipc_message&}  The message.
+ * @return  {const size_t}  The size of the message's header, plus its payload if it fits inline.
+ */
+inline const size_t _nipc_wire_size(const nipc_message& message) { return offsetof(nipc_wire, data) + (message.length <= NIPC_INLINE_SIZE ? message.length : 0); }
+
+/**
+ * @name  _nipc_stride()
+ * @brief  Computes the room a message takes in a record.
+ * @param  size  {const size_t}  The number of bytes of the message that cross the transport.
+ * @return  {const size_t}  The size rounded up to a multiple of 8 bytes, keeping the next message aligned.
+ */
+inline const size_t _nipc_stride(const size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+/**
+ * @name  _nipc_now()
+ * @brief  Reads the clock messages are timestamped with.
+ * @return  {const uint64_t}  The current time in nanoseconds of `CLOCK_MONOTONIC`, which every process of the machine shares.
+ */
+inline const uint64_t _nipc_now()
+{
+	timespec now; // The current time.
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+/**
+ * @name  _nipc_latency_bucket()
+ * @brief  Maps a latency to its bucket of a latency histogram.
+ * @param  latency  {const uint64_t}  The latency in nanoseconds.
+ * @return  {const uint32_t}  The index of the bucket: `0` under 1 µs, `i` for [2^(i-1), 2^i) µs, capped at the last bucket.
+ */
+inline const uint32_t _nipc_latency_bucket(const uint64_t latency)
+{
+	const uint64_t microseconds = latency / 1000; // The latency in whole microseconds.
+	return microseconds ? std::min<uint32_t>(64 - __builtin_clzll(microseconds), NIPC_LATENCY_BUCKETS - 1) : 0;
+}
+
+/**
+ * @name  _nipc_count_latency()
+ * @brief  Counts how long a message took to reach a subscriber of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  self  {nipc_subscriber&}  The entry of the subscriber.
+ * @param  message  {const nipc_message&}  The message.
+ * @param  now  {const uint64_t}  The time the message is handed over at.
+ * @remark  Messages on lanes above `0` are also counted in the instance's histogram of their lane, which the subscribers share.
+ */
+inline void _nipc_count_latency(nipc_instance* const instance, nipc_subscriber& self, const nipc_message& message, const uint64_t now)
+{
+	const uint32_t bucket = _nipc_latency_bucket(now > message.timestamp ? now - message.timestamp : 0); // The bucket of the latency.
+	self.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+	if (message.priority) instance->stats.urgent_latency[message.priority - 1][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_trace_buffer()
+ * @brief  Locates a trace buffer of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  index  {const uint32_t}  The index of the buffer.
+ * @return  {nipc_trace_buffer* const}  The header of the buffer.
+ */
+inline nipc_trace_buffer* const _nipc_trace_buffer(nipc_instance* const instance, const uint32_t index) { return reinterpret_cast<nipc_trace_buffer*>(reinterpret_cast<char*>(instance) + _nipc_trace_offset(instance->options) + index * _nipc_trace_stride(instance->options)); }
+
+/**
+ * @name  _nipc_trace_events()
+ * @brief  Locates the events of a trace buffer.
+ * @param  buffer  {nipc_trace_buffer* const}  The trace buffer.
+ * @return  {nipc_trace_event* const}  The first event.
+ */
+inline nipc_trace_event* const _nipc_trace_events(nipc_trace_buffer* const buffer) { return reinterpret_cast<nipc_trace_event*>(buffer + 1); }
+
+/**
+ * @name  _nipc_trace_claim()
+ * @brief  Claims a trace buffer of a NIPC instance for this process.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @remark  The buffer this process already owns is reused.  Otherwise a free buffer is taken, or failing that one left behind by a process that exited; the events of its previous owner are discarded.
+ * @return  {nipc_trace_buffer* const}  The buffer, or `nullptr` if the instance does not trace or every buffer is taken.
+ */
+nipc_trace_buffer* const _nipc_trace_claim(nipc_instance* const instance)
+{
+	// Instances created without tracing have no buffers.
+	if (!instance->options.trace_events) return nullptr;
+	const pid_t self = getpid(); // The PID of this process.
+
+	// Look for a buffer of this process first, then for a free one, then for one of a process that exited.
+	for (int pass = 0; pass < 3; ++pass) for (uint32_t index = 0; index < instance->options.trace_processes; ++index)
+	{
+		nipc_trace_buffer* const buffer = _nipc_trace_buffer(instance, index); // The buffer.
+		pid_t owner = buffer->pid.load(std::memory_order_relaxed); // The owner of the buffer.
+		if (pass == 0 && owner == self) return buffer;
+		if (pass == 1 && owner != 0) continue;
+		if (pass == 2 && (!owner || kill(owner, 0) == 0 || errno != ESRCH)) continue;
+		if (pass && buffer->pid.compare_exchange_strong(owner, self)) { buffer->origin.store(buffer->head.load(std::memory_order_relaxed), std::memory_order_release); return buffer; }
+	}
+
+	// Every buffer is taken.
+	return nullptr;
+}
+
+/**
+ * @name  _nipc_trace()
+ * @brief  Records a stage that just ended in a trace buffer.
+ * @param  buffer  {nipc_trace_buffer* const}  The trace buffer of this process.
+ * @param  stage  {const uint32_t}  The stage; one of the `NIPC_TRACE_*` constants.
+ * @param  start  {const uint64_t}  The time the stage started at.
+ * @param  flow  {const uint64_t}  The time the send the stage belongs to started at, or `0`.
+ * @param  argument  {const long}  The detail of the stage.
+ * @remark  Lock-free and async-signal-safe, so it may be called from the signal handler.
+ */
+void _nipc_trace(nipc_trace_buffer* const buffer, const uint32_t stage, const uint64_t start, const uint64_t flow, const long argument)
+{
+	// Claim the next position of the buffer and mark its event as being written.
+	const uint64_t end = _nipc_now(); // The time the stage ended at.
+	const uint64_t position = buffer->head.fetch_add(1, std::memory_order_relaxed); // The position of the event.
+	nipc_trace_event& event = _nipc_trace_events(buffer)[position & buffer->mask]; // The event.
+	event.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	// Fill the event in and publish it.
+	if (!_trace_thread) _trace_thread = static_cast<pid_t>(syscall(SYS_gettid));
+	event.start = start;
+	event.duration = end - start;
+	event.flow = flow;
+	event.argument = argument;
+	event.stage = stage;
+	event.thread = _trace_thread;
+	event.sequence.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * @name  _nipc_record_walk()
+ * @brief  Visits every message packed in a record.
+ * @param  data  {const char* const}  The first message of the record.
+ * @param  count  {const size_t}  The number of messages in the record.
+ * @param  visit  {const Visit&}  The operation to run on every message; it receives the message as a `const nipc_wire&`.
+ */
+template <typename Visit> void _nipc_record_walk(const char* const data, const size_t count, const Visit& visit)
+{
+	// Step from message to message by their strides.
+	const char* cursor = data; // The message being visited.
+	for (size_t index = 0; index < count; ++index)
+	{
+		const nipc_wire& wire = *reinterpret_cast<const nipc_wire*>(cursor); // The message.
+		visit(wire);
+		cursor += _nipc_stride(_nipc_wire_size(wire));
+	}
+}
+
+/**
+ * @name  _nipc_ring_evict()
+ * @brief  Drops the reference the oldest slot of the message ring of a NIPC instance still holding one holds to a payload in the slab.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @remark  Used when the slab runs out of room.  Subscribers that have not read the message yet lose it, as if they were lapped; those reading it keep their own reference.
+ * @return  {const bool}  `true` if a reference was dropped, `false` if the ring holds none.
+ */
+const bool _nipc_ring_evict(nipc_instance* const instance)
+{
+	// Only rings hold references of their own.
+	if (instance->options.transport != NIPC_TRANSPORT_RING) return false;
+
+	// Walk the ring from its oldest message and drop the first reference still held.
+	const uint64_t head = instance->ring.head.load(std::memory_order_acquire); // The position the next message will be written at.
+	const uint64_t slots = instance->ring.mask + 1; // The number of slots in the ring.
+	for (uint64_t position = head > slots ? head - slots : 0; position < head; ++position)
+	{
+		const uint64_t held = _nipc_ring_slots(instance)[position & instance->ring.mask].held.exchange(0, std::memory_order_acq_rel); // The reference held by the slot.
+		if (held) { _nipc_slab_release(instance, static_cast<uint32_t>(held)); return true; }
+	}
+
+	// The ring holds no reference.
+	return false;
+}
+
+/**
+ * @name  _nipc_pack()
+ * @brief  Converts a message to be sent to its form on the transport.
+ * @param  instance  {nipc_instance* const}  The NIPC instance the message is sent to.
+ * @param  message  {const nipc_message&}  The message.
+ * @param  wire  {nipc_wire* const}  The buffer to write the message to.
+ * @param  timestamp  {const uint64_t}  The time the message is sent at.
+ * @param  sequence  {const uint64_t}  The sequence number the message was logged under, or `0`.
+ * @remark  A payload larger than `NIPC_INLINE_SIZE` bytes is copied into a run of the slab, which the caller then holds a reference to.  If the slab is full, the oldest payloads held by the ring are evicted to make room.
+ * @throws  EINVAL  If a payload larger than `NIPC_INLINE_SIZE` bytes has no `blob`, or the message's `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If the payload is larger than the slab.
+ * @throws  ENOBUFS  If the slab does not have room for the payload.
+ * @throws  ENOLCK  If the slab could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_pack(nipc_instance* const instance, const nipc_message& message, nipc_wire* const wire, const uint64_t timestamp, const uint64_t sequence)
+{
+	// The message must travel on one of the lanes.
+	if (message.priority >= NIPC_LANES) { errno = EINVAL; return -1; }
+
+	// Copy the header.
+	wire->channel = message.channel;
+	wire->sender = message.sender;
+	wire->length = static_cast<uint32_t>(message.length);
+	wire->block = 0;
+	wire->timestamp = timestamp;
+	wire->sequence = sequence;
+
+	// Store small payloads inline.
+	if (message.length <= NIPC_INLINE_SIZE) { memcpy(wire->data, message.payload(), message.length); return 0; }
+
+	// Copy large payloads into the slab.
+	if (!message.blob) { errno = EINVAL; return -1; }
+	if (message.length > UINT32_MAX) { errno = EMSGSIZE; return -1; }
+	while (!(wire->block = _nipc_slab_alloc(instance, message.length))) if (errno != ENOBUFS || !_nipc_ring_evict(instance)) return -1;
+	memcpy(_nipc_slab_data(instance) + static_cast<size_t>(static_cast<uint32_t>(wire->block)) * instance->slab.block_size, message.blob, message.length);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_unpack()
+ * @brief  Converts a received message from its form on the transport.
+ * @param  instance  {nipc_instance* const}  The NIPC instance the message was received from.
+ * @param  wire  {const nipc_wire&}  The message as received.
+ * @param  message  {nipc_message* const}  The buffer to write the message to.
+ * @remark  A payload held in the slab is not copied; `blob` points at it in place.
+ */
+void _nipc_unpack(nipc_instance* const instance, const nipc_wire& wire, nipc_message* const message)
+{
+	// Copy the header.
+	message->channel = wire.channel;
+	message->sender = wire.sender;
+	message->priority = 0;
+	message->length = wire.length;
+	message->timestamp = wire.timestamp;
+	message->sequence = wire.sequence;
+
+	// Point at payloads held in the slab and copy inline payloads.
+	if (wire.block) { message->blob = _nipc_slab_data(instance) + static_cast<size_t>(static_cast<uint32_t>(wire.block)) * instance->slab.block_size; message->data[0] = '\0'; }
+	else { message->blob = nullptr; memcpy(message->data, wire.data, std::min<size_t>(wire.length, NIPC_INLINE_SIZE)); }
+}
+
+/**
+ * @name  _nipc_dead()
+ * @brief  Tells whether a process no longer exists.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @return  {const bool}  `true` if no process has the PID.
+ */
+inline const bool _nipc_dead(const pid_t pid) { return kill(pid, 0) == -1 && errno == ESRCH; }
+
+/**
+ * @name  _nipc_ring_skip()
+ * @brief  Publishes a slot of the message ring of a NIPC instance that is being written as a message nobody receives.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  slot  {nipc_ring_slot&}  The slot, which the calling process must have recorded itself as the writer of.
+ * @param  sequence  {const uint64_t}  The state of the slot, marked as being written.
+ * @remark  The reference the slot held to a payload in the slab, if it still held one, is dropped.
+ */
+void _nipc_ring_skip(nipc_instance* const instance, nipc_ring_slot& slot, const uint64_t sequence)
+{
+	const uint64_t held = slot.held.exchange(0, std::memory_order_acq_rel); // The reference the slot held to a payload in the slab.
+	if (held) _nipc_slab_release(instance, static_cast<uint32_t>(held));
+	slot.target = NIPC_RING_SKIPPED;
+	slot.message.length = 0;
+	slot.message.block = 0;
+	slot.sequence.store(sequence + 1, std::memory_order_release);
+	instance->stats.reclaimed.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_ring_reclaim()
+ * @brief  Reclaims a slot of the message ring of a NIPC instance that a writer that died left being written, publishing it as a message nobody receives.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  slot  {nipc_ring_slot&}  The slot.
+ * @remark  The reclaiming process records itself as the writer of the slot first, so only one process reclaims it, and one that dies while reclaiming it is reclaimed from in turn.
+ * @remark  Safe to call from a signal handler; `errno` is preserved.
+ * @return  {const bool}  `true` if the slot was reclaimed, `false` if it is not being written or its writer is alive.
+ */
+const bool _nipc_ring_reclaim(nipc_instance* const instance, nipc_ring_slot& slot)
+{
+	// Only a slot being written can be reclaimed.
+	const uint64_t sequence = slot.sequence.load(std::memory_order_acquire); // The state of the slot.
+	if (!(sequence & 1)) return false;
+
+	// Take the slot over from its writer if it died.
+	const int error = errno; // The error to preserve.
+	pid_t writer = slot.writer.load(std::memory_order_relaxed); // The writer of the slot.
+	const bool dead = writer && _nipc_dead(writer); // Whether the writer died.
+	errno = error;
+	if (!dead || !slot.writer.compare_exchange_strong(writer, getpid(), std::memory_order_acquire, std::memory_order_relaxed)) return false;
+
+	// If the slot was published meanwhile, the writer was not the one that left it; hand the slot back unless a new writer took it over already.
+	if (slot.sequence.load(std::memory_order_acquire) != sequence)
+	{
+		pid_t self = getpid(); // The PID of this process.
+		slot.writer.compare_exchange_strong(self, writer, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Publish the slot under a `type` nobody receives.
+	_nipc_ring_skip(instance, slot, sequence);
+	return true;
+}
+
+/**
+ * @name  _nipc_ring_mark()
+ * @brief  Waits for the message a lap behind a position of the message ring of a NIPC instance to be published, then marks the slot of the position as being written.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  position  {const uint64_t}  The position.
+ * @param  pid  {const pid_t}  The PID of the process writing the slot.
+ * @remark  While it waits, it checks now and then whether the writer of the message it waits for died, and reclaims the slot if so.
+ * @return  {nipc_ring_slot&}  The slot.
+ */
+nipc_ring_slot& _nipc_ring_mark(nipc_instance* const instance, const uint64_t position, const pid_t pid)
+{
+	const uint64_t slots = instance->ring.mask + 1; // The number of slots in the ring.
+	nipc_ring_slot& slot = _nipc_ring_slots(instance)[position & instance->ring.mask]; // The slot of the position.
+	const uint64_t previous = position >= slots ? 2 * (position - slots) + 2 : 0; // The state of the slot once the message a lap behind is published.
+	for (uint32_t spins = 1; slot.sequence.load(std::memory_order_acquire) != previous; ++spins)
+	{
+		if (spins % NIPC_RING_PATIENCE == 0) _nipc_ring_reclaim(instance, slot);
+		sched_yield();
+	}
+	slot.writer.store(pid, std::memory_order_relaxed);
+	slot.sequence.store(2 * position + 1, std::memory_order_release);
+	return slot;
+}
+
+/**
+ * @name  _nipc_ring_recover()
+ * @brief  Publishes the slots a writer that died while claiming positions of the message ring of a NIPC instance left behind as messages nobody receives.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @remark  The calling process must have taken the claimant's turn over.  The positions from `nipc_ring::claimed` up to `nipc_ring::head` were claimed by the writer, or by earlier ones that marked them all; those not marked yet are marked and published, and those left being written are reclaimed.
+ */
+void _nipc_ring_recover(nipc_instance* const instance)
+{
+	const pid_t self = getpid(); // The PID of this process.
+	const uint64_t head = instance->ring.head.load(std::memory_order_acquire); // The position past the last one claimed.
+	for (uint64_t position = instance->ring.claimed.load(std::memory_order_acquire); position < head; ++position)
+	{
+		nipc_ring_slot& slot = _nipc_ring_slots(instance)[position & instance->ring.mask]; // The slot of the position.
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire); // The state of the slot.
+		if (sequence == 2 * position + 1) _nipc_ring_reclaim(instance, slot);
+		else if (sequence < 2 * position + 1) _nipc_ring_skip(instance, _nipc_ring_mark(instance, position, self), 2 * position + 1);
+	}
+}
+
+/**
+ * @name  _nipc_ring_claim()
+ * @brief  Claims the next positions of the message ring of a NIPC instance and marks their slots as being written.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  count  {const uint64_t}  The number of positions, at most the number of slots in the ring.
+ * @remark  Writers take turns claiming positions through `nipc_ring::claimant`, and mark every slot they claimed before they hand the turn on, so that a writer dying at any point leaves either slots it marked, which are reclaimed by whoever comes across them, or a turn recording its PID, which the next writer takes over once it finds the PID dead.
+ * @return  {const uint64_t}  The first position claimed.
+ */
+const uint64_t _nipc_ring_claim(nipc_instance* const instance, const uint64_t count)
+{
+	const pid_t self = getpid(); // The PID of this process.
+
+	// Take the turn, or take it over from a claimant that died and publish what it left behind.
+	for (uint32_t spins = 1; ; ++spins)
+	{
+		pid_t claimant = 0; // The PID of the process whose turn it is.
+		if (instance->ring.claimant.compare_exchange_weak(claimant, self, std::memory_order_acquire, std::memory_order_relaxed)) break;
+		if (claimant && spins % NIPC_RING_PATIENCE == 0 && _nipc_dead(claimant) && instance->ring.claimant.compare_exchange_strong(claimant, self, std::memory_order_acquire, std::memory_order_relaxed)) { _nipc_ring_recover(instance); break; }
+		if (claimant) sched_yield();
+	}
+
+	// Claim the positions, mark their slots and hand the turn on.
+	const uint64_t first = instance->ring.head.load(std::memory_order_relaxed); // The first position claimed.
+	instance->ring.claimed.store(first, std::memory_order_relaxed);
+	instance->ring.head.store(first + count, std::memory_order_release);
+	for (uint64_t position = first; position < first + count; ++position) _nipc_ring_mark(instance, position, self);
+	std::atomic_thread_fence(std::memory_order_release);
+	instance->ring.claimant.store(0, std::memory_order_release);
+	return first;
+}
+
+/**
+ * @name  _nipc_ring_write()
+ * @brief  Writes the messages of a record to the message ring of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  target  {const long}  The `type` the messages are sent with.
+ * @param  data  {const char* const}  The first message of the record; the references to payloads in the slab, if any, are handed over to the ring.
+ * @param  count  {const size_t}  The number of messages in the record.
+ * @remark  The positions of up to a lap of messages are claimed at once, so they occupy consecutive slots.
+ * @remark  The reference an overwritten slot held to a payload in the slab, if it still held one, is dropped.
+ */
+void _nipc_ring_write(nipc_instance* const instance, const long target, const char* const data, const size_t count)
+{
+	const uint64_t slots = instance->ring.mask + 1; // The number of slots in the ring.
+	uint64_t left = count; // The number of messages whose positions are not claimed yet.
+	uint64_t position = 0, end = 0; // The position to write the next message at, and the one past the last claimed.
+
+	_nipc_record_walk(data, count, [&](const nipc_wire& message)
+	{
+		// Once the positions claimed are used up, claim those of up to a lap of the remaining messages.
+		if (position == end)
+		{
+			const uint64_t run = std::min(left, slots); // The number of positions to claim.
+			position = _nipc_ring_claim(instance, run);
+			end = position + run;
+			left -= run;
+		}
+
+		// Fill the slot in and publish it.
+		nipc_ring_slot& slot = _nipc_ring_slots(instance)[position & instance->ring.mask]; // The slot of the position.
+		const uint64_t held = slot.held.exchange(0, std::memory_order_acq_rel); // The reference the slot held to the payload of the overwritten message.
+		if (held) _nipc_slab_release(instance, static_cast<uint32_t>(held));
+		slot.target = target;
+		memcpy(&slot.message, &message, _nipc_wire_size(message));
+		slot.held.store(message.block, std::memory_order_relaxed);
+		slot.sequence.store(2 * position + 2, std::memory_order_release);
+		++position;
+	});
+}
+
+/**
+ * @name  _nipc_ring_read()
+ * @brief  Reads the next message addressed to a subscriber from the message ring of a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry in the registry.
+ * @param  message  {nipc_message* const}  The buffer to copy the message to.
+ * @remark  Messages addressed to other subscribers are skipped, as are slots reclaimed from writers that died, matching multicasts against the channels listed in the subscriber's own entry rather than the registry, so a signal handler never waits on a registry update it interrupted.  If the subscriber was lapped, it resumes at the oldest message still in the ring.
+ * @remark  A reference is taken to a payload held in the slab, to be dropped once the message is handled.
+ * @return  {const bool}  `true` if a message was read, `false` if none is pending.
+ */
+const bool _nipc_ring_read(nipc_instance* const instance, const uint32_t entry, nipc_message* const message)
+{
+	nipc_subscriber& self = instance->registry.entries[entry]; // The entry of the subscriber.
+	const long pid = self.pid.load(std::memory_order_relaxed); // The PID of the subscriber.
+	const uint64_t slots = instance->ring.mask + 1; // The number of slots in the ring.
+	uint64_t cursor = self.cursor.load(std::memory_order_relaxed); // The position of the next message to read.
+
+	while (true)
+	{
+		// If the message at the cursor has not been published yet, there is nothing left to read, unless its writer died and the slot can be reclaimed.
+		nipc_ring_slot& slot = _nipc_ring_slots(instance)[cursor & instance->ring.mask]; // The slot of the cursor.
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire); // The state of the slot.
+		if (sequence == 2 * cursor + 1 && _nipc_ring_reclaim(instance, slot)) continue;
+		if (sequence < 2 * cursor + 2) break;
+
+		// If the slot already holds a newer message, the subscriber was lapped; skip to the oldest message still in the ring.
+		if (sequence > 2 * cursor + 2)
+		{
+			const uint64_t head = instance->ring.head.load(std::memory_order_relaxed); // The position of the next message to be written.
+			const uint64_t resume = head - slots > cursor ? head - slots : cursor + 1; // The position to resume reading at.
+			self.lapped.fetch_add(resume - cursor, std::memory_order_relaxed);
+			cursor = resume;
+			continue;
+		}
+
+		// Copy the slot and discard the copy if a writer overwrote the slot meanwhile.
+		const long target = slot.target; // The `type` the message was sent with.
+		nipc_wire wire; // The copy of the message.
+		memcpy(&wire, &slot.message, offsetof(nipc_wire, data));
+		memcpy(wire.data, slot.message.data, _nipc_wire_size(wire) - offsetof(nipc_wire, data));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+		// Advance past the message and skip it unless it is addressed to the subscriber or to a channel it follows.
+		++cursor;
+		if (target && target != pid && (target > 0 || !_nipc_follows(self, target))) continue;
+
+		// Hold on to a payload in the slab; if it was recycled, the slot was overwritten since it was copied and the message is lost as if the subscriber was lapped.
+		if (wire.block && !_nipc_slab_pin(instance, wire.block)) continue;
+
+		// Deliver the message.
+		_nipc_unpack(instance, wire, message);
+		self.cursor.store(cursor, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Remember how far the subscriber has read.
+	self.cursor.store(cursor, std::memory_order_relaxed);
+	return false;
+}
+
+/**
+ * @name  _nipc_find_conflated()
+ * @brief  Looks up the conflation slot of a channel.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  channel  {const long}  The ID of the channel.
+ * @return  {const uint32_t}  The index of the channel's slot, or `NIPC_NONE` if the channel is not conflated.
+ */
+const uint32_t _nipc_find_conflated(nipc_instance* const instance, const long channel)
+{
+	const uint32_t count = instance->conflated.load(std::memory_order_acquire); // The number of conflated channels.
+	for (uint32_t slot = 0; slot < count; ++slot) if (instance->conflation[slot].channel.load(std::memory_order_relaxed) == channel) return slot;
+	return NIPC_NONE;
+}
+
+/**
+ * @name  _nipc_conflation_write()
+ * @brief  Overwrites the value of a conflated channel.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  slot  {const uint32_t}  The index of the channel's slot.
+ * @param  message  {const nipc_message&}  The new value.
+ * @param  timestamp  {const uint64_t}  The time the value is sent at.
+ * @param  sequence  {const uint64_t}  The sequence number the value was logged under, or `0`.
+ * @remark  Concurrent writers of the same slot take turns; the reference the previous value held to a payload in the slab is dropped once the new value is published.
+ * @throws  EINVAL  If the message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If the payload is larger than the instance's slab.
+ * @throws  ENOBUFS  If the instance's slab does not have room for the payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_conflation_write(nipc_instance* const instance, const uint32_t slot, const nipc_message& message, const uint64_t timestamp, const uint64_t sequence)
+{
+	// Pack the value before claiming the slot, so that the slot is held as briefly as possible.
+	nipc_wire wire; // The value.
+	if (_nipc_pack(instance, message, &wire, timestamp, sequence) == -1) return -1;
+
+	// Claim the slot by making its version odd, waiting for any other writer to finish first.
+	nipc_conflation_slot& target = instance->conflation[slot]; // The slot.
+	uint64_t version = target.version.load(std::memory_order_relaxed); // The version of the slot before this write.
+	while ((version & 1) || !target.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed)) if (version & 1) { sched_yield(); version = target.version.load(std::memory_order_relaxed); }
+	std::atomic_thread_fence(std::memory_order_release);
+
+	// Overwrite the value and publish it, then drop the previous value's payload.
+	const uint64_t held = target.message.block; // The reference the previous value held to its payload.
+	memcpy(&target.message, &wire, _nipc_wire_size(wire));
+	target.version.store(version + 2, std::memory_order_release);
+	if (held) _nipc_slab_release(instance, static_cast<uint32_t>(held));
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_conflation_read()
+ * @brief  Receives the latest value of a conflated channel that a subscriber has not read yet, if any.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry in the instance's registry.
+ * @param  message  {nipc_message* const}  The buffer to copy the value to.
+ * @remark  A slot's bit is cleared before the slot is read, so a value written meanwhile flags the slot again and is read next; a value read twice this way is skipped by its version.
+ * @remark  A slot still being written is left for later rather than waited on, as its writer flags it again once done; a signal handler that interrupted the writer would otherwise wait forever.
+ * @return  {const bool}  `true` if a value was received, `false` if none is pending.
+ */
+const bool _nipc_conflation_read(nipc_instance* const instance, const uint32_t entry, nipc_message* const message)
+{
+	nipc_subscriber& self = instance->registry.entries[entry]; // The entry of the subscriber.
+	for (uint64_t stale; (stale = self.stale.load(std::memory_order_relaxed));)
+	{
+		// Take the first flagged slot.
+		const uint32_t slot = static_cast<uint32_t>(__builtin_ctzll(stale)); // The index of the slot.
+		self.stale.fetch_and(~(1ULL << slot));
+		const nipc_conflation_slot& source = instance->conflation[slot]; // The slot.
+
+		while (true)
+		{
+			// Leave the value to be read once its writer finishes, and skip it if it was already read.
+			const uint64_t version = source.version.load(std::memory_order_acquire); // The version of the value.
+			if ((version & 1) || version == self.seen[slot]) break;
+
+			// Copy the value and discard the copy if a writer overwrote it meanwhile.
+			nipc_wire wire; // The copy of the value.
+			memcpy(&wire, &source.message, offsetof(nipc_wire, data));
+			memcpy(wire.data, source.message.data, _nipc_wire_size(wire) - offsetof(nipc_wire, data));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (source.version.load(std::memory_order_relaxed) != version) continue;
+
+			// Hold on to a payload in the slab; if it was recycled, the value was overwritten since it was copied, so read the new one.
+			if (wire.block && !_nipc_slab_pin(instance, wire.block)) continue;
+
+			// Deliver the value.
+			self.seen[slot] = version;
+			_nipc_unpack(instance, wire, message);
+			return true;
+		}
+	}
+
+	// No value is pending.
+	return false;
+}
+
+/**
+ * @name  _nipc_queue()
+ * @brief  Finds the message queue holding the inbox of a process.
+ * @param  instance  {const nipc_instance* const}  The NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @return  {const int}  The ID of the message queue of the shard the PID hashes to.
+ */
+inline const int _nipc_queue(const nipc_instance* const instance, const pid_t pid) { return instance->queues[static_cast<uint32_t>(pid) % instance->options.queue_shards]; }
+
+/**
+ * @name  _nipc_lane_type()
+ * @brief  Computes the message queue type of a lane of a process's inbox.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @param  lane  {const uint32_t}  The lane.
+ * @remark  Lane `0` is addressed by the PID alone, and the others by the lane in the high 32 bits, so each lane is a FIFO of its own within the process's shard.
+ * @return  {const long}  The type to send and receive the lane's records with.
+ */
+inline const long _nipc_lane_type(const pid_t pid, const uint32_t lane) { return static_cast<long>(pid) | static_cast<long>(lane) << 32; }
+
+/**
+ * @name  _nipc_receive()
+ * @brief  Receives the next message pending for this process from a NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of this process's entry in the instance's registry.
+ * @param  message  {nipc_message* const}  The buffer to copy the message to.
+ * @param  inbox  {nipc_inbox* const}  The record to receive messages from; it is refilled from the message queue once all of its messages were received.
+ * @remark  Instances using a ring are read through the process's cursor; the others through its inbox in the message queue of its shard, refilled from the highest lane holding a record.
+ * @remark  The latest values of conflated channels the process has not read yet come first.
+ * @return  {const bool}  `true` if a message was received, `false` if none is pending.
+ */
+const bool _nipc_receive(nipc_instance* const instance, const uint32_t entry, nipc_message* const message, nipc_inbox* const inbox)
+{
+	// Receive the values of conflated channels first.
+	if (instance->registry.entries[entry].stale.load(std::memory_order_relaxed) && _nipc_conflation_read(instance, entry, message)) return true;
+
+	// Read the ring through the process's cursor.
+	if (instance->options.transport == NIPC_TRANSPORT_RING) return _nipc_ring_read(instance, entry, message);
+
+	// Once every message of the current record was received, receive the next record from the process's inbox.
+	if (inbox->offset + offsetof(nipc_wire, data) > inbox->size)
+	{
+		// Try the lanes from the most urgent down, skipping those known to be empty; lane `0` is always tried.
+		const pid_t pid = getpid(); // The PID of this process.
+		const int queue = _nipc_queue(instance, pid); // The message queue of the process's shard.
+		std::atomic<int32_t>* const queued = instance->registry.entries[entry].queued; // The number of records waiting on every lane.
+		ssize_t size = -1; // The size of the record.
+		uint32_t lane = NIPC_LANES; // The lane the record was received on.
+		do if (!--lane || queued[lane].load(std::memory_order_relaxed) > 0) size = msgrcv(queue, &inbox->record, NIPC_RECORD_SIZE, _nipc_lane_type(pid, lane), IPC_NOWAIT);
+		while (lane && size < static_cast<ssize_t>(offsetof(nipc_wire, data)));
+		if (size < static_cast<ssize_t>(offsetof(nipc_wire, data))) { inbox->size = inbox->offset = 0; return false; }
+		if (lane)
+		{
+			int32_t count = 0; // The number of messages in the record.
+			for (size_t offset = 0; offset + offsetof(nipc_wire, data) <= static_cast<size_t>(size); ++count) offset += _nipc_stride(_nipc_wire_size(*reinterpret_cast<const nipc_wire*>(inbox->record.data + offset)));
+			queued[lane].fetch_sub(count, std::memory_order_relaxed);
+		}
+		inbox->size = static_cast<size_t>(size);
+		inbox->offset = 0;
+		inbox->lane = lane;
+	}
+
+	// Take the next message of the record; it already carries its own reference to a payload in the slab.
+	const nipc_wire& wire = *reinterpret_cast<const nipc_wire*>(inbox->record.data + inbox->offset); // The message.
+	_nipc_unpack(instance, wire, message);
+	message->priority = inbox->lane;
+	inbox->offset += _nipc_stride(_nipc_wire_size(wire));
+	return true;
+}
+
+/**
+ * @name  _nipc_futex()
+ * @brief  Invokes a futex operation on a futex word shared between processes.
+ * @param  word  {std::atomic<uint32_t>* const}  The futex word.
+ * @param  operation  {const int}  The futex operation; `FUTEX_WAIT` or `FUTEX_WAKE`.
+ * @param  value  {const uint32_t}  The expected value of the word for `FUTEX_WAIT`, or the number of waiters to wake for `FUTEX_WAKE`.
+ * @param  timeout  {const timespec* const}  How long `FUTEX_WAIT` may sleep, or `nullptr` to sleep until woken.
+ * @remark  The private flag is not used because the word lives in a segment mapped by several processes.
+ * @return  {const long}  The result of the system call.
+ */
+inline const long _nipc_futex(std::atomic<uint32_t>* const word, const int operation, const uint32_t value, const timespec* const timeout = nullptr) { return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), operation, value, timeout, nullptr, 0); }
+
+/**
+ * @name  _nipc_wake()
+ * @brief  Marks a futex word as notified and wakes the thread parked on it, if any.
+ * @param  word  {std::atomic<uint32_t>&}  The futex word.
+ * @remark  A thread that is already notified or still running costs a single atomic load; the system call is only made when the thread is parked.
+ * @remark  The fence orders the publication of whatever the thread is being notified of before the check, pairing with the exchange the thread performs before it looks for work.
+ */
+inline void _nipc_wake(std::atomic<uint32_t>& word)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (word.load(std::memory_order_relaxed) != NIPC_NOTIFIED && word.exchange(NIPC_NOTIFIED) == NIPC_PARKED) _nipc_futex(&word, FUTEX_WAKE, 1);
+}
+
+/**
+ * @name  _nipc_park()
+ * @brief  Parks the calling thread on a futex word until it is notified, unless it was notified since it last consumed a notification.
+ * @param  word  {std::atomic<uint32_t>&}  The futex word.
+ */
+inline void _nipc_park(std::atomic<uint32_t>& word)
+{
+	uint32_t expected = NIPC_RUNNING; // The state the thread expects to park from.
+	if (word.compare_exchange_strong(expected, NIPC_PARKED)) _nipc_futex(&word, FUTEX_WAIT, NIPC_PARKED);
+}
+
+/**
+ * @name  _nipc_address()
+ * @brief  Names the socket a polled subscriber is notified through.
+ * @param  address  {sockaddr_un* const}  The address to fill in.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the subscriber.
+ * @remark  The name lives in the abstract namespace, so it leaves nothing behind in the file system and disappears with the socket, even if the subscriber dies.
+ * @return  {const socklen_t}  The length of the address.
+ */
+const socklen_t _nipc_address(sockaddr_un* const address, const int id, const pid_t pid)
+{
+	memset(address, 0, sizeof(sockaddr_un));
+	address->sun_family = AF_UNIX;
+	const int length = snprintf(address->sun_path + 1, sizeof(address->sun_path) - 1, "nipc.%d.%d", id, static_cast<int>(pid)); // The length of the name.
+	return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + length);
+}
+
+/**
+ * @name  _nipc_post()
+ * @brief  Sends a notification datagram to the socket of a polled subscriber.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the subscriber.
+ * @remark  A full socket already has notifications pending, so that counts as success.
+ * @return  {const bool}  `true` if the subscriber was notified, `false` if its socket is gone.
+ */
+const bool _nipc_post(const int id, const pid_t pid)
+{
+	// Create the socket to send from on first use; if another thread created one meanwhile, use it instead.
+	int notifier = _notifier.load(std::memory_order_acquire); // The socket to send from.
+	if (notifier == -1)
+	{
+		const int created = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0); // The socket created by this thread.
+		if (created == -1) return false;
+		if (_notifier.compare_exchange_strong(notifier, created, std::memory_order_acq_rel)) notifier = created;
+		else close(created);
+	}
+
+	// Send an empty byte to the subscriber's socket.
+	sockaddr_un address; // The address of the subscriber's socket.
+	const socklen_t length = _nipc_address(&address, id, pid); // The length of the address.
+	return sendto(notifier, "", 1, MSG_DONTWAIT | MSG_NOSIGNAL, reinterpret_cast<const sockaddr*>(&address), length) == 1 || errno == EAGAIN;
+}
+
+/**
+ * @name  _nipc_notify()
+ * @brief  Tells a recipient that a message is pending for it.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the recipient's entry in the instance's registry.
+ * @param  pid  {const pid_t}  The PID of the recipient.
+ * @remark  With `NIPC_WAKEUP_SIGNAL`, the signal carries the ID of the instance so that the recipient only drains that instance, and it is only queued if none is already pending for the recipient on this instance.
+ * @remark  With `NIPC_WAKEUP_FUTEX`, the recipient is only woken by a system call if its receiver thread is parked.
+ * @remark  A recipient that subscribed with `nipc_subscribe_poll()` is sent a datagram on its socket instead, whatever the instance's `wakeup`, and likewise only if none is already pending.
+ * @throws  ESRCH  If the recipient could not be notified.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_notify(const int id, nipc_instance* const instance, const uint32_t entry, const pid_t pid)
+{
+	// Signal the recipient, or post to its socket if it polls one, unless a notification from this instance is still pending for it.
+	const bool polled = instance->registry.entries[entry].polled.load(std::memory_order_relaxed); // Whether the recipient polls a socket.
+	if (polled || instance->options.wakeup == NIPC_WAKEUP_SIGNAL)
+	{
+		std::atomic<uint32_t>& signalled = instance->registry.entries[entry].signalled; // Whether a notification is pending for the recipient.
+		if (signalled.exchange(1) == 1) return 0;
+		sigval value; // The ID of the instance, carried by the signal.
+		value.sival_int = id;
+		if (polled ? !_nipc_post(id, pid) : sigqueue(pid, NIPC_SIGNAL, value) == -1) { signalled.store(0); instance->stats.notify_failures.fetch_add(1, std::memory_order_relaxed); errno = ESRCH; return -1; }
+		return 0;
+	}
+
+	// Wake the recipient's receiver thread.
+	_nipc_wake(instance->registry.entries[entry].futex);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_pool_create()
+ * @brief  Creates the process's message pool, unless it already has one.
+ * @param  size  {const unsigned int}  The number of message buffers in the pool.
+ * @throws  ENOMEM  If the pool could not be allocated.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_pool_create(const unsigned int size)
+{
+	// A process has at most one pool.
+	if (_pool.load(std::memory_order_acquire)) return 0;
+
+	// Allocate the buffers and their free list.
+	nipc_message* const messages = new (std::nothrow) nipc_message[size]; // The buffers of the pool.
+	std::atomic<uint32_t>* const next = new (std::nothrow) std::atomic<uint32_t>[size]; // The free list of the pool.
+	std::atomic<nipc_instance*>* const owners = new (std::nothrow) std::atomic<nipc_instance*>[size]; // The instances whose slabs the buffers hold references to.
+	uint32_t* const blocks = new (std::nothrow) uint32_t[size]; // The runs of the slabs the buffers hold references to.
+	if (!messages || !next || !owners || !blocks) { delete[] messages; delete[] next; delete[] owners; delete[] blocks; errno = ENOMEM; return -1; }
+
+	// Link every buffer into the free list, then publish the pool.
+	for (uint32_t index = 0; index < size; ++index)
+	{
+		next[index].store(index + 1 < size ? index + 1 : NIPC_NONE, std::memory_order_relaxed);
+		owners[index].store(nullptr, std::memory_order_relaxed);
+	}
+	_pool_size = size;
+	_pool_next = next;
+	_pool_owners = owners;
+	_pool_blocks = blocks;
+	_pool_head.store(0, std::memory_order_relaxed);
+	_pool_free.store(size, std::memory_order_relaxed);
+	_pool.store(messages, std::memory_order_release);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_pool_reserve()
+ * @brief  Reserves a buffer of the process's message pool, to be taken with `_nipc_pool_acquire()`.
+ * @param  starve  {const bool}  Whether to have the next buffer released redeliver the pending messages if none is left.
+ * @return  {const bool}  `true` if a buffer was reserved, `false` if every buffer is taken or reserved.
+ */
+const bool _nipc_pool_reserve(const bool starve)
+{
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		// Count a buffer out of those free, unless none is.
+		uint32_t free = _pool_free.load(std::memory_order_relaxed); // The number of free buffers.
+		while (free) if (_pool_free.compare_exchange_weak(free, free - 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+
+		// Ask for a redelivery, then look again in case a buffer was released meanwhile.
+		if (!starve) return false;
+		_pool_starved.store(true, std::memory_order_seq_cst);
+	}
+
+	// The pool is exhausted.
+	return false;
+}
+
+/**
+ * @name  _nipc_pool_unreserve()
+ * @brief  Gives back a buffer of the process's message pool that was reserved but not taken.
+ */
+inline void _nipc_pool_unreserve() { _pool_free.fetch_add(1, std::memory_order_release); }
+
+/**
+ * @name  _nipc_pool_acquire()
+ * @brief  Takes a buffer reserved with `_nipc_pool_reserve()` from the process's message pool.
+ * @return  {nipc_message* const}  The buffer, or `nullptr` if the process has no pool.
+ */
+nipc_message* const _nipc_pool_acquire()
+{
+	// Without a pool, there is no buffer to take.
+	nipc_message* const messages = _pool.load(std::memory_order_acquire); // The buffers of the pool.
+	if (!messages) return nullptr;
+
+	// Pop the first free buffer, retrying if another thread changed the free list in the meantime; the reservation guarantees there is one.
+	uint64_t head = _pool_head.load(std::memory_order_acquire); // The head of the free list.
+	while (static_cast<uint32_t>(head) != NIPC_NONE)
+	{
+		const uint64_t next = (((head >> 32) + 1) << 32) | _pool_next[static_cast<uint32_t>(head)].load(std::memory_order_relaxed); // The head of the free list once the buffer is taken.
+		if (_pool_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) return &messages[static_cast<uint32_t>(head)];
+	}
+
+	// Only reached without a reservation.
+	return nullptr;
+}
+
+/**
+ * @name  _nipc_pool_drop()
+ * @brief  Drops the reference a buffer of the process's message pool holds to a run of a slab, if any.
+ * @param  index  {const uint32_t}  The index of the buffer.
+ * @param  instance  {nipc_instance* const}  The NIPC instance whose slab the reference must be to, or `nullptr` for any.
+ */
+void _nipc_pool_drop(const uint32_t index, nipc_instance* const instance)
+{
+	nipc_instance* owner = _pool_owners[index].load(std::memory_order_acquire); // The instance whose slab the buffer holds a reference to.
+	if (!owner || (instance && owner != instance) || !_pool_owners[index].compare_exchange_strong(owner, nullptr, std::memory_order_acq_rel)) return;
+	_nipc_slab_release(owner, _pool_blocks[index]);
+}
+
+/**
+ * @name  _nipc_invoke()
+ * @brief  Hands a batch of messages to the notification handler of a NIPC instance.
+ * @param  handle  {const nipc_handle&}  The state this process keeps for the instance.
+ * @param  batch  {const nipc_message* const}  The messages; their payloads not stored inline must be held in the instance's slab.
+ * @param  count  {const size_t}  The number of messages.
+ * @remark  A batch notification handler receives the batch as is.  Otherwise, every message is copied to a buffer from the process's message pool and passed to the notification handler, which must release it; a buffer must have been reserved for every message with `_nipc_pool_reserve()` before it was received, as this may run in a signal handler where nothing can be allocated.
+ * @remark  A buffer takes its own reference to the payload held in the slab, so that the payload outlives the caller's reference for as long as the buffer is kept.
+ */
+void _nipc_invoke(const nipc_handle& handle, const nipc_message* const batch, const size_t count)
+{
+	// Hand the whole batch to the batch notification handler, if any.
+	if (handle.batch_handler) handle.batch_handler(batch, count);
+
+	// Otherwise, hand the messages to the notification handler one by one.
+	else for (size_t index = 0; index < count; ++index)
+	{
+		// Take the buffer reserved for the message from the pool to store it.
+		nipc_message* const message = _nipc_pool_acquire(); // The buffer holding the message.
+		*message = batch[index];
+
+		// Keep the payload held in the slab for as long as the buffer is.
+		if (message->blob)
+		{
+			const uint32_t buffer = static_cast<uint32_t>(message - _pool.load(std::memory_order_relaxed)); // The index of the buffer.
+			_pool_blocks[buffer] = _nipc_slab_block(handle.instance, message->blob);
+			_nipc_slab_refs(handle.instance)[_pool_blocks[buffer]].fetch_add(1, std::memory_order_relaxed);
+			_pool_owners[buffer].store(handle.instance, std::memory_order_release);
+		}
+
+		// Ensure a notification handler is set and invoke it.
+		if (handle.handler) handle.handler(message);
+
+		// If the message wasn't delivered discard the message.
+		else nipc_message_release(message);
+	}
+}
+
+/**
+ * @name  _nipc_dispatch()
+ * @brief  Hands a batch of received messages to the notification handler of the instance they were received from.
+ * @param  handle  {const nipc_handle&}  The state this process keeps for the instance; the counters of its entry in the instance's registry are updated.
+ * @param  batch  {const nipc_message* const}  The messages.
+ * @param  count  {const size_t}  The number of messages.
+ * @remark  Once the handlers return, the references to the payloads held in the slab are dropped; the buffers handed to the notification handler keep their own.
+ */
+void _nipc_dispatch(const nipc_handle& handle, const nipc_message* const batch, const size_t count)
+{
+	// Record how long the messages took to get here.
+	nipc_instance* const instance = handle.instance; // The NIPC instance.
+	nipc_trace_buffer* const trace = handle.trace; // The trace buffer of this process, or `nullptr`.
+	nipc_subscriber& self = instance->registry.entries[handle.subscriber]; // The entry of this process.
+	const uint64_t now = _nipc_now(); // The time the batch is handed over at.
+	for (size_t index = 0; index < count; ++index) _nipc_count_latency(instance, self, batch[index], now);
+
+	// Hand the batch to the notification handler.
+	_nipc_invoke(handle, batch, count);
+
+	// Count the messages handed over, and trace how long the handlers took.
+	if (trace) _nipc_trace(trace, NIPC_TRACE_HANDLER, now, batch[0].timestamp, static_cast<long>(count));
+	self.received.fetch_add(count, std::memory_order_relaxed);
+
+	// Release the payloads held in the slab.
+	for (size_t index = 0; index < count; ++index) if (batch[index].blob) _nipc_slab_release(instance, _nipc_slab_block(instance, batch[index].blob));
+}
+
+/**
+ * @name  _nipc_handoff()
+ * @brief  Queues a batch of received messages to the worker threads of a subscription.
+ * @param  receiver  {nipc_receiver* const}  The receiver thread of the subscription.
+ * @param  batch  {const nipc_message* const}  The messages.
+ * @param  count  {const size_t}  The number of messages.
+ * @remark  Each message goes to the worker its `channel` hashes to, which keeps the messages of a channel in order.  If that worker's queue is full, the receiver waits for it to make room rather than dropping the message.
+ * @remark  Each worker that was given messages is woken at most once per batch.
+ */
+void _nipc_handoff(nipc_receiver* const receiver, const nipc_message* const batch, const size_t count)
+{
+	uint64_t woken = 0; // The workers that were given messages, one bit per worker.
+
+	for (size_t index = 0; index < count; ++index)
+	{
+		// Pick the worker of the message's channel.
+		const unsigned int target = static_cast<unsigned int>(static_cast<unsigned long>(batch[index].channel) % receiver->workers); // The index of the worker.
+		nipc_worker& worker = receiver->pool[target]; // The worker of the message's channel.
+
+		// Wait for room in the worker's queue, making sure the worker is awake to make it.
+		const uint64_t head = worker.head.load(std::memory_order_relaxed); // The position to queue the message at.
+		while (head - worker.tail.load(std::memory_order_acquire) >= NIPC_WORKER_QUEUE_SIZE) { _nipc_wake(worker.futex); sched_yield(); }
+
+		// Queue the message and publish it.
+		worker.queue[head & (NIPC_WORKER_QUEUE_SIZE - 1)] = batch[index];
+		worker.head.store(head + 1, std::memory_order_release);
+		woken |= 1ULL << target;
+	}
+
+	// Wake the workers that were given messages.
+	for (unsigned int target = 0; target < receiver->workers; ++target) if (woken & (1ULL << target)) _nipc_wake(receiver->pool[target].futex);
+}
+
+/**
+ * @name  _nipc_drain()
+ * @brief  Receives every message pending for this process from a NIPC instance and dispatches them in batches.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  handle  {const nipc_handle&}  The state this process keeps for the instance.
+ * @param  batch  {nipc_message* const}  A buffer of `NIPC_BATCH_SIZE` messages to receive into.
+ * @param  receiver  {nipc_receiver* const}  The receiver thread draining the instance, if any; batches are handed to its worker threads if it has any.
+ * @remark  Unless the subscription has a batch notification handler, a buffer of the process's message pool is reserved for every message before it is received.  If the pool runs dry, draining stops and the remaining messages are left pending until the next notification, or until a buffer is released.
+ */
+void _nipc_drain(const int id, const nipc_handle& handle, nipc_message* const batch, nipc_receiver* const receiver)
+{
+	nipc_instance* const instance = handle.instance; // The NIPC instance.
+	nipc_trace_buffer* const trace = handle.trace; // The trace buffer of this process, or `nullptr`.
+	nipc_inbox* const inbox = receiver ? &receiver->inbox : &_inbox; // The record to receive messages from.
+	const bool pooled = !handle.batch_handler; // Whether every message needs a buffer from the pool.
+	size_t received; // The number of messages received for the current batch.
+	do
+	{
+		// Fill the batch with pending messages, as long as there are buffers for them, dropping those the subscription already replayed from the log.
+		const uint64_t started = trace ? _nipc_now() : 0; // The time receiving the batch started at.
+		size_t count = 0; // The number of messages in the batch.
+		for (received = 0; received < NIPC_BATCH_SIZE; ++received)
+		{
+			if (pooled && !_nipc_pool_reserve(true)) break;
+			if (!_nipc_receive(instance, handle.subscriber, &batch[count], inbox)) { if (pooled) _nipc_pool_unreserve(); break; }
+			const uint64_t sequence = batch[count].sequence; // The sequence number of the message.
+			if (sequence < handle.replayed_from || sequence >= handle.replayed_to) { ++count; continue; }
+			if (pooled) _nipc_pool_unreserve();
+			if (batch[count].blob) _nipc_slab_release(instance, _nipc_slab_block(instance, batch[count].blob));
+		}
+
+		// Dispatch the batch, or hand it to the worker threads.
+		if (trace && count) _nipc_trace(trace, NIPC_TRACE_RECEIVE, started, batch[0].timestamp, static_cast<long>(count));
+		if (count && receiver && receiver->workers) _nipc_handoff(receiver, batch, count);
+		else if (count) _nipc_dispatch(handle, batch, count);
+	}
+	// A full batch means more messages may be pending.
+	while (received == NIPC_BATCH_SIZE);
+}
+
+/**
+ * @name  _nipc_serve()
+ * @brief  Drains every message pending for this process on a NIPC instance it subscribed to, or wakes the receiver thread serving the subscription.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  handle  {const nipc_handle&}  The state this process keeps for the instance.
+ * @remark  Senders may queue a new signal as soon as the pending one is consumed here, which happens before draining so that no message is left behind.
+ */
+void _nipc_serve(const int id, const nipc_handle& handle)
+{
+	// Skip instances the process did not subscribe to, or receives from itself.
+	if (handle.subscriber == NIPC_NONE || handle.fd != -1) return;
+
+	// Consume the pending signal, then drain the instance or wake the receiver thread serving it.
+	nipc_subscriber& self = handle.instance->registry.entries[handle.subscriber]; // The entry of this process.
+	self.signalled.exchange(0);
+	if (handle.receiver) _nipc_wake(self.futex);
+	else _nipc_drain(id, handle, _batch, nullptr);
+}
+
+/**
+ * @brief  The signal handler for `NIPC_SIGNAL`.
+ * @param  signal  {const int}  The signal number.
+ * @param  info  {siginfo_t* const}  The details of the signal.
+ * @param  context  {void* const}  The context the signal interrupted.
+ * @remark  A signal queued by a sender carries the ID of its instance, so only that instance is drained, whatever the number of instances the process opened.
+ * @remark  Any other signal, such as one sent with `kill()`, drains every instance the process subscribed to.
+ */
+void _nipc_handler(const int signal, siginfo_t* const info, void* const context)
+{
+	// Serve the instance the signal names.
+	if (info && info->si_code == SI_QUEUE)
+	{
+		const std::unordered_map<int, nipc_handle>::const_iterator nipc = _subscription_list.find(info->si_value.sival_int); // The instance the signal names.
+		if (nipc != _subscription_list.end()) _nipc_serve(nipc->first, nipc->second);
+		return;
+	}
+
+	// Otherwise, serve every instance in the subscription list.
+	for (const std::pair<const int, nipc_handle>& pair : _subscription_list) _nipc_serve(pair.first, pair.second);
+}
+
+/**
+ * @name  _nipc_worker_main()
+ * @brief  The body of a worker thread running the notification handler of a subscription.
+ * @param  argument  {void* const}  The `nipc_worker` describing the worker.
+ * @remark  The worker handles its queued messages in batches, then parks until the receiver thread queues more.  Once the subscription is closed, it handles what is left in its queue and exits.
+ * @return  {void*}  `nullptr`.
+ */
+void* _nipc_worker_main(void* const argument)
+{
+	nipc_worker* const worker = static_cast<nipc_worker*>(argument); // The worker.
+
+	while (true)
+	{
+		// Consume the pending notification before looking at the queue, so any message queued from now on notifies the worker again.
+		worker->futex.exchange(NIPC_RUNNING);
+
+		// Move the queued messages to the batch buffer, freeing their slots, and handle them.
+		uint64_t tail = worker->tail.load(std::memory_order_relaxed); // The position of the next message to handle.
+		uint64_t head; // The position the next message will be queued at.
+		while ((head = worker->head.load(std::memory_order_acquire)) != tail)
+		{
+			size_t count = 0; // The number of messages in the batch.
+			for (; tail != head && count < NIPC_BATCH_SIZE; ++tail) worker->batch[count++] = worker->queue[tail & (NIPC_WORKER_QUEUE_SIZE - 1)];
+			worker->tail.store(tail, std::memory_order_release);
+			_nipc_dispatch(*worker->receiver->handle, worker->batch, count);
+		}
+
+		// Exit once the subscription is closed, or park until more messages are queued.
+		if (worker->receiver->stopping.load(std::memory_order_acquire)) break;
+		_nipc_park(worker->futex);
+	}
+
+	// Exit the thread.
+	return nullptr;
+}
+
+/**
+ * @name  _nipc_receiver_main()
+ * @brief  The body of a receiver thread serving a subscription to a NIPC instance using `NIPC_WAKEUP_FUTEX` or worker threads.
+ * @param  argument  {void* const}  The `nipc_receiver` describing the subscription.
+ * @remark  The thread drains every pending message, then parks on the subscriber's futex word until a sender, or the signal handler, marks it as notified.  While messages keep arriving it never parks, so neither it nor the senders make any wakeup system call.
+ * @return  {void*}  `nullptr`.
+ */
+void* _nipc_receiver_main(void* const argument)
+{
+	nipc_receiver* const receiver = static_cast<nipc_receiver*>(argument); // The subscription served by the thread.
+	std::atomic<uint32_t>& word = receiver->instance->registry.entries[receiver->subscriber].futex; // The futex word of the subscriber.
+
+	while (!receiver->stopping.load(std::memory_order_acquire))
+	{
+		// Consume the pending notification before draining, so any message published from now on notifies the thread again.
+		word.exchange(NIPC_RUNNING);
+
+		// Drain every pending message.
+		_nipc_drain(receiver->id, *receiver->handle, receiver->batch, receiver);
+
+		// Park until notified, unless a notification arrived while draining.
+		_nipc_park(word);
+	}
+
+	// Exit the thread.
+	return nullptr;
+}
+
+/**
+ * @name  _nipc_stop_workers()
+ * @brief  Stops the first `count` worker threads of a receiver and releases its worker pool.
+ * @param  receiver  {nipc_receiver* const}  The receiver thread whose workers to stop; its `stopping` flag must already be set.
+ * @param  count  {const unsigned int}  The number of workers that were started.
+ */
+void _nipc_stop_workers(nipc_receiver* const receiver, const unsigned int count)
+{
+	// Wake every worker so it notices the flag, and wait for it to finish its queue.
+	for (unsigned int index = 0; index < count; ++index) { _nipc_wake(receiver->pool[index].futex); pthread_join(receiver->pool[index].thread, nullptr); }
+
+	// Release the pool.
+	delete[] receiver->pool;
+	receiver->pool = nullptr;
+}
+
+/**
+ * @name  _nipc_start_receiver()
+ * @brief  Starts a receiver thread, and its worker threads if any, to serve a subscription.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  handle  {const nipc_handle* const}  The state this process keeps for the instance; it must outlive the receiver.
+ * @param  workers  {const unsigned int}  The number of worker threads to start.
+ * @remark  The threads are started with `NIPC_SIGNAL` blocked, so the signal handler of instances notified by signals never runs on them; it would otherwise race the one running on another thread over the buffers they share.
+ * @throws  EAGAIN  If a thread could not be started.
+ * @return  {nipc_receiver* const}  The receiver on success, `nullptr` on failure.
+ */
+nipc_receiver* const _nipc_start_receiver(const int id, const nipc_handle* const handle, const unsigned int workers)
+{
+	nipc_receiver* const receiver = new nipc_receiver(); // The receiver thread serving the subscription.
+	receiver->id = id;
+	receiver->instance = handle->instance;
+	receiver->subscriber = handle->subscriber;
+	receiver->handle = handle;
+	receiver->workers = workers;
+	receiver->trace = handle->trace;
+	receiver->pool = workers ? new nipc_worker[workers]() : nullptr;
+
+	// Block `NIPC_SIGNAL` while the threads are started, so that they inherit a mask blocking it.
+	sigset_t signals, previous; // The notification signal, and the signal mask of the calling thread.
+	sigemptyset(&signals);
+	sigaddset(&signals, NIPC_SIGNAL);
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+	// Start the workers first so that they are ready before any message is handed to them, then the receiver thread.
+	unsigned int index = 0; // The index of the next worker to start.
+	int failed = 0; // Whether a thread could not be started.
+	for (; index < workers; ++index)
+	{
+		receiver->pool[index].receiver = receiver;
+		if ((failed = pthread_create(&receiver->pool[index].thread, nullptr, _nipc_worker_main, &receiver->pool[index]))) break;
+	}
+	if (!failed) failed = pthread_create(&receiver->thread, nullptr, _nipc_receiver_main, receiver);
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+	// Stop the threads started if any could not be.
+	if (failed) { receiver->stopping.store(true); _nipc_stop_workers(receiver, index); delete receiver; errno = EAGAIN; return nullptr; }
+
+	// Return the receiver.
+	return receiver;
+}
+
+/**
+ * @name  _nipc_stop_receiver()
+ * @brief  Stops the receiver thread serving a subscription, and its worker threads, and releases it.
+ * @param  receiver  {nipc_receiver* const}  The receiver thread to stop.
+ */
+void _nipc_stop_receiver(nipc_receiver* const receiver)
+{
+	// Ask the thread to exit, wake it in case it is parked and wait for it.
+	std::atomic<uint32_t>& word = receiver->instance->registry.entries[receiver->subscriber].futex; // The futex word of the subscriber.
+	receiver->stopping.store(true, std::memory_order_release);
+	word.store(NIPC_NOTIFIED);
+	_nipc_futex(&word, FUTEX_WAKE, 1);
+	pthread_join(receiver->thread, nullptr);
+
+	// Stop the workers once nothing more can be handed to them.
+	_nipc_stop_workers(receiver, receiver->workers);
+
+	// Release the receiver.
+	delete receiver;
+}
+
+/**
+ * @name  _nipc_log_name()
+ * @brief  Builds the path of a log segment of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the instance.
+ * @param  index  {const uint64_t}  The index of the segment.
+ * @return  {const std::string}  The path of the segment.
+ */
+const std::string _nipc_log_name(const nipc_options& options, const uint64_t index)
+{
+	char suffix[32]; // The index and extension of the segment.
+	snprintf(suffix, sizeof(suffix), ".%012llu.log", static_cast<unsigned long long>(index));
+	return std::string(options.log_path) + suffix;
+}
+
+/**
+ * @name  _nipc_log_header()
+ * @brief  Reads the header of a log segment of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the instance.
+ * @param  index  {const uint64_t}  The index of the segment.
+ * @param  header  {nipc_log_segment* const}  The buffer to read the header into.
+ * @return  {const bool}  `true` if the segment exists and has a valid header, `false` otherwise.
+ */
+const bool _nipc_log_header(const nipc_options& options, const uint64_t index, nipc_log_segment* const header)
+{
+	const int fd = open(_nipc_log_name(options, index).c_str(), O_RDONLY | O_CLOEXEC); // The segment file.
+	if (fd == -1) return false;
+	const ssize_t size = pread(fd, header, sizeof(nipc_log_segment), 0); // The number of bytes read.
+	close(fd);
+	return size == static_cast<ssize_t>(sizeof(nipc_log_segment)) && header->magic == NIPC_LOG_MAGIC;
+}
+
+/**
+ * @name  _nipc_log_map()
+ * @brief  Maps a log segment of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the instance.
+ * @param  index  {const uint64_t}  The index of the segment.
+ * @param  writable  {const bool}  Whether to map the segment for appending to it; it is mapped read-only otherwise.
+ * @param  size  {size_t* const}  Set to the size of the mapping.
+ * @return  {char* const}  The mapped segment, or `nullptr` if it does not exist or could not be mapped.
+ */
+char* const _nipc_log_map(const nipc_options& options, const uint64_t index, const bool writable, size_t* const size)
+{
+	// Open the segment and find out its size.
+	const int fd = open(_nipc_log_name(options, index).c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC); // The segment file.
+	if (fd == -1) return nullptr;
+	struct stat status; // The status of the segment file.
+	if (fstat(fd, &status) == -1 || static_cast<size_t>(status.st_size) < sizeof(nipc_log_segment)) { close(fd); return nullptr; }
+	*size = static_cast<size_t>(status.st_size);
+
+	// Map it; the mapping outlives the descriptor.
+	void* const map = mmap(nullptr, *size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0); // The mapping.
+	close(fd);
+	return map == MAP_FAILED ? nullptr : static_cast<char*>(map);
+}
+
+/**
+ * @name  _nipc_log_start()
+ * @brief  Creates an empty log segment of a NIPC instance.
+ * @param  options  {const nipc_options&}  The options of the instance.
+ * @param  index  {const uint64_t}  The index of the segment.
+ * @param  first  {const uint64_t}  The sequence number of the first message the segment will hold.
+ * @remark  The file's blocks are allocated up to `options.log_segment_size` up front, so that it can be mapped whole and a full disk fails here rather than raising `SIGBUS` in a sender writing through the mapping.
+ * @remark  A segment that could not be set up is removed again.
+ * @throws  EIO  If the segment could not be created, or the file system has no room for it.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_log_start(const nipc_options& options, const uint64_t index, const uint64_t first)
+{
+	const int fd = open(_nipc_log_name(options, index).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, RW_UGO); // The segment file.
+	if (fd == -1) { errno = EIO; return -1; }
+	const nipc_log_segment header = { NIPC_LOG_MAGIC, first, static_cast<uint64_t>(time(nullptr)), 0 }; // The header of the segment.
+	const bool written = posix_fallocate(fd, 0, static_cast<off_t>(options.log_segment_size)) == 0 && pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)); // Whether the segment was set up.
+	close(fd);
+	if (!written) { unlink(_nipc_log_name(options, index).c_str()); errno = EIO; return -1; }
+	return 0;
+}
+
+/**
+ * @name  _nipc_log_lock()
+ * @brief  Acquires the lock of the log of a NIPC instance.
+ * @param  log  {nipc_log* const}  The log to lock.
+ * @remark  If the previous owner died while holding the lock, the lock is made consistent again; at worst, the sequence number of the record it was appending is skipped.
+ * @throws  ENOLCK  If the lock could not be acquired.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_log_lock(nipc_log* const log)
+{
+	// Acquire the lock, recovering it if its previous owner died.
+	const int status = pthread_mutex_lock(&log->lock); // The result of locking the mutex.
+	if (status == EOWNERDEAD) pthread_mutex_consistent(&log->lock);
+	else if (status) { errno = ENOLCK; return -1; }
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_log_recover()
+ * @brief  Opens the log of a NIPC instance being created, carrying on from the last segment of an existing log or starting a new one.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @remark  The segments are found by listing the directory of `log_path`.  The records of the last one are walked to find where to append and the next sequence number; if it was written with another segment size, the next message starts a new segment.
+ * @throws  EIO  If the log could not be read or created.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_log_recover(nipc_instance* const instance)
+{
+	const nipc_options& options = instance->options; // The options of the instance.
+	nipc_log* const log = &instance->log; // The log of the instance.
+
+	// Split the path into the directory holding the segments and the prefix of their names.
+	const std::string path(options.log_path); // The path prefix of the segments.
+	const size_t slash = path.rfind('/'); // The position of the last separator, if any.
+	const std::string directory = slash == std::string::npos ? "." : slash ? path.substr(0, slash) : "/"; // The directory holding the segments.
+	const std::string prefix = path.substr(slash == std::string::npos ? 0 : slash + 1) + "."; // The start of the names of the segments.
+
+	// Find the oldest and newest segments.
+	DIR* const listing = opendir(directory.c_str()); // The directory holding the segments.
+	if (!listing) { errno = EIO; return -1; }
+	bool found = false; // Whether any segment exists.
+	log->first = UINT64_MAX;
+	log->segment = 0;
+	while (const dirent* const file = readdir(listing))
+	{
+		// Only consider names made of the prefix, twelve digits and the extension.
+		const std::string name(file->d_name); // The name of the file.
+		if (name.size() != prefix.size() + 16 || name.compare(0, prefix.size(), prefix) || name.compare(name.size() - 4, 4, ".log")) continue;
+		const std::string digits = name.substr(prefix.size(), 12); // The index of the segment.
+		if (digits.find_first_not_of("0123456789") != std::string::npos) continue;
+		const uint64_t index = strtoull(digits.c_str(), nullptr, 10); // The index of the segment.
+		log->first = std::min(log->first, index);
+		log->segment = std::max(log->segment, index);
+		found = true;
+	}
+	closedir(listing);
+
+	// Start the first segment of a new log.
+	if (!found)
+	{
+		log->first = log->segment = 0;
+		log->offset = sizeof(nipc_log_segment);
+		log->next.store(1, std::memory_order_relaxed);
+		return _nipc_log_start(options, 0, 1);
+	}
+
+	// Walk the records of the last segment to find its end.
+	size_t size; // The size of the last segment.
+	const char* const segment = _nipc_log_map(options, log->segment, false, &size); // The last segment.
+	if (!segment) { errno = EIO; return -1; }
+	const nipc_log_segment* const header = reinterpret_cast<const nipc_log_segment*>(segment); // The header of the last segment.
+	if (header->magic != NIPC_LOG_MAGIC) { munmap(const_cast<char*>(segment), size); errno = EIO; return -1; }
+	uint64_t next = header->first; // The sequence number following the last record.
+	size_t offset = sizeof(nipc_log_segment); // The offset of the next record.
+	while (offset + sizeof(nipc_log_record) <= size)
+	{
+		const nipc_log_record& record = *reinterpret_cast<const nipc_log_record*>(segment + offset); // The record at the offset.
+		const uint32_t length = record.size.load(std::memory_order_acquire); // The size of the record.
+		if (!length || length % 8 || offset + length > size || record.sequence < next) break;
+		next = record.sequence + 1;
+		offset += length;
+	}
+	munmap(const_cast<char*>(segment), size);
+
+	// Append after the last record, or start a new segment with the next message if this one has another size.
+	log->offset = size == options.log_segment_size ? offset : options.log_segment_size;
+	log->next.store(next, std::memory_order_relaxed);
+	return 0;
+}
+
+/**
+ * @name  _nipc_log_roll()
+ * @brief  Seals the log segment of a NIPC instance being written and starts the next one, deleting the segments that are no longer retained.
+ * @param  instance  {nipc_instance* const}  The NIPC instance; its log must be locked.
+ * @param  first  {const uint64_t}  The sequence number of the first message the new segment will hold.
+ * @remark  The current segment is always kept; older ones are deleted, oldest first, while there are more than `log_retention_size` bytes of segments or they were sealed more than `log_retention_age` seconds ago.
+ * @throws  EIO  If the new segment could not be created.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_log_roll(nipc_instance* const instance, const uint64_t first)
+{
+	const nipc_options& options = instance->options; // The options of the instance.
+	nipc_log* const log = &instance->log; // The log of the instance.
+	const uint64_t now = static_cast<uint64_t>(time(nullptr)); // The current time, in seconds since the epoch.
+
+	// Start the next segment, then seal the current one.
+	if (_nipc_log_start(options, log->segment + 1, first) == -1) return -1;
+	const int fd = open(_nipc_log_name(options, log->segment).c_str(), O_WRONLY | O_CLOEXEC); // The sealed segment.
+	if (fd != -1) { pwrite(fd, &now, sizeof(now), offsetof(nipc_log_segment, sealed)); close(fd); }
+	++log->segment;
+	log->offset = sizeof(nipc_log_segment);
+
+	// Delete the oldest segments that are no longer retained.
+	const uint64_t kept = options.log_retention_size ? std::max<uint64_t>(options.log_retention_size / options.log_segment_size, 1) : 0; // The number of segments retained by size, or `0`.
+	nipc_log_segment header; // The header of the oldest segment.
+	while (log->first < log->segment && ((kept && log->segment - log->first + 1 > kept) || (options.log_retention_age && (!_nipc_log_header(options, log->first, &header) || header.sealed + options.log_retention_age <= now))))
+	{
+		unlink(_nipc_log_name(options, log->first).c_str());
+		++log->first;
+	}
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_log_record_size()
+ * @brief  Computes the size of the record of a message in a log segment.
+ * @param  message  {const nipc_message&}  The message.
+ * @param  channels  {const size_t}  The number of channels recorded besides the first.
+ * @return  {const size_t}  The size of the record, padded to 8 bytes.
+ */
+inline const size_t _nipc_log_record_size(const nipc_message& message, const size_t channels) { return (sizeof(nipc_log_record) + channels * sizeof(long) + message.length + 7) & ~static_cast<size_t>(7); }
+
+/**
+ * @name  _nipc_log_append()
+ * @brief  Appends messages to the log of a NIPC instance under consecutive sequence numbers.
+ * @param  handle  {nipc_handle&}  The state this process keeps for the instance; the segment being written is mapped into it.
+ * @param  msgs  {const nipc_message* const}  The messages.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  type  {const long}  The `type` the messages are sent with; the first of `channels` if they are given.
+ * @param  channels  {const long* const}  The multicast channels the messages are sent on, or `nullptr`.
+ * @param  channel_count  {const size_t}  The number of channels.
+ * @param  timestamp  {const uint64_t}  The time the messages are sent at.
+ * @remark  Each record is published by advancing the next sequence number, so a subscriber that read it while holding the lock finds every record below it complete.
+ * @throws  EINVAL  If a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a message does not fit in a segment.
+ * @throws  ENOLCK  If the log could not be locked.
+ * @throws  EIO  If a segment could not be created or mapped.
+ * @return  {const uint64_t}  The sequence number of the first message on success, `0` on failure.
+ */
+const uint64_t _nipc_log_append(nipc_handle& handle, const nipc_message* const msgs, const size_t n, const long type, const long* const channels, const size_t channel_count, const uint64_t timestamp)
+{
+	nipc_instance* const instance = handle.instance; // The NIPC instance.
+	const nipc_options& options = instance->options; // The options of the instance.
+	nipc_log* const log = &instance->log; // The log of the instance.
+	const size_t extra = channels && channel_count > 1 ? channel_count - 1 : 0; // The number of channels recorded besides `type`.
+
+	// Ensure every message can be logged before logging any.
+	for (size_t index = 0; index < n; ++index)
+	{
+		if ((msgs[index].length > NIPC_INLINE_SIZE && !msgs[index].blob) || msgs[index].priority >= NIPC_LANES) { errno = EINVAL; return 0; }
+		if (_nipc_log_record_size(msgs[index], extra) > options.log_segment_size - sizeof(nipc_log_segment)) { errno = EMSGSIZE; return 0; }
+	}
+	if (_nipc_log_lock(log) == -1) return 0;
+
+	const uint64_t first = log->next.load(std::memory_order_relaxed); // The sequence number of the first message.
+	size_t index = 0; // The number of messages logged so far.
+	for (; index < n; ++index)
+	{
+		// Start a new segment if the record does not fit in the current one, and map the current segment if this process has not yet.
+		const size_t size = _nipc_log_record_size(msgs[index], extra); // The size of the record.
+		if (log->offset + size > options.log_segment_size && _nipc_log_roll(instance, first + index) == -1) break;
+		if (!handle.log_map || handle.log_segment != log->segment)
+		{
+			size_t mapped; // The size of the mapping.
+			if (handle.log_map) munmap(handle.log_map, options.log_segment_size);
+			if (!(handle.log_map = _nipc_log_map(options, log->segment, true, &mapped)) || mapped != options.log_segment_size)
+			{
+				if (handle.log_map) munmap(handle.log_map, mapped);
+				handle.log_map = nullptr;
+				errno = EIO;
+				break;
+			}
+			handle.log_segment = log->segment;
+		}
+
+		// Write the record, its size last, then publish it.
+		char* const data = handle.log_map + log->offset; // The start of the record.
+		nipc_log_record* const record = reinterpret_cast<nipc_log_record*>(data); // The header of the record.
+		record->channels = static_cast<uint32_t>(extra);
+		record->sequence = first + index;
+		record->target = type;
+		record->channel = msgs[index].channel;
+		record->sender = msgs[index].sender;
+		record->length = static_cast<uint32_t>(msgs[index].length);
+		record->timestamp = timestamp;
+		if (extra) memcpy(data + sizeof(nipc_log_record), channels + 1, extra * sizeof(long));
+		memcpy(data + sizeof(nipc_log_record) + extra * sizeof(long), msgs[index].payload(), msgs[index].length);
+		record->size.store(static_cast<uint32_t>(size), std::memory_order_release);
+		log->next.store(first + index + 1, std::memory_order_release);
+		log->offset += size;
+	}
+	pthread_mutex_unlock(&log->lock);
+
+	// Return the sequence number of the first message, unless some could not be logged.
+	return index == n ? first : 0;
+}
+
+/**
+ * @name  _nipc_log_match()
+ * @brief  Checks whether a logged message was addressed to a subscriber.
+ * @param  record  {const nipc_log_record&}  The record of the message.
+ * @param  pid  {const long}  The PID of the subscriber.
+ * @param  subscriber  {const nipc_subscriber&}  The entry of the subscriber.
+ * @return  {const bool}  `true` if the message was broadcast, unicast to the subscriber or multicast to a channel it follows.
+ */
+const bool _nipc_log_match(const nipc_log_record& record, const long pid, const nipc_subscriber& subscriber)
+{
+	// Broadcasts reach everyone and unicasts their target alone.
+	if (!record.target) return true;
+	if (record.target > 0) return record.target == pid;
+
+	// Multicasts reach the followers of any of their channels.
+	const long* const channels = reinterpret_cast<const long*>(&record + 1); // The channels the message was sent on besides `target`.
+	for (uint32_t index = 0; index <= record.channels; ++index) if (_nipc_follows(subscriber, index ? channels[index - 1] : record.target)) return true;
+	return false;
+}
+
+/**
+ * @name  _nipc_replay()
+ * @brief  Hands the logged messages addressed to a process that just subscribed to a NIPC instance to its notification handler.
+ * @param  handle  {const nipc_handle&}  The state this process keeps for the instance.
+ * @param  entry  {const uint32_t}  The index of the process's entry in the instance's registry.
+ * @param  from  {const uint64_t}  The sequence number of the first message to replay.
+ * @param  to  {const uint64_t}  The sequence number to stop replaying before.
+ * @remark  Segments are mapped one at a time and the messages handed over in batches straight from them, so a payload larger than `NIPC_INLINE_SIZE` bytes is only valid until a batch notification handler returns; a message handed over in a buffer gets a copy of its payload in the instance's slab instead.  Segments deleted meanwhile are skipped.
+ * @remark  Messages that find the process's message pool exhausted, or no room in the slab for their payload, are skipped and counted as dropped; the replay runs on the subscribing thread and cannot wait for buffers that the handler may only release once the subscription returns.
+ * @throws  ENOLCK  If the log could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_replay(const nipc_handle& handle, const uint32_t entry, const uint64_t from, const uint64_t to)
+{
+	nipc_instance* const instance = handle.instance; // The NIPC instance.
+	const nipc_options& options = instance->options; // The options of the instance.
+	nipc_subscriber& self = instance->registry.entries[entry]; // The entry of this process.
+	const long pid = getpid(); // The PID of this process.
+
+	// Find the segments kept, then skip those ending before the first message to replay.
+	if (_nipc_log_lock(&instance->log) == -1) return -1;
+	uint64_t index = instance->log.first; // The index of the segment to read.
+	const uint64_t last = instance->log.segment; // The index of the segment being written.
+	pthread_mutex_unlock(&instance->log.lock);
+	nipc_log_segment header; // The header of the segment following the one to read.
+	while (index < last && _nipc_log_header(options, index + 1, &header) && header.first <= from) ++index;
+
+	nipc_message batch[NIPC_BATCH_SIZE]; // The messages to hand over next.
+	size_t handed = 0; // The number of messages handed over.
+	size_t dropped = 0; // The number of messages skipped for want of a buffer or of room in the slab.
+	const auto hand = [&](const size_t size) // Hands over the first messages of the batch, then drops the references to the payloads copied into the slab; the buffers keep their own.
+	{
+		_nipc_invoke(handle, batch, size);
+		if (!handle.batch_handler) for (size_t message = 0; message < size; ++message) if (batch[message].blob) _nipc_slab_release(instance, _nipc_slab_block(instance, batch[message].blob));
+		handed += size;
+	};
+	for (bool done = false; !done && index <= last; ++index)
+	{
+		// Map the segment, unless it was deleted meanwhile.
+		size_t size; // The size of the segment.
+		const char* const segment = _nipc_log_map(options, index, false, &size); // The segment.
+		if (!segment) continue;
+
+		// Collect the messages addressed to this process, handing them over whenever the batch is full and once the segment is read.
+		size_t count = 0; // The number of messages in the batch.
+		for (size_t offset = sizeof(nipc_log_segment); offset + sizeof(nipc_log_record) <= size;)
+		{
+			const nipc_log_record& record = *reinterpret_cast<const nipc_log_record*>(segment + offset); // The record at the offset.
+			const uint32_t length = record.size.load(std::memory_order_acquire); // The size of the record.
+			if (!length || offset + length > size || (done = record.sequence >= to)) break;
+			offset += length;
+			if (record.sequence < from || !_nipc_log_match(record, pid, self)) continue;
+			if (!handle.batch_handler && !_nipc_pool_reserve(false)) { ++dropped; continue; }
+
+			// A buffer outlives the segment, so a large payload handed over in one is copied into the slab; a batch notification handler reads it in place.
+			const char* payload = reinterpret_cast<const char*>(&record + 1) + record.channels * sizeof(long); // The payload of the message.
+			if (record.length > NIPC_INLINE_SIZE && !handle.batch_handler)
+			{
+				const uint64_t reference = _nipc_slab_alloc(instance, record.length); // The run of the slab holding the payload.
+				if (!reference) { _nipc_pool_unreserve(); ++dropped; continue; }
+				char* const copy = _nipc_slab_data(instance) + static_cast<size_t>(static_cast<uint32_t>(reference)) * instance->slab.block_size; // The copy of the payload.
+				memcpy(copy, payload, record.length);
+				payload = copy;
+			}
+
+			// Point at large payloads and copy the others.
+			nipc_message& message = batch[count++]; // The message.
+			message.channel = record.channel;
+			message.sender = record.sender;
+			message.length = record.length;
+			message.timestamp = record.timestamp;
+			message.sequence = record.sequence;
+			if (record.length > NIPC_INLINE_SIZE) { message.blob = payload; message.data[0] = '\0'; }
+			else { message.blob = nullptr; memcpy(message.data, payload, record.length); }
+			if (count == NIPC_BATCH_SIZE) { hand(count); count = 0; }
+		}
+		if (count) hand(count);
+		munmap(const_cast<char*>(segment), size);
+	}
+
+	// Count the messages handed over and those skipped.
+	self.received.fetch_add(handed, std::memory_order_relaxed);
+	if (dropped) self.dropped.fetch_add(dropped, std::memory_order_relaxed);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_queues_remove()
+ * @brief  Removes the message queues of the shards of a NIPC instance past the first, which has the instance's key.
+ * @param  instance  {const nipc_instance* const}  The NIPC instance.
+ * @param  count  {const uint32_t}  The number of shards whose queues were created.
+ */
+void _nipc_queues_remove(const nipc_instance* const instance, const uint32_t count) { for (uint32_t shard = 1; shard < count; ++shard) msgctl(instance->queues[shard], IPC_RMID, NULL); }
+
+/**
+ * @name  nipc_create()
+ * @brief  Creates a NIPC instance that has a key `_key`.  If a NIPC instance with the same key exists, the function fails.
+ * @remark  The NIPC instance relies on a message queue to store and manage messages.
+ * @param  _key  {const key_t}  The key of the NIPC instance to create.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @remark  The subscriber registry of the instance lives entirely in its shared memory segment and is safe to use from any number of processes.
+ * @remark  With `NIPC_TRANSPORT_RING`, a broadcast or multicast is written once to the ring and every subscriber reads it through its own cursor; unicasts travel through the ring as well and are skipped by the other subscribers.
+ * @remark  Payloads larger than `NIPC_INLINE_SIZE` bytes are stored in a slab of `options.slab_size` bytes in the same segment.
+ * @remark  With a `options.log_path`, the last segment of an existing log is scanned so that the sequence numbers carry on from it.
+ * @remark  With `options.queue_shards` above 1, the shards past the first are message queues without a key, found through the instance's shared memory segment.
+ * @throws  EEXIST  If a NIPC instance with the same key already exists.
+ * @throws  EINVAL  If the options are invalid.
+ * @throws  ENOMEM  If the NIPC instance could not be created due to a lack of memory.
+ * @throws  EIO  If the log could not be opened or created.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_create(const key_t _key, const nipc_options& options)
+{
+	// The overflow policy must be one of those known.
+	if (options.overflow > NIPC_OVERFLOW_FAIL) { errno = EINVAL; return -1; }
+
+	// The ring must hold a power of two number of slots so that positions can be mapped to slots with a mask.
+	if (options.transport == NIPC_TRANSPORT_RING && (options.ring_slots < 2 || (options.ring_slots & (options.ring_slots - 1)))) { errno = EINVAL; return -1; }
+
+	// A message queue transport needs at least one shard, and no more than the instance can record.
+	if (options.transport == NIPC_TRANSPORT_QUEUE && (!options.queue_shards || options.queue_shards > NIPC_MAX_SHARDS)) { errno = EINVAL; return -1; }
+
+	// A slab must hold at least one block, and no more than its references can address.
+	if (options.slab_size && (!_nipc_slab_blocks(options) || _nipc_slab_blocks(options) >= UINT32_MAX)) { errno = EINVAL; return -1; }
+
+	// Trace buffers must hold a power of two number of events so that positions can be mapped to events with a mask.
+	if (options.trace_events & (options.trace_events - 1)) { errno = EINVAL; return -1; }
+
+	// The log path must be terminated, and log segments must hold a page and have sizes their records can express.
+	if (!memchr(options.log_path, '\0', NIPC_LOG_PATH_SIZE) || (options.log_path[0] && (options.log_segment_size < 4096 || options.log_segment_size > UINT32_MAX))) { errno = EINVAL; return -1; }
+
+	// Create a shared memory segment with the provided to store the NIPC instance ensuring that the segment does not already exist.
+	const int shmid = shmget(_key, _nipc_segment_size(options), IPC_CREAT | IPC_EXCL | RW_UGO); // The ID of the shared memory segment.
+	// If the shared memory segment could not be created, return an error.
+	if (shmid == -1) { errno = EEXIST; return -1; }
+
+	// Create a message queue with the provided key to store and manage messages ensuring that the queue does not already exist.
+	const int msgq_id = msgget(_key, IPC_CREAT | IPC_EXCL | RW_UGO); // The ID of the message queue.
+	// If the message queue could not be created, return an error.
+	if (msgq_id == -1) { shmctl(shmid, IPC_RMID, NULL); errno = EEXIST; return -1; }
+
+	// Attach the shared memory segment to the address space of the creator process.
+	nipc_instance* shm = static_cast<nipc_instance*>(shmat(shmid, NULL, 0)); // The pointer to the shared memory segment.
+	// If the shared memory segment could not be attached, return an error.
+	if (shm == reinterpret_cast<nipc_instance*>(-1)) { msgctl(msgq_id, IPC_RMID, NULL); shmctl(shmid, IPC_RMID, NULL); errno = ENOMEM; return -1; }
+
+	// Instantiate a new NIPC instance in the shared memory segment.
+	nipc_instance* const instance = new (shm) nipc_instance(); // The NIPC instance.
+	nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	instance->options = options;
+	instance->options.queue_shards = options.transport == NIPC_TRANSPORT_QUEUE ? options.queue_shards : 1;
+	instance->queues[0] = msgq_id;
+	instance->ring.mask = options.ring_slots - 1;
+
+	instance->slab.blocks = static_cast<uint32_t>(_nipc_slab_blocks(options));
+	instance->slab.block_size = options.slab_block_size;
+	instance->slab.offset = _nipc_slab_offset(options);
+	instance->slab.data = _nipc_slab_data_offset(options);
+
+	// Initialise the registry, slab and log locks as process-shared robust mutexes so that a process dying while holding one cannot wedge the instance.
+	pthread_mutexattr_t attributes; // The attributes of the locks.
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+	const int status = pthread_mutex_init(&registry->lock, &attributes) || pthread_mutex_init(&instance->slab.lock, &attributes) || pthread_mutex_init(&instance->log.lock, &attributes); // Whether initialising a lock failed.
+	pthread_mutexattr_destroy(&attributes);
+	if (status) { shmdt(shm); msgctl(msgq_id, IPC_RMID, NULL); shmctl(shmid, IPC_RMID, NULL); errno = ENOMEM; return -1; }
+
+	// Empty the indices and chain every entry onto its free list.
+	for (uint32_t bucket = 0; bucket < NIPC_INDEX_CAPACITY; ++bucket) registry->index[bucket].store(NIPC_NONE, std::memory_order_relaxed);
+	for (uint32_t bucket = 0; bucket < NIPC_INDEX_CAPACITY; ++bucket) registry->channel_index[bucket].store(NIPC_NONE, std::memory_order_relaxed);
+	for (uint32_t entry = 0; entry < NIPC_MAX_SUBSCRIBERS; ++entry) registry->entries[entry].next_free = registry->channels[entry].next_free = entry + 1 < NIPC_MAX_SUBSCRIBERS ? entry + 1 : NIPC_NONE;
+	registry->free_list = registry->channel_free_list = 0;
+
+	// Size the trace buffers, if any; they start out free.
+	for (uint32_t index = 0; options.trace_events && index < options.trace_processes; ++index) _nipc_trace_buffer(instance, index)->mask = options.trace_events - 1;
+
+	// Create the message queues of the other shards, if any; they have no key and are only found through the instance.
+	for (uint32_t shard = 1; shard < instance->options.queue_shards; ++shard)
+		if ((instance->queues[shard] = msgget(IPC_PRIVATE, IPC_CREAT | RW_UGO)) == -1) { _nipc_queues_remove(instance, shard); shmdt(shm); msgctl(msgq_id, IPC_RMID, NULL); shmctl(shmid, IPC_RMID, NULL); errno = ENOMEM; return -1; }
+
+	// Open the log, if any, carrying on from an existing one.
+	if (options.log_path[0] && _nipc_log_recover(instance) == -1) { _nipc_queues_remove(instance, instance->options.queue_shards); shmdt(shm); msgctl(msgq_id, IPC_RMID, NULL); shmctl(shmid, IPC_RMID, NULL); errno = EIO; return -1; }
+
+	// Publish the instance and detach it; the creator opens it through `nipc_get()` like any other process.
+	instance->magic.store(NIPC_MAGIC, std::memory_order_release);
+	shmdt(shm);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  nipc_get()
+ * @brief  Opens a NIPC instance whose key is `_key`.
+ * @param  _key  {const key_t}  The key of the NIPC instance to open.
+ * @throws  ENOENT  If a NIPC instance with the provided key does not exist.
+ * @throws  ENOMEM  If the NIPC instance could not be opened due to a lack of memory.
+ * @return  {const int}  If the instance exists, a unique positive non-zero integer to identify the instance is returned.  Otherwise, `-1` is returned.
+ */
+const int nipc_get(const key_t _key)
+{
+	// Get the ID of the message queue with the provided key.  The message queue ID is used to identify the NIPC instance.
+	const int msgq_id = msgget(_key, RW_UGO); // The ID of the message queue.
+	// If the message queue could not be found, return an error.
+	if (msgq_id == -1) { errno = ENOENT; return -1; }
+
+	// Get the ID of the shared memory segment with the provided key.
+	const int shmid = shmget(_key, 0, RW_UGO); // The ID of the shared memory segment.
+	// If the shared memory segment could not be attached, return an error.
+	if (shmid == -1) { errno = ENOENT; return -1; }
+	// Attach the shared memory segment to the address space of the  process.
+	nipc_instance* nipc = static_cast<nipc_instance*>(shmat(shmid, NULL, 0)); // The NIPC instance.
+	// If the shared memory segment could not be attached, return an error.
+	if (nipc == reinterpret_cast<nipc_instance*>(-1)) { errno = ENOMEM; return -1; }
+	// If the instance has not been fully initialised by its creator, return an error.
+	if (nipc->magic.load(std::memory_order_acquire) != NIPC_MAGIC) { shmdt(nipc); errno = ENOENT; return -1; }
+
+	// If the instance was already opened by this process, keep the existing attachment.
+	if (_subscription_list.find(msgq_id) != _subscription_list.end()) { shmdt(nipc); return msgq_id; }
+
+	// Store the pointer to the shared memory segment in the subscription list such that it could be referenced via the NIPC ID.
+	_subscription_list[msgq_id] = { nipc, NIPC_NONE, nullptr, nullptr, nullptr, nullptr, -1, nullptr, {}, nullptr, 0, 0, 0, NIPC_NONE };
+
+	// Return the ID of the NIPC instance.
+	return msgq_id;
+}
+
+/**
+ * @name  _nipc_catch_up()
+ * @brief  Hands the current value of a conflated channel to a process that just subscribed to it.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the process's entry in the instance's registry.
+ * @param  channel  {const long}  The channel the process subscribed to.
+ * @remark  Nothing is done unless the channel is conflated and has a value the process has not read.
+ */
+void _nipc_catch_up(const int id, nipc_instance* const instance, const uint32_t entry, const long channel)
+{
+	// Ignore channels that are not conflated or have no value yet.
+	const uint32_t slot = _nipc_find_conflated(instance, channel); // The conflation slot of the channel.
+	if (slot == NIPC_NONE || !instance->conflation[slot].version.load(std::memory_order_acquire)) return;
+
+	// Flag the slot and notify the process of it, unless it was already flagged.
+	if (!(instance->registry.entries[entry].stale.fetch_or(1ULL << slot) & (1ULL << slot))) _nipc_notify(id, instance, entry, getpid());
+}
+
+/**
+ * @name  _nipc_subscribe()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @param  handler  {nipc_handler_t}  The function handler to invoke with every message, if `batch_handler` is not set.
+ * @param  batch_handler  {nipc_batch_handler_t}  The function handler to invoke with every batch of messages, if any.
+ * @param  options  {const nipc_subscriber_options&}  The options of the subscription.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, with more than `NIPC_MAX_WORKERS` workers, or already subscribed with `nipc_subscribe_poll()`.
+ * @throws  ENOMEM  If the message pool could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @throws  EAGAIN  If the receiver thread or a worker thread could not be started.
+ * @throws  EIO  If the log could not be replayed.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int _nipc_subscribe(const int id, const long type, nipc_handler_t handler, nipc_batch_handler_t batch_handler, const nipc_subscriber_options& options)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Processes must subscribe to a valid channel.
+	else if (type >= 0) { errno = EINVAL; return -1; }
+
+	// The worker pool is bounded.
+	else if (options.workers > NIPC_MAX_WORKERS) { errno = EINVAL; return -1; }
+
+	// A process that receives from the instance itself has no notification handler to replace.
+	else if (nipc->second.fd != -1) { errno = EINVAL; return -1; }
+
+	// Create the message pool before any message can be delivered into it.
+	if (_nipc_pool_create(options.pool ? options.pool : NIPC_POOL_SIZE) == -1) return -1;
+
+	// Claim a trace buffer if the instance traces.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	if (!nipc->second.trace) nipc->second.trace = _nipc_trace_claim(instance);
+
+	// Set the signal and notification handlers before admitting the process so that no notification is missed.
+	nipc->second.handler = handler;
+	nipc->second.batch_handler = batch_handler;
+	if (instance->options.wakeup == NIPC_WAKEUP_SIGNAL)
+	{
+		struct sigaction action = {}; // The disposition of `NIPC_SIGNAL`.
+		action.sa_sigaction = _nipc_handler;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(NIPC_SIGNAL, &action, nullptr);
+	}
+
+	// Admit the process to the NIPC instance.  On a first subscription that replays the log, hold the log's lock as well, so that every message logged from then on is sent to the process.
+	nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	const bool replay = options.replay && instance->options.log_path[0] && nipc->second.subscriber == NIPC_NONE; // Whether to replay the log.
+	if (replay && _nipc_log_lock(&instance->log) == -1) return -1;
+	if (_nipc_lock(registry) == -1) { if (replay) pthread_mutex_unlock(&instance->log.lock); return -1; }
+	const uint32_t entry = _nipc_register(registry, getpid(), type, instance->ring.head.load(std::memory_order_relaxed)); // The entry of the process.
+	const uint64_t joined = replay ? instance->log.next.load(std::memory_order_relaxed) : 0; // The sequence number of the first message sent to the process.
+	_nipc_unlock(registry);
+	if (replay) pthread_mutex_unlock(&instance->log.lock);
+
+	// If the process could not be admitted, return an error.
+	if (entry == NIPC_NONE) return -1;
+
+	// Replay the logged messages before taking live ones; notifications are ignored until the entry is recorded, and live messages that were replayed are dropped.
+	const int replayed = replay && options.replay < joined ? _nipc_replay(nipc->second, entry, options.replay, joined) : 0; // Whether the replay succeeded.
+	if (replay) { nipc->second.replayed_from = options.replay; nipc->second.replayed_to = joined; }
+	nipc->second.subscriber = entry;
+
+	// A signal that arrived before the entry was recorded was ignored; queue it again.
+	if (instance->options.wakeup == NIPC_WAKEUP_SIGNAL && registry->entries[entry].signalled.load())
+	{
+		sigval value; // The ID of the instance, carried by the signal.
+		value.sival_int = id;
+		sigqueue(getpid(), NIPC_SIGNAL, value);
+	}
+
+	// Hand over the current value of the channel if it is conflated.
+	_nipc_catch_up(id, instance, entry, type);
+
+	// Start a receiver thread for the subscription if the instance uses futex notifications or the subscription uses workers, and none is running yet.
+	if ((instance->options.wakeup == NIPC_WAKEUP_FUTEX || options.workers) && !nipc->second.receiver && !(nipc->second.receiver = _nipc_start_receiver(id, &nipc->second, options.workers))) return -1;
+
+	// If the log could not be replayed, return an error; the process stays subscribed.
+	if (replayed == -1) { errno = EIO; return -1; }
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  nipc_subscribe()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @param  handler  {nipc_handler_t}  The function handler to invoke upon any notification from the NIPC instance.
+ * @param  options  {const nipc_subscriber_options&}  The options of the subscription; they only take effect on the first subscription of the process to the instance.
+ * @remarks  `NIPC_SIGNAL` is used to notify the process of a new message, unless the instance was created with `NIPC_WAKEUP_FUTEX`; then a receiver thread is started for the subscription and the notification handler runs on it.
+ * @remarks  Each instance keeps its own notification handler, and a notification only drains the instance it comes from, so opening many instances does not slow down any of them.
+ * @remarks  When a new message is received, the signal handler will copy it into a buffer and call the notification handler; it is the responsibility of the notification handler to release the buffer using `nipc_message_release()`.
+ * @remarks  A payload held in the instance's slab is only valid until the notification handler returns, even if the buffer is kept longer.
+ * @remarks  Every notification drains all messages pending for the process on its instance, so notifications that were merged do not leave messages behind.
+ * @remarks  Buffers come from the process's message pool and must be released using `nipc_message_release()`, never `free()`; while the pool is exhausted, messages are left pending, and they are delivered once a buffer is released.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`, and replaces its notification handler; a message multicast to several of them is still delivered once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, with more than `NIPC_MAX_WORKERS` workers, or already subscribed with `nipc_subscribe_poll()`.
+ * @throws  ENOMEM  If the message pool could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @throws  EAGAIN  If the receiver thread or a worker thread could not be started.
+ * @throws  EIO  If the log could not be replayed.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe(const int id, const long type, nipc_handler_t handler, const nipc_subscriber_options& options) { return _nipc_subscribe(id, type, handler, nullptr, options); }
+
+/**
+ * @name  nipc_subscribe_batch()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`, delivering messages in batches.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @param  handler  {nipc_batch_handler_t}  The function handler to invoke with every batch of messages received from the NIPC instance.
+ * @param  options  {const nipc_subscriber_options&}  The options of the subscription; they only take effect on the first subscription of the process to the instance.
+ * @remarks  Notifications are delivered as with `nipc_subscribe()`.  On every notification, everything pending for the process on the instance it comes from is drained and handed to `handler` in batches of up to `NIPC_BATCH_SIZE` messages.
+ * @remarks  The batch is owned by the library and is only valid until the handler returns; nothing has to be freed.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`, and replaces its notification handler; a message multicast to several of them is still delivered once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, with more than `NIPC_MAX_WORKERS` workers, or already subscribed with `nipc_subscribe_poll()`.
+ * @throws  ENOMEM  If the message pool could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @throws  EAGAIN  If the receiver thread or a worker thread could not be started.
+ * @throws  EIO  If the log could not be replayed.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe_batch(const int id, const long type, nipc_batch_handler_t handler, const nipc_subscriber_options& options) { return _nipc_subscribe(id, type, nullptr, handler, options); }
+
+/**
+ * @name  nipc_unsubscribe()
+ * @brief  Stops the calling process from following the multicast channel `type` of the opened NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  type  {const long}  The multicast channel to leave.
+ * @remarks  The process stays subscribed to the instance, and keeps receiving broadcasts and unicasts, even once it follows no channel; use `nipc_close()` to leave the instance.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened, or the process does not follow the channel.
+ * @throws  EINVAL  If `type` is not a multicast channel.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_unsubscribe(const int id, const long type)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Only multicast channels can be left.
+	else if (type >= 0) { errno = EINVAL; return -1; }
+
+	// A process that never subscribed follows no channel.
+	else if (nipc->second.subscriber == NIPC_NONE) { errno = ENOENT; return -1; }
+
+	// Remove the channel from those the process follows.
+	nipc_registry* const registry = &nipc->second.instance->registry; // The subscriber registry of the instance.
+	if (_nipc_lock(registry) == -1) return -1;
+	const int status = _nipc_leave(registry, nipc->second.subscriber, type); // The result of leaving the channel.
+	_nipc_unlock(registry);
+
+	// Return the result.
+	return status;
+}
+
+/**
+ * @name  nipc_subscribe_poll()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`, leaving messages pending until it receives them with `nipc_recv()` or `nipc_recv_many()`.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @remarks  No signal is sent to the process and no thread is started for it; senders notify it through the descriptor returned by `nipc_fd()` instead, so it can wait for messages alongside its other I/O with `poll()`, `epoll` or `io_uring`.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`.  A process subscribes to an instance either with a notification handler or this way, not both.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, or already subscribed to the instance with a notification handler.
+ * @throws  ENOMEM  If the descriptor or the receive buffer could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe_poll(const int id, const long type)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Processes must subscribe to a valid channel.
+	else if (type >= 0) { errno = EINVAL; return -1; }
+
+	// A process that subscribed with a notification handler is notified by it.
+	else if (nipc->second.subscriber != NIPC_NONE && nipc->second.fd == -1) { errno = EINVAL; return -1; }
+
+	// Claim a trace buffer if the instance traces.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	if (!nipc->second.trace) nipc->second.trace = _nipc_trace_claim(instance);
+
+	// Bind the socket senders notify the process through, and allocate its inbox, before admitting the process so that no notification is missed.
+	if (nipc->second.fd == -1)
+	{
+		sockaddr_un address; // The address of the socket.
+		const socklen_t length = _nipc_address(&address, id, getpid()); // The length of the address.
+		const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0); // The socket.
+		if (fd == -1 || bind(fd, reinterpret_cast<const sockaddr*>(&address), length) == -1) { if (fd != -1) close(fd); errno = ENOMEM; return -1; }
+		nipc_inbox* const inbox = new (std::nothrow) nipc_inbox(); // The record to receive messages from.
+		if (!inbox) { close(fd); errno = ENOMEM; return -1; }
+		nipc->second.fd = fd;
+		nipc->second.inbox = inbox;
+	}
+
+	// Admit the process to the NIPC instance, marking it as polled before any sender can see it.
+	nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	uint32_t entry = NIPC_NONE; // The entry of the process.
+	if (_nipc_lock(registry) == 0)
+	{
+		entry = _nipc_register(registry, getpid(), type, instance->ring.head.load(std::memory_order_relaxed));
+		if (entry != NIPC_NONE) registry->entries[entry].polled.store(1, std::memory_order_relaxed);
+		_nipc_unlock(registry);
+	}
+
+	// If the process could not be admitted, release the socket unless an earlier subscription uses it, and return an error.
+	if (entry == NIPC_NONE)
+	{
+		const int error = errno; // The reason the process was not admitted.
+		if (nipc->second.subscriber == NIPC_NONE) { close(nipc->second.fd); delete nipc->second.inbox; nipc->second.fd = -1; nipc->second.inbox = nullptr; }
+		errno = error;
+		return -1;
+	}
+	nipc->second.subscriber = entry;
+
+	// Hand over the current value of the channel if it is conflated.
+	_nipc_catch_up(id, instance, entry, type);
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  nipc_fd()
+ * @brief  Returns the descriptor that becomes readable when messages are pending for the calling process on the NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remarks  The descriptor stays readable until `nipc_recv()` or `nipc_recv_many()` finds nothing left to receive, so it may be waited on either level- or edge-triggered as long as the process receives until they fail with `EAGAIN`.
+ * @remarks  The descriptor belongs to the library; it must not be read from or closed, and it is closed by `nipc_close()`.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`.
+ * @return  {const int}  The descriptor on success, `-1` on failure.
+ */
+const int nipc_fd(const int id)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Only processes that receive from the instance themselves have a descriptor.
+	else if (nipc->second.fd == -1) { errno = EINVAL; return -1; }
+
+	// Return the descriptor.
+	return nipc->second.fd;
+}
+
+/**
+ * @name  nipc_recv_many()
+ * @brief  Receives up to `capacity` messages pending for the calling process on the NIPC instance identified by `id`, in order, without blocking.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  msgs  {nipc_message* const}  The buffers to copy the messages to.
+ * @param  capacity  {const size_t}  The number of messages `msgs` can hold.
+ * @remarks  A payload held in the instance's slab is only valid until the next call to `nipc_recv()`, `nipc_recv_many()` or `nipc_close()` on the instance.
+ * @remarks  The messages of an instance must be received from one thread at a time.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`, or `msgs` is `nullptr` or `capacity` is `0`.
+ * @throws  EAGAIN  If no message is pending.
+ * @return  {const int}  The number of messages received on success, `-1` on failure.
+ */
+const int nipc_recv_many(const int id, nipc_message* const msgs, const size_t capacity)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Only processes that subscribed with `nipc_subscribe_poll()` receive messages themselves.
+	else if (nipc->second.fd == -1 || !msgs || !capacity) { errno = EINVAL; return -1; }
+
+	// Release the payloads returned by the previous call.
+	nipc_handle& handle = nipc->second; // The state this process keeps for the instance.
+	nipc_instance* const instance = handle.instance; // The NIPC instance.
+	for (const uint32_t block : handle.held) _nipc_slab_release(instance, block);
+	handle.held.clear();
+
+	// Receive what is pending.  If that is less than asked for, consume the notification and look again, so that any message sent meanwhile is either received now or notifies the process anew.
+	nipc_subscriber& self = instance->registry.entries[handle.subscriber]; // The entry of this process.
+	const uint64_t started = handle.trace ? _nipc_now() : 0; // The time receiving started at.
+	size_t count = 0; // The number of messages received.
+	while (count < capacity && _nipc_receive(instance, handle.subscriber, &msgs[count], handle.inbox)) ++count;
+	if (count < capacity)
+	{
+		char notification[64]; // The buffer notification datagrams are discarded into.
+		while (recv(handle.fd, notification, sizeof(notification), MSG_DONTWAIT) > 0);
+		self.signalled.exchange(0);
+		while (count < capacity && _nipc_receive(instance, handle.subscriber, &msgs[count], handle.inbox)) ++count;
+	}
+	if (!count) { errno = EAGAIN; return -1; }
+
+	// Record how long the messages took to get here, count them, and hold on to their payloads until the next call.
+	const uint64_t now = _nipc_now(); // The time the messages are returned at.
+	for (size_t index = 0; index < count; ++index)
+	{
+		_nipc_count_latency(instance, self, msgs[index], now);
+		if (msgs[index].blob) handle.held.push_back(_nipc_slab_block(instance, msgs[index].blob));
+	}
+	self.received.fetch_add(count, std::memory_order_relaxed);
+	if (handle.trace) _nipc_trace(handle.trace, NIPC_TRACE_RECEIVE, started, msgs[0].timestamp, static_cast<long>(count));
+
+	// Return the number of messages received.
+	return static_cast<int>(count);
+}
+
+/**
+ * @name  nipc_recv()
+ * @brief  Receives the next message pending for the calling process on the NIPC instance identified by `id`, without blocking.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  msg  {nipc_message* const}  The buffer to copy the message to.
+ * @remarks  A payload held in the instance's slab is only valid until the next call to `nipc_recv()`, `nipc_recv_many()` or `nipc_close()` on the instance.
+ * @remarks  The messages of an instance must be received from one thread at a time.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`, or `msg` is `nullptr`.
+ * @throws  EAGAIN  If no message is pending.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_recv(const int id, nipc_message* const msg) { return nipc_recv_many(id, msg, 1) == -1 ? -1 : 0; }
+
+/**
+ * @name  nipc_conflate()
+ * @brief  Makes the multicast channel `type` of the NIPC instance identified by `id` a conflated channel, which only keeps the latest message sent on it.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  type  {const long}  The multicast channel to conflate.
+ * @remarks  Every message sent on a conflated channel overwrites the channel's slot in the instance's shared memory segment instead of being queued, and its subscribers are only notified if they already read the previous value; when they drain, they receive the latest value once, however many were sent meanwhile.  The backlog of a conflated channel is thus a single message, whatever the rate it is published at.
+ * @remarks  A process subscribing to a conflated channel that already has a value receives it.  Values of conflated channels are received ahead of the messages queued for the process.
+ * @remarks  A channel stays conflated for the life of the instance; conflating it again has no effect.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `type` is not a multicast channel.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_CONFLATED` conflated channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_conflate(const int id, const long type)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Only multicast channels can be conflated.
+	else if (type >= 0) { errno = EINVAL; return -1; }
+
+	// Take the next free slot for the channel, unless it already has one; slots are taken under the registry lock so that no two processes take one for the same channel.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	if (_nipc_lock(&instance->registry) == -1) return -1;
+	const uint32_t count = instance->conflated.load(std::memory_order_relaxed); // The number of conflated channels.
+	const bool found = _nipc_find_conflated(instance, type) != NIPC_NONE; // Whether the channel is already conflated.
+	if (!found && count < NIPC_MAX_CONFLATED)
+	{
+		instance->conflation[count].channel.store(type, std::memory_order_relaxed);
+		instance->conflated.store(count + 1, std::memory_order_release);
+	}
+	_nipc_unlock(&instance->registry);
+
+	// If no slot was left, return an error.
+	if (!found && count == NIPC_MAX_CONFLATED) { errno = ENOSPC; return -1; }
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  _nipc_redeliver()
+ * @brief  Has every subscription of the process drained again.
+ * @remark  Subscriptions served by a receiver thread have it woken; the others are drained by the signal handler, which a `NIPC_SIGNAL` sent with `kill()` runs for every instance.
+ */
+void _nipc_redeliver()
+{
+	bool signal = false; // Whether a subscription is drained by the signal handler.
+	for (const std::pair<const int, nipc_handle>& pair : _subscription_list)
+	{
+		const nipc_handle& handle = pair.second; // The state this process keeps for the instance.
+		if (handle.subscriber == NIPC_NONE || handle.fd != -1) continue;
+		if (handle.receiver) _nipc_wake(handle.instance->registry.entries[handle.subscriber].futex);
+		else signal = true;
+	}
+	if (signal) kill(getpid(), NIPC_SIGNAL);
+}
+
+/**
+ * @name  nipc_message_release()
+ * @brief  Releases a message buffer handed to a notification handler.
+ * @param  msg  {nipc_message* const}  The message buffer to release; `nullptr` is ignored.
+ * @remark  The buffer is returned to the process's message pool, and the payload it holds in the instance's slab is released; a buffer that does not come from the pool is ignored.  If a drain stopped because the pool ran dry, the messages it left pending are delivered again.
+ * @remark  This function is lock-free and async-signal-safe, and may be called from any thread.
+ */
+void nipc_message_release(nipc_message* const msg)
+{
+	// Ignore null buffers.
+	if (!msg) return;
+
+	// Ignore buffers from outside the pool.
+	nipc_message* const messages = _pool.load(std::memory_order_acquire); // The buffers of the pool.
+	if (!messages || reinterpret_cast<uintptr_t>(msg) < reinterpret_cast<uintptr_t>(messages) || reinterpret_cast<uintptr_t>(msg) >= reinterpret_cast<uintptr_t>(messages + _pool_size)) return;
+
+	// Release the payload the buffer holds in a slab, if any.
+	const uint32_t index = static_cast<uint32_t>(msg - messages); // The index of the buffer.
+	_nipc_pool_drop(index, nullptr);
+
+	// Push the buffer back onto the free list, retrying if another thread changed it in the meantime.
+	uint64_t head = _pool_head.load(std::memory_order_relaxed); // The head of the free list.
+	do _pool_next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+	while (!_pool_head.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | index, std::memory_order_release, std::memory_order_relaxed));
+	_pool_free.fetch_add(1, std::memory_order_seq_cst);
+
+	// Have the messages left pending for want of a buffer delivered.
+	if (_pool_starved.load(std::memory_order_seq_cst) && _pool_starved.exchange(false)) _nipc_redeliver();
+}
+
+/**
+ * @name  _nipc_pending()
+ * @brief  Counts the messages written to a subscriber's inbox in the message queue that it has not handled yet.
+ * @param  subscriber  {const nipc_subscriber&}  The subscriber.
+ * @remark  The counters are read one by one while senders and the subscriber update them, so the count is approximate.
+ * @return  {const uint64_t}  The number of pending messages.
+ */
+inline const uint64_t _nipc_pending(const nipc_subscriber& subscriber)
+{
+	const uint64_t delivered = subscriber.delivered.load(std::memory_order_relaxed); // The number of messages written to the inbox.
+	const uint64_t handled = subscriber.received.load(std::memory_order_relaxed) + subscriber.dropped.load(std::memory_order_relaxed) + subscriber.evicted.load(std::memory_order_relaxed); // The number of messages taken out of it.
+	return delivered > handled ? delivered - handled : 0;
+}
+
+/**
+ * @name  _nipc_backlog()
+ * @brief  Counts the messages pending for a subscriber on lane `0`, the only ones its quota applies to.
+ * @param  subscriber  {const nipc_subscriber&}  The subscriber.
+ * @remark  Urgent messages are counted when their record is taken off the queue, so the count is as approximate as `_nipc_pending()`.
+ * @return  {const uint64_t}  The number of pending messages on lane `0`.
+ */
+inline const uint64_t _nipc_backlog(const nipc_subscriber& subscriber)
+{
+	const uint64_t pending = _nipc_pending(subscriber); // The number of messages pending on every lane.
+	int64_t urgent = 0; // The number of messages pending above lane `0`.
+	for (uint32_t lane = 1; lane < NIPC_LANES; ++lane) urgent += subscriber.queued[lane].load(std::memory_order_relaxed);
+	return urgent <= 0 ? pending : pending > static_cast<uint64_t>(urgent) ? pending - static_cast<uint64_t>(urgent) : 0;
+}
+
+/**
+ * @name  _nipc_retire()
+ * @brief  Folds the counters of a subscriber into those of its NIPC instance before its entry is released.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry in the instance's registry.
+ * @remark  The caller must hold the registry lock, so that a snapshot never counts the subscriber twice or not at all.
+ */
+void _nipc_retire(nipc_instance* const instance, const uint32_t entry)
+{
+	nipc_subscriber& subscriber = instance->registry.entries[entry]; // The entry of the subscriber.
+	instance->stats.received.fetch_add(subscriber.received.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	instance->stats.dropped.fetch_add(subscriber.dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	instance->stats.lapped.fetch_add(subscriber.lapped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	for (uint32_t bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) instance->stats.latency[bucket].fetch_add(subscriber.latency[bucket].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_discard()
+ * @brief  Removes the oldest record from a lane of a process's inbox in the message queue, releasing the payloads of its messages.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @param  lane  {const uint32_t}  The lane.
+ * @remark  The caller accounts for the messages in the lane's `queued` counter, if the process still has an entry.
+ * @return  {const size_t}  The number of messages removed; `0` if the lane had no record left.
+ */
+const size_t _nipc_discard(nipc_instance* const instance, const pid_t pid, const uint32_t lane)
+{
+	// Take the oldest record addressed to the process on the lane off the queue.
+	msgq_buf record; // The record removed.
+	const ssize_t size = msgrcv(_nipc_queue(instance, pid), &record, NIPC_RECORD_SIZE, _nipc_lane_type(pid, lane), IPC_NOWAIT); // The size of the record.
+	if (size < static_cast<ssize_t>(offsetof(nipc_wire, data))) return 0;
+
+	// Release the payloads of its messages and count them.
+	size_t count = 0; // The number of messages in the record.
+	for (size_t offset = 0; offset + offsetof(nipc_wire, data) <= static_cast<size_t>(size); ++count)
+	{
+		const nipc_wire& wire = *reinterpret_cast<const nipc_wire*>(record.data + offset); // The message.
+		if (wire.block) _nipc_slab_release(instance, static_cast<uint32_t>(wire.block));
+		offset += _nipc_stride(_nipc_wire_size(wire));
+	}
+	return count;
+}
+
+/**
+ * @name  _nipc_evict()
+ * @brief  Removes the oldest record from a subscriber's inbox in the message queue, dropping its messages.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  entry  {const uint32_t}  The index of the subscriber's entry in the instance's registry.
+ * @param  pid  {const pid_t}  The PID of the subscriber.
+ * @param  highest  {const uint32_t}  The lane of the messages room is made for; only records on it or below are evicted.
+ * @remark  The record is taken from the lowest lane holding one, so bulk traffic is dropped before urgent messages, and traffic never evicts more urgent messages than itself.
+ * @remark  The references the record held to payloads in the slab are dropped.  Messages the subscriber already took off the queue cannot be evicted.
+ * @return  {const size_t}  The number of messages dropped; `0` if the inbox had no record left on those lanes.
+ */
+const size_t _nipc_evict(nipc_instance* const instance, const uint32_t entry, const pid_t pid, const uint32_t highest)
+{
+	// Take the oldest record of the lowest lane up to `highest` holding one off the queue; if there is none, nothing was dropped.
+	std::atomic<int32_t>* const queued = instance->registry.entries[entry].queued; // The number of messages waiting on every lane.
+	size_t count = 0; // The number of messages in the record.
+	uint32_t lane = 0; // The lane the record was taken from.
+	for (; lane <= highest && lane < NIPC_LANES && !count; ++lane) if (!lane || queued[lane].load(std::memory_order_relaxed) > 0) count = _nipc_discard(instance, pid, lane);
+	if (!count) return 0;
+	if (--lane) queued[lane].fetch_sub(static_cast<int32_t>(count), std::memory_order_relaxed);
+
+	// Account for the messages as taken out of the inbox and dropped.
+	instance->registry.entries[entry].evicted.fetch_add(count, std::memory_order_relaxed);
+	instance->registry.entries[entry].overflowed.fetch_add(count, std::memory_order_relaxed);
+	instance->stats.overflowed.fetch_add(count, std::memory_order_relaxed);
+	return count;
+}
+
+/**
+ * @name  _nipc_purge()
+ * @brief  Removes every record left on any lane of a process's inbox in the message queue, releasing the payloads of their messages.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @remark  Instances using a ring keep no inboxes, so nothing is done for them.
+ */
+void _nipc_purge(nipc_instance* const instance, const pid_t pid)
+{
+	size_t purged = 0; // The number of messages purged.
+	for (uint32_t lane = 0; instance->options.transport == NIPC_TRANSPORT_QUEUE && lane < NIPC_LANES; ++lane) for (size_t count; (count = _nipc_discard(instance, pid, lane));) purged += count;
+	if (purged) instance->stats.purged.fetch_add(purged, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _nipc_reap()
+ * @brief  Removes a dead process from the registry of a NIPC instance and purges its inbox.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process, which the caller found to be dead.
+ * @remark  The process's counters are folded into those of the instance, as when it closes the instance.  Its inbox is purged even if another sender reaped it first, since a send may have written to it in between.
+ * @return  {const bool}  `true` if the process was still registered and this call removed it.
+ */
+const bool _nipc_reap(nipc_instance* const instance, const pid_t pid)
+{
+	// Remove the process from the registry unless it is already gone, and record it for the next sweep.
+	nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	if (_nipc_lock(registry) == -1) return false;
+	const uint32_t entry = _nipc_find(registry, pid); // The entry of the process, if it is still registered.
+	if (entry != NIPC_NONE)
+	{
+		_nipc_retire(instance, entry);
+		_nipc_unregister(registry, pid);
+		instance->reaped[instance->stats.reaped.fetch_add(1, std::memory_order_relaxed) % NIPC_MAX_REAPED].store(pid, std::memory_order_relaxed);
+	}
+	_nipc_unlock(registry);
+
+	// Purge the messages it left behind.
+	_nipc_purge(instance, pid);
+	return entry != NIPC_NONE;
+}
+
+/**
+ * @name  _nipc_sweep()
+ * @brief  Reaps every subscriber of a NIPC instance that died without closing it.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  force  {const bool}  Whether to sweep even if the instance was swept less than `NIPC_REAP_INTERVAL` ago.
+ * @remark  The inboxes of the processes reaped since the last sweep are purged once more first, so that messages written to them by sends that were already under way are not left behind.
+ * @remark  Only one of the senders racing past the interval sweeps; the others carry on at once.
+ * @return  {const uint32_t}  The number of subscribers reaped.
+ */
+const uint32_t _nipc_sweep(nipc_instance* const instance, const bool force)
+{
+	// Claim the sweep, unless another process swept recently.
+	const uint64_t now = _nipc_now(); // The current time.
+	uint64_t swept = instance->swept.load(std::memory_order_relaxed); // The time of the last sweep.
+	if (!force && (now - swept < NIPC_REAP_INTERVAL || !instance->swept.compare_exchange_strong(swept, now, std::memory_order_relaxed))) return 0;
+	if (force) instance->swept.store(now, std::memory_order_relaxed);
+
+	// Purge the inboxes of the processes reaped since the last sweep once more.
+	for (uint32_t slot = 0; slot < NIPC_MAX_REAPED; ++slot) if (instance->reaped[slot].load(std::memory_order_relaxed)) if (const pid_t pid = instance->reaped[slot].exchange(0, std::memory_order_relaxed)) _nipc_purge(instance, pid);
+
+	// Snapshot the PIDs of the subscribers and reap those that no longer exist.
+	const nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	pid_t pids[NIPC_MAX_SUBSCRIBERS]; // The PIDs of the subscribers.
+	const uint32_t count = _nipc_read(registry, [&]() -> uint32_t
+	{
+		const uint32_t members = std::min<uint32_t>(registry->count.load(std::memory_order_relaxed), NIPC_MAX_SUBSCRIBERS); // The number of subscribers.
+		for (uint32_t position = 0; position < members; ++position) pids[position] = registry->entries[registry->members[position].load(std::memory_order_relaxed) % NIPC_MAX_SUBSCRIBERS].pid.load(std::memory_order_relaxed);
+		return members;
+	}); // The number of subscribers.
+	uint32_t reaped = 0; // The number of subscribers reaped.
+	for (uint32_t position = 0; position < count; ++position) if (pids[position] > 0 && _nipc_dead(pids[position]) && _nipc_reap(instance, pids[position])) ++reaped;
+	return reaped;
+}
+
+/**
+ * @name  _nipc_collect()
+ * @brief  Collects the subscribers of a subscriber bitmap from a registry.
+ * @param  registry  {const nipc_registry* const}  The registry to search.
+ * @param  members  {const nipc_lane* const}  The bitmap of the subscribers to collect.
+ * @param  mailing_list  {nipc_recipient* const}  A buffer of `NIPC_MAX_SUBSCRIBERS` recipients to collect the recipients into.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The number of recipients collected.
+ */
+const uint32_t _nipc_collect(const nipc_registry* const registry, const nipc_lane* const members, nipc_recipient* const mailing_list)
+{
+	uint32_t collected = 0; // The number of recipients collected so far.
+
+	// Visit the set bits only, a word at a time.
+	for (uint32_t word = 0; word < NIPC_MAX_SUBSCRIBERS / 64; ++word) for (uint64_t bits = reinterpret_cast<const uint64_t*>(members)[word]; bits; bits &= bits - 1)
+	{
+		const uint32_t entry = word * 64 + static_cast<uint32_t>(__builtin_ctzll(bits)); // The entry of the subscriber.
+		mailing_list[collected++] = { registry->entries[entry].pid.load(std::memory_order_relaxed), entry, 0, 0, 0, 0 };
+	}
+	return collected;
+}
 
-// src/NIPC.cpp
+/**
+ * @name  _nipc_resolve_channels()
+ * @brief  Collects the subscribers of any of several multicast channels from a registry.
+ * @param  registry  {const nipc_registry* const}  The registry to search.
+ * @param  channels  {const long* const}  The IDs of the multicast channels.
+ * @param  count  {const size_t}  The number of channels.
+ * @param  mailing_list  {nipc_recipient* const}  A buffer of `NIPC_MAX_SUBSCRIBERS` recipients to collect the recipients into.
+ * @remark  The bitmaps of the channels are OR-ed together 256 bits at a time, so every subscriber is collected once however many of the channels it follows.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The number of recipients collected.
+ */
+const uint32_t _nipc_resolve_channels(const nipc_registry* const registry, const long* const channels, const size_t count, nipc_recipient* const mailing_list)
+{
+	// Combine the bitmaps of the channels that have subscribers.
+	nipc_lane members[NIPC_MEMBER_LANES] = {}; // The bitmap of the recipients.
+	for (size_t index = 0; index < count; ++index)
+	{
+		const uint32_t record = _nipc_find_channel(registry, channels[index]); // The entry of the channel.
+		if (record == NIPC_NONE) continue;
+		for (uint32_t lane = 0; lane < NIPC_MEMBER_LANES; ++lane) members[lane] |= registry->channels[record].members[lane];
+	}
+
+	// Collect the recipients.
+	return _nipc_collect(registry, members, mailing_list);
+}
 
 /**
- * @file  src/NIPC.cpp
- * @brief  Notifier Inter-Process Communication (NIPC) source file
- * @date  26/12/2023
- * @version  1.0.0
+ * @name  _nipc_resolve()
+ * @brief  Collects the recipients of a message sent with a given `type` from a registry.
+ * @param  registry  {const nipc_registry* const}  The registry to search.
+ * @param  type  {const long}  The `type` the message is sent with.
+ * @param  mailing_list  {nipc_recipient* const}  A buffer of `NIPC_MAX_SUBSCRIBERS` recipients to collect the recipients into.
+ * @remark  The caller must either hold the registry lock or run this function through `_nipc_read()`.
+ * @return  {const uint32_t}  The number of recipients collected.
  */
+const uint32_t _nipc_resolve(const nipc_registry* const registry, const long type, nipc_recipient* const mailing_list)
+{
+	uint32_t collected = 0; // The number of recipients collected so far.
 
-#include "NIPC.h"		// nipc_message, nipc_handler_t, nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
-#include <unordered_map>	// std::unordered_map
-#include <vector>		// std::vector
-#include <algorithm>		// std::transform
-#include <cerrno>		// errno, Error number definitions
-#include <sys/msg.h>		// msgget, msgctl, msgsnd, msgrcv
-#include <sys/shm.h>		// shmget, shmat, shmdt, shmctl
-#include <sys/types.h>		// key_t, pid_t
-#include <sys/ipc.h>		// IPC_CREAT, IPC_RMID, IPC_EXCL
-#include <csignal>		// signal, kill, SIGUSR1, SIG_DFL
-#include <unistd.h>		// getpid
-#include <cstdlib>		// NULL, malloc
-#include <sys/stat.h>		// S_IRUSR, S_IWUSR, S_IRGRP, S_IWGRP, S_IROTH, S_IWOTH
+	// Unicast the message to a specific subscriber process.
+	// Ensure that the process is a subscriber of the NIPC instance.
+	if (type > 0) { const uint32_t entry = _nipc_find(registry, static_cast<pid_t>(type)); if (entry != NIPC_NONE) mailing_list[collected++] = { static_cast<pid_t>(type), entry, 0, 0, 0, 0 }; return collected; }
 
-// The permissions for the message queue and shared memory segment.
-constexpr int RW_UGO = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+	// Multicast the message to all subscribers of a multicast channel.
+	if (type < 0) return _nipc_resolve_channels(registry, &type, 1, mailing_list);
+
+	// Broadcast the message to all subscribers of the NIPC instance.
+	const uint32_t count = registry->count.load(std::memory_order_relaxed); // The number of subscribers.
+	for (uint32_t position = 0; position < count && position < NIPC_MAX_SUBSCRIBERS; ++position)
+	{
+		const uint32_t entry = registry->members[position].load(std::memory_order_relaxed) % NIPC_MAX_SUBSCRIBERS; // The entry of the subscriber at this position.
+		mailing_list[collected++] = { registry->entries[entry].pid.load(std::memory_order_relaxed), entry, 0, 0, 0, 0 };
+	}
+	return collected;
+}
 
 /**
- * @name  msgq_buf
- * @brief  A buffer to store a message in a message queue.
+ * @name  nipc_send()
+ * @brief  Sends the message `msg` to the NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the message to.
+ * @param  msg  {const nipc_message}  The message to send to the NIPC instance.
+ * @param  type  {const long}  The channel on which to send the message.  If `type` is `0`, the message is broadcast to all subscribers of this NIPC instance.  If `type` is greater than 0, the message will be sent to the process whose process ID matches `type` (also known as a unicast).  If `type` is less than 0, the message will be sent to all processes subscribed to the channel whose channel ID matches `type` (also known as a multicast).
+ * @remark  Once the message is sent, all subscribers of the NIPC instance will be notified of the message.
+ * @remark  The recipients are resolved from a consistent snapshot of the subscriber registry taken without locking it.
+ * @remark  A payload larger than `NIPC_INLINE_SIZE` bytes is copied once into the instance's slab and shared by every recipient; only its location crosses the transport.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  A recipient that cannot be reached does not stop the message from being delivered to the others; the error reported is that of the first failure.
+ * @remark  A recipient found to have died without closing the instance is reaped instead; neither it nor one that closed the instance during the send fails the send.  See `nipc_reap()`.
+ * @remark  A recipient that has used up its quota, or finds the message queue full, is handled according to the instance's overflow policy, so a slow subscriber does not hold up the others unless the policy is to wait for it.
+ * @remark  On a conflated channel, the message overwrites the channel's latest value instead; see `nipc_conflate()`.
+ * @remark  If the instance logs, the message is appended to the log before it is delivered, even if no process receives it.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If the payload is larger than the instance's slab, or the message does not fit in a log segment.
+ * @throws  EIO  If the message could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for the payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @throws  ENODATA  If the target channel has no subscribers.
+ * @throws  ENOMEM  If the message could not be sent due to a lack of memory.
+ * @throws  ESRCH  If a target process that is still subscribed could not be notified of the message.
+ * @throws  EAGAIN  If a target process had no room for the message and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  `0` on success, `-1` on failure.
  */
-struct msgq_buf
+const int nipc_send(const int id, const nipc_message msg, const long type, const int flags) { return nipc_send_batch(id, &msg, 1, type, nullptr, 0, flags) == -1 ? -1 : 0; }
+
+/**
+ * @name  _nipc_send_batch()
+ * @brief  Sends the `n` messages `msgs` to the NIPC instance identified by `id`, in order, either with a `type` or on several multicast channels.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the messages to.
+ * @param  msgs  {const nipc_message* const}  The messages to send to the NIPC instance.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  type  {const long}  The channel on which to send the messages, as for `nipc_send()`; the first of `channels` if they are given.
+ * @param  channels  {const long* const}  The multicast channels to send the messages on, or `nullptr` to send them with `type` alone.
+ * @param  channel_count  {const size_t}  The number of channels.
+ * @param  deliveries  {nipc_delivery* const}  An array to report the outcome for every recipient in, or `nullptr`.
+ * @param  capacity  {const size_t}  The number of entries `deliveries` can hold.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  With `NIPC_TRANSPORT_RING`, messages sent on several channels cannot be addressed by a single `target`, so they are written to the ring once per recipient, addressed to it.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a payload is larger than the instance's slab, or a message does not fit in a log segment.
+ * @throws  EIO  If the messages could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for a payload at the moment.
+ * @throws  ENOLCK  If the instance's slab or log could not be locked.
+ * @throws  ENODATA  If the target channels have no subscribers.
+ * @throws  ENOMEM  If the messages could not be sent to a recipient due to a lack of memory.
+ * @throws  ESRCH  If a recipient that is still subscribed could not be notified of the messages.
+ * @throws  EAGAIN  If a recipient had no room for the messages and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  The number of recipients if every message was delivered to every one of them, or dropped by the overflow policy, `-1` otherwise; the error reported is that of the first failure.
+ */
+const int _nipc_send_batch(const int id, const nipc_message* const msgs, const size_t n, const long type, const long* const channels, const size_t channel_count, nipc_delivery* const deliveries, const size_t capacity, const int flags)
 {
-	/**
-	 * @name  receiver
-	 * @brief  The PID of the process that will receive the message.
-	 * @remark  This corresponds to the `type` parameter of `msgsnd()`.  Here, the message queue type is abstracted an inbox for each process.
-	 */
-	long receiver;
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	const nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
 
-	/**
-	 * @name  message
-	 * @brief  The message to send to the process.
-	 */
-	nipc_message message;
+	// A conflated channel keeps a single value, so it cannot take part in a send to several channels.
+	for (size_t index = 0; channels && index < channel_count; ++index) if (_nipc_find_conflated(instance, channels[index]) != NIPC_NONE) { errno = EINVAL; return -1; }
+	const uint32_t conflated = !channels && type < 0 ? _nipc_find_conflated(instance, type) : NIPC_NONE; // The conflation slot of the channel, if it is conflated.
 
-	/**
-	 * @name msgq_buf()
-	 * @brief  Constructs a new empty message queue buffer.
-	 */
-	msgq_buf() : receiver(0), message() {}
+	// Claim a trace buffer on the first send if the instance traces.
+	if (instance->options.trace_events && !nipc->second.trace) nipc->second.trace = _nipc_trace_claim(instance);
+	nipc_trace_buffer* const trace = nipc->second.trace; // The trace buffer of this process, if any.
 
-	/**
-	 * @name  msgq_buf()
-	 * @brief  Constructs a new message queue buffer with the provided data.
-	 * @param  _receiver  {const long}  The PID of the process that will receive the message.
-	 * @param  _message  {const nipc_message}  The message to send to the process.
-	 */
-	msgq_buf(const long _receiver, const nipc_message _message) : receiver(_receiver), message(_message) {}
+	// Reap the subscribers that died without closing the instance, unless that was done recently.
+	_nipc_sweep(instance, false);
 
-	/**
-	 * @name  msgq_buf()
-	 * @brief  Constructs a new message queue buffer with the provided data.
-	 * @param  _receiver  {const long}  The PID of the process that will receive the message.
-	 * @param  _channel  {const long}  The channel on which to send the message.
-	 * @param  _sender  {const pid_t}  The PID of the process that sent the message.
-	 * @param  _message  {const char[256]}  The message to send to the process.
-	 */
-	msgq_buf(const long _receiver, const long _channel, const pid_t _sender, const char _message[256]) : receiver(_receiver), message(_channel, _sender, _message) {}
-};
+	// Instantiate a buffer to hold all processes to receive these messages.
+	nipc_recipient mailing_list[NIPC_MAX_SUBSCRIBERS]; // A list holding all potential recipients of the messages.
+
+	// Log the messages before looking for recipients, so that a process subscribing meanwhile either receives them live or replays them.
+	const uint64_t timestamp = _nipc_now(); // The time the messages are sent at, which also identifies the send in traces.
+	const uint64_t sequence = instance->options.log_path[0] && n ? _nipc_log_append(nipc->second, msgs, n, type, channels, channel_count, timestamp) : 0; // The sequence number of the first message, if the instance logs.
+	if (instance->options.log_path[0] && n && !sequence) return -1;
+
+	// Collect the recipients once for the whole batch from a consistent snapshot of the registry.
+	const uint32_t recipients = _nipc_read(registry, [&]() -> uint32_t { return channels ? _nipc_resolve_channels(registry, channels, channel_count, mailing_list) : _nipc_resolve(registry, type, mailing_list); }); // The number of recipients.
+	if (trace) _nipc_trace(trace, NIPC_TRACE_RESOLVE, timestamp, timestamp, static_cast<long>(recipients));
+
+	// If the mailing list is empty, return an error.
+	if (!recipients) { errno = ENODATA; return -1; }
+
+	int first = 0; // The error of the first failure, if any.
+
+	// Notifies every recipient that was delivered messages since it was last notified.
+	const auto notify = [&]()
+	{
+		for (uint32_t recipient = 0; recipient < recipients; ++recipient)
+		{
+			nipc_recipient& target = mailing_list[recipient]; // The recipient.
+			if (target.delivered == target.notified) continue;
+			target.notified = target.delivered;
+			const uint64_t started = trace ? _nipc_now() : 0; // The time the notification started at.
+			if (_nipc_notify(id, instance, target.entry, target.pid) == -1 && !target.error)
+			{
+				// A recipient that died is reaped, and one that closed the instance meanwhile is let go, rather than failing the send.
+				target.error = errno;
+				if (_nipc_dead(target.pid)) _nipc_reap(instance, target.pid);
+				else if (!first && _nipc_read(registry, [&]() -> uint32_t { return _nipc_find(registry, target.pid); }) != NIPC_NONE) first = target.error;
+			}
+			if (trace) _nipc_trace(trace, NIPC_TRACE_NOTIFY, started, timestamp, target.pid);
+		}
+	};
+
+	const bool ring = instance->options.transport == NIPC_TRANSPORT_RING; // Whether the instance uses a ring.
+	const nipc_overflow overflow = instance->options.overflow; // What to do when a recipient has no room left.
+	const uint64_t quota = instance->options.quota; // The number of messages a recipient may have waiting, or `0`.
+	const bool wait = overflow == NIPC_OVERFLOW_BLOCK && !(flags & NIPC_NONBLOCK); // Whether to wait for recipients to make room.
+
+	// Makes room for `count` more messages within a recipient's quota, as the overflow policy says; returns `0` if there is room, or the error that prevents it.
+	// Only messages on lane `0` count against the quota, and a recipient with none of them pending always has room, so that records larger than the quota still get through.
+	const auto admit = [&](nipc_recipient& target, const size_t count) -> int
+	{
+		const nipc_subscriber& subscriber = instance->registry.entries[target.entry]; // The entry of the recipient.
+		for (uint64_t pending; quota && (pending = _nipc_backlog(subscriber)) && pending + count > quota;)
+		{
+			// Evict the oldest bulk records of the recipient; if it took them all off the queue already, let the messages through rather than drop urgent ones.
+			if (overflow == NIPC_OVERFLOW_DROP_OLDEST) { const size_t evicted = _nipc_evict(instance, target.entry, target.pid, 0); if (!evicted) return 0; target.dropped += evicted; continue; }
+
+			// Otherwise, wait for the recipient to handle some of its messages, making sure it is awake to do so, unless the send must not wait.
+			if (!wait) return EAGAIN;
+			notify();
+			if (_nipc_dead(target.pid)) return ESRCH;
+			sched_yield();
+		}
+		return 0;
+	};
+
+	msgq_buf record; // The buffer to pack messages into as they're being sent.
+	int failure = 0; // The error that stopped the batch, if any.
+	size_t next = 0; // The number of messages sent so far.
+
+	// On a conflated channel, overwrite the channel's value with the last message and flag it for every recipient; those that had not read the previous value yet were already notified of it.
+	if (conflated != NIPC_NONE && n)
+	{
+		const uint64_t started = trace ? _nipc_now() : 0; // The time the write started at.
+		if (_nipc_conflation_write(instance, conflated, msgs[n - 1], timestamp, sequence ? sequence + n - 1 : 0) == -1) { failure = errno; first = failure; }
+		else for (uint32_t recipient = 0; recipient < recipients; ++recipient)
+		{
+			mailing_list[recipient].delivered = n;
+			if (instance->registry.entries[mailing_list[recipient].entry].stale.fetch_or(1ULL << conflated) & (1ULL << conflated)) mailing_list[recipient].notified = n;
+		}
+		if (trace && !failure) _nipc_trace(trace, NIPC_TRACE_WRITE, started, timestamp, static_cast<long>(n));
+		if (!failure) next = n;
+	}
+
+	while (next < n && !failure)
+	{
+		// Pack as many of the remaining messages of the same priority as fit into a record, moving large payloads into the slab.
+		size_t size = 0; // The number of bytes of messages in the record.
+		size_t count = 0; // The number of messages in the record.
+		while (next + count < n && (!count || msgs[next + count].priority == msgs[next].priority) && size + _nipc_stride(_nipc_wire_size(msgs[next + count])) <= NIPC_RECORD_SIZE)
+		{
+			if (_nipc_pack(instance, msgs[next + count], reinterpret_cast<nipc_wire*>(record.data + size), timestamp, sequence ? sequence + next + count : 0) == -1) { failure = errno; if (!first) first = failure; break; }
+			size += _nipc_stride(_nipc_wire_size(msgs[next + count]));
+			++count;
+		}
+		if (!count) break;
+		const uint32_t lane = msgs[next].priority; // The lane the record travels on.
+
+		// If the instance uses a ring, write the record to it once; every recipient will read it through its own cursor, and the ring takes over the references to the payloads.
+		if (ring && !channels)
+		{
+			const uint64_t started = trace ? _nipc_now() : 0; // The time the write started at.
+			_nipc_ring_write(instance, type, record.data, count);
+			if (trace) _nipc_trace(trace, NIPC_TRACE_WRITE, started, timestamp, static_cast<long>(count));
+			for (uint32_t recipient = 0; recipient < recipients; ++recipient) mailing_list[recipient].delivered += count;
+		}
+
+		// Otherwise, send the record to every recipient still reachable.
+		else for (uint32_t recipient = 0; recipient < recipients; ++recipient)
+		{
+			nipc_recipient& target = mailing_list[recipient]; // The recipient.
+			if (target.error) continue;
+
+			// Once a message was dropped for the recipient with `NIPC_OVERFLOW_DROP_NEWEST`, the rest of the batch is dropped for it too, so that it gets a prefix of the batch.
+			if (!ring && target.dropped && overflow == NIPC_OVERFLOW_DROP_NEWEST)
+			{
+				target.dropped += count;
+				instance->registry.entries[target.entry].overflowed.fetch_add(count, std::memory_order_relaxed);
+				instance->stats.overflowed.fetch_add(count, std::memory_order_relaxed);
+				continue;
+			}
+
+			// Address the record to the process's lane and give it its own references to the payloads.
+			record.receiver = _nipc_lane_type(mailing_list[recipient].pid, lane);
+			_nipc_record_walk(record.data, count, [instance](const nipc_wire& wire) { if (wire.block) _nipc_slab_refs(instance)[static_cast<uint32_t>(wire.block)].fetch_add(1, std::memory_order_relaxed); });
+
+			// If the instance uses a ring, write the record to it addressed to the process alone.
+			const uint64_t started = trace ? _nipc_now() : 0; // The time the write started at.
+			if (ring) { _nipc_ring_write(instance, mailing_list[recipient].pid, record.data, count); mailing_list[recipient].delivered += count; }
+
+			// Otherwise, make room for the record within the process's quota, unless it is urgent, and send it to the process's inbox in its shard.
+			// If the queue is full, either notify the recipients of what they were already delivered so that they make room and wait for it, or evict the process's oldest record, as the overflow policy says.
+			else
+			{
+				const int queue = _nipc_queue(instance, target.pid); // The message queue of the process's shard.
+				int error = lane ? 0 : admit(target, count); // The error that prevents sending the record, if any.
+				if (!error && msgsnd(queue, &record, size, IPC_NOWAIT) == -1)
+				{
+					error = errno;
+					if (error == EAGAIN && wait)
+					{
+						// Before waiting for room, reap the recipients that died so that their inboxes stop taking up the queue, and give up on the process if it is one of them.
+						notify();
+						_nipc_sweep(instance, true);
+						error = target.error ? target.error : _nipc_dead(target.pid) ? ESRCH : msgsnd(queue, &record, size, 0) == -1 ? errno : 0;
+					}
+					else if (error == EAGAIN && overflow == NIPC_OVERFLOW_DROP_OLDEST) { const size_t evicted = _nipc_evict(instance, target.entry, target.pid, lane); target.dropped += evicted; error = evicted && msgsnd(queue, &record, size, IPC_NOWAIT) == -1 ? errno : evicted ? 0 : EAGAIN; }
+				}
+
+				// Credit the record to the process, and let it know that the lane holds a record.
+				if (!error)
+				{
+					target.delivered += count;
+					instance->registry.entries[target.entry].delivered.fetch_add(count, std::memory_order_relaxed);
+					if (lane) instance->registry.entries[target.entry].queued[lane].fetch_add(static_cast<int32_t>(count), std::memory_order_relaxed);
+				}
+
+				// Otherwise, take its references back, and drop the messages or stop delivering to the process.
+				else
+				{
+					_nipc_record_walk(record.data, count, [instance](const nipc_wire& wire) { if (wire.block) _nipc_slab_release(instance, static_cast<uint32_t>(wire.block)); });
+					if (error == EAGAIN && overflow == NIPC_OVERFLOW_DROP_NEWEST)
+					{
+						target.dropped += count;
+						instance->registry.entries[target.entry].overflowed.fetch_add(count, std::memory_order_relaxed);
+						instance->stats.overflowed.fetch_add(count, std::memory_order_relaxed);
+					}
+					else
+					{
+						if (error != EAGAIN && error != ESRCH)
+						{
+							instance->stats.send_error.store(error, std::memory_order_relaxed);
+							instance->stats.send_failures.fetch_add(1, std::memory_order_relaxed);
+							error = ENOMEM;
+						}
+						target.error = error;
+						if (error == ESRCH) _nipc_reap(instance, target.pid);
+						else if (!first) first = error;
+					}
+				}
+			}
+			if (trace) _nipc_trace(trace, NIPC_TRACE_WRITE, started, timestamp, mailing_list[recipient].pid);
+		}
+
+		// Drop the sender's references to the payloads.
+		if (!ring || channels) _nipc_record_walk(record.data, count, [instance](const nipc_wire& wire) { if (wire.block) _nipc_slab_release(instance, static_cast<uint32_t>(wire.block)); });
+		next += count;
+	}
+
+	// Notify every process that was delivered messages it was not notified of yet.
+	notify();
+
+	// Count the messages sent, by how they were addressed, and the copies delivered.
+	uint64_t delivered = 0; // The number of copies of the messages delivered.
+	for (uint32_t recipient = 0; recipient < recipients; ++recipient) delivered += mailing_list[recipient].delivered;
+	if (delivered) instance->stats.delivered.fetch_add(delivered, std::memory_order_relaxed);
+	if (next && type > 0) instance->stats.unicasts.fetch_add(next, std::memory_order_relaxed);
+	else if (next && type == 0) instance->stats.broadcasts.fetch_add(next, std::memory_order_relaxed);
+	else if (next)
+	{
+		instance->stats.multicasts.fetch_add(next, std::memory_order_relaxed);
+		for (size_t index = 0; index < (channels ? channel_count : 1); ++index)
+		{
+			const long target = channels ? channels[index] : type; // The ID of the channel.
+			const uint32_t channel = _nipc_read(registry, [&]() -> uint32_t { return _nipc_find_channel(registry, target); }); // The entry of the channel.
+			if (channel != NIPC_NONE) instance->registry.channels[channel].sent.fetch_add(next, std::memory_order_relaxed);
+		}
+	}
+
+	for (uint32_t recipient = 0; recipient < recipients; ++recipient)
+	{
+		// If the batch stopped early, the messages left were not delivered to anyone.
+		if (failure && !mailing_list[recipient].error) mailing_list[recipient].error = failure;
+
+		// Report the outcome for the recipient.
+		if (deliveries && recipient < capacity) deliveries[recipient] = { mailing_list[recipient].pid, mailing_list[recipient].delivered, mailing_list[recipient].error, mailing_list[recipient].dropped };
+	}
+
+	// If anything failed, return the first error.
+	if (first) { errno = first; return -1; }
+
+	// Return the number of recipients.
+	return static_cast<int>(recipients);
+}
 
 /**
- * @name  _subscription_list
- * @brief  A list of all subscriptions to NIPC instances.
- * @remark  The key is the ID of the NIPC instance and the value is a pair of the shared memory segment pointer and the notification handler.
+ * @name  nipc_send_batch()
+ * @brief  Sends the `n` messages `msgs` to the NIPC instance identified by `id`, in order.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the messages to.
+ * @param  msgs  {const nipc_message* const}  The messages to send to the NIPC instance.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  type  {const long}  The channel on which to send the messages, as for `nipc_send()`.
+ * @param  deliveries  {nipc_delivery* const}  An array to report the outcome for every recipient in, or `nullptr`.
+ * @param  capacity  {const size_t}  The number of entries `deliveries` can hold; the outcomes of any further recipients are not reported.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  The recipients are resolved once for the whole batch.  With `NIPC_TRANSPORT_QUEUE`, as many messages as fit are packed into every message queue write; with `NIPC_TRANSPORT_RING`, they are written to the ring in runs of consecutive slots claimed at once.
+ * @remark  If the instance logs, the messages are appended to it at once under consecutive sequence numbers, before they are delivered.
+ * @remark  Every recipient is notified once, after all of its messages have been delivered; only if the message queue fills up are recipients notified early so that they make room.
+ * @remark  A recipient that cannot be reached does not stop the messages from being delivered to the others, and one found to have died without closing the instance, or to have closed it during the send, is reported with `ESRCH` without failing the send; the dead are reaped.  If a message cannot be sent at all, for example because the slab is full, the batch stops before it, and every recipient has been delivered the messages before it.
+ * @remark  A recipient that has used up its quota, or finds the message queue full, is handled according to the instance's overflow policy; with `NIPC_OVERFLOW_DROP_NEWEST`, it is delivered no more of the batch's messages once one of them was dropped.
+ * @remark  On a conflated channel, only the last message of the batch is kept, as the channel's latest value; every recipient counts as delivered the whole batch.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a payload is larger than the instance's slab, or a message does not fit in a log segment.
+ * @throws  EIO  If the messages could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for a payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @throws  ENODATA  If the target channel has no subscribers.
+ * @throws  ENOMEM  If the messages could not be sent to a recipient due to a lack of memory.
+ * @throws  ESRCH  If a recipient that is still subscribed could not be notified of the messages.
+ * @throws  EAGAIN  If a recipient had no room for the messages and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  The number of recipients if every message was delivered to every one of them, or dropped by the overflow policy, `-1` otherwise; the error reported is that of the first failure.
+ */
+const int nipc_send_batch(const int id, const nipc_message* const msgs, const size_t n, const long type, nipc_delivery* const deliveries, const size_t capacity, const int flags) { return _nipc_send_batch(id, msgs, n, type, nullptr, 0, deliveries, capacity, flags); }
+
+/**
+ * @name  nipc_send_channels()
+ * @brief  Sends the `n` messages `msgs` to every subscriber of any of the `count` multicast channels `channels` of the NIPC instance identified by `id`, in order.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the messages to.
+ * @param  msgs  {const nipc_message* const}  The messages to send to the NIPC instance.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  channels  {const long* const}  The multicast channels to send the messages on.
+ * @param  count  {const size_t}  The number of channels.
+ * @param  deliveries  {nipc_delivery* const}  An array to report the outcome for every recipient in, or `nullptr`.
+ * @param  capacity  {const size_t}  The number of entries `deliveries` can hold; the outcomes of any further recipients are not reported.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  The recipients are the union of the subscribers of the channels, so a subscriber following several of them gets each message once.  Otherwise, the messages are delivered as with `nipc_send_batch()`.
+ * @remark  With `NIPC_TRANSPORT_RING`, messages sent on more than one channel are written to the ring once per recipient.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If no channel is given, a channel is not a multicast channel or is conflated, or a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a payload is larger than the instance's slab, or a message does not fit in a log segment.
+ * @throws  EIO  If the messages could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for a payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @throws  ENODATA  If none of the channels has subscribers.
+ * @throws  ENOMEM  If the messages could not be sent to a recipient due to a lack of memory.
+ * @throws  ESRCH  If a recipient that is still subscribed could not be notified of the messages.
+ * @throws  EAGAIN  If a recipient had no room for the messages and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  The number of recipients if every message was delivered to every one of them, or dropped by the overflow policy, `-1` otherwise; the error reported is that of the first failure.
+ */
+const int nipc_send_channels(const int id, const nipc_message* const msgs, const size_t n, const long* const channels, const size_t count, nipc_delivery* const deliveries, const size_t capacity, const int flags)
+{
+	// At least one channel must be given, and only multicast channels.
+	if (!channels || !count) { errno = EINVAL; return -1; }
+	for (size_t index = 0; index < count; ++index) if (channels[index] >= 0) { errno = EINVAL; return -1; }
+
+	// A single channel is a plain multicast.
+	if (count == 1) return _nipc_send_batch(id, msgs, n, channels[0], nullptr, 0, deliveries, capacity, flags);
+
+	// Send the messages to the union of the channels' subscribers.
+	return _nipc_send_batch(id, msgs, n, channels[0], channels, count, deliveries, capacity, flags);
+}
+
+/**
+ * @name  _nipc_deadline()
+ * @brief  Converts a timeout to the time it expires at.
+ * @param  timeout  {const int}  The timeout in milliseconds, or `-1` for none.
+ * @return  {const uint64_t}  The time the timeout expires at, in nanoseconds of `CLOCK_MONOTONIC`, or `UINT64_MAX` if it never does.
  */
-std::unordered_map<int, std::unordered_map<pid_t, long>*> _subscription_list;
+inline const uint64_t _nipc_deadline(const int timeout) { return timeout < 0 ? UINT64_MAX : _nipc_now() + static_cast<uint64_t>(timeout) * 1000000ULL; }
 
 /**
- * @name  _handler
- * @brief  The function handler to invoke upon any notification from the NIPC instance.
+ * @name  _nipc_nap()
+ * @brief  Sleeps on a futex word while it holds a value, until woken, the deadline passes or `NIPC_CALL_NAP` elapses.
+ * @param  word  {std::atomic<uint32_t>&}  The futex word.
+ * @param  value  {const uint32_t}  The value to sleep on.
+ * @param  deadline  {const uint64_t}  The time to wake up at the latest, in nanoseconds of `CLOCK_MONOTONIC`.
  */
-nipc_handler_t _handler = nullptr;
+void _nipc_nap(std::atomic<uint32_t>& word, const uint32_t value, const uint64_t deadline)
+{
+	const uint64_t now = _nipc_now(); // The current time.
+	const uint64_t span = std::min(NIPC_CALL_NAP, deadline > now ? deadline - now : 0); // How long to sleep for.
+	if (!span) return;
+	const timespec timeout = { static_cast<time_t>(span / 1000000000ULL), static_cast<long>(span % 1000000000ULL) }; // How long to sleep for.
+	_nipc_futex(&word, FUTEX_WAIT, value, &timeout);
+}
 
 /**
- * @brief  The signal handler for `SIGUSR1`.
- * @param  signal  {const int}  The signal number.
- * @remark  The signal handler will allocate a buffer containing the message and call the notification handler; it is the responsibility of the notification handler to free the buffer.
- * @remark  If a buffer to hold the message cannot be allocated, the message will be lost forever.
+ * @name  _nipc_claim()
+ * @brief  Claims an entry owned by a PID for the calling process.
+ * @param  owner  {std::atomic<pid_t>&}  The owner of the entry; `0` if it is free.
+ * @param  pid  {const pid_t}  The PID of the calling process.
+ * @param  reclaim  {const bool}  Whether an entry owned by a process that died may be claimed as well.
+ * @return  {const bool}  `true` if the entry was claimed.
  */
-void _nipc_handler(const int signal)
+const bool _nipc_claim(std::atomic<pid_t>& owner, const pid_t pid, const bool reclaim)
 {
-	// Allocate a buffer to store the message.
-	nipc_message* message = static_cast<nipc_message*>(malloc(sizeof(nipc_message))); // The buffer holding the message. 
+	pid_t current = owner.load(std::memory_order_relaxed); // The owner of the entry.
+	if (current && (!reclaim || kill(current, 0) == 0 || errno != ESRCH)) return false;
+	return owner.compare_exchange_strong(current, pid, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+/**
+ * @name  _call_slot
+ * @brief  The call slot the calling thread claimed last, which it tries first on its next call.
+ */
+thread_local uint32_t _call_slot = 0;
+
+/**
+ * @name  _uniprocessor
+ * @brief  Whether the machine has a single processor, where spinning only holds up the process being waited for; waiters then yield the processor while they spin.
+ */
+const bool _uniprocessor = sysconf(_SC_NPROCESSORS_ONLN) <= 1;
 
-	// Receive the message from the message queue.
-	msgq_buf buf; // A buffer to hold the message as it's being read.
+/**
+ * @name  nipc_listen()
+ * @brief  Lets the calling process answer calls made to it on the opened NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remark  Calls bypass subscriptions and notification handlers entirely; the process takes them with `nipc_accept()` on threads of its own.  Listening again has no effect.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  ENOSPC  If `NIPC_MAX_RESPONDERS` processes already listen on the instance.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_listen(const int id)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
 
-	// Iterate over all NICPs in the subscription list.
-	// Once a message is read, break out of the loop.
-	for (const std::pair<const int, std::unordered_map<int, long>*>& pair : _subscription_list) if (msgrcv(pair.first, &buf, sizeof(msgq_buf), getpid(), IPC_NOWAIT) != -1) break;
+	// Listening again has no effect.
+	if (nipc->second.responder != NIPC_NONE) return 0;
 
-	// If a buffer to hold the message could not be allocated, return.
-	if (!message) return;
+	// Claim a free entry, or failing that one left by a process that died.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	const pid_t pid = getpid(); // The PID of this process.
+	for (uint32_t pass = 0; pass < 2; ++pass) for (uint32_t index = 0; index < NIPC_MAX_RESPONDERS; ++index) if (_nipc_claim(instance->responders[index].pid, pid, pass)) { nipc->second.responder = index; return 0; }
 
-	// Copy the message from the message queue buffer to the allocated buffer.
-	*message = buf.message;
+	// Every entry is taken.
+	errno = ENOSPC;
+	return -1;
+}
 
-	// Ensure a notification handler is set and invoke it.
-	if (_handler) _handler(message);
+/**
+ * @name  _nipc_take()
+ * @brief  Takes the request held by a call slot if it is addressed to the calling process.
+ * @param  instance  {nipc_instance* const}  The NIPC instance.
+ * @param  slot  {const uint32_t}  The index of the slot.
+ * @param  request  {nipc_message* const}  The buffer to copy the request to.
+ * @param  call  {uint64_t* const}  Set to the handle of the call: the state it was taken at in the high 32 bits and the index of its slot in the low 32 bits.
+ * @return  {const bool}  `true` if the request was taken, `false` if the slot holds none for this process or its caller gave up meanwhile.
+ */
+const bool _nipc_take(nipc_instance* const instance, const uint32_t slot, nipc_message* const request, uint64_t* const call)
+{
+	// Only take requests that are waiting, and addressed to this process.
+	nipc_call_slot& source = instance->calls[slot]; // The slot.
+	uint32_t state = source.state.load(std::memory_order_acquire); // The state of the slot.
+	if ((state & NIPC_CALL_PHASE) != NIPC_CALL_REQUESTED || source.callee.load(std::memory_order_relaxed) != getpid()) return false;
 
-	// If the message wasn't delivered discard the message.
-	else free(message);
+	// Copy the request, then take it unless the state changed meanwhile.
+	nipc_wire wire; // The copy of the request.
+	memcpy(&wire, &source.request, offsetof(nipc_wire, data));
+	memcpy(wire.data, source.request.data, _nipc_wire_size(wire) - offsetof(nipc_wire, data));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint32_t taken = state - NIPC_CALL_REQUESTED + NIPC_CALL_TAKEN; // The state of the slot once the request is taken.
+	if (!source.state.compare_exchange_strong(state, taken, std::memory_order_acq_rel, std::memory_order_relaxed)) return false;
 
-	// Return.
-	return;
+	// Hand the request over.
+	_nipc_unpack(instance, wire, request);
+	*call = (static_cast<uint64_t>(taken) << 32) | slot;
+	return true;
 }
 
 /**
- * @name  nipc_create()
- * @brief  Creates a NIPC instance that has a key `_key`.  If a NIPC instance with the same key exists, the function fails.
- * @remark  The NIPC instance relies on a message queue to store and manage messages.
- * @param  _key  {const key_t}  The key of the NIPC instance to create.
- * @remark  NIPCs aren't thread/multiprocess safe by default; it's the responsibility of subscribers to coordinate access to the NIPC.
- * @throws  EEXIST  If a NIPC instance with the same key already exists.
- * @throws  ENOMEM  If the NIPC instance could not be created due to a lack of memory.
+ * @name  nipc_accept()
+ * @brief  Takes the next call made to the calling process on the NIPC instance identified by `id`, waiting for one if need be.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  request  {nipc_message* const}  The buffer to copy the request to.
+ * @param  call  {uint64_t* const}  Set to the handle of the call, to pass to `nipc_reply()`.
+ * @param  timeout  {const int}  The number of milliseconds to wait for a call; `-1` waits indefinitely and `0` does not wait.
+ * @remark  The thread spins briefly before sleeping on a futex, so a call made while it is busy is taken without a system call.  Any number of threads may accept calls at once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process does not listen on the instance, or `request` or `call` is `nullptr`.
+ * @throws  EAGAIN  If `timeout` is `0` and no call is pending.
+ * @throws  ETIMEDOUT  If no call was made within `timeout` milliseconds.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_create(const key_t _key)
+const int nipc_accept(const int id, nipc_message* const request, uint64_t* const call, const int timeout)
 {
-	// Create a shared memory segment with the provided to store the NIPC instance ensuring that the segment does not already exist.
-	const int shmid = shmget(_key, sizeof(std::unordered_map<pid_t, long>), IPC_CREAT | IPC_EXCL | RW_UGO); // The ID of the shared memory segment.
-	// If the shared memory segment could not be created, return an error.
-	if (shmid == -1 || errno == EEXIST) { errno = EEXIST; return -1; } 
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
 
-	// Create a message queue with the provided key to store and manage messages ensuring that the queue does not already exist.
-	const int msgq_id = msgget(_key, IPC_CREAT | IPC_EXCL | RW_UGO); // The ID of the message queue.
-	// If the message queue could not be created, return an error.
-	if (msgq_id == -1) { errno = EEXIST; return -1; }
+	// Only a process that listens can take calls.
+	else if (nipc->second.responder == NIPC_NONE || !request || !call) { errno = EINVAL; return -1; }
 
-	// Attach the shared memory segment to the address space of the creator process.
-	std::unordered_map<pid_t, long>* shm = static_cast<std::unordered_map<pid_t, long>*>(shmat(shmid, NULL, 0)); // The pointer to the shared memory segment.
-	// If the shared memory segment could not be attached, return an error.
-	if (shm == reinterpret_cast<std::unordered_map<pid_t, long>*>(-1)) { errno = ENOMEM; return -1; }
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	nipc_responder& self = instance->responders[nipc->second.responder]; // The entry of this process.
+	const uint64_t deadline = _nipc_deadline(timeout); // The time to give up at.
+	const uint64_t spin = _nipc_now() + NIPC_CALL_SPIN; // The time to stop spinning at.
+	while (true)
+	{
+		// Take the first request pending for the process, clearing the bits of the slots looked at.
+		for (uint32_t word = 0; word < NIPC_MAX_CALLS / 64; ++word) for (uint64_t bits = self.pending[word].load(std::memory_order_acquire); bits; bits &= bits - 1)
+		{
+			const uint64_t bit = bits & -bits; // The bit of the slot.
+			const uint32_t slot = word * 64 + static_cast<uint32_t>(__builtin_ctzll(bits)); // The index of the slot.
+			if ((self.pending[word].fetch_and(~bit, std::memory_order_acq_rel) & bit) && _nipc_take(instance, slot, request, call)) return 0;
+		}
 
-	// Instantiate a new NIPC instance in the shared memory segment.
-	new (shm) std::unordered_map<pid_t, long>();
+		// If no call is pending, give up once the timeout expires.
+		const uint64_t now = _nipc_now(); // The current time.
+		if (!timeout) { errno = EAGAIN; return -1; }
+		if (now >= deadline) { errno = ETIMEDOUT; return -1; }
 
-	// Return success.
-	return 0;
+		// Keep spinning for a while, then sleep until the doorbell rings, unless a request came in meanwhile.
+		if (now < spin) { if (_uniprocessor) sched_yield(); continue; }
+		self.sleepers.fetch_add(1, std::memory_order_seq_cst);
+		const uint32_t rung = self.doorbell.load(std::memory_order_seq_cst); // The doorbell before sleeping.
+		bool idle = true; // Whether no request is pending.
+		for (uint32_t word = 0; word < NIPC_MAX_CALLS / 64 && idle; ++word) idle = !self.pending[word].load(std::memory_order_seq_cst);
+		if (idle) _nipc_nap(self.doorbell, rung, deadline);
+		self.sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
 }
 
 /**
- * @name  nipc_get()
- * @brief  Opens a NIPC instance whose key is `_key`.
- * @param  _key  {const key_t}  The key of the NIPC instance to open.
- * @throws  ENOENT  If a NIPC instance with the provided key does not exist.
- * @throws  ENOMEM  If the NIPC instance could not be opened due to a lack of memory.
- * @return  {const int}  If the instance exists, a unique positive non-zero integer to identify the instance is returned.  Otherwise, `-1` is returned.
+ * @name  nipc_reply()
+ * @brief  Answers a call taken with `nipc_accept()`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  call  {const uint64_t}  The handle of the call.
+ * @param  reply  {const nipc_message&}  The reply; its payload must fit inline.
+ * @remark  The reply is written straight into the caller's slot, and the caller is only woken by a system call if it stopped spinning.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `call` is not the handle of a call taken with `nipc_accept()`.
+ * @throws  EMSGSIZE  If the reply is larger than `NIPC_INLINE_SIZE` bytes.
+ * @throws  ECANCELED  If the caller gave up on the call, or it was already answered.
+ * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_get(const key_t _key)
+const int nipc_reply(const int id, const uint64_t call, const nipc_message& reply)
 {
-	// Get the ID of the message queue with the provided key.  The message queue ID is used to identify the NIPC instance.
-	const int msgq_id = msgget(_key, RW_UGO); // The ID of the message queue.
-	// If the message queue could not be found, return an error.
-	if (msgq_id == -1) { errno = ENOENT; return -1; }
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
 
-	// Get the ID of the shared memory segment with the provided key.
-	const int shmid = shmget(_key, sizeof(std::unordered_map<pid_t, long>), RW_UGO); // The ID of the shared memory segment.
-	// If the shared memory segment could not be attached, return an error.
-	if (shmid == -1) { errno = ENOENT; return -1; }
-	// Attach the shared memory segment to the address space of the  process.
-	std::unordered_map<pid_t, long>* nipc = static_cast<std::unordered_map<pid_t, long>*>(shmat(shmid, NULL, 0)); // The NIPC instance.
-	// If the shared memory segment could not be attached, return an error.
-	if (nipc == reinterpret_cast<std::unordered_map<pid_t, long>*>(-1)) { errno = ENOMEM; return -1; }
+	// The handle must name a slot and a call that was taken.
+	const uint32_t slot = static_cast<uint32_t>(call); // The index of the call's slot.
+	uint32_t taken = static_cast<uint32_t>(call >> 32); // The state of the slot when the call was taken.
+	if (slot >= NIPC_MAX_CALLS || (taken & NIPC_CALL_PHASE) != NIPC_CALL_TAKEN) { errno = EINVAL; return -1; }
 
-	// Store the pointer to the shared memory segment in the subscription list such that it could be referenced via the NIPC ID.
-	_subscription_list[msgq_id] = nipc;
+	// Replies are copied straight into the caller's slot, so they must fit inline.
+	else if (reply.length > NIPC_INLINE_SIZE) { errno = EMSGSIZE; return -1; }
 
-	// Return the ID of the NIPC instance.
-	return msgq_id;
+	// Claim the slot for the reply, unless the caller gave up on the call.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	nipc_call_slot& target = instance->calls[slot]; // The slot of the call.
+	const uint32_t base = taken - NIPC_CALL_TAKEN; // The state of the slot without its phase.
+	if (!target.state.compare_exchange_strong(taken, base + NIPC_CALL_ANSWERING, std::memory_order_acquire, std::memory_order_relaxed)) { errno = ECANCELED; return -1; }
+
+	// Write the reply and publish it, waking the caller if it sleeps.
+	_nipc_pack(instance, reply, &target.reply, _nipc_now(), 0);
+	target.state.store(base + NIPC_CALL_REPLIED, std::memory_order_seq_cst);
+	if (target.sleeping.load(std::memory_order_seq_cst)) _nipc_futex(&target.state, FUTEX_WAKE, 1);
+
+	// Return success.
+	return 0;
 }
 
 /**
- * @name  nipc_subscribe()
- * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`.
- * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
- * @param  type  {const long}  The multicast channel to subscribe to.
- * @param  handler  {nipc_handler_t}  The function handler to invoke upon any notification from the NIPC instance.
- * @remarks  `SIGUSR1` is used to notify the process of a new message.
- * @remarks  When a new message is received, the signal handler will allocate a buffer containing the message and call the notification handler; it is the responsibility of the notification handler to free the buffer.
- * @remarks  For compatibility, the buffer is allocated using `malloc()`; it must be released using `free()`.
+ * @name  nipc_call()
+ * @brief  Sends a request to the process `pid` listening on the NIPC instance identified by `id` and waits for its reply.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process to call.
+ * @param  request  {const nipc_message&}  The request; its payload must fit inline.
+ * @param  reply  {nipc_message* const}  The buffer to copy the reply to.
+ * @param  timeout  {const int}  The number of milliseconds to wait for the reply; `-1` waits indefinitely.
+ * @remark  The call takes a slot of the instance for the request and its reply, starting with the one the calling thread used last, and tags it with a fresh correlation number, so that a late reply to an abandoned call is never mistaken for the reply to the next one.
+ * @remark  The caller spins briefly before sleeping on a futex, so a quick reply is picked up without a system call.  While asleep, it checks every few milliseconds that the callee still listens.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
- * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0.
+ * @throws  EINVAL  If `reply` is `nullptr`.
+ * @throws  EMSGSIZE  If the request is larger than `NIPC_INLINE_SIZE` bytes.
+ * @throws  ESRCH  If `pid` does not listen on the instance, or stopped listening before replying.
+ * @throws  EBUSY  If `NIPC_MAX_CALLS` calls are already in flight on the instance.
+ * @throws  ETIMEDOUT  If no reply came within `timeout` milliseconds.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_subscribe(const int id, const long type, nipc_handler_t handler)
+const int nipc_call(const int id, const pid_t pid, const nipc_message& request, nipc_message* const reply, const int timeout)
 {
 	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
-	if (_subscription_list.find(id) == _subscription_list.end()) { errno = ENOENT; return -1; }
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
 
-	// Processes must subscribe to a valid channel.
-	else if (type >= 0) { errno = EINVAL; return -1; }
-	
-	// Admit the process to the NIPC instance.
+	// A reply needs somewhere to go.
+	else if (!reply) { errno = EINVAL; return -1; }
+
+	// Requests are copied straight into the slot, so they must fit inline.
+	else if (request.length > NIPC_INLINE_SIZE) { errno = EMSGSIZE; return -1; }
 
-	(*_subscription_list[id])[getpid()] = type;
+	// Find the callee among the responders.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	uint32_t index = 0; // The index of the callee's entry.
+	while (index < NIPC_MAX_RESPONDERS && (pid <= 0 || instance->responders[index].pid.load(std::memory_order_acquire) != pid)) ++index;
+	if (index == NIPC_MAX_RESPONDERS) { errno = ESRCH; return -1; }
+	nipc_responder& callee = instance->responders[index]; // The entry of the callee.
+
+	// Claim a slot, starting with the one this thread used last, or failing that one left by a process that died.
+	const pid_t self = getpid(); // The PID of this process.
+	uint32_t slot = NIPC_NONE; // The index of the slot.
+	for (uint32_t pass = 0; pass < 2 && slot == NIPC_NONE; ++pass) for (uint32_t step = 0; step < NIPC_MAX_CALLS && slot == NIPC_NONE; ++step) if (_nipc_claim(instance->calls[(_call_slot + step) % NIPC_MAX_CALLS].owner, self, pass)) slot = (_call_slot + step) % NIPC_MAX_CALLS;
+	if (slot == NIPC_NONE) { errno = EBUSY; return -1; }
+	_call_slot = slot;
+	nipc_call_slot& own = instance->calls[slot]; // The slot of the call.
+
+	// Write the request, then publish it as the slot's next call, waiting out a callee still answering a call its previous owner abandoned.
+	own.callee.store(pid, std::memory_order_relaxed);
+	_nipc_pack(instance, request, &own.request, _nipc_now(), 0);
+	uint32_t state = own.state.load(std::memory_order_relaxed); // The state of the slot.
+	while ((state & NIPC_CALL_PHASE) == NIPC_CALL_ANSWERING || !own.state.compare_exchange_weak(state, (state | NIPC_CALL_PHASE) + 1 + NIPC_CALL_REQUESTED, std::memory_order_release, std::memory_order_relaxed)) if ((state & NIPC_CALL_PHASE) == NIPC_CALL_ANSWERING) { sched_yield(); state = own.state.load(std::memory_order_relaxed); }
+	const uint32_t base = (state | NIPC_CALL_PHASE) + 1; // The state of the slot for this call, without its phase.
+
+	// Ring the callee's doorbell, waking one of its threads if they all sleep.
+	callee.pending[slot / 64].fetch_or(1ULL << (slot % 64), std::memory_order_seq_cst);
+	callee.doorbell.fetch_add(1, std::memory_order_seq_cst);
+	if (callee.sleepers.load(std::memory_order_seq_cst)) _nipc_futex(&callee.doorbell, FUTEX_WAKE, 1);
+
+	// Wait for the reply, spinning for a while and then sleeping.
+	const uint64_t deadline = _nipc_deadline(timeout); // The time to give up at.
+	const uint64_t spin = _nipc_now() + NIPC_CALL_SPIN; // The time to stop spinning at.
+	int error = 0; // The reason the call was abandoned, if it was.
+	for (uint32_t current; (current = own.state.load(std::memory_order_acquire)) != base + NIPC_CALL_REPLIED;)
+	{
+		// Keep spinning for a while.
+		const uint64_t now = _nipc_now(); // The current time.
+		if (now < spin) { if (_uniprocessor) sched_yield(); continue; }
+
+		// Abandon the call once the timeout expires or the callee stopped listening, unless its reply is being written.
+		const bool gone = callee.pid.load(std::memory_order_relaxed) != pid || (kill(pid, 0) == -1 && errno == ESRCH); // Whether the callee stopped listening.
+		if (now >= deadline || gone)
+		{
+			if (((current & NIPC_CALL_PHASE) != NIPC_CALL_ANSWERING || gone) && own.state.compare_exchange_strong(current, base + NIPC_CALL_IDLE)) { error = gone ? ESRCH : ETIMEDOUT; break; }
+			continue;
+		}
+
+		// Sleep until the callee wakes this thread, unless the state changed meanwhile.
+		own.sleeping.store(1, std::memory_order_seq_cst);
+		if (own.state.load(std::memory_order_seq_cst) == current) _nipc_nap(own.state, current, deadline);
+		own.sleeping.store(0, std::memory_order_relaxed);
+	}
+
+	// Copy the reply and release the slot.
+	if (!error) _nipc_unpack(instance, own.reply, reply);
+	own.owner.store(0, std::memory_order_release);
+
+	// If the call was abandoned, return an error.
+	if (error) { errno = error; return -1; }
 
-	// Set the signal and notification handlers
-	_handler = handler;
-	signal(SIGUSR1, _nipc_handler);
-	
 	// Return success.
 	return 0;
 }
 
 /**
- * @name  nipc_send()
- * @brief  Sends the message `msg` to the NIPC instance identified by `id`.
- * @param  id  {const int}  The ID of the NIPC instance to the send the message to.
- * @param  msg  {const nipc_message}  The message to send to the NIPC instance.
- * @param  type  {const long}  The channel on which to send the message.  If `type` is `0`, the message is broadcast to all subscribers of this NIPC instance.  If `type` is greater than 0, the message will be sent to the process whose process ID matches `type` (also known as a unicast).  If `type` is less than 0, the message will be sent to all processes subscribed to the channel whose channel ID matches `type` (also known as a multicast).
- * @remark  Once the message is sent, all subscribers of the NIPC instance will be notified of the message.
+ * @name  nipc_stats()
+ * @brief  Takes a snapshot of the counters of the NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  stats  {nipc_instance_stats* const}  The buffer to write the counters of the instance to.
+ * @param  subscribers  {nipc_subscriber_stats* const}  An array to write the counters of every subscriber to, or `nullptr`.
+ * @param  subscriber_capacity  {const size_t}  The number of entries `subscribers` can hold; `stats->subscribers` tells how many there are.
+ * @param  channels  {nipc_channel_stats* const}  An array to write the counters of every multicast channel to, or `nullptr`.
+ * @param  channel_capacity  {const size_t}  The number of entries `channels` can hold; `stats->channels` tells how many there are.
+ * @remark  The counters live in the instance's shared memory segment and are updated with relaxed atomic operations on the way through, so any process that opened the instance can read them without disturbing the senders and subscribers.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
- * @throws  ENODATA  If the target channel has no subscribers.
- * @throws  ENOMEM  If the message could not be sent due to a lack of memory.
- * @throws  ESRCH  If a target process could not be notified of the message.
+ * @throws  EINVAL  If `stats` is `nullptr`.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_send(const int id, const nipc_message msg, const long type)
+const int nipc_stats(const int id, nipc_instance_stats* const stats, nipc_subscriber_stats* const subscribers, const size_t subscriber_capacity, nipc_channel_stats* const channels, const size_t channel_capacity)
 {
 	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
-	if (_subscription_list.find(id) == _subscription_list.end()) { errno = ENOENT; return -1; }
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+	if (!stats) { errno = EINVAL; return -1; }
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	const nipc_registry* const registry = &instance->registry; // The subscriber registry of the instance.
+	const nipc_counters& counters = instance->stats; // The counters of the instance.
 
-	// Instantiate a buffer to hold the PIDs of all processes to receive this message.
-	std::vector<pid_t> mailing_list = {}; // A list holding all potential recipients of the message.
+	// Copy the counters of the instance, including those folded in by subscribers that have left.
+	stats->broadcasts = counters.broadcasts.load(std::memory_order_relaxed);
+	stats->multicasts = counters.multicasts.load(std::memory_order_relaxed);
+	stats->unicasts = counters.unicasts.load(std::memory_order_relaxed);
+	stats->delivered = counters.delivered.load(std::memory_order_relaxed);
+	stats->send_failures = counters.send_failures.load(std::memory_order_relaxed);
+	stats->send_error = counters.send_error.load(std::memory_order_relaxed);
+	stats->notify_failures = counters.notify_failures.load(std::memory_order_relaxed);
+	stats->reaped = counters.reaped.load(std::memory_order_relaxed);
+	stats->purged = counters.purged.load(std::memory_order_relaxed);
+	stats->reclaimed = counters.reclaimed.load(std::memory_order_relaxed);
+	stats->overflowed = counters.overflowed.load(std::memory_order_relaxed);
+	stats->logged = instance->options.log_path[0] ? instance->log.next.load(std::memory_order_acquire) - 1 : 0;
 
-	// Broadcast the message to all subscribers of the NIPC instance.
-	// Iterate over the subscription list and add the PIDs of all subscribers to the mailing list.
-	if (!type) std::transform(_subscription_list[id]->begin(), _subscription_list[id]->end(), std::back_inserter(mailing_list), [](const auto& pair) { return pair.first; });
+	// Take a consistent snapshot of the subscribers and the channels, and of the retired counters they are folded into under the same lock.
+	uint32_t members[NIPC_MAX_SUBSCRIBERS]; // The entries of the subscribers.
+	nipc_channel_stats active[NIPC_MAX_SUBSCRIBERS]; // The channels with subscribers.
+	_nipc_read(registry, [&]() -> int
+	{
+		stats->subscribers = std::min<uint32_t>(registry->count.load(std::memory_order_relaxed), NIPC_MAX_SUBSCRIBERS);
+		for (uint32_t position = 0; position < stats->subscribers; ++position) members[position] = registry->members[position].load(std::memory_order_relaxed) % NIPC_MAX_SUBSCRIBERS;
+		stats->channels = 0;
+		for (uint32_t entry = 0; entry < NIPC_MAX_SUBSCRIBERS; ++entry) if (const long channel = registry->channels[entry].id.load(std::memory_order_relaxed)) active[stats->channels++] = { channel, registry->channels[entry].count, registry->channels[entry].sent.load(std::memory_order_relaxed) };
+		stats->received = counters.received.load(std::memory_order_relaxed);
+		stats->dropped = counters.dropped.load(std::memory_order_relaxed);
+		stats->lapped = counters.lapped.load(std::memory_order_relaxed);
+		for (uint32_t bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) stats->latency[bucket] = counters.latency[bucket].load(std::memory_order_relaxed);
+		return 0;
+	});
 
-	// Multicast the message to all subscribers of a multicast channel.
-	// Iterate over the subscription list and add the PIDs of all subscribers whose channel ID matches `type` to the mailing list.
-	else if (type < 0) { for (const std::pair<const pid_t, long>& pair : *_subscription_list[id]) if (pair.second == -type) mailing_list.push_back(pair.first); }
+	// Add up the counters of every subscriber, reporting those that fit.
+	const bool ring = instance->options.transport == NIPC_TRANSPORT_RING; // Whether the instance uses a ring.
+	const uint64_t head = instance->ring.head.load(std::memory_order_relaxed); // The position the next message will be written at.
+	for (uint32_t position = 0; position < stats->subscribers; ++position)
+	{
+		const nipc_subscriber& subscriber = registry->entries[members[position]]; // The entry of the subscriber.
+		const uint64_t received = subscriber.received.load(std::memory_order_relaxed); // The number of messages the subscriber received.
+		const uint64_t dropped = subscriber.dropped.load(std::memory_order_relaxed); // The number of messages the subscriber dropped.
+		const uint64_t lapped = subscriber.lapped.load(std::memory_order_relaxed); // The number of ring positions the subscriber skipped.
+		stats->received += received;
+		stats->dropped += dropped;
+		stats->lapped += lapped;
+		for (uint32_t bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) stats->latency[bucket] += subscriber.latency[bucket].load(std::memory_order_relaxed);
+		if (!subscribers || position >= subscriber_capacity) continue;
 
-	// Unicast the message to a specific subscriber process.
-	// Ensure that the process is a subscriber of the NIPC instance.
-	else if (type > 0 && _subscription_list[id]->find(type) != _subscription_list[id]->end()) mailing_list.push_back(-type);
+		// The backlog of a ring subscriber is how far its cursor trails the ring; that of a queue subscriber is what was written to its inbox but not handled yet.
+		const uint64_t cursor = subscriber.cursor.load(std::memory_order_relaxed); // The position of the next message the subscriber will read.
+		const uint64_t pending = ring ? std::min<uint64_t>(head > cursor ? head - cursor : 0, instance->ring.mask + 1) : _nipc_pending(subscriber); // The backlog of the subscriber.
+		const uint32_t followed = std::min<uint32_t>(subscriber.channel_count.load(std::memory_order_relaxed), NIPC_MAX_CHANNELS); // The number of channels the subscriber follows.
+		subscribers[position] = { subscriber.pid.load(std::memory_order_relaxed), followed ? subscriber.channels[0].load(std::memory_order_relaxed) : 0, followed, pending, received, dropped, lapped, subscriber.overflowed.load(std::memory_order_relaxed) };
+	}
 
-	// If the mailing list is empty, return an error.
-	if (mailing_list.empty()) { errno = ENODATA; return -1; }
+	// The urgent lanes have histograms of their own, and lane `0` gets what is left of the overall one; the counters are read one by one, so it is clamped at zero.
+	for (uint32_t bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket)
+	{
+		uint64_t urgent = 0; // The number of messages in the bucket received on lanes above `0`.
+		for (uint32_t lane = 1; lane < NIPC_LANES; ++lane) urgent += stats->lane_latency[lane][bucket] = counters.urgent_latency[lane - 1][bucket].load(std::memory_order_relaxed);
+		stats->lane_latency[0][bucket] = stats->latency[bucket] > urgent ? stats->latency[bucket] - urgent : 0;
+	}
+
+	// Report the channels that fit.
+	for (uint32_t index = 0; channels && index < stats->channels && index < channel_capacity; ++index) channels[index] = active[index];
+
+	// Return success.
+	return 0;
+}
+
+/**
+ * @name  nipc_trace_dump()
+ * @brief  Exports the trace buffers of every process of the NIPC instance identified by `id` as a Chrome trace.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  fd  {const int}  The file descriptor to write the trace to.
+ * @remark  The trace is a JSON object in the Chrome trace event format, which Perfetto and `chrome://tracing` open.  Every stage is a complete event on the thread that ran it: `send.resolve`, `send.write` and `send.notify` in senders, and `receive` and `handler` in subscribers.  Flow arrows link each send to the first handler invocation that handles one of its messages.
+ * @remark  The buffers are read while processes may still be writing to them; events being written at that moment are skipped.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  ENODATA  If the instance was created without tracing.
+ * @throws  EIO  If the trace could not be written.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_trace_dump(const int id, const int fd)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	if (!instance->options.trace_events) { errno = ENODATA; return -1; }
 
-	// Iterate over the mailing list.
-	for (const pid_t& pid : mailing_list)
+	std::string output = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":["; // The part of the trace not written yet.
+	bool failed = false; // Whether writing the trace failed.
+	bool first = true; // Whether no event was exported yet.
+	char line[256]; // The event being formatted.
+
+	// Appends an event to the trace, writing the trace out whenever enough of it piled up.
+	const auto emit = [&](const int length)
+	{
+		if (!first) output += ',';
+		output.append(line, std::min<size_t>(length, sizeof(line) - 1));
+		first = false;
+		if (output.size() < 65536) return;
+		failed = failed || write(fd, output.data(), output.size()) != static_cast<ssize_t>(output.size());
+		output.clear();
+	};
+
+	for (uint32_t index = 0; index < instance->options.trace_processes; ++index)
 	{
-		// Create a message queue buffer to store the message and the PID of the process to receive the message.
-		msgq_buf buf(pid, msg); // The buffer to hold the message as it's being sent.
+		// Skip the buffers no process ever claimed.
+		nipc_trace_buffer* const buffer = _nipc_trace_buffer(instance, index); // The buffer.
+		const pid_t pid = buffer->pid.load(std::memory_order_relaxed); // The owner of the buffer.
+		if (!pid) continue;
 
-		// Send the message to the process's inbox.
-		if (msgsnd(id, &buf, sizeof(msgq_buf), 0) == -1) { errno = ENOMEM; return -1; }
+		// Walk the events of the current owner still in the buffer, oldest first.
+		const uint64_t head = buffer->head.load(std::memory_order_acquire); // The position the next event will be written at.
+		const uint64_t origin = buffer->origin.load(std::memory_order_acquire); // The position of the owner's first event.
+		const uint64_t events = static_cast<uint64_t>(buffer->mask) + 1; // The number of events in the buffer.
+		for (uint64_t position = std::max(origin, head > events ? head - events : 0); position < head; ++position)
+		{
+			// Copy the event and skip it if it was being written meanwhile.
+			const nipc_trace_event& slot = _nipc_trace_events(buffer)[position & buffer->mask]; // The event.
+			if (slot.sequence.load(std::memory_order_acquire) != position + 1) continue;
+			const uint64_t start = slot.start; // The time the stage started at.
+			const uint64_t duration = slot.duration; // The time the stage took.
+			const uint64_t flow = slot.flow; // The send the stage belongs to.
+			const long argument = slot.argument; // The detail of the stage.
+			const uint32_t stage = slot.stage; // The stage.
+			const pid_t thread = slot.thread; // The thread that ran the stage.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) != position + 1 || stage > NIPC_TRACE_HANDLER) continue;
 
-		// Notify the process of a new message.
-		if (kill(pid, SIGUSR1) == -1) { errno = ESRCH; return -1; }
+			// Export the stage as a complete event, with the start or the end of its send's flow if it has one.
+			emit(snprintf(line, sizeof(line), "{\"name\":\"%s\",\"cat\":\"nipc\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"argument\":%ld,\"send\":\"%llx\"}}", NIPC_TRACE_STAGES[stage], start / 1000.0, duration / 1000.0, pid, thread, argument, static_cast<unsigned long long>(flow)));
+			if (flow && stage == NIPC_TRACE_RESOLVE) emit(snprintf(line, sizeof(line), "{\"name\":\"message\",\"cat\":\"nipc\",\"ph\":\"s\",\"id\":\"%llx\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", static_cast<unsigned long long>(flow), start / 1000.0, pid, thread));
+			if (flow && stage == NIPC_TRACE_HANDLER) emit(snprintf(line, sizeof(line), "{\"name\":\"message\",\"cat\":\"nipc\",\"ph\":\"f\",\"bp\":\"e\",\"id\":\"%llx\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", static_cast<unsigned long long>(flow), start / 1000.0, pid, thread));
+		}
 	}
 
+	// Close the trace and write out what is left of it.
+	output += "]}\n";
+	failed = failed || write(fd, output.data(), output.size()) != static_cast<ssize_t>(output.size());
+	if (failed) { errno = EIO; return -1; }
+
 	// Return success.
 	return 0;
 }
 
+/**
+ * @name  nipc_reap()
+ * @brief  Removes the subscribers of the NIPC instance identified by `id` that died without closing it, and purges the messages left in their inboxes.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remark  Senders already do this on their own, at most once every 100 ms across the instance, and as soon as a recipient is found dead; this forces it.
+ * @remark  The payloads of purged messages are released from the slab.  Those a subscriber had already taken off its inbox when it died cannot be, and stay allocated.
+ * @remark  A process is only known to be dead once its PID no longer exists, so a subscriber whose PID was already reused by another process is not reaped.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @return  {const int}  The number of subscribers reaped on success, `-1` on failure.
+ */
+const int nipc_reap(const int id)
+{
+	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Sweep the instance now and return the number of subscribers reaped.
+	return static_cast<int>(_nipc_sweep(nipc->second.instance, true));
+}
+
 /**
  * @name  nipc_close()
  * @brief  Unsubscribes the calling process from the NIPC instance identified by `id`. A closed NIPC instance cannot be used unless opened again.
  * @param  id  {const int}  The ID of the NIPC instance to unsubscribe from.
+ * @remark  If the process listens for calls on the instance, it stops; callers waiting on it fail with `ESRCH`.
+ * @remark  Messages still waiting in the process's inbox are purged, and the payloads held in the instance's slab by message buffers not yet released are released, so those buffers must not be read past the call.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
  * @throws  ENOMEM  If the NIPC instance could not be closed due to a memory error.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
 const int nipc_close(const int id)
 {
 	// Ensure that the NIPC instance exists and the process called `nipc_get()` for this NIPC instance.
-	if (_subscription_list.find(id) == _subscription_list.end()) { errno = ENOENT; return -1; }
+	const std::unordered_map<int, nipc_handle>::iterator nipc = _subscription_list.find(id); // The opened NIPC instance.
+	if (nipc == _subscription_list.end()) { errno = ENOENT; return -1; }
+
+	// Stop the receiver thread serving the subscription, if any.
+	if (nipc->second.receiver) _nipc_stop_receiver(nipc->second.receiver);
+
+	// Release the payloads last returned by `nipc_recv()`, and those of the messages left in the inbox.
+	nipc_instance* const instance = nipc->second.instance; // The NIPC instance.
+	for (const uint32_t block : nipc->second.held) _nipc_slab_release(instance, block);
+	if (_pool.load(std::memory_order_acquire)) for (uint32_t index = 0; index < _pool_size; ++index) _nipc_pool_drop(index, instance);
+	for (nipc_inbox* const inbox = nipc->second.inbox; inbox && inbox->offset + offsetof(nipc_wire, data) <= inbox->size;)
+	{
+		const nipc_wire& wire = *reinterpret_cast<const nipc_wire*>(inbox->record.data + inbox->offset); // The message.
+		if (wire.block) _nipc_slab_release(instance, static_cast<uint32_t>(wire.block));
+		inbox->offset += _nipc_stride(_nipc_wire_size(wire));
+	}
 
-	// Remove the process from the NIPC instance and detach the shared memory segment.
-	_subscription_list[id]->erase(getpid());
-	if (shmdt(_subscription_list[id]) == -1) { errno = ENOMEM; return -1; }
+	// Unmap the log segment the process last appended to, if any.
+	if (nipc->second.log_map) munmap(nipc->second.log_map, instance->options.log_segment_size);
+
+	// Stop answering calls, if the process did.
+	if (nipc->second.responder != NIPC_NONE) instance->responders[nipc->second.responder].pid.store(0, std::memory_order_release);
+
+	// Remove the process from the NIPC instance, keeping its counters, purge the messages left in its inbox, and detach the shared memory segment.
+	nipc_registry* const registry = &nipc->second.instance->registry; // The subscriber registry of the instance.
+	if (_nipc_lock(registry) == -1) return -1;
+	if (nipc->second.subscriber != NIPC_NONE) _nipc_retire(nipc->second.instance, nipc->second.subscriber);
+	_nipc_unregister(registry, getpid());
+	_nipc_unlock(registry);
+	_nipc_purge(instance, getpid());
+	if (shmdt(nipc->second.instance) == -1) { errno = ENOMEM; return -1; }
+
+	// Close the socket senders notified the process through, if any.
+	if (nipc->second.fd != -1) { close(nipc->second.fd); delete nipc->second.inbox; }
 
 	// Remove the NIPC instance from the subscription list.
-	_subscription_list.erase(id);
+	_subscription_list.erase(nipc);
 
-	// Restore the default signal handler for `SIGUSR1`.
-	signal(SIGUSR1, SIG_DFL);
+	// Restore the default signal handler for `NIPC_SIGNAL` once no subscription relies on it.
+	for (const std::pair<const int, nipc_handle>& pair : _subscription_list) if (pair.second.subscriber != NIPC_NONE && pair.second.fd == -1 && pair.second.instance->options.wakeup == NIPC_WAKEUP_SIGNAL) return 0;
+	signal(NIPC_SIGNAL, SIG_DFL);
 
 	// Return success.
 	return 0;
@@ -299,6 +5325,7 @@ const int nipc_close(const int id)
  * @name  nipc_remove()
  * @brief  Removes an NIPC instance identified by `_key` from the system.
  * @param  id  {const int}  The ID of the NIPC instance to remove.
+ * @remark  Every shard of the instance's message queue is removed.  The instance's log, if any, is left on disk so that it can be replayed by an instance created with the same `log_path`.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
  * @throws  ENOMEM  If the NIPC instance could not be removed due to a memory error.
  * @return  {const int}  `0` on success, `-1` on failure.
@@ -311,10 +5338,18 @@ const int nipc_remove(const key_t _key)
 	if (msgq_id == -1) { errno = ENOENT; return -1; }
 
 	// Get the ID of the shared memory segment with the provided key.
-	const int shmid = shmget(_key, sizeof(std::unordered_map<pid_t, long>), RW_UGO); // The ID of the shared memory segment.
+	const int shmid = shmget(_key, 0, RW_UGO); // The ID of the shared memory segment.
 	// If the shared memory segment could not be attached, return an error.
 	if (shmid == -1) { errno = ENOENT; return -1; }
 
+	// Remove the message queues of the other shards, if the instance was fully created.
+	const nipc_instance* const instance = static_cast<const nipc_instance*>(shmat(shmid, NULL, SHM_RDONLY)); // The NIPC instance.
+	if (instance != reinterpret_cast<const nipc_instance*>(-1))
+	{
+		if (instance->magic.load(std::memory_order_acquire) == NIPC_MAGIC) _nipc_queues_remove(instance, instance->options.queue_shards);
+		shmdt(instance);
+	}
+
 	// Remove the message queue.
 	if (msgctl(msgq_id, IPC_RMID, NULL) == -1) { errno = ENOMEM; return -1; }
 	// Remove the shared memory segment.
@@ -330,6 +5365,10 @@ const int nipc_remove(const key_t _key)
  * @param  id  {const int}  The ID of the NIPC instance to send the message to.
  * @remarks  augh!
  */
-void nipc_thats_what_im_sayin(const int id) { nipc_send(id, nipc_message(0, getpid(), "    __             / |\n   / /          _ /  |\n  /  \\         /o    |\n | __/      __|     O|\n | |       /   \\     |\n  \\ \\     |     |    |\n   \\ \\    |__   |    /\n    \\ \\__/   \\______/\n     \\__ |\\_______/|__\n       / |         |_ \\____\n      /  |      ___|_\\     |\n     /   |     /     __---/\n    /    \\_____\\____/\n"), NIPC_BROADCAST); }
+void nipc_thats_what_im_sayin(const int id)
+{
+	static const char art[] = "    __             / |\n   / /          _ /  |\n  /  \\         /o    |\n | __/      __|     O|\n | |       /   \\     |\n  \\ \\     |     |    |\n   \\ \\    |__   |    /\n    \\ \\__/   \\______/\n     \\__ |\\_______/|__\n       / |         |_ \\____\n      /  |      ___|_\\     |\n     /   |     /     __---/\n    /    \\_____\\____/\n"; // The message, too large to travel inline.
+	nipc_send(id, nipc_message::borrow(0, getpid(), art, sizeof(art)), NIPC_BROADCAST);
+}
 
 // End of src/NIPC.cpp
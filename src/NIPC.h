@@ -17,11 +17,20 @@
 #define NIPC_H
 
 #include <sys/types.h>	// key_t, pid_t
-#include <cstring>	// strncpy
+#include <cstring>	// memcpy, strlen
+#include <cstdint>	// uint32_t, uint64_t
+#include <csignal>	// SIGRTMIN
+
+// The largest payload carried inline in a message; larger payloads travel through the instance's slab.
+#define NIPC_INLINE_SIZE 256U
+
+// The number of priority lanes of every subscriber's inbox; lane `0` carries bulk traffic and higher lanes are received first.
+#define NIPC_LANES 4U
 
 /**
  * @name  nipc_message
  * @brief  A message to be sent through the NIPC.
+ * @remark  Payloads of up to `NIPC_INLINE_SIZE` bytes are stored in `data` and only their actual length is copied between processes.  Larger payloads are referenced through `blob`, which only `borrow()` sets; they are copied once into the shared memory slab of the instance and read in place by every recipient.
  */
 struct nipc_message
 {
@@ -38,45 +47,599 @@ struct nipc_message
 	pid_t sender;
 
 	/**
-	 * @name  {char[256]}  data
-	 * @brief  The data to send.
+	 * @name  {unsigned int}  priority
+	 * @brief  The lane the message travels on, from `0`, the default, up to `NIPC_LANES - 1` for the most urgent messages.
+	 * @remark  A subscriber receives every message pending on a higher lane before any on a lower one, so urgent messages do not wait behind bulk traffic; messages on the same lane keep their order, but not across lanes.  Messages above lane `0` are also exempt from the subscriber's quota.
+	 * @remark  With `NIPC_TRANSPORT_RING`, on conflated channels and when replaying a log, every message is received in order on lane `0`.
+	 */
+	unsigned int priority;
+
+	/**
+	 * @name  {size_t}  length
+	 * @brief  The length of the payload in bytes.
+	 */
+	size_t length;
+
+	/**
+	 * @name  {const void*}  blob
+	 * @brief  The payload, if it is larger than `NIPC_INLINE_SIZE` bytes; `nullptr` if it is stored in `data`.
+	 * @remark  On the sending side, it is set by `borrow()` and must stay valid until `nipc_send()` returns.  On the receiving side, it points into the instance's shared memory segment; a buffer handed to a notification handler keeps it valid until the buffer is released or the instance is closed.
+	 */
+	const void* blob;
+
+	/**
+	 * @name  {char[NIPC_INLINE_SIZE]}  data
+	 * @brief  The payload, if it is no larger than `NIPC_INLINE_SIZE` bytes; only its first `length` bytes are meaningful.
+	 * @remark  Only the first `length` bytes are sent, so `length` must be updated when writing to `data` directly.
 	 */
-	char data[256];
+	char data[NIPC_INLINE_SIZE];
+
+	/**
+	 * @name  {uint64_t}  timestamp
+	 * @brief  The time the message was sent at, in nanoseconds of `CLOCK_MONOTONIC`.
+	 * @remark  Set by the library on the receiving side; ignored when sending.
+	 */
+	uint64_t timestamp;
+
+	/**
+	 * @name  {uint64_t}  sequence
+	 * @brief  The sequence number the message was logged under, if the instance logs; `0` otherwise.
+	 * @remark  Set by the library on the receiving side; ignored when sending.
+	 */
+	uint64_t sequence;
 
 	/**
 	 * @name  nipc_message()
 	 * @brief  Constructs a new empty message.
 	 */
-	nipc_message() : channel(0L), sender(0) { data[0] = '\0'; }
+	nipc_message() : channel(0L), sender(0), priority(0U), length(0), blob(nullptr), timestamp(0), sequence(0) { data[0] = '\0'; }
 
 	/**
 	 * @name  nipc_message(const long _channel, const pid_t _sender, const char* const _data)
-	 * @brief  Constructs a new message with the given channel, sender and data.
+	 * @brief  Constructs a new message with the given channel, sender and text.
+	 * @param  _channel  The channel on which to send the message.
+	 * @param  _sender  The PID of the process that sent the message.
+	 * @param  _data  The null-terminated text to send; the payload includes the terminating null character.
+	 * @remark  The text is always copied; text that does not fit inline is not, and the message is refused when sent, so send it with `borrow()` instead.
+	 */
+	nipc_message(const long _channel, const pid_t _sender, const char* const _data) : channel(_channel), sender(_sender), priority(0U), length(strlen(_data) + 1), blob(nullptr), timestamp(0), sequence(0)
+	{
+		if (length <= NIPC_INLINE_SIZE) memcpy(data, _data, length);
+		else data[0] = '\0';
+	}
+
+	/**
+	 * @name  nipc_message(const long _channel, const pid_t _sender, const void* const _payload, const size_t _length)
+	 * @brief  Constructs a new message with the given channel, sender and binary payload.
+	 * @param  _channel  The channel on which to send the message.
+	 * @param  _sender  The PID of the process that sent the message.
+	 * @param  _payload  The payload to send.
+	 * @param  _length  The length of the payload in bytes.
+	 * @remark  The payload is always copied; a payload that does not fit inline is not, and the message is refused when sent, so send it with `borrow()` instead.
+	 */
+	nipc_message(const long _channel, const pid_t _sender, const void* const _payload, const size_t _length) : channel(_channel), sender(_sender), priority(0U), length(_length), blob(nullptr), timestamp(0), sequence(0)
+	{
+		if (length <= NIPC_INLINE_SIZE) memcpy(data, _payload, length);
+		else data[0] = '\0';
+	}
+
+	/**
+	 * @name  borrow(const long _channel, const pid_t _sender, const void* const _payload, const size_t _length)
+	 * @brief  Constructs a new message with the given channel, sender and binary payload, referencing the payload if it does not fit inline.
 	 * @param  _channel  The channel on which to send the message.
 	 * @param  _sender  The PID of the process that sent the message.
-	 * @param  _data  The data to send.
+	 * @param  _payload  The payload to send.
+	 * @param  _length  The length of the payload in bytes.
+	 * @remark  A payload larger than `NIPC_INLINE_SIZE` bytes is not copied but referenced through `blob`, so it must stay valid until the message is sent; smaller ones are copied inline.
+	 * @return  {nipc_message}  The message.
 	 */
-	nipc_message(const long _channel, const pid_t _sender, const char* const _data) : channel(_channel), sender(_sender) { strncpy(data, _data, 256); }
+	static nipc_message borrow(const long _channel, const pid_t _sender, const void* const _payload, const size_t _length)
+	{
+		nipc_message message(_channel, _sender, _payload, _length); // The message.
+		if (_length > NIPC_INLINE_SIZE) message.blob = _payload;
+		return message;
+	}
+
+	/**
+	 * @name  payload()
+	 * @brief  Locates the payload of the message, wherever it is stored.
+	 * @return  {const void*}  The first byte of the payload.
+	 */
+	const void* payload() const { return blob ? blob : data; }
 	
 };
 
 // The notification handler's function type.
 typedef void (*nipc_handler_t)(nipc_message* const);
 
+// The batch notification handler's function type; it receives a batch of messages and the number of messages in it.
+typedef void (*nipc_batch_handler_t)(const nipc_message* const, const size_t);
+
+// The maximum number of messages handed to a batch notification handler at once.
+#define NIPC_BATCH_SIZE 64U
+
+// The maximum number of worker threads a subscription can run its notification handler on.
+#define NIPC_MAX_WORKERS 64U
+
+// The default number of message buffers in a process's message pool.
+#define NIPC_POOL_SIZE 1024U
+
 #define NIPC_BROADCAST 0L
 #define NIPC_UNICAST(pid) static_cast<long>(pid)
-#define NIPC_MULTICAST(type) static_cast<long>(-type)
+#define NIPC_MULTICAST(type) static_cast<long>(-(type))
+
+// The flag making a send skip a recipient with `EAGAIN` rather than wait for room in the message queue or in the recipient's quota.
+#define NIPC_NONBLOCK 1
+
+// The maximum number of processes that can be subscribed to a NIPC instance at once.
+#define NIPC_MAX_SUBSCRIBERS 1024U
+
+// The maximum number of multicast channels a process can be subscribed to on a NIPC instance at once.
+#define NIPC_MAX_CHANNELS 64U
+
+// The maximum number of conflated channels a NIPC instance can have.
+#define NIPC_MAX_CONFLATED 64U
+
+// The size of the buffer holding the path of a NIPC instance's log, including the terminating null character.
+#define NIPC_LOG_PATH_SIZE 256U
+
+// The maximum number of calls that can be in flight on a NIPC instance at once, across all of its callers.
+#define NIPC_MAX_CALLS 256U
+
+// The maximum number of processes that can answer calls on a NIPC instance at once.
+#define NIPC_MAX_RESPONDERS 64U
+
+// The maximum number of message queues a NIPC instance can spread its subscribers' inboxes over.
+#define NIPC_MAX_SHARDS 64U
+
+// The realtime signal used to notify subscribers of instances created with `NIPC_WAKEUP_SIGNAL`; it carries the ID of the instance that has messages pending.
+#define NIPC_SIGNAL (SIGRTMIN)
+
+/**
+ * @name  nipc_transport
+ * @brief  The mechanism a NIPC instance uses to carry messages to its subscribers.
+ */
+enum nipc_transport
+{
+	// Every recipient gets its own copy of the message in the instance's message queue.
+	NIPC_TRANSPORT_QUEUE,
+
+	// Every message is written once to a ring in the instance's shared memory segment and read in place by each recipient.
+	NIPC_TRANSPORT_RING
+};
+
+/**
+ * @name  nipc_wakeup
+ * @brief  The mechanism a NIPC instance uses to tell subscribers that messages are pending.
+ */
+enum nipc_wakeup
+{
+	// Deliveries queue `NIPC_SIGNAL` to the recipient, at most one per instance at a time, and its notification handler runs inside the signal handler.
+	NIPC_WAKEUP_SIGNAL,
+
+	// Each subscription is served by a receiver thread parked on a futex word in the instance's shared memory segment; senders only wake it when it is parked, and the notification handler runs on that thread.
+	NIPC_WAKEUP_FUTEX
+};
+
+/**
+ * @name  nipc_overflow
+ * @brief  What a sender does when a recipient has no room left for its messages.
+ */
+enum nipc_overflow
+{
+	// The sender waits for the recipient to make room, unless it sends with `NIPC_NONBLOCK`; then the recipient is skipped with `EAGAIN`.
+	NIPC_OVERFLOW_BLOCK,
+
+	// The oldest messages still waiting in the recipient's inbox are dropped to make room.
+	NIPC_OVERFLOW_DROP_OLDEST,
+
+	// The messages that do not fit are dropped for the recipient, and the send still succeeds.
+	NIPC_OVERFLOW_DROP_NEWEST,
+
+	// The recipient is skipped, and the send fails with `EAGAIN`.
+	NIPC_OVERFLOW_FAIL
+};
+
+/**
+ * @name  nipc_options
+ * @brief  The options a NIPC instance is created with.
+ */
+struct nipc_options
+{
+	/**
+	 * @name  {nipc_transport}  transport
+	 * @brief  The mechanism used to carry messages to subscribers.
+	 */
+	nipc_transport transport;
+
+	/**
+	 * @name  {unsigned int}  ring_slots
+	 * @brief  The number of messages the ring can hold when `transport` is `NIPC_TRANSPORT_RING`; must be a power of two.
+	 * @remark  A subscriber that falls more than `ring_slots` messages behind loses the oldest messages it has not read yet.
+	 */
+	unsigned int ring_slots;
+
+	/**
+	 * @name  {unsigned int}  queue_shards
+	 * @brief  The number of message queues, from 1 up to `NIPC_MAX_SHARDS`, that the inboxes of subscribers are spread over when `transport` is `NIPC_TRANSPORT_QUEUE`; ignored otherwise.
+	 * @remark  A process's inbox lives in the shard its PID hashes to, so sends to processes in different shards, and those processes receiving, do not contend on the same kernel lock or share the same byte limit.  The ID returned by `nipc_get()` is that of the first shard.
+	 */
+	unsigned int queue_shards;
+
+	/**
+	 * @name  {nipc_wakeup}  wakeup
+	 * @brief  The mechanism used to tell subscribers that messages are pending.
+	 */
+	nipc_wakeup wakeup;
+
+	/**
+	 * @name  {unsigned int}  quota
+	 * @brief  The number of messages each subscriber may have waiting in the message queue before `overflow` applies to it; `0` leaves subscribers unbounded.
+	 * @remark  A slow subscriber then only ever holds its own quota of the shared message queue, so it cannot fill the queue and hold up senders and the other subscribers; the quota times the number of subscribers in a shard should fit in its queue.  Messages sent above lane `0` do not count against it.
+	 * @remark  The quota is checked against counters updated by concurrent senders and subscribers, so it may be exceeded by the messages of concurrent sends.  With `NIPC_TRANSPORT_RING`, senders never wait and slow subscribers are lapped instead, so the quota does not apply.
+	 */
+	unsigned int quota;
+
+	/**
+	 * @name  {nipc_overflow}  overflow
+	 * @brief  What a sender does when a recipient has used up its quota or the message queue is full.
+	 */
+	nipc_overflow overflow;
+
+	/**
+	 * @name  {size_t}  slab_size
+	 * @brief  The size in bytes of the slab holding payloads larger than `NIPC_INLINE_SIZE`; `0` disables such payloads.
+	 * @remark  A payload is stored once in the slab however many subscribers receive it and is freed when the last of them is done with it.
+	 * @remark  With `NIPC_TRANSPORT_RING`, the ring keeps the payloads of its messages until they are overwritten; when the slab runs out of room, the oldest of them are evicted, and subscribers that have not read them yet lose them as if they were lapped.
+	 */
+	size_t slab_size;
+
+	/**
+	 * @name  {unsigned int}  slab_block_size
+	 * @brief  The granularity in bytes at which the slab is handed out to payloads.
+	 */
+	unsigned int slab_block_size;
+
+	/**
+	 * @name  {unsigned int}  trace_events
+	 * @brief  The number of events every process keeps in its trace buffer, which must be a power of two; `0` disables tracing.
+	 * @remark  When tracing, every process that sends to or subscribes to the instance records when each stage of a message's life starts and how long it takes, overwriting its oldest events once its buffer is full.  `nipc_trace_dump()` exports them.
+	 */
+	unsigned int trace_events;
+
+	/**
+	 * @name  {unsigned int}  trace_processes
+	 * @brief  The number of trace buffers of the instance, and so the number of processes that can trace at once.
+	 * @remark  A buffer stays with its process after it exits, so that its events can still be exported, until another process needs it and no buffer is free.
+	 */
+	unsigned int trace_processes;
+
+	/**
+	 * @name  {char[NIPC_LOG_PATH_SIZE]}  log_path
+	 * @brief  The path prefix of the instance's log segments, which are named `<log_path>.<index>.log`; empty disables the log.
+	 * @remark  When logging, every message sent is first appended with a sequence number, starting at 1, to a memory-mapped segment file; subscribers can then replay them, see `nipc_subscriber_options::replay`.  The log outlives the instance: an instance created again with the same path carries on where the last segment ends.
+	 */
+	char log_path[NIPC_LOG_PATH_SIZE];
+
+	/**
+	 * @name  {size_t}  log_segment_size
+	 * @brief  The size in bytes of each log segment, from 4096 bytes up to 4 GiB; every logged message must fit in one.
+	 * @remark  Every segment's disk space is allocated when it is created, so running out of space fails the send that starts a segment with `EIO`.
+	 */
+	size_t log_segment_size;
+
+	/**
+	 * @name  {uint64_t}  log_retention_size
+	 * @brief  The number of bytes of log segments to keep; older segments are deleted when a new one is started.  `0` keeps every segment.
+	 * @remark  The current segment is always kept.
+	 */
+	uint64_t log_retention_size;
+
+	/**
+	 * @name  {unsigned int}  log_retention_age
+	 * @brief  The number of seconds to keep a log segment once it is full; older segments are deleted when a new one is started.  `0` keeps them regardless of age.
+	 */
+	unsigned int log_retention_age;
+
+	/**
+	 * @name  nipc_options()
+	 * @brief  Constructs the default options: a message queue transport with a single shard and signal notifications, unbounded subscribers that senders wait for, a 1 MiB slab, no tracing and no log.
+	 */
+	nipc_options() : transport(NIPC_TRANSPORT_QUEUE), ring_slots(1024U), queue_shards(1U), wakeup(NIPC_WAKEUP_SIGNAL), quota(0U), overflow(NIPC_OVERFLOW_BLOCK), slab_size(1U << 20), slab_block_size(4096U), trace_events(0U), trace_processes(64U), log_segment_size(64U << 20), log_retention_size(0), log_retention_age(0U) { log_path[0] = '\0'; }
+};
+
+/**
+ * @name  nipc_subscriber_options
+ * @brief  The options a process subscribes to a NIPC instance with.
+ */
+struct nipc_subscriber_options
+{
+	/**
+	 * @name  {unsigned int}  workers
+	 * @brief  The number of worker threads to run the notification handler on, up to `NIPC_MAX_WORKERS`; `0` runs it on the thread that receives the messages.
+	 * @remark  With workers, a dedicated receiver thread pulls messages off the instance and hands them to the workers through lock-free queues, so the handler never runs in signal context and a slow handler does not hold up delivery.
+	 * @remark  Messages sharing a `channel` are always handled by the same worker, in the order they were received.
+	 */
+	unsigned int workers;
+
+	/**
+	 * @name  {unsigned int}  pool
+	 * @brief  The number of message buffers to preallocate for the notification handler; `0` picks `NIPC_POOL_SIZE`.
+	 * @remark  The pool is shared by every subscription of the process and is created by its first subscription; later sizes are ignored.
+	 * @remark  Buffers are taken from and returned to the pool without locking or allocating, which is safe in a signal handler.  If the pool runs dry, messages are left pending until buffers are released, so it should be sized for the number of messages the handler holds on to at once.
+	 */
+	unsigned int pool;
+
+	/**
+	 * @name  {uint64_t}  replay
+	 * @brief  The sequence number to replay the instance's log from before switching to live delivery; `0` replays nothing.
+	 * @remark  The logged messages the process would have received, from `replay` up to the last one logged before it subscribed, are handed to the notification handler on the subscribing thread before the subscription returns, straight from the mapped segments.  Live messages start right after them, so none is missed or handled twice.
+	 * @remark  Replay starts at the oldest message still retained if `replay` is older.  It only applies to the subscription that asks for it; the channels the process follows by then decide which multicasts are replayed.
+	 */
+	uint64_t replay;
+
+	/**
+	 * @name  nipc_subscriber_options()
+	 * @brief  Constructs the default options: the notification handler runs on the thread that receives the messages, with a pool of `NIPC_POOL_SIZE` buffers, and nothing is replayed.
+	 */
+	nipc_subscriber_options() : workers(0U), pool(NIPC_POOL_SIZE), replay(0) {}
+};
+
+/**
+ * @name  nipc_delivery
+ * @brief  The outcome of a send for one of its recipients.
+ */
+struct nipc_delivery
+{
+	/**
+	 * @name  {pid_t}  pid
+	 * @brief  The PID of the recipient.
+	 */
+	pid_t pid;
+
+	/**
+	 * @name  {size_t}  delivered
+	 * @brief  The number of messages delivered to the recipient, counted from the first message of the send.
+	 */
+	size_t delivered;
+
+	/**
+	 * @name  {int}  error
+	 * @brief  `0` if every message was delivered to the recipient and it was notified; otherwise, the error that stopped delivery to it.
+	 */
+	int error;
+
+	/**
+	 * @name  {size_t}  dropped
+	 * @brief  The number of messages dropped for the recipient by the overflow policy: those of the send that were not delivered with `NIPC_OVERFLOW_DROP_NEWEST`, or older ones evicted from its inbox with `NIPC_OVERFLOW_DROP_OLDEST`.
+	 */
+	size_t dropped;
+};
+
+// The number of buckets in the latency histograms of a NIPC instance; bucket `0` counts latencies under 1 µs, bucket `i` those in [2^(i-1), 2^i) µs, and the last bucket everything above.
+#define NIPC_LATENCY_BUCKETS 32U
+
+/**
+ * @name  nipc_instance_stats
+ * @brief  A snapshot of the counters of a NIPC instance.
+ * @remark  Counters are updated without locking and read one by one, so a snapshot taken while messages are flowing may be slightly inconsistent.
+ */
+struct nipc_instance_stats
+{
+	/**
+	 * @name  {uint64_t}  broadcasts
+	 * @brief  The number of messages broadcast.
+	 */
+	uint64_t broadcasts;
+
+	/**
+	 * @name  {uint64_t}  multicasts
+	 * @brief  The number of messages multicast.
+	 */
+	uint64_t multicasts;
+
+	/**
+	 * @name  {uint64_t}  unicasts
+	 * @brief  The number of messages unicast.
+	 */
+	uint64_t unicasts;
+
+	/**
+	 * @name  {uint64_t}  delivered
+	 * @brief  The number of copies of messages delivered to recipients, counting each recipient of a message once.
+	 */
+	uint64_t delivered;
+
+	/**
+	 * @name  {uint64_t}  received
+	 * @brief  The number of messages handed to notification handlers, including those of processes that have since unsubscribed.
+	 */
+	uint64_t received;
+
+	/**
+	 * @name  {uint64_t}  dropped
+	 * @brief  The number of replayed messages skipped because the message pool of their recipient had no buffer left for the notification handler, or the slab no room left for their payload.
+	 */
+	uint64_t dropped;
+
+	/**
+	 * @name  {uint64_t}  lapped
+	 * @brief  The number of ring positions skipped by subscribers that were lapped, including those of messages addressed to others.
+	 */
+	uint64_t lapped;
+
+	/**
+	 * @name  {uint64_t}  overflowed
+	 * @brief  The number of messages dropped by the overflow policy because their recipient had used up its quota or the message queue was full.
+	 */
+	uint64_t overflowed;
+
+	/**
+	 * @name  {uint64_t}  logged
+	 * @brief  The sequence number of the last message logged, including those logged before the instance was created again, or `0`.
+	 */
+	uint64_t logged;
+
+	/**
+	 * @name  {uint64_t}  send_failures
+	 * @brief  The number of message queue writes that failed.
+	 */
+	uint64_t send_failures;
+
+	/**
+	 * @name  {int}  send_error
+	 * @brief  The error of the last message queue write that failed, or `0`.
+	 */
+	int send_error;
+
+	/**
+	 * @name  {uint64_t}  notify_failures
+	 * @brief  The number of recipients that could not be signalled.
+	 */
+	uint64_t notify_failures;
+
+	/**
+	 * @name  {uint64_t}  reaped
+	 * @brief  The number of subscribers removed from the instance because they died without closing it.
+	 */
+	uint64_t reaped;
+
+	/**
+	 * @name  {uint64_t}  purged
+	 * @brief  The number of messages purged from the inboxes of reaped subscribers, and of processes that closed the instance with messages still waiting.
+	 */
+	uint64_t purged;
+
+	/**
+	 * @name  {uint64_t}  reclaimed
+	 * @brief  The number of ring slots reclaimed from writers that died before publishing them, each losing the message it was being written with.
+	 */
+	uint64_t reclaimed;
+
+	/**
+	 * @name  {uint32_t}  subscribers
+	 * @brief  The number of subscribed processes.
+	 */
+	uint32_t subscribers;
+
+	/**
+	 * @name  {uint32_t}  channels
+	 * @brief  The number of multicast channels with at least one subscriber.
+	 */
+	uint32_t channels;
+
+	/**
+	 * @name  {uint64_t[NIPC_LATENCY_BUCKETS]}  latency
+	 * @brief  The histogram of the time between sending messages and handing them to notification handlers, over every subscriber.
+	 */
+	uint64_t latency[NIPC_LATENCY_BUCKETS];
+
+	/**
+	 * @name  {uint64_t[NIPC_LANES][NIPC_LATENCY_BUCKETS]}  lane_latency
+	 * @brief  The same histogram split by the lane the messages travelled on, so that the wait of urgent messages can be told apart from that of bulk traffic.
+	 */
+	uint64_t lane_latency[NIPC_LANES][NIPC_LATENCY_BUCKETS];
+};
+
+/**
+ * @name  nipc_subscriber_stats
+ * @brief  A snapshot of the counters of a subscriber of a NIPC instance.
+ */
+struct nipc_subscriber_stats
+{
+	/**
+	 * @name  {pid_t}  pid
+	 * @brief  The PID of the subscriber.
+	 */
+	pid_t pid;
+
+	/**
+	 * @name  {long}  channel
+	 * @brief  The first multicast channel the subscriber subscribed to among those it still follows, or `0` if it follows none.
+	 */
+	long channel;
+
+	/**
+	 * @name  {uint32_t}  channels
+	 * @brief  The number of multicast channels the subscriber follows.
+	 */
+	uint32_t channels;
+
+	/**
+	 * @name  {uint64_t}  pending
+	 * @brief  The number of messages delivered to the subscriber but not handed to its notification handler yet.
+	 * @remark  With `NIPC_TRANSPORT_RING`, it is the number of ring positions the subscriber has yet to read, including those of messages addressed to others.
+	 */
+	uint64_t pending;
+
+	/**
+	 * @name  {uint64_t}  received
+	 * @brief  The number of messages handed to the subscriber's notification handler.
+	 */
+	uint64_t received;
+
+	/**
+	 * @name  {uint64_t}  dropped
+	 * @brief  The number of replayed messages the subscriber skipped because its message pool had no buffer left for them, or the slab no room left for their payload.
+	 */
+	uint64_t dropped;
+
+	/**
+	 * @name  {uint64_t}  lapped
+	 * @brief  The number of ring positions the subscriber skipped because it was lapped.
+	 */
+	uint64_t lapped;
+
+	/**
+	 * @name  {uint64_t}  overflowed
+	 * @brief  The number of messages dropped for the subscriber by the overflow policy.
+	 */
+	uint64_t overflowed;
+};
+
+/**
+ * @name  nipc_channel_stats
+ * @brief  A snapshot of the counters of a multicast channel of a NIPC instance.
+ */
+struct nipc_channel_stats
+{
+	/**
+	 * @name  {long}  channel
+	 * @brief  The ID of the multicast channel.
+	 */
+	long channel;
+
+	/**
+	 * @name  {uint32_t}  subscribers
+	 * @brief  The number of subscribers of the channel.
+	 */
+	uint32_t subscribers;
+
+	/**
+	 * @name  {uint64_t}  sent
+	 * @brief  The number of messages multicast to the channel since its first subscriber joined.
+	 */
+	uint64_t sent;
+};
 
 /**
  * @name  nipc_create()
  * @brief  Creates a NIPC instance that has a key `_key`.  If a NIPC instance with the same key exists, the function fails.
  * @remark  The NIPC instance relies on a message queue to store and manage messages.
  * @param  _key  {const key_t}  The key of the NIPC instance to create.
+ * @param  options  {const nipc_options&}  The options of the NIPC instance.
+ * @remark  The subscriber registry of the instance lives entirely in its shared memory segment and is safe to use from any number of processes.
+ * @remark  With `NIPC_TRANSPORT_RING`, a broadcast or multicast is written once to the ring and every subscriber reads it through its own cursor; unicasts travel through the ring as well and are skipped by the other subscribers.
+ * @remark  Payloads larger than `NIPC_INLINE_SIZE` bytes are stored in a slab of `options.slab_size` bytes in the same segment.
+ * @remark  With a `options.log_path`, the last segment of an existing log is scanned so that the sequence numbers carry on from it.
+ * @remark  With `options.queue_shards` above 1, the shards past the first are message queues without a key, found through the instance's shared memory segment.
  * @throws  EEXIST  If a NIPC instance with the same key already exists.
+ * @throws  EINVAL  If the options are invalid.
  * @throws  ENOMEM  If the NIPC instance could not be created due to a lack of memory.
+ * @throws  EIO  If the log could not be opened or created.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_create(const key_t _key);
+const int nipc_create(const key_t _key, const nipc_options& options = nipc_options());
 
 /**
  * @name  nipc_get()
@@ -94,14 +657,140 @@ const int nipc_get(const key_t _key);
  * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
  * @param  type  {const long}  The multicast channel to subscribe to.
  * @param  handler  {nipc_handler_t}  The function handler to invoke upon any notification from the NIPC instance.
- * @remarks  `SIGUSR1` is used to notify the process of a new message.
- * @remarks  When a new message is received, the signal handler will allocate a buffer containing the message and call the notification handler; it is the responsibility of the notification handler to free the buffer.
- * @remarks  For compatibility, the buffer is allocated using `malloc()`; it must be released using `free()`.
+ * @param  options  {const nipc_subscriber_options&}  The options of the subscription; they only take effect on the first subscription of the process to the instance.
+ * @remarks  `NIPC_SIGNAL` is used to notify the process of a new message, unless the instance was created with `NIPC_WAKEUP_FUTEX`; then a receiver thread is started for the subscription and the notification handler runs on it.
+ * @remarks  Each instance keeps its own notification handler, and a notification only drains the instance it comes from, so opening many instances does not slow down any of them.
+ * @remarks  When a new message is received, the signal handler will copy it into a buffer and call the notification handler; it is the responsibility of the notification handler to release the buffer using `nipc_message_release()`.
+ * @remarks  A payload held in the instance's slab stays valid as long as its buffer is kept, until it is released or the instance is closed.
+ * @remarks  Every notification drains all messages pending for the process on its instance, so notifications that were merged do not leave messages behind.
+ * @remarks  Buffers come from the process's message pool and must be released using `nipc_message_release()`, never `free()`; while the pool is exhausted, messages are left pending, and they are delivered once a buffer is released.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`, and replaces its notification handler; a message multicast to several of them is still delivered once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, with more than `NIPC_MAX_WORKERS` workers, or already subscribed with `nipc_subscribe_poll()`.
+ * @throws  ENOMEM  If the message pool could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @throws  EAGAIN  If the receiver thread or a worker thread could not be started.
+ * @throws  EIO  If the log could not be replayed.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe(const int id, const long type, nipc_handler_t handler, const nipc_subscriber_options& options = nipc_subscriber_options());
+
+/**
+ * @name  nipc_subscribe_batch()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`, delivering messages in batches.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @param  handler  {nipc_batch_handler_t}  The function handler to invoke with every batch of messages received from the NIPC instance.
+ * @param  options  {const nipc_subscriber_options&}  The options of the subscription; they only take effect on the first subscription of the process to the instance.
+ * @remarks  Notifications are delivered as with `nipc_subscribe()`.  On every notification, everything pending for the process on the instance it comes from is drained and handed to `handler` in batches of up to `NIPC_BATCH_SIZE` messages.
+ * @remarks  The batch is owned by the library and is only valid until the handler returns; nothing has to be freed.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`, and replaces its notification handler; a message multicast to several of them is still delivered once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, with more than `NIPC_MAX_WORKERS` workers, or already subscribed with `nipc_subscribe_poll()`.
+ * @throws  ENOMEM  If the message pool could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @throws  EAGAIN  If the receiver thread or a worker thread could not be started.
+ * @throws  EIO  If the log could not be replayed.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe_batch(const int id, const long type, nipc_batch_handler_t handler, const nipc_subscriber_options& options = nipc_subscriber_options());
+
+/**
+ * @name  nipc_unsubscribe()
+ * @brief  Stops the calling process from following the multicast channel `type` of the opened NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  type  {const long}  The multicast channel to leave.
+ * @remarks  The process stays subscribed to the instance, and keeps receiving broadcasts and unicasts, even once it follows no channel; use `nipc_close()` to leave the instance.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened, or the process does not follow the channel.
+ * @throws  EINVAL  If `type` is not a multicast channel.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_unsubscribe(const int id, const long type);
+
+/**
+ * @name  nipc_subscribe_poll()
+ * @brief  Subscribes the calling process to the opened NIPC instance identified by `id` under the specified type `type`, leaving messages pending until it receives them with `nipc_recv()` or `nipc_recv_many()`.
+ * @param  id  {const int}  The ID of the NIPC instance to subscribe to.
+ * @param  type  {const long}  The multicast channel to subscribe to.
+ * @remarks  No signal is sent to the process and no thread is started for it; senders notify it through the descriptor returned by `nipc_fd()` instead, so it can wait for messages alongside its other I/O with `poll()`, `epoll` or `io_uring`.
+ * @remarks  Subscribing again adds the channel to those the calling process follows on this instance, up to `NIPC_MAX_CHANNELS`.  A process subscribes to an instance either with a notification handler or this way, not both.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0, or already subscribed to the instance with a notification handler.
+ * @throws  ENOMEM  If the descriptor or the receive buffer could not be allocated.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_SUBSCRIBERS` subscribers or channels, or the process already follows `NIPC_MAX_CHANNELS` channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_subscribe_poll(const int id, const long type);
+
+/**
+ * @name  nipc_fd()
+ * @brief  Returns the descriptor that becomes readable when messages are pending for the calling process on the NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remarks  The descriptor stays readable until `nipc_recv()` or `nipc_recv_many()` finds nothing left to receive, so it may be waited on either level- or edge-triggered as long as the process receives until they fail with `EAGAIN`.
+ * @remarks  The descriptor belongs to the library; it must not be read from or closed, and it is closed by `nipc_close()`.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
- * @throws  EINVAL  If the process attempts to subscribe to a channel greater than 0.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`.
+ * @return  {const int}  The descriptor on success, `-1` on failure.
+ */
+const int nipc_fd(const int id);
+
+/**
+ * @name  nipc_recv()
+ * @brief  Receives the next message pending for the calling process on the NIPC instance identified by `id`, without blocking.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  msg  {nipc_message* const}  The buffer to copy the message to.
+ * @remarks  A payload held in the instance's slab is only valid until the next call to `nipc_recv()`, `nipc_recv_many()` or `nipc_close()` on the instance.
+ * @remarks  The messages of an instance must be received from one thread at a time.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`, or `msg` is `nullptr`.
+ * @throws  EAGAIN  If no message is pending.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_subscribe(const int id, const long type, nipc_handler_t handler);
+const int nipc_recv(const int id, nipc_message* const msg);
+
+/**
+ * @name  nipc_recv_many()
+ * @brief  Receives up to `capacity` messages pending for the calling process on the NIPC instance identified by `id`, in order, without blocking.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  msgs  {nipc_message* const}  The buffers to copy the messages to.
+ * @param  capacity  {const size_t}  The number of messages `msgs` can hold.
+ * @remarks  A payload held in the instance's slab is only valid until the next call to `nipc_recv()`, `nipc_recv_many()` or `nipc_close()` on the instance.
+ * @remarks  The messages of an instance must be received from one thread at a time.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process did not subscribe to the instance with `nipc_subscribe_poll()`, or `msgs` is `nullptr` or `capacity` is `0`.
+ * @throws  EAGAIN  If no message is pending.
+ * @return  {const int}  The number of messages received on success, `-1` on failure.
+ */
+const int nipc_recv_many(const int id, nipc_message* const msgs, const size_t capacity);
+
+/**
+ * @name  nipc_conflate()
+ * @brief  Makes the multicast channel `type` of the NIPC instance identified by `id` a conflated channel, which only keeps the latest message sent on it.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  type  {const long}  The multicast channel to conflate.
+ * @remarks  Every message sent on a conflated channel overwrites the channel's slot in the instance's shared memory segment instead of being queued, and its subscribers are only notified if they already read the previous value; when they drain, they receive the latest value once, however many were sent meanwhile.  The backlog of a conflated channel is thus a single message, whatever the rate it is published at.
+ * @remarks  A process subscribing to a conflated channel that already has a value receives it.  Values of conflated channels are received ahead of the messages queued for the process.
+ * @remarks  A channel stays conflated for the life of the instance; conflating it again has no effect.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `type` is not a multicast channel.
+ * @throws  ENOSPC  If the NIPC instance already has `NIPC_MAX_CONFLATED` conflated channels.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_conflate(const int id, const long type);
+
+/**
+ * @name  nipc_message_release()
+ * @brief  Releases a message buffer handed to a notification handler.
+ * @param  msg  {nipc_message* const}  The message buffer to release; `nullptr` is ignored.
+ * @remark  The buffer is returned to the process's message pool; a buffer that does not come from it is ignored.  If messages were left pending because the pool ran dry, they are delivered again.
+ * @remark  This function is lock-free and async-signal-safe, and may be called from any thread.
+ */
+void nipc_message_release(nipc_message* const msg);
 
 /**
  * @name  nipc_send()
@@ -110,20 +799,198 @@ const int nipc_subscribe(const int id, const long type, nipc_handler_t handler);
  * @param  msg  {const nipc_message}  The message to send to the NIPC instance.
  * @param  type  {const long}  The channel on which to send the message.  If `type` is `0`, the message is broadcast to all subscribers of this NIPC instance.  If `type` is greater than 0, the message will be sent to the process whose process ID matches `type` (also known as a unicast).  If `type` is less than 0, the message will be sent to all processes subscribed to the channel whose channel ID matches `type` (also known as a multicast).
  * @remark  Once the message is sent, all subscribers of the NIPC instance will be notified of the message.
+ * @remark  The recipients are resolved from a consistent snapshot of the subscriber registry taken without locking it.
+ * @remark  A payload larger than `NIPC_INLINE_SIZE` bytes is copied once into the instance's slab and shared by every recipient; only its location crosses the transport.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  A recipient that cannot be reached does not stop the message from being delivered to the others; the error reported is that of the first failure.
+ * @remark  A recipient found to have died without closing the instance is reaped instead; neither it nor one that closed the instance during the send fails the send.  See `nipc_reap()`.
+ * @remark  A recipient that has used up its quota, or finds the message queue full, is handled according to the instance's overflow policy, so a slow subscriber does not hold up the others unless the policy is to wait for it.
+ * @remark  On a conflated channel, the message overwrites the channel's latest value instead; see `nipc_conflate()`.
+ * @remark  If the instance logs, the message is appended to the log before it is delivered, even if no process receives it.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If the payload is larger than the instance's slab, or the message does not fit in a log segment.
+ * @throws  EIO  If the message could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for the payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
  * @throws  ENODATA  If the target channel has no subscribers.
  * @throws  ENOMEM  If the message could not be sent due to a lack of memory.
- * @throws  ESRCH  If a target process could not be notified of the message.
+ * @throws  ESRCH  If a target process that is still subscribed could not be notified of the message.
+ * @throws  EAGAIN  If a target process had no room for the message and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
-const int nipc_send(const int id, const nipc_message msg, const long type);
+const int nipc_send(const int id, const nipc_message msg, const long type, const int flags = 0);
+
+/**
+ * @name  nipc_send_batch()
+ * @brief  Sends the `n` messages `msgs` to the NIPC instance identified by `id`, in order.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the messages to.
+ * @param  msgs  {const nipc_message* const}  The messages to send to the NIPC instance.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  type  {const long}  The channel on which to send the messages, as for `nipc_send()`.
+ * @param  deliveries  {nipc_delivery* const}  An array to report the outcome for every recipient in, or `nullptr`.
+ * @param  capacity  {const size_t}  The number of entries `deliveries` can hold; the outcomes of any further recipients are not reported.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  The recipients are resolved once for the whole batch.  With `NIPC_TRANSPORT_QUEUE`, as many messages as fit are packed into every message queue write; with `NIPC_TRANSPORT_RING`, they are written to the ring in runs of consecutive slots claimed at once.
+ * @remark  If the instance logs, the messages are appended to it at once under consecutive sequence numbers, before they are delivered.
+ * @remark  Every recipient is notified once, after all of its messages have been delivered; only if the message queue fills up are recipients notified early so that they make room.
+ * @remark  A recipient that cannot be reached does not stop the messages from being delivered to the others, and one found to have died without closing the instance, or to have closed it during the send, is reported with `ESRCH` without failing the send; the dead are reaped.  If a message cannot be sent at all, for example because the slab is full, the batch stops before it, and every recipient has been delivered the messages before it.
+ * @remark  A recipient that has used up its quota, or finds the message queue full, is handled according to the instance's overflow policy; with `NIPC_OVERFLOW_DROP_NEWEST`, it is delivered no more of the batch's messages once one of them was dropped.
+ * @remark  On a conflated channel, only the last message of the batch is kept, as the channel's latest value; every recipient counts as delivered the whole batch.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a payload is larger than the instance's slab, or a message does not fit in a log segment.
+ * @throws  EIO  If the messages could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for a payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @throws  ENODATA  If the target channel has no subscribers.
+ * @throws  ENOMEM  If the messages could not be sent to a recipient due to a lack of memory.
+ * @throws  ESRCH  If a recipient that is still subscribed could not be notified of the messages.
+ * @throws  EAGAIN  If a recipient had no room for the messages and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  The number of recipients if every message was delivered to every one of them, or dropped by the overflow policy, `-1` otherwise; the error reported is that of the first failure.
+ */
+const int nipc_send_batch(const int id, const nipc_message* const msgs, const size_t n, const long type, nipc_delivery* const deliveries = nullptr, const size_t capacity = 0, const int flags = 0);
+
+/**
+ * @name  nipc_send_channels()
+ * @brief  Sends the `n` messages `msgs` to every subscriber of any of the `count` multicast channels `channels` of the NIPC instance identified by `id`, in order.
+ * @param  id  {const int}  The ID of the NIPC instance to the send the messages to.
+ * @param  msgs  {const nipc_message* const}  The messages to send to the NIPC instance.
+ * @param  n  {const size_t}  The number of messages.
+ * @param  channels  {const long* const}  The multicast channels to send the messages on.
+ * @param  count  {const size_t}  The number of channels.
+ * @param  deliveries  {nipc_delivery* const}  An array to report the outcome for every recipient in, or `nullptr`.
+ * @param  capacity  {const size_t}  The number of entries `deliveries` can hold; the outcomes of any further recipients are not reported.
+ * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+ * @remark  The recipients are the union of the subscribers of the channels, so a subscriber following several of them gets each message once.  Otherwise, the messages are delivered as with `nipc_send_batch()`.
+ * @remark  With `NIPC_TRANSPORT_RING`, messages sent on more than one channel are written to the ring once per recipient.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If no channel is given, a channel is not a multicast channel or is conflated, or a message is larger than `NIPC_INLINE_SIZE` bytes but has no `blob`, or its `priority` is not below `NIPC_LANES`.
+ * @throws  EMSGSIZE  If a payload is larger than the instance's slab, or a message does not fit in a log segment.
+ * @throws  EIO  If the messages could not be logged.
+ * @throws  ENOBUFS  If the instance's slab does not have room for a payload at the moment.
+ * @throws  ENOLCK  If the instance's slab could not be locked.
+ * @throws  ENODATA  If none of the channels has subscribers.
+ * @throws  ENOMEM  If the messages could not be sent to a recipient due to a lack of memory.
+ * @throws  ESRCH  If a recipient that is still subscribed could not be notified of the messages.
+ * @throws  EAGAIN  If a recipient had no room for the messages and the overflow policy or `NIPC_NONBLOCK` says not to wait for it.
+ * @return  {const int}  The number of recipients if every message was delivered to every one of them, or dropped by the overflow policy, `-1` otherwise; the error reported is that of the first failure.
+ */
+const int nipc_send_channels(const int id, const nipc_message* const msgs, const size_t n, const long* const channels, const size_t count, nipc_delivery* const deliveries = nullptr, const size_t capacity = 0, const int flags = 0);
+
+/**
+ * @name  nipc_listen()
+ * @brief  Lets the calling process answer calls made to it on the opened NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remark  Calls bypass subscriptions and notification handlers entirely; the process takes them with `nipc_accept()` on threads of its own.  Listening again has no effect.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  ENOSPC  If `NIPC_MAX_RESPONDERS` processes already listen on the instance.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_listen(const int id);
+
+/**
+ * @name  nipc_accept()
+ * @brief  Takes the next call made to the calling process on the NIPC instance identified by `id`, waiting for one if need be.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  request  {nipc_message* const}  The buffer to copy the request to.
+ * @param  call  {uint64_t* const}  Set to the handle of the call, to pass to `nipc_reply()`.
+ * @param  timeout  {const int}  The number of milliseconds to wait for a call; `-1` waits indefinitely and `0` does not wait.
+ * @remark  The thread spins briefly before sleeping on a futex, so a call made while it is busy is taken without a system call.  Any number of threads may accept calls at once.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If the process does not listen on the instance, or `request` or `call` is `nullptr`.
+ * @throws  EAGAIN  If `timeout` is `0` and no call is pending.
+ * @throws  ETIMEDOUT  If no call was made within `timeout` milliseconds.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_accept(const int id, nipc_message* const request, uint64_t* const call, const int timeout = -1);
+
+/**
+ * @name  nipc_reply()
+ * @brief  Answers a call taken with `nipc_accept()`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  call  {const uint64_t}  The handle of the call.
+ * @param  reply  {const nipc_message&}  The reply; its payload must fit inline.
+ * @remark  The reply is written straight into the caller's slot, and the caller is only woken by a system call if it stopped spinning.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `call` is not the handle of a call taken with `nipc_accept()`.
+ * @throws  EMSGSIZE  If the reply is larger than `NIPC_INLINE_SIZE` bytes.
+ * @throws  ECANCELED  If the caller gave up on the call, or it was already answered.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_reply(const int id, const uint64_t call, const nipc_message& reply);
+
+/**
+ * @name  nipc_call()
+ * @brief  Sends a request to the process `pid` listening on the NIPC instance identified by `id` and waits for its reply.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  pid  {const pid_t}  The PID of the process to call.
+ * @param  request  {const nipc_message&}  The request; its payload must fit inline.
+ * @param  reply  {nipc_message* const}  The buffer to copy the reply to.
+ * @param  timeout  {const int}  The number of milliseconds to wait for the reply; `-1` waits indefinitely.
+ * @remark  The call takes a slot of the instance for the request and its reply, starting with the one the calling thread used last, and tags it with a fresh correlation number, so that a late reply to an abandoned call is never mistaken for the reply to the next one.
+ * @remark  The caller spins briefly before sleeping on a futex, so a quick reply is picked up without a system call.  While asleep, it checks every few milliseconds that the callee still listens.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `reply` is `nullptr`.
+ * @throws  EMSGSIZE  If the request is larger than `NIPC_INLINE_SIZE` bytes.
+ * @throws  ESRCH  If `pid` does not listen on the instance, or stopped listening before replying.
+ * @throws  EBUSY  If `NIPC_MAX_CALLS` calls are already in flight on the instance.
+ * @throws  ETIMEDOUT  If no reply came within `timeout` milliseconds.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_call(const int id, const pid_t pid, const nipc_message& request, nipc_message* const reply, const int timeout = -1);
+
+/**
+ * @name  nipc_stats()
+ * @brief  Takes a snapshot of the counters of the NIPC instance identified by `id`.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  stats  {nipc_instance_stats* const}  The buffer to write the counters of the instance to.
+ * @param  subscribers  {nipc_subscriber_stats* const}  An array to write the counters of every subscriber to, or `nullptr`.
+ * @param  subscriber_capacity  {const size_t}  The number of entries `subscribers` can hold; `stats->subscribers` tells how many there are.
+ * @param  channels  {nipc_channel_stats* const}  An array to write the counters of every multicast channel to, or `nullptr`.
+ * @param  channel_capacity  {const size_t}  The number of entries `channels` can hold; `stats->channels` tells how many there are.
+ * @remark  The counters live in the instance's shared memory segment and are updated with relaxed atomic operations on the way through, so any process that opened the instance can read them without disturbing the senders and subscribers.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  EINVAL  If `stats` is `nullptr`.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_stats(const int id, nipc_instance_stats* const stats, nipc_subscriber_stats* const subscribers = nullptr, const size_t subscriber_capacity = 0, nipc_channel_stats* const channels = nullptr, const size_t channel_capacity = 0);
+
+/**
+ * @name  nipc_trace_dump()
+ * @brief  Exports the trace buffers of every process of the NIPC instance identified by `id` as a Chrome trace.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @param  fd  {const int}  The file descriptor to write the trace to.
+ * @remark  The trace is a JSON object in the Chrome trace event format, which Perfetto and `chrome://tracing` open.  Every stage is a complete event on the thread that ran it: `send.resolve`, `send.write` and `send.notify` in senders, and `receive` and `handler` in subscribers.  Flow arrows link each send to the first handler invocation that handles one of its messages.
+ * @remark  The buffers are read while processes may still be writing to them; events being written at that moment are skipped.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @throws  ENODATA  If the instance was created without tracing.
+ * @throws  EIO  If the trace could not be written.
+ * @return  {const int}  `0` on success, `-1` on failure.
+ */
+const int nipc_trace_dump(const int id, const int fd);
+
+/**
+ * @name  nipc_reap()
+ * @brief  Removes the subscribers of the NIPC instance identified by `id` that died without closing it, and purges the messages left in their inboxes.
+ * @param  id  {const int}  The ID of the NIPC instance.
+ * @remark  Senders already do this on their own, at most once every 100 ms across the instance, and as soon as a recipient is found dead; this forces it.
+ * @remark  The payloads of purged messages are released from the slab.  Those a subscriber had already taken off its inbox when it died cannot be, and stay allocated.
+ * @remark  A process is only known to be dead once its PID no longer exists, so a subscriber whose PID was already reused by another process is not reaped.
+ * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+ * @return  {const int}  The number of subscribers reaped on success, `-1` on failure.
+ */
+const int nipc_reap(const int id);
 
 /**
  * @name  nipc_close()
  * @brief  Unsubscribes the calling process from the NIPC instance identified by `id`. A closed NIPC instance cannot be used unless opened again.
  * @param  id  {const int}  The ID of the NIPC instance to unsubscribe from.
+ * @remark  If the process listens for calls on the instance, it stops; callers waiting on it fail with `ESRCH`.
+ * @remark  Messages still waiting in the process's inbox are purged.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
  * @throws  ENOMEM  If the NIPC instance could not be closed due to a memory error.
+ * @throws  ENOLCK  If the subscriber registry could not be locked.
  * @return  {const int}  `0` on success, `-1` on failure.
  */
 const int nipc_close(const int id);
@@ -132,6 +999,7 @@ const int nipc_close(const int id);
  * @name  nipc_remove()
  * @brief  Removes an NIPC instance identified by `_key` from the system.
  * @param  id  {const int}  The ID of the NIPC instance to remove.
+ * @remark  Every shard of the instance's message queue is removed.  The instance's log, if any, is left on disk so that it can be replayed by an instance created with the same `log_path`.
  * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
  * @throws  ENOMEM  If the NIPC instance could not be removed due to a memory error.
  * @return  {const int}  `0` on success, `-1` on failure.
@@ -0,0 +1,263 @@
+// src/NIPC_channel.h
+
+/**
+ * @file  src/NIPC_channel.h
+ * @brief  Typed channels over a Notifier Inter-Process Communication (NIPC) instance
+ * @date  26/12/2023
+ * @version  1.0.0
+ */
+
+#pragma once
+
+#ifndef NIPC_CHANNEL_H
+#define NIPC_CHANNEL_H
+
+#include "NIPC.h"		// nipc_message, nipc_send_batch, nipc_subscribe_poll, nipc_unsubscribe, nipc_recv_many, nipc_fd
+#include <cstddef>		// size_t
+#include <cstring>		// memcpy
+#include <cerrno>		// errno, EAGAIN
+#include <memory>		// std::unique_ptr
+#include <new>			// std::launder
+#include <type_traits>		// std::is_trivially_copyable, std::is_invocable, std::decay_t
+#include <unordered_map>	// std::unordered_map
+#include <utility>		// std::forward, std::move
+#include <unistd.h>		// getpid
+
+namespace nipc
+{
+	namespace detail
+	{
+		/**
+		 * @name  sink
+		 * @brief  The handler of a typed channel, with its type erased.
+		 */
+		struct sink
+		{
+			virtual ~sink() = default;
+
+			/**
+			 * @name  deliver()
+			 * @brief  Hands a received message to the handler if its payload has the channel's type.
+			 * @param  message  {const nipc_message&}  The message.
+			 * @return  {const bool}  `true` if the message was handled, `false` if its length does not match the channel's type.
+			 */
+			virtual const bool deliver(const nipc_message& message) = 0;
+		};
+
+		/**
+		 * @name  typed_sink
+		 * @brief  The handler of a channel of `T`.
+		 * @remark  The callable is moved in, so move-only callables such as lambdas capturing a `std::unique_ptr` are accepted.
+		 */
+		template <typename T, typename F>
+		struct typed_sink final : sink
+		{
+			/**
+			 * @name  {F}  handler
+			 * @brief  The callable invoked with every value received.
+			 */
+			F handler;
+
+			/**
+			 * @name  typed_sink()
+			 * @brief  Constructs the handler of a channel from a callable.
+			 * @param  _handler  {F&&}  The callable.
+			 */
+			explicit typed_sink(F&& _handler) : handler(std::move(_handler)) {}
+
+			const bool deliver(const nipc_message& message) override
+			{
+				// Reject payloads that are not exactly a `T`.
+				if (message.length != sizeof(T)) return false;
+
+				// Copy the payload into suitably aligned storage and hand it over.
+				alignas(T) unsigned char storage[sizeof(T)]; // The value received.
+				memcpy(storage, message.payload(), sizeof(T));
+				handler(*std::launder(reinterpret_cast<const T*>(storage)));
+				return true;
+			}
+		};
+
+		/**
+		 * @name  routes
+		 * @brief  The handlers of the typed channels this process subscribed to, by ID of their NIPC instance and then by channel.
+		 */
+		inline std::unordered_map<int, std::unordered_map<long, std::unique_ptr<sink>>> routes;
+	}
+
+	/**
+	 * @name  dispatch()
+	 * @brief  Receives every message pending for this process on the NIPC instance identified by `id` and hands each to the handler of its typed channel.
+	 * @param  id  {const int}  The ID of the NIPC instance.
+	 * @remark  Call it whenever `nipc_fd(id)` becomes readable.  Messages are routed by their `channel`; those on a channel without a typed handler, or whose length does not match its type, are dropped.
+	 * @throws  ENOENT  If the NIPC instance does not exist or it has not been opened.
+	 * @throws  EINVAL  If the process did not subscribe to the instance through a typed channel.
+	 * @return  {const int}  The number of messages handled on success, `-1` on failure.
+	 */
+	inline const int dispatch(const int id)
+	{
+		nipc_message batch[NIPC_BATCH_SIZE]; // The messages received.
+		int handled = 0; // The number of messages handled.
+
+		// Receive batches until none is left, looking up the handlers again for every batch in case a handler changed them.
+		for (int count; (count = nipc_recv_many(id, batch, NIPC_BATCH_SIZE)) != -1;)
+		{
+			const std::unordered_map<int, std::unordered_map<long, std::unique_ptr<detail::sink>>>::iterator table = detail::routes.find(id); // The handlers of the instance.
+			for (int index = 0; table != detail::routes.end() && index < count; ++index)
+			{
+				const std::unordered_map<long, std::unique_ptr<detail::sink>>::iterator route = table->second.find(batch[index].channel); // The handler of the message's channel.
+				if (route != table->second.end() && route->second->deliver(batch[index])) ++handled;
+			}
+		}
+
+		// Running out of messages is the expected way out.
+		return errno == EAGAIN ? handled : -1;
+	}
+
+	/**
+	 * @name  channel
+	 * @brief  A multicast channel of a NIPC instance carrying values of type `T`.
+	 * @remark  `T` must be trivially copyable.  Exactly `sizeof(T)` bytes are copied per message, and whether they travel inline or through the instance's slab is decided at compile time.
+	 * @remark  Received values are handed to a typed handler by `dispatch()`, which drains a subscription made with `nipc_subscribe_poll()`; a process that subscribed to the instance with a notification handler cannot subscribe through a typed channel as well.
+	 */
+	template <typename T>
+	class channel
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "The values of a typed channel must be trivially copyable.");
+		static_assert(sizeof(T) <= UINT32_MAX, "The values of a typed channel must fit in a message.");
+
+	public:
+		// The number of bytes every message of the channel carries.
+		static constexpr size_t payload_size = sizeof(T);
+
+		// Whether the values travel inline in the message rather than through the instance's slab.
+		static constexpr bool is_inline = sizeof(T) <= NIPC_INLINE_SIZE;
+
+		/**
+		 * @name  channel()
+		 * @brief  Binds a typed channel to a multicast channel of an opened NIPC instance.
+		 * @param  _id  {const int}  The ID of the NIPC instance.
+		 * @param  _type  {const long}  The multicast channel, such as `NIPC_MULTICAST(1)`.
+		 */
+		channel(const int _id, const long _type) : id(_id), type(_type) {}
+
+		/**
+		 * @name  send()
+		 * @brief  Sends a value on the channel.
+		 * @param  value  {const T&}  The value to send.
+		 * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+		 * @throws  Any error of `nipc_send_batch()`.
+		 * @return  {const int}  `0` on success, `-1` on failure.
+		 */
+		const int send(const T& value, const int flags = 0) const
+		{
+			nipc_message message; // The message carrying the value.
+			pack(value, getpid(), &message);
+			return nipc_send_batch(id, &message, 1, type, nullptr, 0, flags) == -1 ? -1 : 0;
+		}
+
+		/**
+		 * @name  send()
+		 * @brief  Sends `n` values on the channel, in order.
+		 * @param  values  {const T* const}  The values to send.
+		 * @param  n  {const size_t}  The number of values.
+		 * @param  flags  {const int}  `NIPC_NONBLOCK` to never wait for a recipient, or `0`.
+		 * @remark  The values are sent in batches of up to `NIPC_BATCH_SIZE` with `nipc_send_batch()`; sending stops at the first batch that fails.
+		 * @throws  Any error of `nipc_send_batch()`.
+		 * @return  {const int}  `0` on success, `-1` on failure.
+		 */
+		const int send(const T* const values, const size_t n, const int flags = 0) const
+		{
+			nipc_message batch[NIPC_BATCH_SIZE]; // The messages carrying the values.
+			const pid_t sender = getpid(); // The PID of this process.
+			for (size_t sent = 0; sent < n;)
+			{
+				const size_t count = n - sent < NIPC_BATCH_SIZE ? n - sent : NIPC_BATCH_SIZE; // The number of values in the batch.
+				for (size_t index = 0; index < count; ++index) pack(values[sent + index], sender, &batch[index]);
+				if (nipc_send_batch(id, batch, count, type, nullptr, 0, flags) == -1) return -1;
+				sent += count;
+			}
+			return 0;
+		}
+
+		/**
+		 * @name  subscribe()
+		 * @brief  Subscribes the calling process to the channel, handing every value received to `handler`.
+		 * @param  handler  {F&&}  A callable taking a `const T&`; it is moved in and may be move-only.
+		 * @remark  Values are only handed over by `dispatch()`.  Subscribing again replaces the channel's handler.
+		 * @throws  Any error of `nipc_subscribe_poll()`.
+		 * @return  {const int}  `0` on success, `-1` on failure.
+		 */
+		template <typename F>
+		const int subscribe(F&& handler)
+		{
+			static_assert(std::is_invocable<std::decay_t<F>&, const T&>::value, "The handler of a typed channel must be callable with a const T&.");
+
+			// Install the handler before subscribing so that no value is missed, and remove it again if subscribing fails.
+			std::unordered_map<long, std::unique_ptr<detail::sink>>& table = detail::routes[id]; // The handlers of the instance.
+			std::unique_ptr<detail::sink> previous = std::move(table[type]); // The handler being replaced, if any.
+			table[type].reset(new detail::typed_sink<T, std::decay_t<F>>(std::decay_t<F>(std::forward<F>(handler))));
+			if (nipc_subscribe_poll(id, type) == -1)
+			{
+				if (previous) table[type] = std::move(previous);
+				else table.erase(type);
+				return -1;
+			}
+			return 0;
+		}
+
+		/**
+		 * @name  unsubscribe()
+		 * @brief  Unsubscribes the calling process from the channel and drops its handler.
+		 * @throws  Any error of `nipc_unsubscribe()`.
+		 * @return  {const int}  `0` on success, `-1` on failure.
+		 */
+		const int unsubscribe()
+		{
+			const std::unordered_map<int, std::unordered_map<long, std::unique_ptr<detail::sink>>>::iterator table = detail::routes.find(id); // The handlers of the instance.
+			if (table != detail::routes.end()) table->second.erase(type);
+			return nipc_unsubscribe(id, type);
+		}
+
+		/**
+		 * @name  fd()
+		 * @brief  Returns the descriptor that becomes readable when a value is pending on the channel's instance.
+		 * @return  {const int}  As for `nipc_fd()`.
+		 */
+		const int fd() const { return nipc_fd(id); }
+
+		/**
+		 * @name  dispatch()
+		 * @brief  Hands every value pending on the channel's instance to the handlers of their channels.
+		 * @return  {const int}  As for `nipc::dispatch()`.
+		 */
+		const int dispatch() const { return nipc::dispatch(id); }
+
+	private:
+		/**
+		 * @name  pack()
+		 * @brief  Fills in a message carrying a value.
+		 * @param  value  {const T&}  The value.
+		 * @param  sender  {const pid_t}  The PID of this process.
+		 * @param  message  {nipc_message* const}  The message to fill in.
+		 * @remark  Only `sizeof(T)` bytes are copied; a value too large to travel inline is referenced and copied once into the slab when sent.
+		 */
+		void pack(const T& value, const pid_t sender, nipc_message* const message) const
+		{
+			message->channel = type;
+			message->sender = sender;
+			message->length = sizeof(T);
+			if constexpr (is_inline) memcpy(message->data, &value, sizeof(T));
+			else message->blob = &value;
+		}
+
+		// The ID of the NIPC instance.
+		int id;
+
+		// The multicast channel.
+		long type;
+	};
+}
+
+#endif  // NIPC_CHANNEL_H
+// End of src/NIPC_channel.h
@@ -0,0 +1,186 @@
+// tests/test.h
+
+/**
+ * @file  tests/test.h
+ * @brief  Helpers shared by the NIPC test cases
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Every test case forks the processes it needs, checks what they see with `CHECK()`, and exits with `EXIT_FAILURE` if any check failed in it or in one of its children.
+ */
+
+#pragma once
+
+#ifndef NIPC_TEST_H
+#define NIPC_TEST_H
+
+#include <cstdio>		// printf, fprintf, fflush, perror
+#include <cstdlib>		// exit, EXIT_SUCCESS, EXIT_FAILURE
+#include <ctime>		// clock_gettime, nanosleep, CLOCK_MONOTONIC
+#include <unistd.h>		// fork, pipe, read, write, close, _exit
+#include <sys/wait.h>		// waitpid, WIFEXITED, WEXITSTATUS
+
+// Checks that a condition holds, reporting it and counting a failure if it does not.
+#define CHECK(condition) test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace test
+{
+	/**
+	 * @name  failures
+	 * @brief  The number of checks that failed in this process.
+	 */
+	inline int failures = 0;
+
+	/**
+	 * @name  check()
+	 * @brief  Counts and reports a failed check.
+	 * @param  passed  {const bool}  Whether the check passed.
+	 * @param  condition  {const char* const}  The text of the condition checked.
+	 * @param  file  {const char* const}  The file the check is in.
+	 * @param  line  {const int}  The line the check is on.
+	 * @return  {const bool}  `passed`.
+	 */
+	inline const bool check(const bool passed, const char* const condition, const char* const file, const int line)
+	{
+		if (passed) return true;
+		fprintf(stderr, "%s:%d: check failed in process %d: %s\n", file, line, static_cast<int>(getpid()), condition);
+		fflush(stderr);
+		++failures;
+		return false;
+	}
+
+	/**
+	 * @name  now()
+	 * @brief  Reads the monotonic clock.
+	 * @return  {const double}  The time in milliseconds.
+	 */
+	inline const double now()
+	{
+		timespec time; // The current time.
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+	}
+
+	/**
+	 * @name  sleep()
+	 * @brief  Sleeps for a number of milliseconds.
+	 * @param  milliseconds  {const long}  The time to sleep.
+	 */
+	inline void sleep(const long milliseconds)
+	{
+		const timespec time = { milliseconds / 1000, (milliseconds % 1000) * 1000000L }; // The time to sleep.
+		nanosleep(&time, nullptr);
+	}
+
+	/**
+	 * @name  wait_until()
+	 * @brief  Polls a condition until it holds or a deadline passes.
+	 * @param  condition  {const Condition&}  The condition, a callable returning `bool`.
+	 * @param  timeout  {const long}  The number of milliseconds to wait for.
+	 * @return  {const bool}  Whether the condition held in time.
+	 */
+	template <typename Condition> const bool wait_until(const Condition& condition, const long timeout = 5000)
+	{
+		for (const double deadline = now() + timeout; !condition(); sleep(1)) if (now() > deadline) return condition();
+		return true;
+	}
+
+	/**
+	 * @name  gate
+	 * @brief  A pair of pipes a parent and its children use to wait for each other.
+	 * @remark  Each direction has its own pipe, so a process never reads back the byte it posted itself.  The gate must be created before forking.
+	 * @remark  Children let through may reach the next step before the others woke up, so several children must wait at a different gate at every step.
+	 */
+	struct gate
+	{
+		// The pipe the children post to and the parent waits on.
+		int up[2];
+
+		// The pipe the parent posts to and the children wait on.
+		int down[2];
+
+		/**
+		 * @name  gate()
+		 * @brief  Creates the pipes of a gate.
+		 */
+		gate() { if (pipe(up) == -1 || pipe(down) == -1) { perror("pipe"); exit(EXIT_FAILURE); } }
+
+		/**
+		 * @name  ~gate()
+		 * @brief  Closes the pipes of a gate.
+		 */
+		~gate() { close(up[0]); close(up[1]); close(down[0]); close(down[1]); }
+
+		gate(const gate&) = delete;
+		gate& operator=(const gate&) = delete;
+
+		/**
+		 * @name  post_up()
+		 * @brief  Lets the parent know a child reached a point.
+		 */
+		void post_up() const { const char byte = 'x'; if (write(up[1], &byte, 1) != 1) _exit(EXIT_FAILURE); }
+
+		/**
+		 * @name  wait_up()
+		 * @brief  Waits for `count` children to reach a point.
+		 * @param  count  {const int}  The number of children.
+		 */
+		void wait_up(const int count = 1) const { char byte; for (int index = 0; index < count; ++index) if (read(up[0], &byte, 1) != 1) exit(EXIT_FAILURE); }
+
+		/**
+		 * @name  post_down()
+		 * @brief  Lets `count` children go on.
+		 * @param  count  {const int}  The number of children.
+		 */
+		void post_down(const int count = 1) const { const char byte = 'x'; for (int index = 0; index < count; ++index) if (write(down[1], &byte, 1) != 1) exit(EXIT_FAILURE); }
+
+		/**
+		 * @name  wait_down()
+		 * @brief  Waits for the parent to let the child go on.
+		 */
+		void wait_down() const { char byte; if (read(down[0], &byte, 1) != 1) _exit(EXIT_FAILURE); }
+	};
+
+	/**
+	 * @name  spawn()
+	 * @brief  Forks a child that runs `body` and exits, failing if any of its own checks failed.
+	 * @param  body  {const Body&}  The code the child runs.
+	 * @return  {const pid_t}  The PID of the child.
+	 */
+	template <typename Body> const pid_t spawn(const Body& body)
+	{
+		fflush(stdout);
+		const pid_t pid = fork(); // The PID of the child.
+		if (pid == -1) { perror("fork"); exit(EXIT_FAILURE); }
+		if (pid) return pid;
+		failures = 0;
+		body();
+		fflush(stdout);
+		_exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+
+	/**
+	 * @name  join()
+	 * @brief  Waits for a child to exit.
+	 * @param  pid  {const pid_t}  The PID of the child.
+	 * @return  {const bool}  Whether the child exited successfully.
+	 */
+	inline const bool join(const pid_t pid)
+	{
+		int status; // The exit status of the child.
+		return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+	}
+
+	/**
+	 * @name  finish()
+	 * @brief  Reports the outcome of a test case and exits with it.
+	 * @param  name  {const char* const}  The name of the test case.
+	 */
+	[[noreturn]] inline void finish(const char* const name)
+	{
+		printf("%s: %s\n", name, failures ? "failed" : "passed");
+		exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+}
+
+#endif  // NIPC_TEST_H
+// End of tests/test.h
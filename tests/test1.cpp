@@ -1,32 +1,117 @@
-//TODO: do
-
-// tests/test1.c
+// tests/test1.cpp
 
 /**
- * @file  tests/test1.c
- * @brief  NIPC test case number 1
+ * @file  tests/test1.cpp
+ * @brief  NIPC test case number 1: registering and unregistering subscribers
  * @date  26/12/2023
  * @version  1.0.0
+ * @remark  Several processes subscribe to one of two channels and close the instance; every message must reach each subscriber of its channel exactly once, nothing must reach a process that closed the instance, and entries must be reusable afterwards.
  */
 
-#include <stdio.h>		// printf
-#include <stdlib.h>		// exit
-#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+#include <cerrno>		// errno, EEXIST, EINVAL, ENOENT, ENODATA
+#include <atomic>		// std::atomic
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495001;
+
+// The number of subscribing processes.
+const int CHILDREN = 8;
+
+// The number of messages sent in each round: a multicast to each channel, then a broadcast.
+const int STEPS = 3;
 
+// The number of messages this process was handed.
+std::atomic<int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts and releases every message received.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  expected()
+ * @brief  Computes the number of messages a child should have received once a step is over.
+ * @param  child  {const int}  The index of the child; even children follow channel 1 and odd ones channel 2.
+ * @param  step  {const int}  The index of the step.
+ * @return  {const int}  The number of messages.
+ */
+const int expected(const int child, const int step) { return step == 0 ? child % 2 == 0 : step; }
 
 int main(const int argc, const char* const argv[], const char* const envp[])
 {
-	exit(EXIT_SUCCESS);
+	// Create the instance; a second instance with the same key is refused.
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY) == 0);
+	CHECK(nipc_create(KEY) == -1 && errno == EEXIST);
+	const int id = nipc_get(KEY); // The ID of the instance.
+	CHECK(id != -1);
+	CHECK(nipc_get(KEY + 1) == -1 && errno == ENOENT);
 
-	
-}
+	// Only multicast channels can be subscribed to, and nothing can be sent before anyone subscribed.
+	CHECK(nipc_subscribe(id, 1, handler) == -1 && errno == EINVAL);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "nobody"), NIPC_BROADCAST) == -1 && errno == ENODATA);
+
+	for (int round = 0; round < 2; ++round)
+	{
+		// Every child follows channel 1 or 2, subscribing twice to check that it is registered once.
+		const test::gate joined; // The gate the children wait at once they subscribed.
+		const test::gate steps[STEPS]; // The gates the children wait at once they received the message of a step.
+		const test::gate closed; // The gate the children wait at once they closed the instance.
+		pid_t children[CHILDREN]; // The PIDs of the children.
+		for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+		{
+			const int id = nipc_get(KEY); // The ID of the instance.
+			const long channel = 1 + child % 2; // The channel the child follows.
+			CHECK(nipc_subscribe(id, NIPC_MULTICAST(channel), handler) == 0);
+			CHECK(nipc_subscribe(id, NIPC_MULTICAST(channel), handler) == 0);
+			joined.post_up();
+			for (int step = 0; step < STEPS; ++step)
+			{
+				steps[step].wait_down();
+				CHECK(test::wait_until([&]() { return received == expected(child, step); }));
+				steps[step].post_up();
+			}
+			CHECK(nipc_close(id) == 0);
+			closed.post_up();
+			closed.wait_down();
+			CHECK(received == STEPS - 1);
+		});
+		joined.wait_up(CHILDREN);
 
-// End of tests/test1.c
+		// Multicast to each channel, then broadcast, one message at a time.
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "one"), NIPC_MULTICAST(1)) == 0);
+		steps[0].post_down(CHILDREN);
+		steps[0].wait_up(CHILDREN);
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "two"), NIPC_MULTICAST(2)) == 0);
+		steps[1].post_down(CHILDREN);
+		steps[1].wait_up(CHILDREN);
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "all"), NIPC_BROADCAST) == 0);
+		steps[2].post_down(CHILDREN);
+		steps[2].wait_up(CHILDREN);
 
-//// TODO: design the tests; test 1 will be a simple case, test 2 will have a lot of procs and mx and bx, test 3 will have more than one nipc
+		// Once they closed the instance, nobody is left to send to, and the next round reuses their entries.
+		closed.wait_up(CHILDREN);
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "nobody"), NIPC_MULTICAST(1)) == -1 && errno == ENODATA);
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "nobody"), NIPC_BROADCAST) == -1 && errno == ENODATA);
+		CHECK(nipc_send(id, nipc_message(1, getpid(), "nobody"), NIPC_UNICAST(children[0])) == -1 && errno == ENODATA);
+		closed.post_down(CHILDREN);
+		for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	}
 
-//// TODO: you'll have an expected output for each test, and you'll compare it with the actual output, if they dont match, you'll exit(EXIT_FAILURE)
+	// Remove the instance; it cannot be opened again.
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	CHECK(nipc_get(KEY) == -1);
+	test::finish("test1");
+}
 
-//// TODO: write a build script that compiles the tests into the tests dir
-//// TODO: write a run script that forks the tests and checks the exit code, if passed print :white_check_mark: otherwise print :x:
-//// TODO: combine both into a single script
\ No newline at end of file
+// End of tests/test1.cpp
@@ -0,0 +1,105 @@
+// tests/test10.cpp
+
+/**
+ * @file  tests/test10.cpp
+ * @brief  NIPC test case number 10: a short run of the benchmark
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Runs the benchmark that `build_script` builds next to this test, whichever directory the test is run from, over a small sweep of every transport, notification mechanism and delivery mode; every run must print one result, in which every message expected was received and no send failed.
+ */
+
+#include <cstdio>		// FILE, fdopen, fgets, fclose
+#include <cstdlib>		// strtoull
+#include <climits>		// ULLONG_MAX, PATH_MAX
+#include <string>		// std::string
+#include <unistd.h>		// pipe, dup2, execv, close, access, readlink, _exit
+#include "test.h"		// CHECK, test::spawn, test::join, test::finish
+
+// The path of the benchmark, in the directory of this test's executable.
+std::string benchmark_path;
+
+// The number of runs in every sweep: three delivery modes, two payload sizes and two subscriber counts.
+const int RUNS = 3 * 2 * 2;
+
+/**
+ * @name  field()
+ * @brief  Reads a numeric field of a result printed by the benchmark.
+ * @param  line  {const std::string&}  The result, a JSON object.
+ * @param  name  {const char* const}  The name of the field.
+ * @return  {const unsigned long long}  The value of the field, or `ULLONG_MAX` if it is missing.
+ */
+const unsigned long long field(const std::string& line, const char* const name)
+{
+	const std::string key = std::string("\"") + name + "\":"; // The key of the field.
+	const size_t position = line.find(key); // The position of the key.
+	return position == std::string::npos ? ULLONG_MAX : strtoull(line.c_str() + position + key.size(), nullptr, 10);
+}
+
+/**
+ * @name  locate()
+ * @brief  Finds the benchmark in the directory of this test's executable.
+ * @param  self  {const char* const}  The path this test was run as, used if `/proc/self/exe` cannot be read.
+ * @return  {std::string}  The path of the benchmark.
+ */
+std::string locate(const char* const self)
+{
+	char path[PATH_MAX]; // The path of this test's executable.
+	const ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1); // The length of the path.
+	const std::string executable = length > 0 ? std::string(path, static_cast<size_t>(length)) : std::string(self); // The path of this test's executable.
+	const size_t slash = executable.rfind('/'); // The position of the last separator in the path.
+	return (slash == std::string::npos ? std::string(".") : executable.substr(0, slash)) + "/benchmark";
+}
+
+/**
+ * @name  sweep()
+ * @brief  Runs the benchmark over a small sweep and checks its results.
+ * @param  arguments  {const char* const* const}  The options of the sweep, ending with `nullptr`.
+ */
+void sweep(const char* const* const arguments)
+{
+	// Run the benchmark with its output going to a pipe.
+	int output[2]; // The pipe the benchmark prints to.
+	CHECK(pipe(output) == 0);
+	const pid_t benchmark = test::spawn([&]()
+	{
+		dup2(output[1], STDOUT_FILENO);
+		close(output[0]);
+		close(output[1]);
+		const char* argv[32] = { benchmark_path.c_str() }; // The command line of the benchmark.
+		for (int index = 0; arguments[index] && index < 30; ++index) argv[index + 1] = arguments[index];
+		execv(benchmark_path.c_str(), const_cast<char* const*>(argv));
+		_exit(127);
+	});
+	close(output[1]);
+
+	// Every run prints a result in which nothing was lost.
+	FILE* const results = fdopen(output[0], "r"); // The output of the benchmark.
+	char buffer[1024]; // A line of the output.
+	int runs = 0; // The number of results printed.
+	while (fgets(buffer, sizeof(buffer), results))
+	{
+		const std::string line(buffer); // The result.
+		CHECK(field(line, "received") == field(line, "expected") && field(line, "expected") > 0);
+		CHECK(field(line, "lost") == 0 && field(line, "failed") == 0);
+		++runs;
+	}
+	fclose(results);
+	CHECK(runs == RUNS);
+	CHECK(test::join(benchmark));
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// The benchmark must have been built next to this test.
+	benchmark_path = locate(argv[0]);
+	if (!CHECK(access(benchmark_path.c_str(), X_OK) == 0)) test::finish("test10");
+
+	// Sweep both transports, both notification mechanisms, and single and batched sends from several publishers.
+	const char* const queue[] = { "--transport", "queue", "--wakeup", "signal", "--payloads", "16,4096", "--subscribers", "1,4", "--messages", "500", nullptr };
+	const char* const ring[] = { "--transport", "ring", "--wakeup", "futex", "--payloads", "16,4096", "--subscribers", "1,4", "--messages", "500", "--batch", "8", "--publishers", "2", nullptr };
+	sweep(queue);
+	sweep(ring);
+	test::finish("test10");
+}
+
+// End of tests/test10.cpp
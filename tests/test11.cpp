@@ -0,0 +1,140 @@
+// tests/test11.cpp
+
+/**
+ * @file  tests/test11.cpp
+ * @brief  NIPC test case number 11: runtime statistics
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  The counters of the instance, of every subscriber and of every channel must account for every message sent, delivered, pending and received, as seen from any process that opened the instance.
+ */
+
+#include <cerrno>		// errno, ENOENT, EINVAL
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_stats, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495011;
+
+// The number of subscribing processes: the first follows channel 1, the second channels 1 and 2, the third channel 2.
+const int CHILDREN = 3;
+
+// The number of broadcasts, multicasts to channels 1 and 2, and unicasts to the first child sent.
+const int BROADCASTS = 5, FIRST = 4, SECOND = 3, UNICASTS = 2;
+
+// The number of messages every child should receive.
+const uint64_t EXPECTED[CHILDREN] = { BROADCASTS + FIRST + UNICASTS, BROADCASTS + FIRST + SECOND, BROADCASTS + SECOND };
+
+// The number of messages delivered in all.
+const uint64_t DELIVERED = EXPECTED[0] + EXPECTED[1] + EXPECTED[2];
+
+// The number of messages this process received.
+std::atomic<uint64_t> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts and releases every message received.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  sum()
+ * @brief  Adds up the buckets of a latency histogram.
+ * @param  histogram  {const uint64_t* const}  The histogram.
+ * @return  {const uint64_t}  The number of messages it counts.
+ */
+const uint64_t sum(const uint64_t* const histogram)
+{
+	uint64_t total = 0; // The number of messages counted.
+	for (unsigned int bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) total += histogram[bucket];
+	return total;
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Create the instance; only opened instances can be queried, and only into a buffer.
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+	nipc_instance_stats stats; // The counters of the instance.
+	CHECK(nipc_stats(id + 1, &stats) == -1 && errno == ENOENT);
+	CHECK(nipc_stats(id, nullptr) == -1 && errno == EINVAL);
+	CHECK(nipc_stats(id, &stats) == 0 && stats.subscribers == 0 && stats.channels == 0 && stats.delivered == 0 && sum(stats.latency) == 0);
+
+	// The children hold off their notifications until the parent looked at what is pending.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		if (child < 2) CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		if (child > 0) CHECK(nipc_subscribe(id, NIPC_MULTICAST(2), handler) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([&]() { return received == EXPECTED[child]; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Send to everyone, to each channel and to the first child.
+	for (int index = 0; index < BROADCASTS; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "broadcast"), NIPC_BROADCAST) == 0);
+	for (int index = 0; index < FIRST; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "first"), NIPC_MULTICAST(1)) == 0);
+	for (int index = 0; index < SECOND; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "second"), NIPC_MULTICAST(2)) == 0);
+	for (int index = 0; index < UNICASTS; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "unicast"), NIPC_UNICAST(children[0])) == 0);
+
+	// Everything is delivered and pending, and nothing was received yet.
+	nipc_subscriber_stats subscribers[CHILDREN]; // The counters of the subscribers.
+	nipc_channel_stats channels[2]; // The counters of the channels.
+	CHECK(nipc_stats(id, &stats, subscribers, CHILDREN, channels, 2) == 0);
+	CHECK(stats.broadcasts == BROADCASTS && stats.multicasts == FIRST + SECOND && stats.unicasts == UNICASTS);
+	CHECK(stats.delivered == DELIVERED && stats.received == 0 && stats.dropped == 0 && stats.overflowed == 0);
+	CHECK(stats.subscribers == CHILDREN && stats.channels == 2);
+	for (uint32_t index = 0; index < stats.subscribers && index < CHILDREN; ++index) for (int child = 0; child < CHILDREN; ++child) if (subscribers[index].pid == children[child])
+	{
+		CHECK(subscribers[index].pending == EXPECTED[child] && subscribers[index].received == 0);
+		CHECK(subscribers[index].channels == (child == 1 ? 2U : 1U) && subscribers[index].channel == NIPC_MULTICAST(child < 2 ? 1 : 2));
+	}
+	for (uint32_t index = 0; index < stats.channels && index < 2; ++index) CHECK(channels[index].subscribers == 2 && channels[index].sent == static_cast<uint64_t>(channels[index].channel == NIPC_MULTICAST(1) ? FIRST : SECOND));
+
+	// Once the children took their messages, nothing is pending, and every message was timed.
+	joined.post_down(CHILDREN);
+	done.wait_up(CHILDREN);
+	CHECK(nipc_stats(id, &stats, subscribers, CHILDREN) == 0);
+	CHECK(stats.received == DELIVERED && sum(stats.latency) == DELIVERED && sum(stats.lane_latency[0]) == DELIVERED);
+	for (uint32_t index = 0; index < stats.subscribers && index < CHILDREN; ++index) for (int child = 0; child < CHILDREN; ++child) if (subscribers[index].pid == children[child]) CHECK(subscribers[index].pending == 0 && subscribers[index].received == EXPECTED[child]);
+
+	// Another process reads the same counters, and those of closed subscribers are kept.
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	const pid_t reader = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_instance_stats stats; // The counters of the instance.
+		CHECK(nipc_stats(id, &stats) == 0);
+		CHECK(stats.subscribers == 0 && stats.channels == 0 && stats.delivered == DELIVERED && stats.received == DELIVERED && sum(stats.latency) == DELIVERED);
+		CHECK(nipc_close(id) == 0);
+	});
+	CHECK(test::join(reader));
+
+	// Remove the instance.
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test11");
+}
+
+// End of tests/test11.cpp
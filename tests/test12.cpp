@@ -0,0 +1,171 @@
+// tests/test12.cpp
+
+/**
+ * @file  tests/test12.cpp
+ * @brief  NIPC test case number 12: lifecycle tracing
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  With tracing, the exported Chrome trace must hold every stage of every message in the process that ran it, linked from send to handler, and keep the events of subscribers that have since exited.
+ */
+
+#include <cerrno>		// errno, ENODATA, EIO
+#include <cstdio>		// FILE, tmpfile, fileno, fclose, rewind, fread
+#include <atomic>		// std::atomic
+#include <string>		// std::string, std::to_string
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_trace_dump, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495012;
+
+// The number of subscribing processes.
+const int CHILDREN = 3;
+
+// The number of messages sent.
+const int MESSAGES = 10;
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts and releases every message received.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  dump()
+ * @brief  Exports the trace of an instance.
+ * @param  id  {const int}  The ID of the instance.
+ * @return  {std::string}  The trace, or an empty string if it could not be exported.
+ */
+std::string dump(const int id)
+{
+	FILE* const file = tmpfile(); // The file the trace is written to.
+	if (!file) return "";
+	std::string trace; // The trace.
+	if (nipc_trace_dump(id, fileno(file)) == 0)
+	{
+		rewind(file);
+		char buffer[4096]; // A part of the trace.
+		for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0;) trace.append(buffer, count);
+	}
+	fclose(file);
+	return trace;
+}
+
+/**
+ * @name  count()
+ * @brief  Counts the occurrences of a fragment in a trace.
+ * @param  trace  {const std::string&}  The trace.
+ * @param  fragment  {const std::string&}  The fragment.
+ * @return  {const int}  The number of times the fragment occurs.
+ */
+const int count(const std::string& trace, const std::string& fragment)
+{
+	int found = 0; // The number of occurrences found.
+	for (size_t position = trace.find(fragment); position != std::string::npos; position = trace.find(fragment, position + 1)) ++found;
+	return found;
+}
+
+/**
+ * @name  events()
+ * @brief  Counts the complete events of a stage run by a process.
+ * @param  trace  {const std::string&}  The trace.
+ * @param  stage  {const char* const}  The name of the stage.
+ * @param  pid  {const pid_t}  The PID of the process.
+ * @return  {const int}  The number of events.
+ */
+const int events(const std::string& trace, const char* const stage, const pid_t pid)
+{
+	int found = 0; // The number of events found.
+	const std::string name = std::string("{\"name\":\"") + stage + "\",\"cat\":\"nipc\",\"ph\":\"X\""; // The start of an event of the stage.
+	const std::string process = ",\"pid\":" + std::to_string(pid) + ","; // The process field of an event run by the process.
+	for (size_t position = trace.find(name); position != std::string::npos; position = trace.find(name, position + 1)) if (trace.compare(trace.find(",\"pid\":", position), process.size(), process) == 0) ++found;
+	return found;
+}
+
+/**
+ * @name  balanced()
+ * @brief  Checks that the braces and brackets of a trace are balanced.
+ * @param  trace  {const std::string&}  The trace, which holds no strings containing either.
+ * @return  {const bool}  Whether they are balanced.
+ */
+const bool balanced(const std::string& trace)
+{
+	int braces = 0, brackets = 0; // The number of braces and brackets open.
+	for (const char character : trace)
+	{
+		braces += character == '{' ? 1 : character == '}' ? -1 : 0;
+		brackets += character == '[' ? 1 : character == ']' ? -1 : 0;
+		if (braces < 0 || brackets < 0) return false;
+	}
+	return braces == 0 && brackets == 0;
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// An instance created without tracing has nothing to export.
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY) == 0);
+	int id = nipc_get(KEY); // The ID of the instance.
+	CHECK(nipc_trace_dump(id, STDOUT_FILENO) == -1 && errno == ENODATA);
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+
+	// Create a traced instance.
+	nipc_options options; // The options of the instance.
+	options.trace_events = 256U;
+	options.trace_processes = 8U;
+	CHECK(nipc_create(KEY, options) == 0);
+	id = nipc_get(KEY);
+	CHECK(nipc_trace_dump(id, -1) == -1 && errno == EIO);
+
+	// Every child receives every message.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([]() { return received == MESSAGES; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+	for (int index = 0; index < MESSAGES; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "traced"), NIPC_MULTICAST(1)) == 0);
+	done.wait_up(CHILDREN);
+
+	// Every send is traced in the parent, and every handler invocation in the child that ran it, with flows linking them.
+	std::string trace = dump(id); // The exported trace.
+	const std::string header = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":["; // The start of every trace.
+	CHECK(trace.compare(0, header.size(), header) == 0 && balanced(trace));
+	CHECK(events(trace, "send.resolve", getpid()) == MESSAGES);
+	CHECK(events(trace, "send.write", getpid()) >= MESSAGES);
+	CHECK(events(trace, "send.notify", getpid()) >= 1);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(events(trace, "handler", children[child]) >= 1 && events(trace, "receive", children[child]) >= 1);
+	CHECK(count(trace, "\"ph\":\"s\"") == MESSAGES);
+	CHECK(count(trace, "\"ph\":\"f\"") >= 1);
+
+	// The events of the children outlive them.
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	trace = dump(id);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(events(trace, "handler", children[child]) >= 1);
+
+	// Remove the instance.
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test12");
+}
+
+// End of tests/test12.cpp
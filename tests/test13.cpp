@@ -0,0 +1,124 @@
+// tests/test13.cpp
+
+/**
+ * @file  tests/test13.cpp
+ * @brief  NIPC test case number 13: one process subscribed to many instances
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Subscribers that opened several instances, of every transport and notification mechanism, must have each message handed to the handler of the instance it was sent on, and closing one instance must leave the others working.
+ */
+
+#include <cerrno>		// errno, ENODATA
+#include <atomic>		// std::atomic
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the first instance under test; those of the others step by 256, so as not to clash with those of other tests.
+const key_t KEY = 0x4E495013;
+
+// The number of instances.
+const int INSTANCES = 8;
+
+// The number of subscribing processes.
+const int CHILDREN = 3;
+
+// The number of messages sent to each instance in each round.
+const int MESSAGES = 20;
+
+// The number of messages this process received on every instance.
+std::atomic<int> received[INSTANCES];
+
+// The number of messages this process received on the wrong instance's handler.
+std::atomic<int> misrouted(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts a message received on instance `Instance` and checks that it was sent on it.
+ * @param  msg  {nipc_message* const}  The message; its payload is the index of the instance it was sent on.
+ */
+template <int Instance> void handler(nipc_message* const msg)
+{
+	if (*static_cast<const int*>(msg->payload()) != Instance) ++misrouted;
+	++received[Instance];
+	nipc_message_release(msg);
+}
+
+// The handler of every instance.
+const nipc_handler_t HANDLERS[INSTANCES] = { handler<0>, handler<1>, handler<2>, handler<3>, handler<4>, handler<5>, handler<6>, handler<7> };
+
+/**
+ * @name  all()
+ * @brief  Checks whether this process received a number of messages on every instance from a given one on.
+ * @param  count  {const int}  The number of messages.
+ * @param  first  {const int}  The index of the first instance checked.
+ * @return  {const bool}  Whether it did.
+ */
+const bool all(const int count, const int first = 0)
+{
+	for (int instance = first; instance < INSTANCES; ++instance) if (received[instance] != count) return false;
+	return true;
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Create the instances, alternating transports and notification mechanisms.
+	int ids[INSTANCES]; // The IDs of the instances.
+	for (int instance = 0; instance < INSTANCES; ++instance)
+	{
+		nipc_options options; // The options of the instance.
+		options.transport = instance % 2 ? NIPC_TRANSPORT_RING : NIPC_TRANSPORT_QUEUE;
+		options.wakeup = instance % 4 >= 2 ? NIPC_WAKEUP_FUTEX : NIPC_WAKEUP_SIGNAL;
+		nipc_remove(KEY + (instance << 8));
+		CHECK(nipc_create(KEY + (instance << 8), options) == 0);
+		ids[instance] = nipc_get(KEY + (instance << 8));
+	}
+
+	// Every child subscribes to every instance with a handler of its own.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate first; // The gate the children wait at once they received the first round.
+	const test::gate done; // The gate the children wait at once they received the second round.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		int ids[INSTANCES]; // The IDs of the instances.
+		for (int instance = 0; instance < INSTANCES; ++instance)
+		{
+			ids[instance] = nipc_get(KEY + (instance << 8));
+			CHECK(nipc_subscribe(ids[instance], NIPC_MULTICAST(1), HANDLERS[instance]) == 0);
+		}
+		joined.post_up();
+		CHECK(test::wait_until([]() { return all(MESSAGES); }));
+
+		// Leaving the first instance leaves the others untouched.
+		CHECK(nipc_close(ids[0]) == 0);
+		first.post_up();
+		CHECK(test::wait_until([]() { return all(2 * MESSAGES, 1); }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received[0] == MESSAGES && all(2 * MESSAGES, 1) && misrouted == 0);
+		for (int instance = 1; instance < INSTANCES; ++instance) CHECK(nipc_close(ids[instance]) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Interleave the instances.
+	for (int index = 0; index < MESSAGES; ++index) for (int instance = 0; instance < INSTANCES; ++instance) CHECK(nipc_send(ids[instance], nipc_message(1, getpid(), &instance, sizeof(instance)), NIPC_MULTICAST(1)) == 0);
+
+	// Once the children left the first instance, it has no subscribers, and the others still deliver.
+	first.wait_up(CHILDREN);
+	CHECK(nipc_send(ids[0], nipc_message(1, getpid(), "nobody"), NIPC_MULTICAST(1)) == -1 && errno == ENODATA);
+	for (int index = 0; index < MESSAGES; ++index) for (int instance = 1; instance < INSTANCES; ++instance) CHECK(nipc_send(ids[instance], nipc_message(1, getpid(), &instance, sizeof(instance)), NIPC_MULTICAST(1)) == 0);
+
+	// Let the children go and remove the instances.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	for (int instance = 0; instance < INSTANCES; ++instance)
+	{
+		CHECK(nipc_close(ids[instance]) == 0);
+		CHECK(nipc_remove(KEY + (instance << 8)) == 0);
+	}
+	test::finish("test13");
+}
+
+// End of tests/test13.cpp
@@ -0,0 +1,120 @@
+// tests/test14.cpp
+
+/**
+ * @file  tests/test14.cpp
+ * @brief  NIPC test case number 14: following several channels
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A subscriber following several channels must receive a message sent to any number of them once, up to `NIPC_MAX_CHANNELS` channels, and stop receiving those of a channel it left while still receiving the others; both transports are tested.
+ */
+
+#include <cerrno>		// errno, EINVAL, ENOSPC
+#include <atomic>		// std::atomic
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_unsubscribe, nipc_send, nipc_send_channels, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495014;
+
+// The number of subscribing processes: the first follows every channel it can, the second channels 1 and 2, the third channel 3.
+const int CHILDREN = 3;
+
+// The last channel a process can follow; signed, so that it can be negated into a multicast type.
+const long LAST = NIPC_MAX_CHANNELS;
+
+// The number of messages sent to several channels at once.
+const int MESSAGES = 5;
+
+// The number of messages every child should receive.
+const int EXPECTED[CHILDREN] = { MESSAGES + 1, MESSAGES + 1, MESSAGES };
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts and releases every message received.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  run()
+ * @brief  Sends to several channels at once, to the last channel followed and to a channel left, and checks who received what.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate left; // The gate the children wait at once the first child left channel 1.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		if (child == 0)
+		{
+			// Follow as many channels as allowed, and no more.
+			for (long channel = 1; channel <= LAST; ++channel) CHECK(nipc_subscribe(id, NIPC_MULTICAST(channel), handler) == 0);
+			CHECK(nipc_subscribe(id, NIPC_MULTICAST(LAST + 1), handler) == -1 && errno == ENOSPC);
+		}
+		else if (child == 1) { CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0); CHECK(nipc_subscribe(id, NIPC_MULTICAST(2), handler) == 0); }
+		else CHECK(nipc_subscribe(id, NIPC_MULTICAST(3), handler) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([&]() { return received == MESSAGES; }));
+		if (child == 0) CHECK(nipc_unsubscribe(id, NIPC_MULTICAST(1)) == 0);
+		left.post_up();
+		CHECK(test::wait_until([&]() { return received == EXPECTED[child]; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == EXPECTED[child]);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Channels must be given, and must be multicast channels.
+	const long channels[] = { NIPC_MULTICAST(1), NIPC_MULTICAST(2), NIPC_MULTICAST(3) }; // The channels sent to at once.
+	const long unicast[] = { NIPC_MULTICAST(1), NIPC_UNICAST(getpid()) }; // A list that is not only of multicast channels.
+	nipc_message messages[MESSAGES]; // The messages sent to several channels.
+	for (int index = 0; index < MESSAGES; ++index) messages[index] = nipc_message(1, getpid(), "channels");
+	CHECK(nipc_send_channels(id, messages, MESSAGES, channels, 0) == -1 && errno == EINVAL);
+	CHECK(nipc_send_channels(id, messages, MESSAGES, unicast, 2) == -1 && errno == EINVAL);
+
+	// Every follower of any of the channels is a recipient once, and is delivered every message once.
+	nipc_delivery deliveries[CHILDREN]; // The outcomes of the recipients.
+	CHECK(nipc_send_channels(id, messages, MESSAGES, channels, 3, deliveries, CHILDREN) == CHILDREN);
+	for (int index = 0; index < CHILDREN; ++index) CHECK(deliveries[index].delivered == MESSAGES && deliveries[index].error == 0);
+
+	// The last channel the first child follows reaches it; once it left channel 1, that channel reaches the second child only.
+	left.wait_up(CHILDREN);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "last"), NIPC_MULTICAST(LAST)) == 0);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "left"), NIPC_MULTICAST(1)) == 0);
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test14");
+}
+
+// End of tests/test14.cpp
@@ -0,0 +1,153 @@
+// tests/test15.cpp
+
+/**
+ * @file  tests/test15.cpp
+ * @brief  NIPC test case number 15: per-subscriber quotas and overflow policies
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A subscriber that stops reading must only ever hold its quota of messages, the messages beyond it must be waited for, dropped or refused as the overflow policy says, and a subscriber that keeps reading must get every message regardless.
+ */
+
+#include <cerrno>		// errno, EAGAIN
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <sys/wait.h>		// waitpid, WNOHANG
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_stats, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495015;
+
+// The number of messages a subscriber may have waiting.
+const unsigned int QUOTA = 4U;
+
+// The number of messages sent.
+const int MESSAGES = 10;
+
+// The indices of the messages this process received, in order.
+int indices[MESSAGES];
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Records the index of every message received and releases it.
+ * @param  msg  {nipc_message* const}  The message; its payload is its index as an `int`.
+ */
+void handler(nipc_message* const msg)
+{
+	const int index = received; // The position of the message among those received.
+	if (index < MESSAGES) indices[index] = *static_cast<const int*>(msg->payload());
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  counters()
+ * @brief  Reads the counters of a subscriber.
+ * @param  id  {const int}  The ID of the instance.
+ * @param  pid  {const pid_t}  The PID of the subscriber.
+ * @return  {const nipc_subscriber_stats}  The counters of the subscriber; its `pending` and `overflowed` are `UINT64_MAX` if it is not subscribed.
+ */
+const nipc_subscriber_stats counters(const int id, const pid_t pid)
+{
+	nipc_instance_stats stats; // The counters of the instance.
+	nipc_subscriber_stats subscribers[2]; // The counters of the subscribers.
+	if (nipc_stats(id, &stats, subscribers, 2) == 0) for (uint32_t index = 0; index < stats.subscribers && index < 2; ++index) if (subscribers[index].pid == pid) return subscribers[index];
+	nipc_subscriber_stats missing = nipc_subscriber_stats(); // The counters of a subscriber that is not subscribed.
+	missing.pending = missing.overflowed = UINT64_MAX;
+	return missing;
+}
+
+/**
+ * @name  run()
+ * @brief  Sends more messages than a stalled subscriber's quota and checks what it and a reading subscriber receive.
+ * @param  overflow  {const nipc_overflow}  The overflow policy of the instance.
+ * @param  flags  {const int}  The flags the messages are sent with.
+ */
+void run(const nipc_overflow overflow, const int flags)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.quota = QUOTA;
+	options.overflow = overflow;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Only a blocking send waits for the stalled subscriber, which then gets everything; otherwise, it gets its quota's worth, the newest if the oldest are dropped.
+	const bool waits = overflow == NIPC_OVERFLOW_BLOCK && !(flags & NIPC_NONBLOCK); // Whether sends wait for room.
+	const int kept = waits ? MESSAGES : static_cast<int>(QUOTA); // The number of messages the stalled subscriber gets.
+	const int oldest = overflow == NIPC_OVERFLOW_DROP_OLDEST ? MESSAGES - kept : 0; // The index of the first message it gets.
+
+	// The reading subscriber takes everything as it comes; the stalled one holds off its notifications until the sends are over.
+	const test::gate joined; // The gate the subscribers wait at once they subscribed.
+	const test::gate done; // The gate the subscribers wait at once they received everything.
+	pid_t subscribers[2]; // The PIDs of the reading and the stalled subscriber.
+	for (int stalled = 0; stalled < 2; ++stalled) subscribers[stalled] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		if (stalled) sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		if (stalled) { joined.wait_down(); sigprocmask(SIG_UNBLOCK, &signals, nullptr); }
+		const int expected = stalled ? kept : MESSAGES; // The number of messages to receive.
+		CHECK(test::wait_until([&]() { return received == expected; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == expected);
+		for (int index = 0; index < expected && index < MESSAGES; ++index) CHECK(indices[index] == (stalled ? oldest : 0) + index);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(2);
+
+	// Send from another process, which only finishes before the stalled subscriber reads if it never waits.
+	const test::gate sent; // The gate the parent waits at once the sender is done.
+	const pid_t sender = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		for (int index = 0; index < MESSAGES; ++index)
+		{
+			// Let the reading subscriber catch up first, so that only the stalled one ever reaches its quota.
+			CHECK(test::wait_until([&]() { return counters(id, subscribers[0]).pending == 0; }));
+			const bool refused = !waits && index >= static_cast<int>(QUOTA) && (overflow == NIPC_OVERFLOW_FAIL || overflow == NIPC_OVERFLOW_BLOCK); // Whether the stalled subscriber is skipped with an error.
+			const int result = nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1), flags); // The outcome of the send.
+			CHECK(refused ? result == -1 && errno == EAGAIN : result == 0);
+		}
+		sent.post_up();
+		CHECK(nipc_close(id) == 0);
+	});
+	if (waits) { test::sleep(100); CHECK(waitpid(sender, nullptr, WNOHANG) == 0); }
+	else sent.wait_up();
+
+	// Messages beyond the quota were dropped for the stalled subscriber only if the policy drops them.
+	const uint64_t dropped = overflow == NIPC_OVERFLOW_DROP_OLDEST || overflow == NIPC_OVERFLOW_DROP_NEWEST ? MESSAGES - QUOTA : 0; // The number of messages dropped.
+	CHECK(counters(id, subscribers[1]).overflowed == dropped && counters(id, subscribers[0]).overflowed == 0);
+
+	// Let the stalled subscriber read, which lets a waiting sender through.
+	joined.post_down();
+	if (waits) sent.wait_up();
+	CHECK(test::join(sender));
+	done.wait_up(2);
+	done.post_down(2);
+	for (int stalled = 0; stalled < 2; ++stalled) CHECK(test::join(subscribers[stalled]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_OVERFLOW_BLOCK, 0);
+	run(NIPC_OVERFLOW_BLOCK, NIPC_NONBLOCK);
+	run(NIPC_OVERFLOW_DROP_OLDEST, 0);
+	run(NIPC_OVERFLOW_DROP_NEWEST, 0);
+	run(NIPC_OVERFLOW_FAIL, 0);
+	test::finish("test15");
+}
+
+// End of tests/test15.cpp
@@ -0,0 +1,179 @@
+// tests/test16.cpp
+
+/**
+ * @file  tests/test16.cpp
+ * @brief  NIPC test case number 16: receiving through a pollable descriptor
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A subscriber that receives with `nipc_recv()` and `nipc_recv_many()` must get every message in order, inline or in the slab, and its descriptor must be readable exactly while messages are pending, whether they were sent before or while it waits on it; no signal may reach it, and both transports are tested.
+ */
+
+#include <cerrno>		// errno, EINVAL, EAGAIN
+#include <poll.h>		// pollfd, poll, POLLIN
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, sigpending, sigismember, SIG_BLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_subscribe_poll, nipc_fd, nipc_recv, nipc_recv_many, nipc_send, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495016;
+
+// The number of subscribing processes.
+const int CHILDREN = 2;
+
+// The number of messages sent in each round: the first is sent before the children look, the second while they wait.
+const int MESSAGES = 20;
+
+// The number of `int`s in the payload of every fifth message, which is too large to be stored inline.
+const int LARGE = 128;
+
+// The number of messages received at once with `nipc_recv_many()`.
+const size_t CAPACITY = 8;
+
+/**
+ * @name  handler()
+ * @brief  Releases every message received; it must never be called.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg) { nipc_message_release(msg); }
+
+/**
+ * @name  readable()
+ * @brief  Waits for a descriptor to become readable.
+ * @param  fd  {const int}  The descriptor.
+ * @param  timeout  {const int}  The number of milliseconds to wait for.
+ * @return  {const bool}  Whether it became readable in time.
+ */
+const bool readable(const int fd, const int timeout)
+{
+	pollfd descriptor = { fd, POLLIN, 0 }; // The descriptor waited on.
+	return poll(&descriptor, 1, timeout) == 1 && (descriptor.revents & POLLIN);
+}
+
+/**
+ * @name  intact()
+ * @brief  Checks that a message received is the next one expected.
+ * @param  msg  {const nipc_message&}  The message; its payload is its index as an `int`, repeated throughout if it is large.
+ * @param  index  {const int}  The index of the message expected.
+ * @return  {const bool}  Whether it is.
+ */
+const bool intact(const nipc_message& msg, const int index)
+{
+	const int count = index % 5 ? 1 : LARGE; // The number of `int`s in the payload.
+	if (msg.length != count * sizeof(int) || (count == LARGE) != (msg.blob != nullptr)) return false;
+	for (int position = 0; position < count; ++position) if (static_cast<const int*>(msg.payload())[position] != index) return false;
+	return true;
+}
+
+/**
+ * @name  drain()
+ * @brief  Receives everything pending, the first message alone and the rest in batches, checking that they come in order.
+ * @param  id  {const int}  The ID of the instance.
+ * @param  fd  {const int}  The descriptor of the instance.
+ * @param  received  {int&}  The number of messages received so far, which is the index of the next one.
+ * @param  backlog  {const bool}  Whether the whole round was pending already and nothing else is sent meanwhile, so that the descriptor must be readable exactly until the last message.
+ * @remark  While messages are still being sent, the descriptor may be readable with nothing pending, if a message was received before its sender notified; the next receive then finds nothing and clears it.
+ */
+void drain(const int id, const int fd, int& received, const bool backlog)
+{
+	nipc_message msgs[CAPACITY]; // The messages received.
+	if (nipc_recv(id, msgs) == -1) { CHECK(!backlog && errno == EAGAIN); return; }
+	CHECK(intact(msgs[0], received++));
+
+	// The descriptor stays readable as long as anything is left.
+	if (backlog) CHECK(readable(fd, 0));
+	for (int count; (count = nipc_recv_many(id, msgs, CAPACITY)) > 0;) for (int index = 0; index < count; ++index) CHECK(intact(msgs[index], received++));
+	CHECK(errno == EAGAIN);
+	if (backlog) CHECK(!readable(fd, 0));
+}
+
+/**
+ * @name  run()
+ * @brief  Sends two rounds of messages to subscribers that receive them through their descriptors.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate first; // The gate the children wait at once they received the first round.
+	const test::gate done; // The gate the children wait at once they received the second round.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		// Any signal sent despite all would stay pending.
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+
+		// Only a process subscribed for polling has a descriptor and can receive, and it cannot take a handler as well.
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_message msg; // A message received.
+		CHECK(nipc_fd(id) == -1 && errno == EINVAL);
+		CHECK(nipc_recv(id, &msg) == -1 && errno == EINVAL);
+		CHECK(nipc_subscribe_poll(id, NIPC_MULTICAST(1)) == 0);
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == -1 && errno == EINVAL);
+		const int fd = nipc_fd(id); // The descriptor of the instance.
+		CHECK(fd >= 0);
+		CHECK(nipc_recv(id, nullptr) == -1 && errno == EINVAL);
+		CHECK(nipc_recv_many(id, &msg, 0) == -1 && errno == EINVAL);
+
+		// Nothing is pending yet.
+		CHECK(!readable(fd, 0));
+		CHECK(nipc_recv(id, &msg) == -1 && errno == EAGAIN);
+		joined.post_up();
+
+		// The first round is already pending when the child looks.
+		int received = 0; // The number of messages received.
+		joined.wait_down();
+		CHECK(readable(fd, 0));
+		drain(id, fd, received, true);
+		CHECK(received == MESSAGES);
+		first.post_up();
+
+		// The second round wakes the child up as it comes.
+		while (received < 2 * MESSAGES && CHECK(readable(fd, 5000))) drain(id, fd, received, false);
+		CHECK(received == 2 * MESSAGES);
+		done.post_up();
+		done.wait_down();
+		sigpending(&signals);
+		CHECK(!sigismember(&signals, NIPC_SIGNAL));
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Send both rounds, every fifth message through the slab.
+	int payload[LARGE]; // The payload of the message sent.
+	for (int round = 0; round < 2; ++round)
+	{
+		for (int index = round * MESSAGES; index < (round + 1) * MESSAGES; ++index)
+		{
+			for (int position = 0; position < LARGE; ++position) payload[position] = index;
+			CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), payload, (index % 5 ? 1 : LARGE) * sizeof(int)), NIPC_MULTICAST(1)) == 0);
+		}
+		if (round == 0) { joined.post_down(CHILDREN); first.wait_up(CHILDREN); }
+	}
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test16");
+}
+
+// End of tests/test16.cpp
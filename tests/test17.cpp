@@ -0,0 +1,194 @@
+// tests/test17.cpp
+
+/**
+ * @file  tests/test17.cpp
+ * @brief  NIPC test case number 17: conflated channels
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A subscriber that falls behind on a conflated channel must only receive its latest value, once and ahead of its queued messages, a process subscribing late must catch up on that value, and the number of conflated channels must be bounded; both transports are tested.
+ */
+
+#include <cerrno>		// errno, ENOENT, EINVAL, ENOSPC, EAGAIN
+#include <climits>		// INT_MIN
+#include <atomic>		// std::atomic
+#include <poll.h>		// pollfd, poll, POLLIN
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_conflate, nipc_subscribe, nipc_subscribe_poll, nipc_fd, nipc_recv, nipc_send, nipc_send_channels, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495017;
+
+// The conflated channel the values are published on.
+const long CONFLATED = NIPC_MULTICAST(1);
+
+// The ordinary channel messages are queued on.
+const long QUEUED = NIPC_MULTICAST(100);
+
+// The number of values published while the subscribers are not reading.
+const int UPDATES = 1000;
+
+// The number of messages queued meanwhile; their payloads are negative, unlike the values.
+const int MESSAGES = 3;
+
+// The number of values this process received through its handler.
+std::atomic<int> received(0);
+
+// The last value this process received through its handler.
+std::atomic<int> latest(-1);
+
+/**
+ * @name  handler()
+ * @brief  Counts and records every value received and releases it.
+ * @param  msg  {nipc_message* const}  The message; its payload is the value as an `int`.
+ */
+void handler(nipc_message* const msg)
+{
+	latest = *static_cast<const int*>(msg->payload());
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  next()
+ * @brief  Waits for the descriptor of an instance to become readable and receives the next message.
+ * @param  id  {const int}  The ID of the instance.
+ * @return  {const int}  The payload of the message, or `INT_MIN` if none came.
+ */
+const int next(const int id)
+{
+	pollfd descriptor = { nipc_fd(id), POLLIN, 0 }; // The descriptor waited on.
+	nipc_message msg; // The message received.
+	for (const double deadline = test::now() + 5000; test::now() < deadline; poll(&descriptor, 1, 100)) if (nipc_recv(id, &msg) == 0) return *static_cast<const int*>(msg.payload());
+	return INT_MIN;
+}
+
+/**
+ * @name  empty()
+ * @brief  Checks that nothing is left to receive on an instance, even after senders had time to notify.
+ * @param  id  {const int}  The ID of the instance.
+ * @return  {const bool}  Whether nothing is left.
+ */
+const bool empty(const int id)
+{
+	nipc_message msg; // A message received.
+	test::sleep(50);
+	return nipc_recv(id, &msg) == -1 && errno == EAGAIN;
+}
+
+/**
+ * @name  run()
+ * @brief  Publishes a burst of values to a polling and a signalled subscriber that are not reading, then to one that subscribes late.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance; only multicast channels of opened instances can be conflated, and conflating twice has no effect.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+	CHECK(nipc_conflate(id + 1, CONFLATED) == -1 && errno == ENOENT);
+	CHECK(nipc_conflate(id, NIPC_BROADCAST) == -1 && errno == EINVAL);
+	CHECK(nipc_conflate(id, NIPC_UNICAST(getpid())) == -1 && errno == EINVAL);
+	CHECK(nipc_conflate(id, CONFLATED) == 0);
+	CHECK(nipc_conflate(id, CONFLATED) == 0);
+
+	// Only so many channels can be conflated.
+	for (long channel = 2; channel <= static_cast<long>(NIPC_MAX_CONFLATED); ++channel) CHECK(nipc_conflate(id, NIPC_MULTICAST(channel)) == 0);
+	CHECK(nipc_conflate(id, NIPC_MULTICAST(static_cast<long>(NIPC_MAX_CONFLATED) + 1)) == -1 && errno == ENOSPC);
+
+	// The first child polls and also follows the queued channel; the second is signalled and holds off its notifications until the burst is over.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate burst; // The gate the children wait at once they received the burst.
+	const test::gate done; // The gate the children wait at once they received the last value.
+	pid_t children[3]; // The PIDs of the children.
+	for (int child = 0; child < 2; ++child) children[child] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		if (child == 0) { CHECK(nipc_subscribe_poll(id, CONFLATED) == 0); CHECK(nipc_subscribe_poll(id, QUEUED) == 0); }
+		else CHECK(nipc_subscribe(id, CONFLATED, handler) == 0);
+		joined.post_up();
+		joined.wait_down();
+
+		// Only the latest value is received, once, and ahead of the queued messages.
+		if (child == 0)
+		{
+			CHECK(next(id) == UPDATES - 1);
+			for (int index = 0; index < MESSAGES; ++index) CHECK(next(id) == -1 - index);
+			CHECK(empty(id));
+		}
+		else
+		{
+			sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+			CHECK(test::wait_until([]() { return received > 0; }));
+			test::sleep(50);
+			CHECK(received == 1 && latest == UPDATES - 1);
+		}
+		burst.post_up();
+
+		// The next value is received on its own.
+		if (child == 0) { CHECK(next(id) == UPDATES); CHECK(empty(id)); }
+		else { CHECK(test::wait_until([]() { return received == 2; })); CHECK(latest == UPDATES); }
+		done.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(2);
+
+	// Publish the burst and queue a few messages behind it; a conflated channel cannot be sent to along with others.
+	for (int value = 0; value < UPDATES; ++value) CHECK(nipc_send(id, nipc_message(1, getpid(), &value, sizeof(value)), CONFLATED) == 0);
+	for (int index = 0; index < MESSAGES; ++index)
+	{
+		const int payload = -1 - index; // The payload of the message.
+		CHECK(nipc_send(id, nipc_message(1, getpid(), &payload, sizeof(payload)), QUEUED) == 0);
+	}
+	const long channels[] = { QUEUED, CONFLATED }; // A list of channels including a conflated one.
+	const nipc_message msg(1, getpid(), "both"); // A message sent to several channels.
+	CHECK(nipc_send_channels(id, &msg, 1, channels, 2) == -1 && errno == EINVAL);
+	joined.post_down(2);
+	burst.wait_up(2);
+
+	// A process subscribing late receives the current value without anything being sent.
+	const test::gate caught; // The gate the parent waits at once the late child received the current value.
+	children[2] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe_poll(id, CONFLATED) == 0);
+		CHECK(next(id) == UPDATES - 1);
+		CHECK(empty(id));
+		caught.post_up();
+		CHECK(next(id) == UPDATES);
+		CHECK(empty(id));
+		done.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	caught.wait_up();
+
+	// Publish one more value, which everyone receives.
+	const int value = UPDATES; // The last value.
+	CHECK(nipc_send(id, nipc_message(1, getpid(), &value, sizeof(value)), CONFLATED) == 0);
+
+	// Let the children go and remove the instance.
+	done.wait_up(3);
+	done.post_down(3);
+	for (int child = 0; child < 3; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test17");
+}
+
+// End of tests/test17.cpp
@@ -0,0 +1,245 @@
+// tests/test18.cpp
+
+/**
+ * @file  tests/test18.cpp
+ * @brief  NIPC test case number 18: the message log and its replay
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Every message sent on a logging instance must get the next sequence number, a subscriber replaying the log must receive every message from the one it asked for on exactly once, even while others are sent, the log must outlive the instance, only the segments retained may be kept, and a large payload replayed must outlive its segment for as long as its buffer is kept.
+ */
+
+#include <cerrno>		// errno, EIO, EMSGSIZE, ENODATA
+#include <cstdio>		// snprintf
+#include <cstdlib>		// mkdtemp
+#include <cstring>		// memcmp
+#include <atomic>		// std::atomic
+#include <string>		// std::string
+#include <vector>		// std::vector
+#include <dirent.h>		// DIR, dirent, opendir, readdir, closedir
+#include <unistd.h>		// getpid, unlink, rmdir
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495018;
+
+// The size of the log's segments, which hold a few dozen small messages each.
+const size_t SEGMENT = 4096;
+
+// The number of messages sent before and while a subscriber replays the log.
+const int MESSAGES = 100;
+
+// The number of messages sent to the log that keeps only a few segments.
+const int RETAINED = 1000;
+
+// The sequence number of the first message this process received.
+std::atomic<uint64_t> first(0);
+
+// The sequence number of the last message this process received.
+std::atomic<uint64_t> last(0);
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+// The number of messages this process received out of sequence, or whose payload does not match their sequence number.
+std::atomic<int> misplaced(0);
+
+/**
+ * @name  handler()
+ * @brief  Records the sequence number of every message received and releases it.
+ * @param  msg  {nipc_message* const}  The message; its payload is its sequence number less one, as an `int`.
+ */
+void handler(nipc_message* const msg)
+{
+	if ((received && msg->sequence != last + 1) || static_cast<uint64_t>(*static_cast<const int*>(msg->payload())) + 1 != msg->sequence) ++misplaced;
+	if (!received) first = msg->sequence;
+	last = msg->sequence;
+	++received;
+	nipc_message_release(msg);
+}
+
+// The buffer holding the large payload this process replayed, kept past the handler.
+std::atomic<nipc_message*> kept(nullptr);
+
+/**
+ * @name  keep()
+ * @brief  Keeps the buffer of a replayed message instead of releasing it.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void keep(nipc_message* const msg) { kept = msg; }
+
+/**
+ * @name  logging()
+ * @brief  Builds the options of an instance logging to a path.
+ * @param  path  {const std::string&}  The path prefix of the log segments.
+ * @param  retention  {const uint64_t}  The number of bytes of segments to keep, or `0` to keep them all.
+ * @return  {nipc_options}  The options.
+ */
+nipc_options logging(const std::string& path, const uint64_t retention = 0)
+{
+	nipc_options options; // The options of the instance.
+	snprintf(options.log_path, sizeof(options.log_path), "%s", path.c_str());
+	options.log_segment_size = SEGMENT;
+	options.log_retention_size = retention;
+	return options;
+}
+
+/**
+ * @name  segments()
+ * @brief  Lists the segments of a log in a directory.
+ * @param  directory  {const std::string&}  The directory.
+ * @param  name  {const std::string&}  The name the log's path ends with.
+ * @return  {std::vector<std::string>}  The paths of the segments.
+ */
+std::vector<std::string> segments(const std::string& directory, const std::string& name)
+{
+	std::vector<std::string> found; // The paths of the segments.
+	DIR* const listing = opendir(directory.c_str()); // The directory.
+	if (!listing) return found;
+	while (const dirent* const file = readdir(listing)) if (std::string(file->d_name).compare(0, name.size() + 1, name + ".") == 0) found.push_back(directory + "/" + file->d_name);
+	closedir(listing);
+	return found;
+}
+
+/**
+ * @name  replay()
+ * @brief  Spawns a child that subscribes, replaying the log from a sequence number, and checks what it received once everything logged reached it.
+ * @param  from  {const uint64_t}  The sequence number to replay from.
+ * @param  expected  {const uint64_t}  The sequence number of the first message it should receive.
+ * @param  total  {const uint64_t}  The sequence number of the last message logged by the time the child is let go.
+ * @param  joined  {const test::gate&}  The gate the child posts to once it subscribed and waits at before checking.
+ * @param  done  {const test::gate&}  The gate the child posts to once it received everything and waits at before leaving.
+ * @return  {const pid_t}  The PID of the child.
+ */
+const pid_t replay(const uint64_t from, const uint64_t expected, const uint64_t total, const test::gate& joined, const test::gate& done)
+{
+	return test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_subscriber_options options; // The options of the subscription.
+		options.replay = from;
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler, options) == 0);
+		joined.post_up();
+		joined.wait_down();
+		CHECK(test::wait_until([&]() { return last == total; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(first == expected && last == total && received == static_cast<int>(total - expected + 1) && misplaced == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Keep the segments in a directory of their own; a log that cannot be created fails the instance.
+	char directory[] = "/tmp/nipc_test18_XXXXXX"; // The directory of the logs.
+	if (!CHECK(mkdtemp(directory) != nullptr)) test::finish("test18");
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY, logging(std::string(directory) + "/missing/log")) == -1 && errno == EIO);
+
+	// Create the instance; messages are logged even if nobody receives them, but must fit in a segment.
+	const std::string path = std::string(directory) + "/log"; // The path prefix of the log.
+	CHECK(nipc_create(KEY, logging(path)) == 0);
+	int id = nipc_get(KEY); // The ID of the instance.
+	const std::vector<char> oversized(SEGMENT + 1, 'x'); // A payload larger than a segment.
+	CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), oversized.data(), oversized.size()), NIPC_MULTICAST(1)) == -1 && errno == EMSGSIZE);
+	int index = 0; // The index of the next message sent, which is its sequence number less one.
+	CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == -1 && errno == ENODATA);
+	++index;
+
+	// A child that subscribed live receives the rest as they are logged.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[3]; // The PIDs of the subscribing children.
+	children[0] = replay(0, 2, 2 * MESSAGES, joined, done);
+	joined.wait_up();
+	for (; index < MESSAGES; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == 0);
+
+	// Another child replays the whole log while more messages are sent, and must see each of them once.
+	const test::gate started; // The gate the sender waits at until the replaying child is about to subscribe.
+	const pid_t sender = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		started.wait_down();
+		for (int index = MESSAGES; index < 2 * MESSAGES; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	started.post_down();
+	test::sleep(1);
+	children[1] = replay(1, 1, 2 * MESSAGES, joined, done);
+	joined.wait_up();
+	CHECK(test::join(sender));
+	index = 2 * MESSAGES;
+
+	// A third replays from the middle once everything was sent.
+	children[2] = replay(MESSAGES + MESSAGES / 2, MESSAGES + MESSAGES / 2, 2 * MESSAGES, joined, done);
+	joined.wait_up();
+	joined.post_down(3);
+	done.wait_up(3);
+	done.post_down(3);
+	for (int child = 0; child < 3; ++child) CHECK(test::join(children[child]));
+
+	// The log outlives the instance: once created again, it replays the old messages and carries on numbering.
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	CHECK(!segments(directory, "log").empty());
+	CHECK(nipc_create(KEY, logging(path)) == 0);
+	id = nipc_get(KEY);
+	children[0] = replay(1, 1, 2 * MESSAGES + 1, joined, done);
+	joined.wait_up();
+	CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == 0);
+	joined.post_down();
+	done.wait_up();
+	done.post_down();
+	CHECK(test::join(children[0]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+
+	// A log keeping two segments deletes the older ones, and replay starts at the oldest message left.
+	const std::string retained = std::string(directory) + "/retained"; // The path prefix of the log keeping two segments.
+	CHECK(nipc_create(KEY, logging(retained, 2 * SEGMENT)) == 0);
+	id = nipc_get(KEY);
+	for (index = 0; index < RETAINED; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == -1 && errno == ENODATA);
+	CHECK(segments(directory, "retained").size() == 2);
+	children[0] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_subscriber_options options; // The options of the subscription.
+		options.replay = 1;
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler, options) == 0);
+		CHECK(first > 1 && last == RETAINED && received == static_cast<int>(RETAINED - first + 1) && misplaced == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	CHECK(test::join(children[0]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+
+	// A large payload replayed into a buffer is still there once its segment was unmapped.
+	const std::string large = std::string(directory) + "/large"; // The path prefix of the log holding a large payload.
+	CHECK(nipc_create(KEY, logging(large)) == 0);
+	id = nipc_get(KEY);
+	const std::vector<char> payload(SEGMENT / 2, 'p'); // A payload too large to travel inline.
+	CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), payload.data(), payload.size()), NIPC_MULTICAST(1)) == -1 && errno == ENODATA);
+	children[0] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_subscriber_options options; // The options of the subscription.
+		options.replay = 1;
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), keep, options) == 0);
+		CHECK(kept && kept.load()->length == payload.size() && kept.load()->blob && memcmp(kept.load()->payload(), payload.data(), payload.size()) == 0);
+		nipc_message_release(kept);
+		CHECK(nipc_close(id) == 0);
+	});
+	CHECK(test::join(children[0]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+
+	// Delete the logs.
+	for (const std::string& segment : segments(directory, "log")) unlink(segment.c_str());
+	for (const std::string& segment : segments(directory, "retained")) unlink(segment.c_str());
+	for (const std::string& segment : segments(directory, "large")) unlink(segment.c_str());
+	CHECK(rmdir(directory) == 0);
+	test::finish("test18");
+}
+
+// End of tests/test18.cpp
@@ -0,0 +1,167 @@
+// tests/test19.cpp
+
+/**
+ * @file  tests/test19.cpp
+ * @brief  NIPC test case number 19: typed channels
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Values sent on a typed channel, one at a time or in batches larger than `NIPC_BATCH_SIZE`, inline or through the slab, must reach the move-only handler of their channel intact and in order, messages of the wrong size must be dropped, and a process that subscribed with a notification handler must not subscribe through a typed channel; both transports are tested.
+ */
+
+#include <cerrno>		// errno, EINVAL, ENODATA
+#include <memory>		// std::unique_ptr
+#include <poll.h>		// pollfd, poll, POLLIN
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+#include "../src/NIPC_channel.h"	// nipc::channel, nipc::detail::routes
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::now, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495019;
+
+// The number of ticks sent one at a time, and then at once.
+const int SINGLE = 10, BATCH = 100;
+
+// The number of snapshots sent.
+const int SNAPSHOTS = 5;
+
+/**
+ * @name  tick
+ * @brief  A small value, which travels inline.
+ */
+struct tick
+{
+	// The index of the tick.
+	long index;
+
+	// A value derived from the index.
+	double price;
+};
+
+/**
+ * @name  snapshot
+ * @brief  A large value, which travels through the slab.
+ */
+struct snapshot
+{
+	// The index of the snapshot.
+	int index;
+
+	// Bytes all equal to the index.
+	unsigned char body[1000];
+};
+
+static_assert(nipc::channel<tick>::is_inline && nipc::channel<tick>::payload_size == sizeof(tick), "Ticks must travel inline.");
+static_assert(!nipc::channel<snapshot>::is_inline && nipc::channel<snapshot>::payload_size == sizeof(snapshot), "Snapshots must travel through the slab.");
+
+/**
+ * @name  make()
+ * @brief  Builds the snapshot of an index.
+ * @param  index  {const int}  The index.
+ * @return  {snapshot}  The snapshot.
+ */
+snapshot make(const int index)
+{
+	snapshot value; // The snapshot.
+	value.index = index;
+	for (unsigned char& byte : value.body) byte = static_cast<unsigned char>(index);
+	return value;
+}
+
+/**
+ * @name  run()
+ * @brief  Sends ticks and snapshots to a child dispatching them to typed handlers.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate left; // The gate the parent waits at once the first child left the snapshot channel.
+	const test::gate done; // The gate the children wait at once they are done.
+	const pid_t child = test::spawn([&]()
+	{
+		// Count what the handlers see through state they own, which makes them move-only.
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc::channel<tick> ticks(id, NIPC_MULTICAST(1)); // The channel of the ticks.
+		nipc::channel<snapshot> snapshots(id, NIPC_MULTICAST(2)); // The channel of the snapshots.
+		int ticked = 0, snapped = 0, misplaced = 0; // The number of ticks and snapshots received, and of those out of order or damaged.
+		std::unique_ptr<long> next(new long(0)); // The index of the next tick.
+		CHECK(ticks.subscribe([next = std::move(next), &ticked, &misplaced](const tick& value)
+		{
+			if (value.index != (*next)++ || value.price != value.index * 0.5) ++misplaced;
+			++ticked;
+		}) == 0);
+		CHECK(snapshots.subscribe([owned = std::unique_ptr<int>(new int(0)), &snapped, &misplaced](const snapshot& value)
+		{
+			if (value.index != (*owned)++) ++misplaced;
+			for (const unsigned char byte : value.body) if (byte != static_cast<unsigned char>(value.index)) { ++misplaced; break; }
+			++snapped;
+		}) == 0);
+		joined.post_up();
+
+		// Dispatch until everything arrived; the message of the wrong size is not handled.
+		pollfd descriptor = { ticks.fd(), POLLIN, 0 }; // The descriptor waited on.
+		int handled = 0; // The number of messages handled.
+		for (const double deadline = test::now() + 5000; (ticked < SINGLE + BATCH || snapped < SNAPSHOTS) && test::now() < deadline; poll(&descriptor, 1, 100))
+		{
+			const int count = snapshots.dispatch(); // The number of messages handled at once.
+			if (CHECK(count != -1)) handled += count;
+		}
+		CHECK(ticked == SINGLE + BATCH && snapped == SNAPSHOTS && misplaced == 0 && handled == ticked + snapped);
+
+		// Once it left the snapshot channel, nobody follows it any more.
+		CHECK(snapshots.unsubscribe() == 0);
+		left.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+
+	// A process subscribed with a notification handler cannot subscribe through a typed channel.
+	const pid_t handled = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(3), [](nipc_message* const msg) { nipc_message_release(msg); }) == 0);
+		nipc::channel<tick> ticks(id, NIPC_MULTICAST(1)); // The channel of the ticks.
+		CHECK(ticks.subscribe([](const tick&) {}) == -1 && errno == EINVAL);
+		CHECK(nipc::detail::routes[id].empty());
+		joined.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(2);
+
+	// Send ticks one at a time, a message of the wrong size, ticks at once, and snapshots.
+	const nipc::channel<tick> ticks(id, NIPC_MULTICAST(1)); // The channel of the ticks.
+	const nipc::channel<snapshot> snapshots(id, NIPC_MULTICAST(2)); // The channel of the snapshots.
+	for (long index = 0; index < SINGLE; ++index) CHECK(ticks.send(tick{ index, index * 0.5 }) == 0);
+	CHECK(nipc_send(id, nipc_message(NIPC_MULTICAST(1), getpid(), "short"), NIPC_MULTICAST(1)) == 0);
+	tick batch[BATCH]; // The ticks sent at once.
+	for (long index = 0; index < BATCH; ++index) batch[index] = tick{ SINGLE + index, (SINGLE + index) * 0.5 };
+	CHECK(ticks.send(batch, BATCH) == 0);
+	for (int index = 0; index < SNAPSHOTS; ++index) CHECK(snapshots.send(make(index)) == 0);
+	left.wait_up();
+	CHECK(snapshots.send(make(SNAPSHOTS)) == -1 && errno == ENODATA);
+
+	// Let the children go and remove the instance.
+	done.post_down(2);
+	CHECK(test::join(child));
+	CHECK(test::join(handled));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test19");
+}
+
+// End of tests/test19.cpp
@@ -1,50 +1,136 @@
-//TODO: do
-
-// tests/test2.c
+// tests/test2.cpp
 
 /**
- * @file  tests/test2.c
- * @brief  NIPC test case number 2
+ * @file  tests/test2.cpp
+ * @brief  NIPC test case number 2: broadcast, multicast and unicast fan-out across many processes
  * @date  26/12/2023
  * @version  1.0.0
+ * @remark  Every child follows one of a few channels; each must receive every broadcast, the multicasts of its own channel only, and the unicast addressed to it only.
+ * @remark  Messages are sent in waves that reach every child at most once, and every child acknowledges a wave before the next one, so that no two notifications of a child are ever pending at once.
  */
 
-#include <stdio.h>		// printf
-#include <stdlib.h>		// exit
-#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+#include <cerrno>		// errno, ENODATA
+#include <cstdio>		// snprintf
+#include <cstdlib>		// atoi
+#include <atomic>		// std::atomic
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495002;
+
+// The number of subscribing processes.
+const int CHILDREN = 16;
+
+// The number of multicast channels the children are spread over; one more channel is left without subscribers.
+const int CHANNELS = 4;
+
+// The number of broadcasts, and of multicasts to every channel.
+const int ROUNDS = 10;
+
+// The number of waves: a broadcast and a multicast to every channel in every round, then a unicast to every child.
+const int WAVES = 2 * ROUNDS + 1;
+
+// The channel this process follows.
+int channel = 0;
+
+// The number of broadcasts, multicasts and unicasts this process received.
+std::atomic<int> broadcasts(0), multicasts(0), unicasts(0);
+
+// The number of messages this process received that were not meant for it.
+std::atomic<int> strays(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts every message by how it was addressed, as its payload tells.
+ * @param  msg  {nipc_message* const}  The message; its payload is `b`, `m<channel>` or `u<pid>`.
+ */
+void handler(nipc_message* const msg)
+{
+	if (msg->data[0] == 'b') ++broadcasts;
+	else if (msg->data[0] == 'm' && atoi(msg->data + 1) == channel) ++multicasts;
+	else if (msg->data[0] == 'u' && atoi(msg->data + 1) == getpid()) ++unicasts;
+	else ++strays;
+	nipc_message_release(msg);
+}
 
-#include <sys/shm.h>
-#include <unistd.h>
-#include <stdlib.h>
-#include <sys/wait.h>
+/**
+ * @name  received()
+ * @brief  Checks whether this process received everything sent up to the end of a wave, and nothing more.
+ * @param  wave  {const int}  The index of the wave.
+ * @return  {const bool}  Whether the counters match.
+ */
+const bool received(const int wave)
+{
+	if (wave == WAVES - 1) return broadcasts == ROUNDS && multicasts == ROUNDS && unicasts == 1;
+	return broadcasts == wave / 2 + 1 && multicasts == (wave + 1) / 2 && unicasts == 0;
+}
 
 int main(const int argc, const char* const argv[], const char* const envp[])
 {
-	key_t key = ftok(".",65); 
-	int shmid = shmget(key,sizeof(int*),0666|IPC_CREAT); 
-	int **shm_ptr = (int**) shmat(shmid,(void*)0,0); 
-	*shm_ptr = (int*) malloc(sizeof(int));
-	**shm_ptr = 9000;
-	printf("Shared memory pointer: %p\n", shm_ptr);
-	printf("Address of the int: %p\n", *shm_ptr);
-
-	int pid = fork();
-	if(pid == 0)
+	// Create the instance.
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every child follows one channel and acknowledges every wave once it received what the wave meant for it.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate waves[WAVES]; // The gates the children wait at before checking every wave.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
 	{
-		printf("Read from shared memory: %d\n", **shm_ptr);
-		printf("Shared memory pointer: %p\n", shm_ptr);
-		printf("Address of the int: %p\n", *shm_ptr);
+		channel = 1 + child % CHANNELS;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(channel), handler) == 0);
+		joined.post_up();
+		for (int wave = 0; wave < WAVES; ++wave)
+		{
+			waves[wave].wait_down();
+			CHECK(test::wait_until([&]() { return received(wave); }));
+			waves[wave].post_up();
+		}
+		done.wait_down();
+		CHECK(received(WAVES - 1));
+		CHECK(strays == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// A channel nobody follows has no recipients.
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "m5"), NIPC_MULTICAST(CHANNELS + 1)) == -1 && errno == ENODATA);
 
-		exit(EXIT_SUCCESS);
+	// Broadcast, then multicast to every channel, in every round.
+	for (int wave = 0; wave < WAVES - 1; ++wave)
+	{
+		if (wave % 2 == 0) CHECK(nipc_send(id, nipc_message(1, getpid(), "b"), NIPC_BROADCAST) == 0);
+		else for (int target = 1; target <= CHANNELS; ++target)
+		{
+			char payload[16]; // The payload naming the channel.
+			snprintf(payload, sizeof(payload), "m%d", target);
+			CHECK(nipc_send(id, nipc_message(1, getpid(), payload), NIPC_MULTICAST(target)) == 0);
+		}
+		waves[wave].post_down(CHILDREN);
+		waves[wave].wait_up(CHILDREN);
 	}
-	else 
+
+	// Unicast to every child.
+	for (int child = 0; child < CHILDREN; ++child)
 	{
-		wait(NULL);
-		shmdt(shm_ptr); 
-		shmctl(shmid,IPC_RMID,NULL); 
+		char payload[16]; // The payload naming the child.
+		snprintf(payload, sizeof(payload), "u%d", static_cast<int>(children[child]));
+		CHECK(nipc_send(id, nipc_message(1, getpid(), payload), NIPC_UNICAST(children[child])) == 0);
 	}
+	waves[WAVES - 1].post_down(CHILDREN);
+	waves[WAVES - 1].wait_up(CHILDREN);
 
-	exit(EXIT_SUCCESS);
+	// Let the children go and remove the instance.
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test2");
 }
 
-// End of tests/test2.c
+// End of tests/test2.cpp
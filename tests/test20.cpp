@@ -0,0 +1,171 @@
+// tests/test20.cpp
+
+/**
+ * @file  tests/test20.cpp
+ * @brief  NIPC test case number 20: request and reply
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Calls made by several processes at once must each get the reply to their own request, a call that times out must not receive a late reply nor spoil the next call, and calling a process that does not listen, or that is killed before replying, must fail with `ESRCH`.
+ */
+
+#include <cerrno>		// errno, EINVAL, EMSGSIZE, EAGAIN, ETIMEDOUT, ECANCELED, ESRCH
+#include <thread>		// std::thread
+#include <vector>		// std::vector
+#include <signal.h>		// kill, SIGKILL
+#include <sys/wait.h>		// waitpid, WIFSIGNALED, WTERMSIG
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_listen, nipc_accept, nipc_reply, nipc_call, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::now, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495020;
+
+// The number of threads the responder accepts calls on.
+const int THREADS = 2;
+
+// The number of calling processes, and the number of calls each of them makes.
+const int CALLERS = 3, CALLS = 200;
+
+// The request that makes a responder thread stop, and the one it answers too late.
+const int STOP = -1, SLOW = -2;
+
+// The number of milliseconds the caller of a slow request waits for, and the responder takes to answer it.
+const int PATIENCE = 50, DELAY = 200;
+
+/**
+ * @name  request()
+ * @brief  Builds a request or reply carrying a number.
+ * @param  value  {const int}  The number.
+ * @return  {nipc_message}  The message.
+ */
+nipc_message request(const int value) { return nipc_message(1, getpid(), &value, sizeof(value)); }
+
+/**
+ * @name  value()
+ * @brief  Reads the number a request or reply carries.
+ * @param  msg  {const nipc_message&}  The message.
+ * @return  {const int}  The number.
+ */
+const int value(const nipc_message& msg) { return *static_cast<const int*>(msg.payload()); }
+
+/**
+ * @name  respond()
+ * @brief  Answers calls with twice their number until asked to stop, taking its time over slow requests.
+ * @param  id  {const int}  The ID of the instance.
+ */
+void respond(const int id)
+{
+	for (;;)
+	{
+		nipc_message msg; // The request.
+		uint64_t call; // The handle of the call.
+		if (!CHECK(nipc_accept(id, &msg, &call) == 0)) return;
+		const int number = value(msg); // The number of the request.
+
+		// The caller of a slow request gave up by the time it is answered.
+		if (number == SLOW) { test::sleep(DELAY); CHECK(nipc_reply(id, call, request(2 * number)) == -1 && errno == ECANCELED); continue; }
+
+		// A call is answered once only, and with a reply that fits inline.
+		const std::vector<char> large(NIPC_INLINE_SIZE + 1, 'x'); // A payload too large to fit inline.
+		CHECK(nipc_reply(id, call, nipc_message(1, getpid(), large.data(), large.size())) == -1 && errno == EMSGSIZE);
+		CHECK(nipc_reply(id, call, request(2 * number)) == 0);
+		CHECK(nipc_reply(id, call, request(2 * number)) == -1 && errno == ECANCELED);
+		if (number == STOP) return;
+	}
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Create the instance; only listening processes can be called, with a request that fits inline, and only they can accept calls.
+	nipc_remove(KEY);
+	CHECK(nipc_create(KEY) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+	nipc_message reply; // The reply to a call.
+	uint64_t call; // The handle of a call.
+	const std::vector<char> large(NIPC_INLINE_SIZE + 1, 'x'); // A payload too large to fit inline.
+	CHECK(nipc_call(id, getpid(), request(1), &reply, PATIENCE) == -1 && errno == ESRCH);
+	CHECK(nipc_call(id, getpid(), request(1), nullptr) == -1 && errno == EINVAL);
+	CHECK(nipc_call(id, getpid(), nipc_message(1, getpid(), large.data(), large.size()), &reply) == -1 && errno == EMSGSIZE);
+	CHECK(nipc_accept(id, &reply, &call, 0) == -1 && errno == EINVAL);
+
+	// The responder answers on several threads once it checked that nothing is pending yet.
+	const test::gate joined; // The gate the parent waits at once the responders listen.
+	const pid_t responder = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_message msg; // A request.
+		uint64_t call; // The handle of a call.
+		CHECK(nipc_listen(id) == 0);
+		CHECK(nipc_listen(id) == 0);
+		CHECK(nipc_accept(id, &msg, &call, 0) == -1 && errno == EAGAIN);
+		CHECK(nipc_accept(id, &msg, &call, 20) == -1 && errno == ETIMEDOUT);
+		CHECK(nipc_accept(id, nullptr, &call, 0) == -1 && errno == EINVAL);
+		CHECK(nipc_reply(id, NIPC_MAX_CALLS, request(0)) == -1 && errno == EINVAL);
+		joined.post_up();
+		std::thread threads[THREADS]; // The threads accepting calls.
+		for (std::thread& thread : threads) thread = std::thread(respond, id);
+		for (std::thread& thread : threads) thread.join();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// Several processes call at once, and every reply matches its request.
+	pid_t callers[CALLERS]; // The PIDs of the calling children.
+	for (int caller = 0; caller < CALLERS; ++caller) callers[caller] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_message reply; // The reply to a call.
+		for (int index = 0; index < CALLS; ++index)
+		{
+			const int number = caller * CALLS + index; // The number of the request.
+			if (CHECK(nipc_call(id, responder, request(number), &reply, 5000) == 0)) CHECK(value(reply) == 2 * number && reply.sender == responder);
+		}
+		CHECK(nipc_close(id) == 0);
+	});
+
+	// A call that times out gives up, and the next one gets its own reply rather than the late one.
+	const double started = test::now(); // The time the slow call was made at.
+	CHECK(nipc_call(id, responder, request(SLOW), &reply, PATIENCE) == -1 && errno == ETIMEDOUT);
+	CHECK(test::now() - started >= PATIENCE && test::now() - started < DELAY);
+	CHECK(nipc_call(id, responder, request(7), &reply, 5000) == 0 && value(reply) == 14);
+	for (int caller = 0; caller < CALLERS; ++caller) CHECK(test::join(callers[caller]));
+
+	// Stop every responder thread; the one busy with the slow request takes its stop once done with it.
+	for (int thread = 0; thread < THREADS; ++thread) CHECK(nipc_call(id, responder, request(STOP), &reply, 5000) == 0 && value(reply) == 2 * STOP);
+	CHECK(test::join(responder));
+
+	// A responder killed while a call waits on it fails the call; it is called from a sibling, since the parent cannot reap it while calling.
+	const test::gate ready; // The gate the caller waits at until the responder listens.
+	const pid_t victim = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_message msg; // The request.
+		uint64_t call; // The handle of the call.
+		CHECK(nipc_listen(id) == 0);
+		joined.post_up();
+		CHECK(nipc_accept(id, &msg, &call) == 0);
+		kill(getpid(), SIGKILL);
+	});
+	const pid_t caller = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		nipc_message reply; // The reply to the call.
+		ready.wait_down();
+		const double started = test::now(); // The time the call was made at.
+		CHECK(nipc_call(id, victim, request(1), &reply, 5000) == -1 && errno == ESRCH);
+		CHECK(test::now() - started < 5000);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+	ready.post_down();
+	int status; // The exit status of the killed responder.
+	CHECK(waitpid(victim, &status, 0) == victim && WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+	CHECK(test::join(caller));
+
+	// Remove the instance.
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test20");
+}
+
+// End of tests/test20.cpp
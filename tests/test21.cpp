@@ -0,0 +1,156 @@
+// tests/test21.cpp
+
+/**
+ * @file  tests/test21.cpp
+ * @brief  NIPC test case number 21: sharded message queues
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  With the inboxes of many subscribers spread over several message queues, every subscriber must receive the messages of several concurrent publishers once and in order, unicasts must find the shard of their recipient, and each shard must only hold the messages of its own subscribers.
+ */
+
+#include <cerrno>		// errno, EINVAL
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <sys/msg.h>		// msqid_ds, msgctl, IPC_STAT
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_stats, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495021;
+
+// The number of message queues the inboxes are spread over.
+const unsigned int SHARDS = 8U;
+
+// The number of subscribing processes.
+const int CHILDREN = 16;
+
+// The number of publishing processes, and the number of messages each of them multicasts.
+const int PUBLISHERS = 4, MESSAGES = 25;
+
+// The number of messages broadcast by the parent while the subscribers are not reading.
+const int STALLED = 5;
+
+// The number of messages every child should receive: the broadcasts, the multicasts and its unicast.
+const int EXPECTED = STALLED + PUBLISHERS * MESSAGES + 1;
+
+/**
+ * @name  payload
+ * @brief  The payload of every message.
+ */
+struct payload
+{
+	// The index of the publisher, `PUBLISHERS` for the parent's broadcasts or `-1` for its unicasts.
+	int publisher;
+
+	// The index of the message among those of its publisher, or of the recipient for unicasts.
+	int index;
+};
+
+// The index of the next message expected from every publisher, the parent's broadcasts last.
+std::atomic<int> next[PUBLISHERS + 1];
+
+// The index of the child, which its unicast must carry.
+int self = -1;
+
+// The number of messages this process received, and of those out of order or meant for another child.
+std::atomic<int> received(0), misplaced(0);
+
+/**
+ * @name  handler()
+ * @brief  Checks that every message received comes in order from its publisher, or is this child's unicast, and releases it.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	const payload& data = *static_cast<const payload*>(msg->payload()); // The payload of the message.
+	if (data.publisher == -1 ? data.index != self : data.publisher < 0 || data.publisher > PUBLISHERS || next[data.publisher]++ != data.index) ++misplaced;
+	++received;
+	nipc_message_release(msg);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Create the instance; it needs at least one shard, and no more than it can record.
+	nipc_remove(KEY);
+	nipc_options options; // The options of the instance.
+	options.queue_shards = 0U;
+	CHECK(nipc_create(KEY, options) == -1 && errno == EINVAL);
+	options.queue_shards = NIPC_MAX_SHARDS + 1;
+	CHECK(nipc_create(KEY, options) == -1 && errno == EINVAL);
+	options.queue_shards = SHARDS;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance, which is that of its first shard.
+
+	// The children hold off their notifications until the parent looked at the first shard.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		self = child;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([]() { return received == EXPECTED; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == EXPECTED && misplaced == 0);
+		for (int publisher = 0; publisher < PUBLISHERS; ++publisher) CHECK(next[publisher] == MESSAGES);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Every broadcast is delivered to every child, but the first shard only holds the copies of the children whose PIDs hash to it.
+	int first = 0; // The number of children in the first shard.
+	for (int child = 0; child < CHILDREN; ++child) if (static_cast<unsigned int>(children[child]) % SHARDS == 0) ++first;
+	for (int index = 0; index < STALLED; ++index)
+	{
+		const payload data = { PUBLISHERS, index }; // The payload of the broadcast.
+		CHECK(nipc_send(id, nipc_message(1, getpid(), &data, sizeof(data)), NIPC_BROADCAST) == 0);
+	}
+	msqid_ds queue; // The state of the first shard.
+	nipc_instance_stats stats; // The counters of the instance.
+	CHECK(msgctl(id, IPC_STAT, &queue) == 0 && queue.msg_qnum == static_cast<msgqnum_t>(STALLED * first));
+	CHECK(nipc_stats(id, &stats) == 0 && stats.delivered == static_cast<uint64_t>(STALLED * CHILDREN));
+	joined.post_down(CHILDREN);
+
+	// Several publishers multicast at once, and the parent unicasts to every child.
+	pid_t publishers[PUBLISHERS]; // The PIDs of the publishers.
+	for (int publisher = 0; publisher < PUBLISHERS; ++publisher) publishers[publisher] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		for (int index = 0; index < MESSAGES; ++index)
+		{
+			const payload data = { publisher, index }; // The payload of the multicast.
+			CHECK(nipc_send(id, nipc_message(1, getpid(), &data, sizeof(data)), NIPC_MULTICAST(1)) == 0);
+		}
+		CHECK(nipc_close(id) == 0);
+	});
+	for (int child = 0; child < CHILDREN; ++child)
+	{
+		const payload data = { -1, child }; // The payload of the unicast.
+		CHECK(nipc_send(id, nipc_message(1, getpid(), &data, sizeof(data)), NIPC_UNICAST(children[child])) == 0);
+	}
+	for (int publisher = 0; publisher < PUBLISHERS; ++publisher) CHECK(test::join(publishers[publisher]));
+
+	// Once the children received everything, the first shard is empty and the counters agree.
+	done.wait_up(CHILDREN);
+	CHECK(msgctl(id, IPC_STAT, &queue) == 0 && queue.msg_qnum == 0);
+	CHECK(nipc_stats(id, &stats) == 0 && stats.delivered == static_cast<uint64_t>(EXPECTED * CHILDREN) && stats.received == stats.delivered);
+
+	// Let the children go and remove the instance.
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test21");
+}
+
+// End of tests/test21.cpp
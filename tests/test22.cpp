@@ -0,0 +1,144 @@
+// tests/test22.cpp
+
+/**
+ * @file  tests/test22.cpp
+ * @brief  NIPC test case number 22: reaping dead subscribers and partial failures
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Subscribers killed without closing the instance must be reaped, by `nipc_reap()` or by the next send that finds them, with the messages they left purged; a send must go on past recipients it cannot deliver to, report each of them, and still deliver to the others.
+ */
+
+#include <cerrno>		// errno, EAGAIN, ESRCH
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, kill, SIGKILL, SIG_BLOCK, SIG_UNBLOCK
+#include <sys/msg.h>		// msqid_ds, msgctl, IPC_STAT
+#include <sys/wait.h>		// waitpid, WIFSIGNALED
+#include <unistd.h>		// getpid, pause
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_send_batch, nipc_reap, nipc_stats, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495022;
+
+// The subscribing processes, in the order they subscribe: one that stops reading, one killed and reaped on demand, one that reads until it is killed and found dead by a send, and one that keeps reading.
+enum role { FULL, REAPED, FOUND, READER, CHILDREN };
+
+// The number of messages every subscriber may have waiting, which is also the number broadcast before anyone dies.
+const unsigned int QUOTA = 10U;
+
+// The number of messages sent in the batch that finds a dead subscriber.
+const size_t BATCH = 5;
+
+// The number of messages this process received.
+std::atomic<unsigned int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts and releases every message received.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  kill9()
+ * @brief  Kills a child without letting it close the instance, and waits for it so that its PID no longer exists.
+ * @param  pid  {const pid_t}  The PID of the child.
+ * @return  {const bool}  Whether the child was killed.
+ */
+const bool kill9(const pid_t pid)
+{
+	int status; // The exit status of the child.
+	return kill(pid, SIGKILL) == 0 && waitpid(pid, &status, 0) == pid && WIFSIGNALED(status);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Create the instance; subscribers at their quota fail sends rather than hold them up.
+	nipc_remove(KEY);
+	nipc_options options; // The options of the instance.
+	options.quota = QUOTA;
+	options.overflow = NIPC_OVERFLOW_FAIL;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Only the readers take their messages as they come; the others hold off their notifications.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate read; // The gate the parent waits at once the readers received the first broadcasts.
+	const test::gate done; // The gate the surviving children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child)
+	{
+		children[child] = test::spawn([&]()
+		{
+			sigset_t signals; // The notification signal.
+			sigemptyset(&signals);
+			sigaddset(&signals, NIPC_SIGNAL);
+			if (child == FULL || child == REAPED) sigprocmask(SIG_BLOCK, &signals, nullptr);
+			const int id = nipc_get(KEY); // The ID of the instance.
+			CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+			joined.post_up();
+			if (child == FOUND || child == READER) { CHECK(test::wait_until([]() { return received == QUOTA; })); read.post_up(); }
+			if (child == REAPED || child == FOUND) for (;;) pause();
+			joined.wait_down();
+			sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+			const unsigned int expected = child == READER ? QUOTA + BATCH : QUOTA; // The number of messages to receive.
+			CHECK(test::wait_until([&]() { return received == expected; }));
+			done.post_up();
+			done.wait_down();
+			CHECK(received == expected);
+			CHECK(nipc_close(id) == 0);
+		});
+		joined.wait_up();
+	}
+
+	// Fill the inboxes of the subscribers that do not read up to the quota.
+	for (unsigned int index = 0; index < QUOTA; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "before"), NIPC_BROADCAST) == 0);
+	read.wait_up(2);
+
+	// A subscriber killed is reaped on demand, with everything it left behind, and only once.
+	nipc_instance_stats stats; // The counters of the instance.
+	CHECK(kill9(children[REAPED]));
+	CHECK(nipc_reap(id) == 1);
+	CHECK(nipc_reap(id) == 0);
+	CHECK(nipc_stats(id, &stats) == 0 && stats.subscribers == CHILDREN - 1 && stats.reaped == 1 && stats.purged == QUOTA);
+
+	// A send finding that the other reader died reaps it and reports it, reports the full subscriber, and still delivers to the surviving reader.
+	CHECK(kill9(children[FOUND]));
+	nipc_message batch[BATCH]; // The messages sent at once.
+	for (size_t index = 0; index < BATCH; ++index) batch[index] = nipc_message(1, getpid(), "after");
+	nipc_delivery deliveries[CHILDREN]; // The outcomes of the recipients.
+	for (nipc_delivery& delivery : deliveries) delivery.pid = -1;
+	CHECK(nipc_send_batch(id, batch, BATCH, NIPC_BROADCAST, deliveries, CHILDREN) == -1 && errno == EAGAIN);
+	size_t purged = QUOTA; // The number of messages purged from the dead subscribers.
+	int reported = 0; // The number of recipients reported.
+	for (const nipc_delivery& delivery : deliveries)
+	{
+		if (delivery.pid == -1) continue;
+		++reported;
+		if (delivery.pid == children[FULL]) CHECK(delivery.delivered == 0 && delivery.error == EAGAIN);
+		else if (delivery.pid == children[FOUND]) { CHECK(delivery.delivered == BATCH && delivery.error == ESRCH); purged += delivery.delivered; }
+		else CHECK(delivery.pid == children[READER] && delivery.delivered == BATCH && delivery.error == 0);
+	}
+	CHECK(reported == CHILDREN - 1);
+	CHECK(nipc_stats(id, &stats) == 0 && stats.subscribers == CHILDREN - 2 && stats.reaped == 2 && stats.purged == purged);
+
+	// The survivors receive what they were delivered, and nothing the dead left is still queued.
+	joined.post_down(2);
+	done.wait_up(2);
+	msqid_ds queue; // The state of the message queue.
+	CHECK(msgctl(id, IPC_STAT, &queue) == 0 && queue.msg_qnum == 0);
+
+	// Let the survivors go and remove the instance.
+	done.post_down(2);
+	CHECK(test::join(children[FULL]));
+	CHECK(test::join(children[READER]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+	test::finish("test22");
+}
+
+// End of tests/test22.cpp
@@ -0,0 +1,191 @@
+// tests/test23.cpp
+
+/**
+ * @file  tests/test23.cpp
+ * @brief  NIPC test case number 23: priority lanes
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Messages pending on higher lanes must be received before bulk traffic sent earlier, in order within each lane, they must neither count against the quota nor be evicted to make room for bulk traffic, and their latency must be counted per lane; a ring carries every message in order on lane `0`.
+ */
+
+#include <cerrno>		// errno, EINVAL, EAGAIN
+#include <atomic>		// std::atomic
+#include <vector>		// std::vector
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_stats, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495023;
+
+// The number of messages the subscriber may have waiting, which is also the number of bulk messages sent first.
+const unsigned int QUOTA = 8U;
+
+// The number of urgent messages sent, spread over every lane above `0`.
+const int URGENT = 6;
+
+// The number of bulk messages sent once the quota is used up.
+const int EXTRA = 4;
+
+// The payload of the first urgent message; the others follow it.
+const int FIRST = 100;
+
+// The number of messages sent in all.
+const int MESSAGES = QUOTA + URGENT + EXTRA;
+
+// The payloads and lanes of the messages this process received, in order.
+int indices[MESSAGES], lanes[MESSAGES];
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+/**
+ * @name  handler()
+ * @brief  Records the payload and lane of every message received and releases it.
+ * @param  msg  {nipc_message* const}  The message; its payload is its index as an `int`.
+ */
+void handler(nipc_message* const msg)
+{
+	const int index = received; // The position of the message among those received.
+	if (index < MESSAGES) { indices[index] = *static_cast<const int*>(msg->payload()); lanes[index] = static_cast<int>(msg->priority); }
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  lane()
+ * @brief  Picks the lane of an urgent message.
+ * @param  index  {const int}  The index of the message among the urgent ones.
+ * @return  {const unsigned int}  The lane, cycling from `1` up to `NIPC_LANES - 1`.
+ */
+const unsigned int lane(const int index) { return 1U + static_cast<unsigned int>(index) % (NIPC_LANES - 1); }
+
+/**
+ * @name  send()
+ * @brief  Sends a message on a lane.
+ * @param  id  {const int}  The ID of the instance.
+ * @param  index  {const int}  The payload of the message.
+ * @param  priority  {const unsigned int}  The lane.
+ * @return  {const int}  As for `nipc_send()`.
+ */
+const int send(const int id, const int index, const unsigned int priority)
+{
+	nipc_message msg(1, getpid(), &index, sizeof(index)); // The message.
+	msg.priority = priority;
+	return nipc_send(id, msg, NIPC_MULTICAST(1));
+}
+
+/**
+ * @name  sum()
+ * @brief  Adds up the buckets of a latency histogram.
+ * @param  histogram  {const uint64_t* const}  The histogram.
+ * @return  {const uint64_t}  The number of messages it counts.
+ */
+const uint64_t sum(const uint64_t* const histogram)
+{
+	uint64_t total = 0; // The number of messages counted.
+	for (unsigned int bucket = 0; bucket < NIPC_LATENCY_BUCKETS; ++bucket) total += histogram[bucket];
+	return total;
+}
+
+/**
+ * @name  run()
+ * @brief  Fills a stalled subscriber's quota with bulk messages, then sends urgent messages and more bulk ones, and checks the order it receives them in.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ * @param  overflow  {const nipc_overflow}  The overflow policy of the instance.
+ */
+void run(const nipc_transport transport, const nipc_overflow overflow)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	options.quota = QUOTA;
+	options.overflow = overflow;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+	const bool ring = transport == NIPC_TRANSPORT_RING; // Whether every message travels on lane `0`.
+	const bool evicts = !ring && overflow == NIPC_OVERFLOW_DROP_OLDEST; // Whether the last bulk messages evict the first ones.
+	const bool refuses = !ring && overflow == NIPC_OVERFLOW_FAIL; // Whether the last bulk messages are refused.
+
+	// On a ring, the messages arrive as sent; otherwise, the urgent ones come first, from the highest lane down, and the bulk ones left after them.
+	std::vector<int> expected; // The payloads of the messages the subscriber should receive, in order.
+	std::vector<unsigned int> expected_lanes; // The lanes they should be received on.
+	if (ring)
+	{
+		for (unsigned int index = 0; index < QUOTA; ++index) { expected.push_back(index); expected_lanes.push_back(0); }
+		for (int index = 0; index < URGENT; ++index) { expected.push_back(FIRST + index); expected_lanes.push_back(0); }
+		for (int index = 0; index < EXTRA; ++index) { expected.push_back(QUOTA + index); expected_lanes.push_back(0); }
+	}
+	else
+	{
+		for (unsigned int priority = NIPC_LANES - 1; priority > 0; --priority) for (int index = 0; index < URGENT; ++index) if (lane(index) == priority) { expected.push_back(FIRST + index); expected_lanes.push_back(priority); }
+		for (int index = evicts ? EXTRA : 0; index < static_cast<int>(refuses ? QUOTA : QUOTA + EXTRA); ++index) { expected.push_back(index); expected_lanes.push_back(0); }
+	}
+	const int count = static_cast<int>(expected.size()); // The number of messages the subscriber should receive.
+
+	// The subscriber holds off its notifications until everything was sent.
+	const test::gate joined; // The gate the child waits at once it subscribed.
+	const test::gate done; // The gate the child waits at once it received everything.
+	const pid_t child = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([&]() { return received == count; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == count);
+		for (int index = 0; index < count && index < MESSAGES; ++index) CHECK(indices[index] == expected[index] && lanes[index] == static_cast<int>(expected_lanes[index]));
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// Lanes stop below `NIPC_LANES`.
+	CHECK(send(id, -1, NIPC_LANES) == -1 && errno == EINVAL);
+
+	// Fill the quota with bulk messages; urgent messages still get through, and further bulk messages make room by evicting bulk ones only, or are refused.
+	for (unsigned int index = 0; index < QUOTA; ++index) CHECK(send(id, index, 0) == 0);
+	for (int index = 0; index < URGENT; ++index) CHECK(send(id, FIRST + index, lane(index)) == 0);
+	for (int index = 0; index < EXTRA; ++index)
+	{
+		const int result = send(id, QUOTA + index, 0); // The outcome of the send.
+		CHECK(refuses ? result == -1 && errno == EAGAIN : result == 0);
+	}
+	nipc_instance_stats stats; // The counters of the instance.
+	CHECK(nipc_stats(id, &stats) == 0 && stats.overflowed == static_cast<uint64_t>(evicts ? EXTRA : 0));
+	joined.post_down();
+
+	// Once everything was received, the latency of every message was counted on the lane it travelled on.
+	done.wait_up();
+	CHECK(nipc_stats(id, &stats) == 0 && sum(stats.latency) == static_cast<uint64_t>(count));
+	for (unsigned int priority = 0; priority < NIPC_LANES; ++priority)
+	{
+		uint64_t on_lane = 0; // The number of messages received on the lane.
+		for (const unsigned int received_lane : expected_lanes) if (received_lane == priority) ++on_lane;
+		CHECK(sum(stats.lane_latency[priority]) == on_lane);
+	}
+
+	// Let the child go and remove the instance.
+	done.post_down();
+	CHECK(test::join(child));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE, NIPC_OVERFLOW_DROP_OLDEST);
+	run(NIPC_TRANSPORT_QUEUE, NIPC_OVERFLOW_FAIL);
+	run(NIPC_TRANSPORT_RING, NIPC_OVERFLOW_BLOCK);
+	test::finish("test23");
+}
+
+// End of tests/test23.cpp
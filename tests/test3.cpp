@@ -1,21 +1,340 @@
-//TODO: do
-
-// tests/test3.c
+// tests/test3.cpp
 
 /**
- * @file  tests/test3.c
- * @brief  NIPC test case number 3
+ * @file  tests/test3.cpp
+ * @brief  NIPC test case number 3: the shared-memory message ring
  * @date  26/12/2023
  * @version  1.0.0
+ * @remark  Subscribers read every message in order from a ring they keep up with, skip to the oldest message still in a ring that lapped them, and never see a message torn by writers racing for the same slot.
+ * @remark  Writers killed between marking their slots and publishing them must hold up neither the subscribers nor the other writers.
+ */
+
+#include <cerrno>		// errno, ENODATA
+#include <cstring>		// memset, memcpy
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, kill, SIG_BLOCK, SIG_UNBLOCK, SIGKILL
+#include <sys/wait.h>		// waitpid
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_subscribe_poll, nipc_recv, nipc_send, nipc_send_batch, nipc_stats, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495003;
+
+// The number of subscribers reading along with the ring.
+const int READERS = 6;
+
+// The number of processes writing to the ring at once.
+const int WRITERS = 4;
+
+// The number of messages sent in each part of the test.
+const int MESSAGES = 40, LAPPING = 20, RACING = 500;
+
+// The number of slots of the ring that is lapped, the one that is raced for and the one writers are killed on.
+const unsigned int SMALL_RING = 8U, RACED_RING = 16U, CRASH_RING = 64U;
+
+// The number of messages a writer that is killed sends at once, and the largest number of writers killed before one is caught between marking and publishing its slots.
+const int CRASH_BATCH = 32, KILLS = 200;
+
+// The index of the message sent once every writer was killed, past any sent before.
+const int FINAL = KILLS * static_cast<int>(CRASH_RING);
+
+/**
+ * @name  sample
+ * @brief  The payload of a message raced for, filled with a pattern a torn copy would break.
+ */
+struct sample
+{
+	int writer; // The index of the writing process.
+	int index; // The index of the message among those of its writer.
+	unsigned char fill[120]; // The pattern, derived from `writer` and `index`.
+};
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+// The index of the first and of the last message this process received in order.
+int first = -1, last = -1;
+
+// The number of messages this process received out of order or torn.
+std::atomic<int> disordered(0), torn(0);
+
+// The index of the last message this process received from every writer.
+int latest[WRITERS];
+
+/**
+ * @name  pattern()
+ * @brief  Computes the fill byte of a sample.
+ * @param  writer  {const int}  The index of the writer.
+ * @param  index  {const int}  The index of the message.
+ * @param  offset  {const size_t}  The offset of the byte.
+ * @return  {const unsigned char}  The byte.
+ */
+const unsigned char pattern(const int writer, const int index, const size_t offset) { return static_cast<unsigned char>(writer * 31 + index * 7 + offset); }
+
+/**
+ * @name  ordered()
+ * @brief  Counts messages carrying an increasing index and releases them.
+ * @param  msg  {nipc_message* const}  The message; its payload is the index as an `int`.
+ */
+void ordered(nipc_message* const msg)
+{
+	int index; // The index of the message.
+	memcpy(&index, msg->data, sizeof(index));
+	if (first == -1) first = index;
+	if (index <= last) ++disordered;
+	last = index;
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  raced()
+ * @brief  Checks that samples are intact and in order per writer, and releases them.
+ * @param  msg  {nipc_message* const}  The message; its payload is a `sample`.
+ */
+void raced(nipc_message* const msg)
+{
+	sample payload; // The payload of the message.
+	memcpy(&payload, msg->data, sizeof(payload));
+	bool intact = payload.writer >= 0 && payload.writer < WRITERS; // Whether the sample was not torn.
+	for (size_t offset = 0; intact && offset < sizeof(payload.fill); ++offset) intact = payload.fill[offset] == pattern(payload.writer, payload.index, offset);
+	if (!intact) ++torn;
+	else if (payload.index <= latest[payload.writer]) ++disordered;
+	else latest[payload.writer] = payload.index;
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  keep_up()
+ * @brief  Checks that subscribers that keep up with the ring read every message addressed to them, in order.
+ */
+void keep_up()
+{
+	// Create a ring large enough for every message.
+	nipc_options options; // The options of the instance.
+	options.transport = NIPC_TRANSPORT_RING;
+	options.ring_slots = 64U;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every reader follows channel 1 and waits until it read every message.
+	const test::gate joined; // The gate the readers wait at once they subscribed.
+	const test::gate done; // The gate the readers wait at once they read everything.
+	pid_t readers[READERS]; // The PIDs of the readers.
+	for (int reader = 0; reader < READERS; ++reader) readers[reader] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), ordered) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([]() { return received == MESSAGES; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == MESSAGES && first == 0 && last == MESSAGES - 1 && disordered == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(READERS);
+
+	// Alternate broadcasts and multicasts to channel 1; multicasts to channel 2 find nobody.
+	for (int index = 0; index < MESSAGES; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), index % 2 ? NIPC_MULTICAST(1) : NIPC_BROADCAST) == 0);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "nobody"), NIPC_MULTICAST(2)) == -1 && errno == ENODATA);
+
+	// Let the readers go.
+	done.wait_up(READERS);
+	done.post_down(READERS);
+	for (int reader = 0; reader < READERS; ++reader) CHECK(test::join(readers[reader]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+/**
+ * @name  lap()
+ * @brief  Checks that a subscriber that falls more than a lap behind resumes at the oldest message still in the ring.
  */
+void lap()
+{
+	// Create a small ring.
+	nipc_options options; // The options of the instance.
+	options.transport = NIPC_TRANSPORT_RING;
+	options.ring_slots = SMALL_RING;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The reader holds off notifications until the ring has been lapped.
+	const test::gate joined; // The gate the reader waits at once it subscribed.
+	const test::gate done; // The gate the reader waits at once it read everything.
+	const pid_t reader = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), ordered) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([]() { return received == static_cast<int>(SMALL_RING); }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == static_cast<int>(SMALL_RING) && first == LAPPING - static_cast<int>(SMALL_RING) && last == LAPPING - 1 && disordered == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
 
-#include <stdio.h>		// printf
-#include <stdlib.h>		// exit
-#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_close, nipc_remove
+	// Send more than two laps' worth of messages, then let the reader catch up.
+	for (int index = 0; index < LAPPING; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), &index, sizeof(index)), NIPC_MULTICAST(1)) == 0);
+	joined.post_down();
+
+	// The reader skipped every message overwritten before it got to read it.
+	done.wait_up();
+	done.post_down();
+	CHECK(test::join(reader));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+/**
+ * @name  race()
+ * @brief  Checks that writers racing around a small ring never tear a message.
+ */
+void race()
+{
+	// Create a small ring.
+	nipc_options options; // The options of the instance.
+	options.transport = NIPC_TRANSPORT_RING;
+	options.ring_slots = RACED_RING;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The reader checks every sample it gets to read, down to the last message sent.
+	const test::gate joined; // The gate the reader waits at once it subscribed.
+	const test::gate done; // The gate the reader waits at once the writers are done.
+	const pid_t reader = test::spawn([&]()
+	{
+		for (int writer = 0; writer < WRITERS; ++writer) latest[writer] = -1;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), raced) == 0);
+		joined.post_up();
+		done.wait_down();
+		CHECK(test::wait_until([]() { for (int writer = 0; writer < WRITERS; ++writer) if (latest[writer] == RACING - 1) return true; return false; }));
+		CHECK(received > 0 && torn == 0 && disordered == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// The writers send at once, lapping each other and the reader.
+	const test::gate start; // The gate the writers wait at before sending.
+	pid_t writers[WRITERS]; // The PIDs of the writers.
+	for (int writer = 0; writer < WRITERS; ++writer) writers[writer] = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		start.wait_down();
+		sample payload; // The sample sent.
+		memset(&payload, 0, sizeof(payload));
+		payload.writer = writer;
+		for (payload.index = 0; payload.index < RACING; ++payload.index)
+		{
+			for (size_t offset = 0; offset < sizeof(payload.fill); ++offset) payload.fill[offset] = pattern(writer, payload.index, offset);
+			CHECK(nipc_send(id, nipc_message(1, getpid(), &payload, sizeof(payload)), NIPC_MULTICAST(1)) == 0);
+		}
+		CHECK(nipc_close(id) == 0);
+	});
+	start.post_down(WRITERS);
+	for (int writer = 0; writer < WRITERS; ++writer) CHECK(test::join(writers[writer]));
+
+	// Let the reader check what it read.
+	done.post_down();
+	CHECK(test::join(reader));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+/**
+ * @name  crash()
+ * @brief  Checks that slots left being written by writers that were killed are reclaimed by the readers and writers that come across them.
+ * @remark  Writers are killed at random points of their sends until one is caught between claiming positions and publishing them.  After every kill, this process sends a lap of messages, taking over every slot the writer may have left behind.
+ */
+void crash()
+{
+	// Create a ring.
+	nipc_options options; // The options of the instance.
+	options.transport = NIPC_TRANSPORT_RING;
+	options.ring_slots = CRASH_RING;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The reader must get past every slot the writers left behind, down to the last message sent; it polls the ring, so that it does not depend on notifications from the writers that are killed.
+	const test::gate joined; // The gate the reader waits at once it subscribed.
+	const test::gate done; // The gate the reader waits at once the writers were killed.
+	const pid_t reader = test::spawn([&]()
+	{
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe_poll(id, NIPC_MULTICAST(1)) == 0);
+		joined.post_up();
+		done.wait_down();
+		CHECK(test::wait_until([&]()
+		{
+			// The messages of the writers carry `-1`; those of this process carry an increasing index.
+			nipc_message msg; // The message received.
+			while (nipc_recv(id, &msg) == 0)
+			{
+				int index; // The index of the message.
+				memcpy(&index, msg.data, sizeof(index));
+				if (index < 0) continue;
+				if (index <= last) ++disordered;
+				last = index;
+			}
+			return last == FINAL;
+		}));
+		CHECK(disordered == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// Kill writers in the middle of their sends until one leaves slots behind.
+	nipc_instance_stats stats; // The counters of the instance.
+	const int dead = -1; // The payload of the messages sent by the writers that are killed.
+	for (int kills = 0; kills < KILLS && nipc_stats(id, &stats) == 0 && stats.reclaimed == 0; ++kills)
+	{
+		const test::gate started; // The gate the writer passes once it is about to send.
+		const pid_t writer = test::spawn([&]()
+		{
+			const int id = nipc_get(KEY); // The ID of the instance.
+			nipc_message batch[CRASH_BATCH]; // The messages sent at once.
+			for (nipc_message& msg : batch) msg = nipc_message(1, getpid(), &dead, sizeof(dead));
+			started.post_up();
+			while (true) nipc_send_batch(id, batch, CRASH_BATCH, NIPC_MULTICAST(1));
+		});
+		started.wait_up();
+		test::sleep(1 + kills % 3);
+		kill(writer, SIGKILL);
+		CHECK(waitpid(writer, nullptr, 0) == writer);
+
+		// A lap of messages goes through whatever the writer left behind.
+		nipc_message lap[CRASH_RING]; // The messages sent.
+		for (int index = 0; index < static_cast<int>(CRASH_RING); ++index) { const int payload = kills * static_cast<int>(CRASH_RING) + index; lap[index] = nipc_message(1, getpid(), &payload, sizeof(payload)); }
+		CHECK(nipc_send_batch(id, lap, CRASH_RING, NIPC_MULTICAST(1)) == 1);
+	}
+	CHECK(nipc_stats(id, &stats) == 0 && stats.reclaimed > 0);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), &FINAL, sizeof(FINAL)), NIPC_MULTICAST(1)) == 0);
+
+	// Let the reader check that it got to the last message.
+	done.post_down();
+	CHECK(test::join(reader));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
 
 int main(const int argc, const char* const argv[], const char* const envp[])
 {
-	exit(EXIT_SUCCESS);
+	nipc_remove(KEY);
+	keep_up();
+	lap();
+	race();
+	crash();
+	test::finish("test3");
 }
 
-// End of tests/test3.c
+// End of tests/test3.cpp
@@ -0,0 +1,107 @@
+// tests/test4.cpp
+
+/**
+ * @file  tests/test4.cpp
+ * @brief  NIPC test case number 4: futex notifications
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  With `NIPC_WAKEUP_FUTEX`, subscribers receive every message on their receiver thread, including those that arrive after the thread parked, without `NIPC_SIGNAL` ever being queued to them; both transports are tested.
+ */
+
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, sigpending, sigismember, SIG_BLOCK
+#include <sys/syscall.h>	// SYS_gettid
+#include <unistd.h>		// getpid, syscall
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495004;
+
+// The number of subscribing processes.
+const int CHILDREN = 4;
+
+// The number of messages sent in a burst.
+const int BURST = 200;
+
+// The number of messages this process received.
+std::atomic<int> received(0);
+
+// The number of messages this process handled on its main thread.
+std::atomic<int> on_main(0);
+
+/**
+ * @name  handler()
+ * @brief  Counts every message, and those handled on the main thread, and releases it.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	if (syscall(SYS_gettid) == getpid()) ++on_main;
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  run()
+ * @brief  Sends a burst of messages and, once the receivers parked, one more, and checks that every subscriber received them all.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	options.wakeup = NIPC_WAKEUP_FUTEX;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every child blocks the notification signal, so one queued to it would stay pending.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate burst; // The gate the children wait at once they received the burst.
+	const test::gate done; // The gate the children wait at once they received the last message.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([]() { return received == BURST; }));
+		burst.post_up();
+		CHECK(test::wait_until([]() { return received == BURST + 1; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == BURST + 1 && on_main == 0);
+		sigset_t pending; // The signals pending for the child.
+		CHECK(sigpending(&pending) == 0 && !sigismember(&pending, NIPC_SIGNAL));
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Send a burst, then one message once the receiver threads had time to park.
+	for (int index = 0; index < BURST; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "burst"), index % 2 ? NIPC_MULTICAST(1) : NIPC_BROADCAST) == 0);
+	burst.wait_up(CHILDREN);
+	test::sleep(50);
+	CHECK(nipc_send(id, nipc_message(1, getpid(), "parked"), NIPC_MULTICAST(1)) == 0);
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test4");
+}
+
+// End of tests/test4.cpp
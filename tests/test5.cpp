@@ -0,0 +1,118 @@
+// tests/test5.cpp
+
+/**
+ * @file  tests/test5.cpp
+ * @brief  NIPC test case number 5: draining everything pending in batches
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Subscribers that hold off their notifications while messages pile up must get all of them, in order, in full batches of `NIPC_BATCH_SIZE` once a single notification arrives; both transports are tested.
+ */
+
+#include <cstring>		// memcpy
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe_batch, nipc_send, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495005;
+
+// The number of subscribing processes.
+const int CHILDREN = 2;
+
+// The number of messages that pile up in the ring, and in the message queue, which must be able to hold them for every child at once.
+const int RING_MESSAGES = 100, QUEUE_MESSAGES = 25;
+
+// The number of messages this process expects.
+int expected = 0;
+
+// The number of messages and of batches this process received.
+std::atomic<int> received(0), batches(0);
+
+// The number of batches this process received that were empty, oversized or out of order.
+std::atomic<int> malformed(0);
+
+/**
+ * @name  handler()
+ * @brief  Checks and counts a batch of messages carrying consecutive indices.
+ * @param  msgs  {const nipc_message* const}  The batch.
+ * @param  n  {const size_t}  The number of messages in the batch.
+ */
+void handler(const nipc_message* const msgs, const size_t n)
+{
+	if (!n || n > NIPC_BATCH_SIZE) ++malformed;
+	for (size_t index = 0; index < n; ++index)
+	{
+		int value; // The index the message carries.
+		memcpy(&value, msgs[index].data, sizeof(value));
+		if (value != received + static_cast<int>(index)) { ++malformed; break; }
+	}
+	received += n;
+	++batches;
+}
+
+/**
+ * @name  run()
+ * @brief  Sends messages to subscribers holding off their notifications and checks that they drain them in full batches.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ * @param  messages  {const int}  The number of messages to send.
+ */
+void run(const nipc_transport transport, const int messages)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every child blocks the notification signal until the parent sent everything.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		expected = messages;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe_batch(id, NIPC_MULTICAST(1), handler) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([]() { return received == expected; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == messages && malformed == 0);
+		CHECK(batches == (messages + static_cast<int>(NIPC_BATCH_SIZE) - 1) / static_cast<int>(NIPC_BATCH_SIZE));
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Send everything, then let the children take their notification.
+	for (int index = 0; index < messages; ++index)
+	{
+		const nipc_message msg(1, getpid(), &index, sizeof(index)); // The message, carrying its index.
+		CHECK(nipc_send(id, msg, NIPC_MULTICAST(1)) == 0);
+	}
+	joined.post_down(CHILDREN);
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE, QUEUE_MESSAGES);
+	run(NIPC_TRANSPORT_RING, RING_MESSAGES);
+	test::finish("test5");
+}
+
+// End of tests/test5.cpp
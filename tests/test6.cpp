@@ -0,0 +1,129 @@
+// tests/test6.cpp
+
+/**
+ * @file  tests/test6.cpp
+ * @brief  NIPC test case number 6: handing messages to a pool of worker threads
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Subscribers with workers must handle every message off their main thread, spread over every worker, with the messages of each channel handled by a single worker in the order they were sent; both notification mechanisms are tested.
+ */
+
+#include <cstring>		// memcpy
+#include <atomic>		// std::atomic
+#include <sys/syscall.h>	// SYS_gettid
+#include <unistd.h>		// getpid, syscall, usleep
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495006;
+
+// The number of subscribing processes.
+const int CHILDREN = 3;
+
+// The number of worker threads of every subscriber.
+const unsigned int WORKERS = 4U;
+
+// The number of channels messages are spread over; a multiple of `WORKERS`, so every worker gets some.
+const int CHANNELS = 8;
+
+// The number of messages sent to every channel.
+const int MESSAGES = 50;
+
+// The number of messages this process received, and handled on its main thread.
+std::atomic<int> received(0), on_main(0);
+
+// The thread that handled every channel, or `0` until one did.
+std::atomic<long> handled_by[CHANNELS];
+
+// The index of the last message handled on every channel.
+std::atomic<int> latest[CHANNELS];
+
+// The number of messages handled out of order or by a different thread than the other messages of their channel.
+std::atomic<int> disordered(0), moved(0);
+
+/**
+ * @name  handler()
+ * @brief  Checks which thread handles a message and in what order, slowly, and releases it.
+ * @param  msg  {nipc_message* const}  The message; its `channel` is one of `CHANNELS` and its payload the index of the message on it.
+ */
+void handler(nipc_message* const msg)
+{
+	const long thread = syscall(SYS_gettid); // The thread handling the message.
+	int index; // The index of the message on its channel.
+	memcpy(&index, msg->data, sizeof(index));
+	if (thread == getpid()) ++on_main;
+	long expected = 0; // The thread expected to handle the channel.
+	if (!handled_by[msg->channel].compare_exchange_strong(expected, thread) && expected != thread) ++moved;
+	if (index != latest[msg->channel] + 1) ++disordered;
+	latest[msg->channel] = index;
+	usleep(100);
+	++received;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  run()
+ * @brief  Sends messages on several channels to subscribers with workers and checks how they were handled.
+ * @param  wakeup  {const nipc_wakeup}  The notification mechanism of the instance.
+ */
+void run(const nipc_wakeup wakeup)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.wakeup = wakeup;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every child subscribes with a pool of workers.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they handled everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		for (int channel = 0; channel < CHANNELS; ++channel) { handled_by[channel] = 0; latest[channel] = -1; }
+		nipc_subscriber_options subscriber; // The options of the subscription.
+		subscriber.workers = WORKERS;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler, subscriber) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([]() { return received == CHANNELS * MESSAGES; }, 20000));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == CHANNELS * MESSAGES && on_main == 0 && disordered == 0 && moved == 0);
+		unsigned int workers = 0; // The number of distinct threads that handled messages.
+		for (int channel = 0; channel < CHANNELS; ++channel)
+		{
+			bool seen = false; // Whether an earlier channel was handled by the same thread.
+			for (int earlier = 0; earlier < channel && !seen; ++earlier) seen = handled_by[earlier] == handled_by[channel];
+			if (!seen) ++workers;
+		}
+		CHECK(workers == WORKERS);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Interleave the channels.
+	for (int index = 0; index < MESSAGES; ++index) for (int channel = 0; channel < CHANNELS; ++channel)
+	{
+		const nipc_message msg(channel, getpid(), &index, sizeof(index)); // The message, carrying its index on its channel.
+		CHECK(nipc_send(id, msg, NIPC_MULTICAST(1)) == 0);
+	}
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_WAKEUP_SIGNAL);
+	run(NIPC_WAKEUP_FUTEX);
+	test::finish("test6");
+}
+
+// End of tests/test6.cpp
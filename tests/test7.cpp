@@ -0,0 +1,124 @@
+// tests/test7.cpp
+
+/**
+ * @file  tests/test7.cpp
+ * @brief  NIPC test case number 7: the message pool
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A subscriber holding on to every buffer of its pool must have the messages that find it exhausted left pending, and must get them as soon as it releases buffers, without losing any, on either transport; buffers that do not come from the pool are ignored on release.
+ */
+
+#include <cstring>		// strcmp
+#include <atomic>		// std::atomic
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_stats, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495007;
+
+// The number of buffers in the subscriber's pool.
+const unsigned int POOL = 8U;
+
+// The number of messages sent while the pool is held.
+const int MESSAGES = 20;
+
+// The buffers this process holds on to.
+nipc_message* held[POOL];
+
+// The number of messages this process received, and how many of those were sent before and after the pool was released.
+std::atomic<int> received(0), early(0), again(0);
+
+/**
+ * @name  handler()
+ * @brief  Holds on to the first messages received, without releasing them, and counts and releases the others.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void handler(nipc_message* const msg)
+{
+	const int index = received++; // The index of the message.
+	if (index < static_cast<int>(POOL)) { held[index] = msg; return; }
+	if (!strcmp(msg->data, "held")) ++early;
+	else if (!strcmp(msg->data, "again")) ++again;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  run()
+ * @brief  Exhausts a subscriber's pool, then checks that it gets every message left pending once it releases its buffers.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The subscriber holds off its notifications until everything was sent, so that a single drain finds its pool exhausted, then releases the pool.
+	const test::gate joined; // The gate the subscriber waits at once it subscribed.
+	const test::gate released; // The gate the subscriber waits at once it got the messages left pending.
+	const test::gate done; // The gate the subscriber waits at once it received the last messages.
+	const pid_t child = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		nipc_subscriber_options options; // The options of the subscription.
+		options.pool = POOL;
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), handler, options) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+
+		// Only a pool's worth of messages got a buffer; the others wait.
+		CHECK(test::wait_until([]() { return received == static_cast<int>(POOL); }));
+		test::sleep(50);
+		CHECK(received == static_cast<int>(POOL));
+		for (unsigned int index = 0; index < POOL; ++index) CHECK(!strcmp(held[index]->data, "held"));
+
+		// Released buffers go back to the pool and the waiting messages are delivered without another notification; buffers from elsewhere are ignored.
+		nipc_message outside(1, getpid(), "outside"); // A buffer that does not come from the pool.
+		nipc_message_release(&outside);
+		nipc_message_release(nullptr);
+		for (unsigned int index = 0; index < POOL; ++index) nipc_message_release(held[index]);
+		CHECK(test::wait_until([]() { return received == MESSAGES; }));
+		CHECK(early == MESSAGES - static_cast<int>(POOL));
+		released.post_up();
+		CHECK(test::wait_until([]() { return received == MESSAGES + static_cast<int>(POOL); }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == MESSAGES + static_cast<int>(POOL) && again == static_cast<int>(POOL));
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// Send more messages than the pool holds.
+	for (int index = 0; index < MESSAGES; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "held"), NIPC_MULTICAST(1)) == 0);
+	joined.post_down();
+
+	// Once the subscriber got every message, new ones keep arriving, and none was lost.
+	released.wait_up();
+	for (unsigned int index = 0; index < POOL; ++index) CHECK(nipc_send(id, nipc_message(1, getpid(), "again"), NIPC_MULTICAST(1)) == 0);
+	done.wait_up();
+	nipc_instance_stats stats; // The counters of the instance.
+	CHECK(nipc_stats(id, &stats) == 0 && stats.dropped == 0);
+	done.post_down();
+	CHECK(test::join(child));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test7");
+}
+
+// End of tests/test7.cpp
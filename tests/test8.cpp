@@ -0,0 +1,243 @@
+// tests/test8.cpp
+
+/**
+ * @file  tests/test8.cpp
+ * @brief  NIPC test case number 8: large payloads in the shared slab
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A payload shared by several subscribers must keep its blocks until the last of them releases the buffer holding it, even long after the notification handler returned, and the blocks must be reusable afterwards; the copying constructors must refuse to reference a large payload; a ring running the slab dry must evict its oldest payloads rather than fail sends.
+ */
+
+#include <cerrno>		// errno, ENOBUFS, EMSGSIZE, EINVAL
+#include <signal.h>		// sigset_t, sigemptyset, sigaddset, sigprocmask, SIG_BLOCK, SIG_UNBLOCK
+#include <atomic>		// std::atomic
+#include <vector>		// std::vector
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send, nipc_message_release, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::sleep, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495008;
+
+// The number of subscribing processes sharing a payload.
+const int CHILDREN = 4;
+
+// The size of the slab's blocks, and the number of them in the slab.
+const size_t BLOCK = 4096, BLOCKS = 16;
+
+// The size of the payload the subscribers hold on to, three blocks' worth.
+const size_t HELD = 2 * BLOCK + 100;
+
+// The number of payloads sent to the ring, which fills the slab several times over.
+const int LAPS = 20;
+
+// The number of messages this process received intact, and torn.
+std::atomic<int> received(0), torn(0);
+
+// The index of the last payload this process received from the ring.
+std::atomic<int> last(-1);
+
+/**
+ * @name  fill()
+ * @brief  Creates a payload filled with a pattern derived from its size and index.
+ * @param  size  {const size_t}  The size of the payload.
+ * @param  index  {const int}  The index of the payload, stored in its first byte.
+ * @return  {std::vector<unsigned char>}  The payload.
+ */
+std::vector<unsigned char> fill(const size_t size, const int index = 0)
+{
+	std::vector<unsigned char> payload(size); // The payload.
+	for (size_t offset = 0; offset < size; ++offset) payload[offset] = static_cast<unsigned char>(offset * 13 + size + index);
+	payload[0] = static_cast<unsigned char>(index);
+	return payload;
+}
+
+/**
+ * @name  intact()
+ * @brief  Checks that a received message carries the payload `fill()` created for its size and index.
+ * @param  msg  {const nipc_message* const}  The message.
+ * @return  {const bool}  Whether the payload is intact.
+ */
+const bool intact(const nipc_message* const msg)
+{
+	const unsigned char* const payload = static_cast<const unsigned char*>(msg->payload()); // The payload of the message.
+	if (msg->length <= NIPC_INLINE_SIZE || !msg->blob) return false;
+	for (size_t offset = 1; offset < msg->length; ++offset) if (payload[offset] != static_cast<unsigned char>(offset * 13 + msg->length + payload[0])) return false;
+	return true;
+}
+
+// The gates a subscriber holding on to a payload posts to and waits at; one per child.
+test::gate* holding[CHILDREN];
+
+// The index of this process among the children.
+int self = 0;
+
+// The buffer holding the payload this process holds on to, once received.
+std::atomic<nipc_message*> kept(nullptr);
+
+/**
+ * @name  hold()
+ * @brief  Checks a payload and, for the one to hold, keeps its buffer past the handler instead of releasing it.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void hold(nipc_message* const msg)
+{
+	if (!intact(msg)) ++torn;
+	else ++received;
+	if (msg->length == HELD) { kept = msg; holding[self]->post_up(); }
+	else nipc_message_release(msg);
+}
+
+/**
+ * @name  lapped()
+ * @brief  Checks a payload read from the ring and records its index.
+ * @param  msg  {nipc_message* const}  The message.
+ */
+void lapped(nipc_message* const msg)
+{
+	if (!intact(msg)) ++torn;
+	else { ++received; last = *static_cast<const unsigned char*>(msg->payload()); }
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  share()
+ * @brief  Checks that a payload held by several subscribers keeps its blocks until the last of them releases it.
+ */
+void share()
+{
+	// Create a small slab; the handlers run on receiver threads so that they may hold on to a payload.
+	nipc_options options; // The options of the instance.
+	options.wakeup = NIPC_WAKEUP_FUTEX;
+	options.slab_size = BLOCK * BLOCKS;
+	options.slab_block_size = BLOCK;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// Every child holds on to the buffer of the shared payload until let go, then checks that the payload is still intact.
+	test::gate gates[CHILDREN]; // The gates of the children.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN]; // The PIDs of the children.
+	for (int child = 0; child < CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		self = child;
+		for (int index = 0; index < CHILDREN; ++index) holding[index] = &gates[index];
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), hold) == 0);
+		joined.post_up();
+		gates[child].wait_down();
+		CHECK(kept && intact(kept));
+		nipc_message_release(kept);
+		CHECK(test::wait_until([]() { return received == 3; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == 3 && torn == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN);
+
+	// Malformed and oversized payloads are refused outright, and so are large payloads that were not borrowed.
+	nipc_message bare(1, getpid(), "bare"); // A message claiming a large payload it does not reference.
+	bare.length = NIPC_INLINE_SIZE + 1;
+	CHECK(nipc_send(id, bare, NIPC_BROADCAST) == -1 && errno == EINVAL);
+	const std::vector<unsigned char> oversized = fill(BLOCK * BLOCKS + 1); // A payload larger than the slab.
+	CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), oversized.data(), oversized.size()), NIPC_BROADCAST) == -1 && errno == EMSGSIZE);
+	const std::vector<unsigned char> shared = fill(HELD); // The payload the children hold on to.
+	const nipc_message copied(1, getpid(), shared.data(), shared.size()); // A message that copies its payload rather than referencing it.
+	CHECK(!copied.blob && copied.length == HELD);
+	CHECK(nipc_send(id, copied, NIPC_MULTICAST(1)) == -1 && errno == EINVAL);
+
+	// While the children hold the shared payload, a payload needing every other block and one more does not fit.
+	const std::vector<unsigned char> rest = fill((BLOCKS - 2) * BLOCK); // A payload needing one block more than the shared one leaves.
+	CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), shared.data(), shared.size()), NIPC_MULTICAST(1)) == 0);
+	for (int child = 0; child < CHILDREN; ++child) gates[child].wait_up();
+	CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), rest.data(), rest.size()), NIPC_MULTICAST(1)) == -1 && errno == ENOBUFS);
+
+	// It still does not fit until the last child lets go of the shared payload.
+	for (int child = 0; child < CHILDREN - 1; ++child)
+	{
+		gates[child].post_down();
+		test::sleep(20);
+		CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), rest.data(), rest.size()), NIPC_MULTICAST(1)) == -1 && errno == ENOBUFS);
+	}
+	gates[CHILDREN - 1].post_down();
+	int sent = -1; // The outcome of the last send retried until the slab has room.
+	test::wait_until([&]() { return (sent = nipc_send(id, nipc_message::borrow(1, getpid(), rest.data(), rest.size()), NIPC_MULTICAST(1))) == 0 || errno != ENOBUFS; });
+	CHECK(sent == 0);
+
+	// Once every child is done with it too, the whole slab is free again.
+	const std::vector<unsigned char> whole = fill(BLOCKS * BLOCK); // A payload taking up the whole slab.
+	test::wait_until([&]() { return (sent = nipc_send(id, nipc_message::borrow(1, getpid(), whole.data(), whole.size()), NIPC_MULTICAST(1))) == 0 || errno != ENOBUFS; });
+	CHECK(sent == 0);
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN);
+	done.post_down(CHILDREN);
+	for (int child = 0; child < CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+/**
+ * @name  evict()
+ * @brief  Checks that a ring whose payloads fill the slab evicts the oldest of them rather than failing sends.
+ */
+void evict()
+{
+	// Create a ring whose slab holds fewer payloads than the ring does.
+	nipc_options options; // The options of the instance.
+	options.transport = NIPC_TRANSPORT_RING;
+	options.ring_slots = 64U;
+	options.slab_size = BLOCK * BLOCKS;
+	options.slab_block_size = BLOCK;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The reader holds off notifications until every payload was sent.
+	const test::gate joined; // The gate the reader waits at once it subscribed.
+	const test::gate done; // The gate the reader waits at once it read everything.
+	const pid_t reader = test::spawn([&]()
+	{
+		sigset_t signals; // The notification signal.
+		sigemptyset(&signals);
+		sigaddset(&signals, NIPC_SIGNAL);
+		sigprocmask(SIG_BLOCK, &signals, nullptr);
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(1), lapped) == 0);
+		joined.post_up();
+		joined.wait_down();
+		sigprocmask(SIG_UNBLOCK, &signals, nullptr);
+		CHECK(test::wait_until([]() { return last == LAPS - 1; }));
+		CHECK(received > 0 && received <= static_cast<int>(BLOCKS / 3) && torn == 0);
+		done.post_up();
+		done.wait_down();
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up();
+
+	// Every send succeeds, evicting the oldest payloads.
+	for (int index = 0; index < LAPS; ++index)
+	{
+		const std::vector<unsigned char> payload = fill(HELD, index); // The payload.
+		CHECK(nipc_send(id, nipc_message::borrow(1, getpid(), payload.data(), payload.size()), NIPC_MULTICAST(1)) == 0);
+	}
+	joined.post_down();
+
+	// Let the reader go and remove the instance.
+	done.wait_up();
+	done.post_down();
+	CHECK(test::join(reader));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	share();
+	evict();
+	test::finish("test8");
+}
+
+// End of tests/test8.cpp
@@ -0,0 +1,123 @@
+// tests/test9.cpp
+
+/**
+ * @file  tests/test9.cpp
+ * @brief  NIPC test case number 9: sending batches of messages
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  A batch must reach every recipient whole and in order, larger than the message queue can hold at once and mixing inline and slab payloads, with the outcome of every recipient reported up to the capacity given; both transports are tested.
+ */
+
+#include <cstring>		// memset
+#include <atomic>		// std::atomic
+#include <vector>		// std::vector
+#include <unistd.h>		// getpid
+#include "../src/NIPC.h"	// nipc_create, nipc_get, nipc_subscribe, nipc_send_batch, nipc_close, nipc_remove
+#include "test.h"		// CHECK, test::gate, test::spawn, test::join, test::wait_until, test::finish
+
+// The key of the instance under test.
+const key_t KEY = 0x4E495009;
+
+// The number of processes following channel 1; one more follows channel 2.
+const int CHILDREN = 5;
+
+// The number of messages in the multicast batch, and in the unicast batch.
+const int BATCH = 100, UNICASTS = 10;
+
+// The size of the payloads that go to the slab, and how often one does.
+const size_t LARGE = 1000;
+const int EVERY = 10;
+
+// The number of messages this process received in order and intact, and otherwise.
+std::atomic<int> received(0), malformed(0);
+
+/**
+ * @name  handler()
+ * @brief  Checks that a message carries the next index, in a payload of the expected size, and releases it.
+ * @param  msg  {nipc_message* const}  The message; its payload starts with its index as an `int`, and every byte after is the index's low byte.
+ */
+void handler(nipc_message* const msg)
+{
+	const unsigned char* const payload = static_cast<const unsigned char*>(msg->payload()); // The payload of the message.
+	const int index = *reinterpret_cast<const int*>(payload); // The index of the message.
+	bool intact = index == received && msg->length == (index % EVERY ? sizeof(int) : LARGE); // Whether the message is the one expected.
+	for (size_t offset = sizeof(int); intact && offset < msg->length; ++offset) intact = payload[offset] == static_cast<unsigned char>(index);
+	if (intact) ++received;
+	else ++malformed;
+	nipc_message_release(msg);
+}
+
+/**
+ * @name  run()
+ * @brief  Sends a batch to the followers of a channel and another to one process, and checks what was delivered and reported.
+ * @param  transport  {const nipc_transport}  The transport of the instance.
+ */
+void run(const nipc_transport transport)
+{
+	// Create the instance.
+	nipc_options options; // The options of the instance.
+	options.transport = transport;
+	CHECK(nipc_create(KEY, options) == 0);
+	const int id = nipc_get(KEY); // The ID of the instance.
+
+	// The last child follows channel 2 and only receives the unicast batch.
+	const test::gate joined; // The gate the children wait at once they subscribed.
+	const test::gate done; // The gate the children wait at once they received everything.
+	pid_t children[CHILDREN + 1]; // The PIDs of the children.
+	for (int child = 0; child <= CHILDREN; ++child) children[child] = test::spawn([&]()
+	{
+		const int expected = child < CHILDREN ? BATCH : UNICASTS; // The number of messages the child should receive.
+		const int id = nipc_get(KEY); // The ID of the instance.
+		CHECK(nipc_subscribe(id, NIPC_MULTICAST(child < CHILDREN ? 1 : 2), handler) == 0);
+		joined.post_up();
+		CHECK(test::wait_until([&]() { return received == expected; }));
+		done.post_up();
+		done.wait_down();
+		CHECK(received == expected && malformed == 0);
+		CHECK(nipc_close(id) == 0);
+	});
+	joined.wait_up(CHILDREN + 1);
+
+	// Build the batch; every tenth payload goes to the slab.
+	std::vector<std::vector<unsigned char>> payloads(BATCH); // The payloads of the messages.
+	std::vector<nipc_message> batch; // The messages.
+	for (int index = 0; index < BATCH; ++index)
+	{
+		payloads[index].assign(index % EVERY ? sizeof(int) : LARGE, static_cast<unsigned char>(index));
+		memcpy(payloads[index].data(), &index, sizeof(index));
+		batch.push_back(nipc_message::borrow(1, getpid(), payloads[index].data(), payloads[index].size()));
+	}
+
+	// Every follower of channel 1 is reported delivered the whole batch; reports beyond the capacity are left alone.
+	nipc_delivery deliveries[CHILDREN + 1]; // The outcomes of the recipients.
+	memset(deliveries, 0xFF, sizeof(deliveries));
+	CHECK(nipc_send_batch(id, batch.data(), BATCH, NIPC_MULTICAST(1), deliveries, CHILDREN) == CHILDREN);
+	for (int index = 0; index < CHILDREN; ++index)
+	{
+		bool known = false; // Whether the recipient follows channel 1.
+		for (int child = 0; child < CHILDREN; ++child) known = known || deliveries[index].pid == children[child];
+		CHECK(known && deliveries[index].delivered == BATCH && deliveries[index].error == 0 && deliveries[index].dropped == 0);
+	}
+	CHECK(deliveries[CHILDREN].pid == -1);
+
+	// A unicast batch reaches its recipient only.
+	CHECK(nipc_send_batch(id, batch.data(), UNICASTS, NIPC_UNICAST(children[CHILDREN]), deliveries, 1) == 1);
+	CHECK(deliveries[0].pid == children[CHILDREN] && deliveries[0].delivered == UNICASTS && deliveries[0].error == 0);
+
+	// Let the children go and remove the instance.
+	done.wait_up(CHILDREN + 1);
+	done.post_down(CHILDREN + 1);
+	for (int child = 0; child <= CHILDREN; ++child) CHECK(test::join(children[child]));
+	CHECK(nipc_close(id) == 0);
+	CHECK(nipc_remove(KEY) == 0);
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	nipc_remove(KEY);
+	run(NIPC_TRANSPORT_QUEUE);
+	run(NIPC_TRANSPORT_RING);
+	test::finish("test9");
+}
+
+// End of tests/test9.cpp
@@ -1 +1,79 @@
-//TODO: do
+// utils/build_script.cpp
+
+/**
+ * @file  utils/build_script.cpp
+ * @brief  Builds the NIPC tests, benchmark and utilities into the builds directory
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Run from the root of the repository; builds every target, or only the targets named on the command line.
+ * @remark  The compiler can be overridden through the `CXX` environment variable.
+ */
+
+#include <cstdio>		// printf, fprintf
+#include <cstdlib>		// exit, getenv, system, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>		// strcmp
+#include <string>		// std::string
+
+/**
+ * @name  build_target
+ * @brief  A program built from one source file linked with the library.
+ */
+struct build_target
+{
+	const char* name; // The name of the executable in the builds directory.
+	const char* source; // The source file of its `main`.
+};
+
+// The targets, in the order they are built.
+const build_target BUILD_TARGETS[] =
+{
+	{ "test1", "tests/test1.cpp" },
+	{ "test2", "tests/test2.cpp" },
+	{ "test3", "tests/test3.cpp" },
+	{ "test4", "tests/test4.cpp" },
+	{ "test5", "tests/test5.cpp" },
+	{ "test6", "tests/test6.cpp" },
+	{ "test7", "tests/test7.cpp" },
+	{ "test8", "tests/test8.cpp" },
+	{ "test9", "tests/test9.cpp" },
+	{ "test10", "tests/test10.cpp" },
+	{ "test11", "tests/test11.cpp" },
+	{ "test12", "tests/test12.cpp" },
+	{ "test13", "tests/test13.cpp" },
+	{ "test14", "tests/test14.cpp" },
+	{ "test15", "tests/test15.cpp" },
+	{ "test16", "tests/test16.cpp" },
+	{ "test17", "tests/test17.cpp" },
+	{ "test18", "tests/test18.cpp" },
+	{ "test19", "tests/test19.cpp" },
+	{ "test20", "tests/test20.cpp" },
+	{ "test21", "tests/test21.cpp" },
+	{ "test22", "tests/test22.cpp" },
+	{ "test23", "tests/test23.cpp" },
+	{ "benchmark", "benchmarks/benchmark.cpp" },
+	{ "trace_dump", "utils/trace_dump.cpp" }
+};
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Pick the compiler.
+	const char* const compiler = getenv("CXX") ? getenv("CXX") : "g++"; // The C++ compiler.
+	int status = EXIT_SUCCESS; // The exit status of the build.
+
+	for (const build_target& target : BUILD_TARGETS)
+	{
+		// Skip the targets not asked for, if any were.
+		bool wanted = argc < 2; // Whether the target is built.
+		for (int index = 1; index < argc && !wanted; ++index) wanted = !strcmp(argv[index], target.name);
+		if (!wanted) continue;
+
+		// Compile the target together with the library.
+		const std::string command = std::string(compiler) + " -std=c++17 -O2 -Wall -pthread -o builds/" + target.name + " " + target.source + " src/NIPC.cpp"; // The command building the target.
+		printf("%s\n", command.c_str());
+		if (system(command.c_str())) { fprintf(stderr, "build_script: %s failed\n", target.name); status = EXIT_FAILURE; }
+	}
+
+	exit(status);
+}
+
+// End of utils/build_script.cpp
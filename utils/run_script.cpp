@@ -1 +1,87 @@
-//TODO: do
+// utils/run_script.cpp
+
+/**
+ * @file  utils/run_script.cpp
+ * @brief  Runs the NIPC tests built into the builds directory and reports which passed
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Run from the root of the repository after `build_script`; runs every `builds/test<N>`, in order, or only the tests named on the command line.
+ * @remark  Each test runs in its own process and fails if it exits with a non-zero status or takes longer than `TEST_TIMEOUT` seconds.
+ */
+
+#include <cstdio>		// printf, fprintf, fflush
+#include <cstdlib>		// exit, strtoul, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>		// strcmp, strrchr
+#include <algorithm>		// std::sort
+#include <string>		// std::string
+#include <vector>		// std::vector
+#include <glob.h>		// glob, globfree
+#include <signal.h>		// kill, SIGKILL
+#include <sys/wait.h>		// waitpid, WIFEXITED, WEXITSTATUS, WNOHANG
+#include <unistd.h>		// fork, execl, usleep, _exit
+
+// The number of seconds a test may run for.
+const int TEST_TIMEOUT = 120;
+
+/**
+ * @name  number()
+ * @brief  Extracts the number of a test from its path.
+ * @param  path  {const std::string&}  The path of the test, such as `builds/test12`.
+ * @return  {const unsigned long}  The number of the test.
+ */
+const unsigned long number(const std::string& path) { return strtoul(path.c_str() + path.rfind("test") + 4, nullptr, 10); }
+
+/**
+ * @name  run()
+ * @brief  Runs a test and waits for it to exit or time out.
+ * @param  path  {const std::string&}  The path of the test.
+ * @return  {const bool}  `true` if the test passed.
+ */
+const bool run(const std::string& path)
+{
+	// Start the test.
+	fflush(stdout);
+	const pid_t pid = fork(); // The PID of the test.
+	if (pid == -1) return false;
+	if (!pid) { execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr)); _exit(127); }
+
+	// Wait for it to exit, killing it once it runs out of time.
+	int status = 0; // The exit status of the test.
+	for (int waited = 0; waitpid(pid, &status, WNOHANG) == 0; waited += 10)
+	{
+		if (waited >= TEST_TIMEOUT * 1000) { kill(pid, SIGKILL); waitpid(pid, &status, 0); fprintf(stderr, "run_script: %s timed out\n", path.c_str()); return false; }
+		usleep(10000);
+	}
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Find the tests, in the order of their numbers.
+	glob_t found; // The test executables.
+	if (glob("builds/test[0-9]*", 0, nullptr, &found)) { fprintf(stderr, "run_script: no tests in builds/; run build_script first\n"); exit(EXIT_FAILURE); }
+	std::vector<std::string> tests(found.gl_pathv, found.gl_pathv + found.gl_pathc); // The paths of the tests.
+	globfree(&found);
+	std::sort(tests.begin(), tests.end(), [](const std::string& left, const std::string& right) { return number(left) < number(right); });
+
+	int failed = 0; // The number of tests that failed.
+	for (const std::string& test : tests)
+	{
+		// Skip the tests not asked for, if any were.
+		const char* const name = strrchr(test.c_str(), '/') + 1; // The name of the test.
+		bool wanted = argc < 2; // Whether the test is run.
+		for (int index = 1; index < argc && !wanted; ++index) wanted = !strcmp(argv[index], name);
+		if (!wanted) continue;
+
+		// Run it and report the outcome.
+		const bool passed = run(test); // Whether the test passed.
+		printf("%s %s\n", passed ? "✅" : "❌", name);
+		if (!passed) ++failed;
+	}
+
+	// Fail if any test did.
+	printf("%d failed\n", failed);
+	exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+// End of utils/run_script.cpp
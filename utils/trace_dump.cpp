@@ -0,0 +1,40 @@
+// utils/trace_dump.cpp
+
+/**
+ * @file  utils/trace_dump.cpp
+ * @brief  Exports the lifecycle trace of a NIPC instance as Chrome trace JSON
+ * @date  17/10/2026
+ * @version  1.0.0
+ * @remark  Usage: trace_dump <key> [file]; the trace is written to standard output when no file is given.
+ * @remark  The instance must have been created with tracing enabled; open the output in chrome://tracing or Perfetto.
+ */
+
+#include <cerrno>		// errno
+#include <cstdio>		// fprintf
+#include <cstdlib>		// exit, strtol, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>		// strerror
+#include <fcntl.h>		// open, O_WRONLY, O_CREAT, O_TRUNC
+#include <unistd.h>		// close, STDOUT_FILENO
+
+#include "../src/NIPC.h"
+
+int main(const int argc, const char* const argv[], const char* const envp[])
+{
+	// Check the arguments.
+	if (argc < 2 || argc > 3) { fprintf(stderr, "usage: trace_dump <key> [file]\n"); exit(EXIT_FAILURE); }
+
+	// Open the NIPC instance.
+	const int id = nipc_get(static_cast<key_t>(strtol(argv[1], nullptr, 0))); // The NIPC instance.
+	if (id == -1) { fprintf(stderr, "trace_dump: nipc_get: %s\n", strerror(errno)); exit(EXIT_FAILURE); }
+
+	// Open the output.
+	const int fd = argc == 3 ? open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO; // The file the trace is written to.
+	if (fd == -1) { fprintf(stderr, "trace_dump: %s: %s\n", argv[2], strerror(errno)); exit(EXIT_FAILURE); }
+
+	// Export the trace.
+	const int status = nipc_trace_dump(id, fd) == -1 ? (fprintf(stderr, "trace_dump: nipc_trace_dump: %s\n", strerror(errno)), EXIT_FAILURE) : EXIT_SUCCESS; // The exit status.
+	if (fd != STDOUT_FILENO) close(fd);
+	exit(status);
+}
+
+// End of utils/trace_dump.cpp